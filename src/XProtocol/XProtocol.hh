@@ -191,7 +191,8 @@ enum XLoginVersion {
 };
 
 enum XStatRequestOption {
-   kXR_vfs    = 1
+   kXR_vfs    = 1,
+   kXR_sxinfo = 2   // kXR_statx: return full stat information for each path
 };
 
 enum XStatRespFlags {
@@ -207,8 +208,9 @@ enum XStatRespFlags {
 };
 
 enum XDirlistRequestOption {
-   kXR_online = 1,
-   kXR_dstat  = 2
+   kXR_online  = 1,
+   kXR_dstat   = 2,
+   kXR_dcursor = 4    // Return a page of entries and a cursor to continue
 };
 
 enum XOpenRequestOption {
@@ -115,6 +115,7 @@ enum CmsReqCode            // Request Codes
      kYR_update  = 25,
      kYR_usage   = 26,
      kYR_xauth   = 27,
+     kYR_filter  = 28,
      kYR_MaxReq            // Count of request numbers (highest + 1)
 };
 
@@ -235,6 +236,30 @@ struct CmsHaveRequest
 //     kXR_string    Path;
 };
 
+/******************************************************************************/
+/*                        f i l t e r   R e q u e s t                         */
+/******************************************************************************/
+
+// Request: filter <gen> <size> <offset> <hashes> <data>
+// Respond: n/a
+//
+// Sent by a data server to its managers to describe its namespace as a Bloom
+// filter of <size> bytes (a power of two) using <hashes> probes per path. The
+// filter is sent as raw binary in consecutive chunks, each one at <offset>, all
+// carrying the same <gen>. The last chunk has the kYR_last modifier set.
+//
+struct CmsFilterRequest
+{      CmsRRHdr      Hdr;    // Modifier: kYR_raw | optional kYR_last
+       kXR_unt32     Gen;
+       kXR_unt32     Size;
+       kXR_unt32     Offset;
+       kXR_char      Hashes;
+       kXR_char      Rsvd[3];
+//     kXR_char      Data[];
+
+enum  {kYR_last = 0x01};
+};
+
 /******************************************************************************/
 /*                        l o c a t e   R e q u e s t                         */
 /******************************************************************************/
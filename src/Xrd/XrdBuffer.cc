@@ -41,6 +41,7 @@
 #include "XrdSys/XrdSysPlatform.hh"
 #include "XrdSys/XrdSysTimer.hh"
 #include "Xrd/XrdBuffer.hh"
+#include "Xrd/XrdStatsShm.hh"
 #include "XrdBuffXL.hh"
 
 #define XRD_TRACE XrdTrace->
@@ -95,6 +96,8 @@ XrdBuffManager::XrdBuffManager(XrdSysError *lP, XrdOucTrace *tP, int minrst) :
    totreq   = 0;
    totalo   = 0;
    totadj   = 0;
+   shmCtr   = XrdStatsShm::noCtr;
+   shmGge   = XrdStatsShm::noCtr;
 #ifdef _SC_PHYS_PAGES
    maxalo   = static_cast<long long>(pagsz)/8
               * static_cast<long long>(sysconf(_SC_PHYS_PAGES));
@@ -129,9 +132,15 @@ XrdBuffManager::~XrdBuffManager()
 
 void XrdBuffManager::Init()
 {
+   static const char *ggeName[] = {"mem", "buffs"};
    pthread_t tid;
    int rc;
 
+// Define our shared statistics
+//
+   shmCtr = XrdStatsShm::Define("buff.reqs");
+   shmGge = XrdStatsShm::Define("buff", ggeName, 2, XrdStatsShm::isGauge);
+
 // Start the reshaper thread
 //
    if ((rc = XrdSysThread::Run(&tid, XrdReshaper, static_cast<void *>(this), 0,
@@ -166,6 +175,7 @@ XrdBuffer *XrdBuffManager::Obtain(int sz)
 //
     Reshaper.Lock();
     totreq++;
+    XrdStatsShm::Add(shmCtr);
     bucket[bindex].numreq++;
     if ((bp = bucket[bindex].bnext))
        {bucket[bindex].bnext = bp->next; bucket[bindex].numbuf--;}
@@ -190,6 +200,8 @@ XrdBuffer *XrdBuffManager::Obtain(int sz)
     totbuf++;
     if ((totalo += mk) > maxalo && !rsinprog)
        {rsinprog = 1; Reshaper.Signal();}
+    XrdStatsShm::Set(shmGge, totalo);
+    XrdStatsShm::Set(shmGge+1, totbuf);
     Reshaper.UnLock();
     return bp;
 }
@@ -292,6 +304,8 @@ while(1)
                     memhave -= memslot; totalo  -= memslot;
                     totbuf--;
                    } else {bucket[i].numbuf = 0; break;}
+           XrdStatsShm::Set(shmGge, totalo);
+           XrdStatsShm::Set(shmGge+1, totbuf);
            Reshaper.UnLock();
            memslot = memslot>>1;
           }
@@ -117,6 +117,8 @@ long long maxalo;
 int       minrsw;
 int       rsinprog;
 int       totadj;
+int       shmCtr;   // Shared statistics request counter
+int       shmGge;   // First shared statistics gauge
 
 XrdSysCondVar      Reshaper;
 static const char *TraceID;
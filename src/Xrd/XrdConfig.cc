@@ -52,6 +52,7 @@
 #include "Xrd/XrdLink.hh"
 #include "Xrd/XrdPoll.hh"
 #include "Xrd/XrdStats.hh"
+#include "Xrd/XrdStatsShm.hh"
 
 #include "XrdNet/XrdNetAddr.hh"
 #include "XrdNet/XrdNetIF.hh"
@@ -167,6 +168,8 @@ XrdConfig::XrdConfig() : Log(&Logger, "Xrd"), Trace(&Log), Sched(&Log, &Trace),
    repDest[1] = 0;
    repInt     = 600;
    repOpts    = 0;
+   shmPath    = 0;
+   shmCtrs    = 1024;
    ppNet      = 0;
    NetTCPlep  = -1;
    NetADM     = 0;
@@ -584,10 +587,12 @@ int XrdConfig::ConfigXeq(char *var, XrdOucStream &Config, XrdSysError *eDest)
    {
    TS_Xeq("adminpath",     xapath);
    TS_Xeq("allow",         xallow);
+   TS_Xeq("fairness",      xfair);
    TS_Xeq("homepath",      xhpath);
    TS_Xeq("port",          xport);
    TS_Xeq("protocol",      xprot);
    TS_Xeq("report",        xrep);
+   TS_Xeq("shmstats",      xshm);
    TS_Xeq("sitename",      xsit);
    TS_Xeq("timeout",       xtmo);
    }
@@ -997,6 +1002,12 @@ int XrdConfig::Setup(char *dfltp)
                                  ProtInfo.myName, Firstcp->port,
                                  ProtInfo.myInst, ProtInfo.myProg, mySitName);
 
+// Create the shared statistics segment, if wanted, before loading protocols
+// so that they can publish their counters.
+//
+   if (shmPath && !XrdStatsShm::Init(&Log, shmPath, shmCtrs, ProtInfo.myProg,
+                                     ProtInfo.myInst)) return 1;
+
 // Allocate a WAN port number of we need to
 //
    if (PortWAN &&  (NetWAN = new XrdInet(&Log, &Trace, Police)))
@@ -1243,6 +1254,68 @@ int XrdConfig::xbuf(XrdSysError *eDest, XrdOucStream &Config)
     return 0;
 }
 
+/******************************************************************************/
+/*                                 x f a i r                                  */
+/******************************************************************************/
+
+/* Function: xfair
+
+   Purpose:  To parse directive: fairness {off | [reqs <n>] [bytes <bsz>]}
+
+             off      a link keeps its thread for as long as it has requests
+                      and the scheduler allows it (the default).
+             <n>      the maximum number of requests a link may process each
+                      time it is dispatched.
+             <bsz>    the maximum number of bytes a link may transfer each time
+                      it is dispatched, in bytes or K, M, or G.
+
+             A link that has used up its quantum and still has requests
+             pending is queued behind the other ready links.
+
+   Output: 0 upon success or 1 upon failure.
+*/
+
+int XrdConfig::xfair(XrdSysError *eDest, XrdOucStream &Config)
+{
+    char *val;
+    long long V_bytes = 0;
+    int  V_reqs = 0;
+
+    if (!(val = Config.GetWord()))
+       {eDest->Emsg("Config", "fairness option not specified"); return 1;}
+
+    if (!strcmp("off", val)) {XrdLink::setFair(0, 0); return 0;}
+
+    while (val)
+          {     if (!strcmp("reqs", val))
+                   {if (!(val = Config.GetWord()))
+                       {eDest->Emsg("Config", "fairness reqs value not specified");
+                        return 1;
+                       }
+                    if (XrdOuca2x::a2i(*eDest, "fairness reqs", val,
+                                       &V_reqs, 1)) return 1;
+                   }
+           else if (!strcmp("bytes", val))
+                   {if (!(val = Config.GetWord()))
+                       {eDest->Emsg("Config", "fairness bytes value not specified");
+                        return 1;
+                       }
+                    if (XrdOuca2x::a2sz(*eDest, "fairness bytes", val,
+                                        &V_bytes, 1)) return 1;
+                   }
+           else {eDest->Emsg("Config", "invalid fairness option", val);
+                 return 1;
+                }
+           val = Config.GetWord();
+          }
+
+    if (!V_reqs && !V_bytes)
+       {eDest->Emsg("Config", "fairness quantum not specified"); return 1;}
+
+    XrdLink::setFair(V_reqs, V_bytes);
+    return 0;
+}
+
 /******************************************************************************/
 /*                                  x n e t                                   */
 /******************************************************************************/
@@ -1767,6 +1840,50 @@ int XrdConfig::xsched(XrdSysError *eDest, XrdOucStream &Config)
    return 0;
 }
 
+/******************************************************************************/
+/*                                  x s h m                                   */
+/******************************************************************************/
+
+/* Function: xshm
+
+   Purpose:  To parse the directive: shmstats <path> [counters <num>]
+
+             <path>    the file where counters are published in shared memory.
+                       The file is best placed in a memory file system.
+
+             <num>     the maximum number of counters. The default is 1024.
+
+  Output: 0 upon success or !0 upon failure.
+*/
+
+int XrdConfig::xshm(XrdSysError *eDest, XrdOucStream &Config)
+{
+    char *val;
+
+// Get the path
+//
+   if (!(val = Config.GetWord()) || *val != '/')
+      {eDest->Emsg("Config", "shmstats path not specified or not absolute");
+       return 1;
+      }
+   if (shmPath) free(shmPath);
+   shmPath = strdup(val);
+
+// Get optional counter limit
+//
+   if ((val = Config.GetWord()))
+      {if (strcmp("counters", val))
+          {eDest->Emsg("Config", "invalid shmstats option", val); return 1;}
+       if (!(val = Config.GetWord()))
+          {eDest->Emsg("Config", "shmstats counters value not specified");
+           return 1;
+          }
+       if (XrdOuca2x::a2i(*eDest, "shmstats counters", val, &shmCtrs,
+                          64, 65536)) return 1;
+      }
+   return 0;
+}
+
 /******************************************************************************/
 /*                                  x s i t                                   */
 /******************************************************************************/
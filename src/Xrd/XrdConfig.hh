@@ -74,6 +74,7 @@ int   xallow(XrdSysError *edest, XrdOucStream &Config);
 int   xapath(XrdSysError *edest, XrdOucStream &Config);
 int   xhpath(XrdSysError *edest, XrdOucStream &Config);
 int   xbuf(XrdSysError *edest, XrdOucStream &Config);
+int   xfair(XrdSysError *edest, XrdOucStream &Config);
 int   xnet(XrdSysError *edest, XrdOucStream &Config);
 int   xnkap(XrdSysError *edest, char *val);
 int   xlog(XrdSysError *edest, XrdOucStream &Config);
@@ -81,6 +82,7 @@ int   xport(XrdSysError *edest, XrdOucStream &Config);
 int   xprot(XrdSysError *edest, XrdOucStream &Config);
 int   xrep(XrdSysError *edest, XrdOucStream &Config);
 int   xsched(XrdSysError *edest, XrdOucStream &Config);
+int   xshm(XrdSysError *edest, XrdOucStream &Config);
 int   xsit(XrdSysError *edest, XrdOucStream &Config);
 int   xtrace(XrdSysError *edest, XrdOucStream &Config);
 int   xtmo(XrdSysError *edest, XrdOucStream &Config);
@@ -104,6 +106,7 @@ char               *AdminPath;
 char               *HomePath;
 char               *ConfigFN;
 char               *repDest[2];
+char               *shmPath;
 XrdConfigProt      *Firstcp;
 XrdConfigProt      *Lastcp;
 int                 Net_Blen;
@@ -118,6 +121,7 @@ int                 NetTCPlep;
 int                 AdminMode;
 int                 HomeMode;
 int                 repInt;
+int                 shmCtrs;
 char                repOpts;
 char                ppNet;
 signed char         coreV;
@@ -27,10 +27,13 @@
 /* specific prior written permission of the institution or contributor.       */
 /******************************************************************************/
 
+#include <set>
+#include <string>
 #include <poll.h>
 #include <signal.h>
 #include <stdio.h>
 #include <string.h>
+#include <sys/ioctl.h>
 #include <sys/types.h>
 #include <sys/uio.h>
 
@@ -66,6 +69,7 @@
 #include "Xrd/XrdPoll.hh"
 #include "Xrd/XrdScheduler.hh"
 #include "Xrd/XrdSendQ.hh"
+#include "Xrd/XrdStatsShm.hh"
 
 #define  TRACELINK this
 #define  XRD_TRACE XrdTrace->
@@ -92,6 +96,7 @@ void          DoIt() {idleScan();}
 
 private:
 
+void               idleMove(XrdLink *lp, int tick);
 void               idleScan();
 
 XrdSysError       *XrdLog;
@@ -136,6 +141,14 @@ static const char *TraceID;
        int             XrdLink::LinkStalls    = 0;
        int             XrdLink::LinkSfIntr    = 0;
        int             XrdLink::maxFD         = 0;
+       int             XrdLink::shmCtr        = XrdStatsShm::noCtr;
+       int             XrdLink::shmNum        = -1;
+       int             XrdLink::shmQue        = XrdStatsShm::noCtr;
+       int             XrdLink::fairReqs      = 0;
+       long long       XrdLink::fairBytes     = 0;
+       long long       XrdLink::LinkQWait     = 0;
+       long long       XrdLink::LinkQNum      = 0;
+       long long       XrdLink::LinkRequeue   = 0;
        XrdSysMutex     XrdLink::statsMutex;
 
        const char     *XrdLinkScan::TraceID = "LinkScan";
@@ -143,6 +156,29 @@ static const char *TraceID;
        short           XrdLink::killWait= 3;  // Kill then wait
        short           XrdLink::waitKill= 4;  // Wait then kill
 
+       XrdSysMutex     XrdLink::idleMutex;
+       XrdLink       **XrdLink::idleHead  = 0;
+       int             XrdLink::idleSlots = 0;
+       int             XrdLink::curTick   = 0;
+
+// Links are indexed by host name and user name so that administrative queries
+// for a particular host or user need not look at every link. Each index holds
+// the name and the link's file descriptor and is protected by the LTMutex.
+//
+typedef std::set<std::pair<std::string, int> > XrdLinkIndex;
+
+static  XrdLinkIndex   hostIndex;
+static  XrdLinkIndex   userIndex;
+
+// Return the user name of a link ID (i.e. user.pid:fd@host), if any.
+//
+static std::string    IndexUser(const char *id)
+                           {const char *dot = index(id, '.');
+                            const char *col = index(id, ':');
+                            if (!dot || (col && col < dot)) return std::string();
+                            return std::string(id, dot - id);
+                           }
+
 // The following values are defined for LinkBat[]. We assume that FREE is 0
 //
 #define XRDLINK_FREE 0x00
@@ -189,6 +225,11 @@ void XrdLink::Reset()
   inQ      = 0;
   isBridged= 0;
   BytesOut = BytesIn = BytesOutTot = BytesInTot = 0;
+  qTime    = qWait = qWaitTot = 0;
+  qNum     = qNumTot = rqNum = rqNumTot = 0;
+  idleNext = idlePrev = 0;
+  idleTick = -1;
+  lastTick = curTick;
   doPost   = 0;
   LockReads= 0;
   KeepFD   = 0;
@@ -270,6 +311,13 @@ XrdLink *XrdLink::Alloc(XrdNetAddr &peer, int opts)
    lp->FD = peerFD;
    lp->Comment = (const char *)unp;
 
+// Index the link by host and place it in the idle list
+//
+   LTMutex.Lock();
+   hostIndex.insert(std::make_pair(std::string(lp->HostName), peerFD));
+   LTMutex.UnLock();
+   lp->idleAdd(curTick);
+
 // Set options as needed
 //
    lp->LockReads = (0 != (opts & XRDLINK_RDLOCK));
@@ -282,6 +330,7 @@ XrdLink *XrdLink::Alloc(XrdNetAddr &peer, int opts)
    statsMutex.Lock();
    AtomicInc(LinkCountTot);            // LinkCountTot++
    if (LinkCountMax <= AtomicInc(LinkCount)) LinkCountMax = LinkCount;
+   XrdStatsShm::Add(shmCtr+2); XrdStatsShm::Add(shmNum);
    statsMutex.UnLock();
    return lp;
 }
@@ -409,7 +458,10 @@ int XrdLink::Close(int defer)
        LTMutex.Lock();
        LinkBat[fd] = XRDLINK_FREE;
        if (fd == LTLast) while(LTLast && !(LinkBat[LTLast])) LTLast--;
+       if (HostName) hostIndex.erase(std::make_pair(std::string(HostName),fd));
+       userIndex.erase(std::make_pair(IndexUser(ID), fd));
        LTMutex.UnLock();
+       idleDel();
       } else opHelper.UnLock();
 
 // Close the file descriptor if it isn't being shared. Do it as the last
@@ -428,7 +480,18 @@ int XrdLink::Close(int defer)
  
 void XrdLink::DoIt()
 {
-   int rc;
+   long long bBeg = 0;
+   int rc, nReq = 0;
+
+// Account for the time the link waited for a thread after it became ready
+//
+   if (qTime)
+      {long long qDelay = qClock() - qTime;
+       if (qDelay < 0) qDelay = 0;
+       AtomicAdd(qWait, qDelay); AtomicInc(qNum);
+       XrdStatsShm::Add(shmQue, qDelay); XrdStatsShm::Add(shmQue+1, 1);
+       qTime = 0;
+      }
 
 // The Process() return code tells us what to do:
 // < 0 -> Stop getting requests, 
@@ -437,11 +500,27 @@ void XrdLink::DoIt()
 // = 0 -> OK, get next request, if allowed, o/w enable the link
 // > 0 -> Slow link, stop getting requests  and enable the link
 //
-   if (Protocol)
-      do {rc = Protocol->Process(this);} while (!rc && XrdSched->canStick());
-      else {XrdLog->Emsg("Link", "Dispatch on closed link", ID);
-            return;
-           }
+// When a fairness quantum is in effect and the link used it up, we stop
+// getting requests. If the link still has data it is queued behind whatever
+// else is ready as if the poller had found it ready again. Otherwise, it is
+// simply enabled as usual.
+//
+   if (!Protocol)
+      {XrdLog->Emsg("Link", "Dispatch on closed link", ID);
+       return;
+      }
+   if (fairBytes) bBeg = BytesIn + BytesOut;
+   do {rc = Protocol->Process(this);
+       if (rc || !XrdSched->canStick()) break;
+       if ((fairReqs  && ++nReq >= fairReqs)
+       ||  (fairBytes && BytesIn + BytesOut - bBeg >= fairBytes))
+          {if (!Pending()) break;
+           AtomicInc(rqNum); XrdStatsShm::Add(shmQue+2, 1);
+           qTime = qClock();
+           XrdSched->Schedule((XrdJob *)this);
+           return;
+          }
+      } while(1);
 
 // Either re-enable the link and cycle back waiting for a new request, leave
 // disabled, or terminate the connection.
@@ -471,9 +550,8 @@ void XrdLink::Enable()
 XrdLink *XrdLink::Find(int &curr, XrdLinkMatch *who)
 {
    XrdLink *lp;
-   const int MaxSeek = 16;
    unsigned int myINS;
-   int i, seeklim = MaxSeek;
+   int i;
 
 // Do initialization
 //
@@ -481,23 +559,17 @@ XrdLink *XrdLink::Find(int &curr, XrdLinkMatch *who)
    if (curr >= 0 && LinkTab[curr]) LinkTab[curr]->setRef(-1);
       else curr = -1;
 
-// Find next matching link. Since this may take some time, we periodically
-// release the LTMutex lock which drives up overhead but will still allow
-// other critical operations to occur.
+// Find next matching link
 //
-   for (i = curr+1; i <= LTLast; i++)
-       {if ((lp = LinkTab[i]) && LinkBat[i] && lp->HostName)
-           if (!who 
-           ||   who->Match(lp->ID,lp->Lname-lp->ID-1,lp->HostName,lp->HNlen))
-              {myINS = lp->Instance;
-               LTMutex.UnLock();
-               lp->setRef(1);
-               curr = i;
-               if (myINS == lp->Instance) return lp;
-               LTMutex.Lock();
-              }
-        if (!seeklim--) {LTMutex.UnLock(); seeklim = MaxSeek; LTMutex.Lock();}
-       }
+   while((i = Seek(curr, who)) >= 0)
+        {lp = LinkTab[i];
+         myINS = lp->Instance;
+         LTMutex.UnLock();
+         lp->setRef(1);
+         curr = i;
+         if (myINS == lp->Instance) return lp;
+         LTMutex.Lock();
+        }
 
 // Done scanning the table
 //
@@ -516,26 +588,17 @@ XrdLink *XrdLink::Find(int &curr, XrdLinkMatch *who)
 //
 int XrdLink::getName(int &curr, char *nbuf, int nbsz, XrdLinkMatch *who)
 {
-   XrdLink *lp;
-   const int MaxSeek = 16;
-   int i, ulen = 0, seeklim = MaxSeek;
+   int i, ulen;
 
-// Find next matching link. Since this may take some time, we periodically
-// release the LTMutex lock which drives up overhead but will still allow
-// other critical operations to occur.
+// Find next matching link
 //
    LTMutex.Lock();
-   for (i = curr+1; i <= LTLast; i++)
-       {if ((lp = LinkTab[i]) && LinkBat[i] && lp->HostName)
-           if (!who 
-           ||   who->Match(lp->ID,lp->Lname-lp->ID-1,lp->HostName,lp->HNlen))
-              {ulen = lp->Client(nbuf, nbsz);
-               LTMutex.UnLock();
-               curr = i;
-               return ulen;
-              }
-        if (!seeklim--) {LTMutex.UnLock(); seeklim = MaxSeek; LTMutex.Lock();}
-       }
+   if ((i = Seek(curr, who)) >= 0)
+      {ulen = LinkTab[i]->Client(nbuf, nbsz);
+       LTMutex.UnLock();
+       curr = i;
+       return ulen;
+      }
    LTMutex.UnLock();
 
 // Done scanning the table
@@ -544,6 +607,46 @@ int XrdLink::getName(int &curr, char *nbuf, int nbsz, XrdLinkMatch *who)
    return 0;
 }
 
+/******************************************************************************/
+/*                               i d l e A d d                                */
+/******************************************************************************/
+
+// Place the link in the idle list for the tick. The link must not be in a list.
+
+void XrdLink::idleAdd(int tick)
+{
+   XrdLink **head;
+
+   if (!idleSlots) return;
+   idleMutex.Lock();
+   head = &idleHead[tick % idleSlots];
+   idleTick = tick;
+   idlePrev = 0;
+   if ((idleNext = *head)) idleNext->idlePrev = this;
+   *head = this;
+   idleMutex.UnLock();
+}
+
+/******************************************************************************/
+/*                               i d l e D e l                                */
+/******************************************************************************/
+
+// Remove the link from its idle list, if it is in one.
+
+void XrdLink::idleDel()
+{
+   if (!idleSlots) return;
+   idleMutex.Lock();
+   if (idleTick >= 0)
+      {if (idlePrev) idlePrev->idleNext = idleNext;
+          else idleHead[idleTick % idleSlots] = idleNext;
+       if (idleNext) idleNext->idlePrev = idlePrev;
+       idleNext = idlePrev = 0;
+       idleTick = -1;
+      }
+   idleMutex.UnLock();
+}
+
 /******************************************************************************/
 /*                                  P e e k                                   */
 /******************************************************************************/
@@ -561,7 +664,7 @@ int XrdLink::Peek(char *Buff, int Blen, int timeout)
 
 // Wait until we can actually read something
 //
-   isIdle = 0;
+   lastTick = curTick;
    do {retc = poll(&polltab, 1, timeout);} while(retc < 0 && errno == EINTR);
    if (retc != 1)
       {if (retc == 0) return 0;
@@ -588,6 +691,19 @@ int XrdLink::Peek(char *Buff, int Blen, int timeout)
    return -1;
 }
   
+/******************************************************************************/
+/*                               P e n d i n g                                */
+/******************************************************************************/
+
+// Return true if the link has data waiting to be read.
+
+bool XrdLink::Pending()
+{
+   int n = 0;
+
+   return ioctl(FDnum(), FIONREAD, &n) == 0 && n > 0;
+}
+
 /******************************************************************************/
 /*                                  R e c v                                   */
 /******************************************************************************/
@@ -600,9 +716,9 @@ int XrdLink::Recv(char *Buff, int Blen)
 // timeout to receive as much data as possible.
 //
    if (LockReads) rdMutex.Lock();
-   isIdle = 0;
+   lastTick = curTick;
    do {rlen = read(FD, Buff, Blen);} while(rlen < 0 && errno == EINTR);
-   if (rlen > 0) AtomicAdd(BytesIn, rlen);
+   if (rlen > 0) {AtomicAdd(BytesIn, rlen); XrdStatsShm::Add(shmCtr, rlen);}
    if (LockReads) rdMutex.UnLock();
 
    if (rlen >= 0) return int(rlen);
@@ -625,7 +741,7 @@ int XrdLink::Recv(char *Buff, int Blen, int timeout)
 
 // Wait up to timeout milliseconds for data to arrive
 //
-   isIdle = 0;
+   lastTick = curTick;
    while(Blen > 0)
         {do {retc = poll(&polltab,1,timeout);} while(retc < 0 && errno == EINTR);
          if (retc != 1)
@@ -633,7 +749,7 @@ int XrdLink::Recv(char *Buff, int Blen, int timeout)
                 {tardyCnt++;
                  if (totlen)
                     {if ((++stallCnt & 0xff) == 1) TRACEI(DEBUG,"read timed out");
-                     AtomicAdd(BytesIn, totlen);
+                     AtomicAdd(BytesIn, totlen); XrdStatsShm::Add(shmCtr, totlen);
                     }
                  return int(totlen);
                 }
@@ -659,7 +775,7 @@ int XrdLink::Recv(char *Buff, int Blen, int timeout)
          totlen += rlen; Blen -= rlen; Buff += rlen;
         }
 
-   AtomicAdd(BytesIn, totlen);
+   AtomicAdd(BytesIn, totlen); XrdStatsShm::Add(shmCtr, totlen);
    return int(totlen);
 }
 
@@ -693,9 +809,9 @@ int XrdLink::RecvAll(char *Buff, int Blen, int timeout)
 // Note that we will block until we receive all he bytes.
 //
    if (LockReads) rdMutex.Lock();
-   isIdle = 0;
+   lastTick = curTick;
    do {rlen = recv(FD,Buff,Blen,MSG_WAITALL);} while(rlen < 0 && errno == EINTR);
-   if (rlen > 0) AtomicAdd(BytesIn, rlen);
+   if (rlen > 0) {AtomicAdd(BytesIn, rlen); XrdStatsShm::Add(shmCtr, rlen);}
    if (LockReads) rdMutex.UnLock();
 
    if (int(rlen) == Blen) return Blen;
@@ -716,8 +832,8 @@ int XrdLink::Send(const char *Buff, int Blen)
 // Get a lock
 //
    wrMutex.Lock();
-   isIdle = 0;
-   AtomicAdd(BytesOut, Blen);
+   lastTick = curTick;
+   AtomicAdd(BytesOut, Blen); XrdStatsShm::Add(shmCtr+1, Blen);
 
 // Do non-blocking writes if we are setup to do so.
 //
@@ -760,8 +876,8 @@ int XrdLink::Send(const struct iovec *iov, int iocnt, int bytes)
 // Get a lock and assume we will be successful (statistically we are)
 //
    wrMutex.Lock();
-   isIdle = 0;
-   AtomicAdd(BytesOut, bytes);
+   lastTick = curTick;
+   AtomicAdd(BytesOut, bytes); XrdStatsShm::Add(shmCtr+1, bytes);
 
 // Do non-blocking writes if we are setup to do so.
 //
@@ -843,13 +959,13 @@ int XrdLink::Send(const sfVec *sfP, int sfN)
 // very limited conditions.
 //
    wrMutex.Lock();
-   isIdle = 0;
+   lastTick = curTick;
 do{retc = sendfilev(FD, vecSFP, sfN, &xframt);
 
 // Check if all went well and return if so (usual case)
 //
    if (xframt == bytes)
-      {AtomicAdd(BytesOut, bytes);
+      {AtomicAdd(BytesOut, bytes); XrdStatsShm::Add(shmCtr+1, bytes);
        wrMutex.UnLock();
        return totamt;
       }
@@ -862,6 +978,7 @@ do{retc = sendfilev(FD, vecSFP, sfN, &xframt);
 //
    if (xframt > 0)
       {AtomicAdd(BytesOut, xframt); bytes -= xframt; SfIntr++;
+       XrdStatsShm::Add(shmCtr+1, xframt);
        while(xframt > 0 && sfN)
             {if ((ssize_t)xframt < (ssize_t)vecSFP->sfv_len)
                 {vecSFP->sfv_off += xframt; vecSFP->sfv_len -= xframt; break;}
@@ -887,7 +1004,7 @@ do{retc = sendfilev(FD, vecSFP, sfN, &xframt);
 // lock the link
 //
    wrMutex.Lock();
-   isIdle = 0;
+   lastTick = curTick;
 
 // In linux we need to cork the socket. On permanent errors we do not uncork
 // the socket because it will be closed in short order.
@@ -928,7 +1045,7 @@ do{retc = sendfilev(FD, vecSFP, sfN, &xframt);
 // All done
 //
    if (xIntr > sfN) SfIntr += (xIntr - sfN);
-   AtomicAdd(BytesOut, xfrbytes);
+   AtomicAdd(BytesOut, xfrbytes); XrdStatsShm::Add(shmCtr+1, xfrbytes);
    wrMutex.UnLock();
    return xfrbytes;
 #endif
@@ -980,15 +1097,25 @@ void XrdLink::setID(const char *userid, int procid)
    char buff[sizeof(Uname)], *bp, *sp;
    int ulen;
 
+   std::string user;
+
    snprintf(buff, sizeof(buff), "%s.%d:%d", userid, procid, FD);
    ulen = strlen(buff);
    sp = buff + ulen - 1;
    bp = &Uname[sizeof(Uname)-1];
    if (ulen > (int)sizeof(Uname)) ulen = sizeof(Uname);
+
+// Change the ID and reindex the link under the new user name
+//
+   LTMutex.Lock();
+   userIndex.erase(std::make_pair(IndexUser(ID), FD));
    *bp = '@'; bp--;
    while(ulen--) {*bp = *sp; bp--; sp--;}
    ID = bp+1;
    Comment = (const char *)ID;
+   if (!(user = IndexUser(ID)).empty())
+      userIndex.insert(std::make_pair(user, FD));
+   LTMutex.UnLock();
 }
  
 /******************************************************************************/
@@ -1020,14 +1147,75 @@ bool XrdLink::setNB()
 #endif
 }
 
+/******************************************************************************/
+/*                                  S e e k                                   */
+/******************************************************************************/
+
+// Return the file descriptor of the next link after curr that matches or -1.
+// Must be called with the LTMutex held. When the target names a particular
+// host or user only the links in the corresponding index are looked at.
+// Otherwise, the whole table is scanned, periodically releasing the LTMutex
+// which drives up overhead but will still allow other critical operations.
+//
+int XrdLink::Seek(int curr, XrdLinkMatch *who)
+{
+   const int MaxSeek = 16;
+   XrdLinkIndex *idx = 0;
+   XrdLinkIndex::iterator it;
+   XrdLink *lp;
+   std::string key;
+   const char *kP;
+   int i, klen, seeklim = MaxSeek;
+
+// Check if we can use an index
+//
+   if (who)
+      {if ((kP = who->Host())) {idx = &hostIndex; key = kP;}
+          else if ((kP = who->User(klen)))
+                  {idx = &userIndex; key.assign(kP, klen);}
+      }
+
+// Look at the indexed links in file descriptor order
+//
+   if (idx)
+      {for (it = idx->lower_bound(std::make_pair(key, curr+1));
+            it != idx->end() && it->first == key; ++it)
+           {i = it->second;
+            if ((lp = LinkTab[i]) && LinkBat[i] && lp->HostName
+            &&  who->Match(lp->ID,lp->Lname-lp->ID-1,lp->HostName,lp->HNlen))
+               return i;
+           }
+       return -1;
+      }
+
+// Scan the link table
+//
+   for (i = curr+1; i <= LTLast; i++)
+       {if ((lp = LinkTab[i]) && LinkBat[i] && lp->HostName)
+           if (!who
+           ||   who->Match(lp->ID,lp->Lname-lp->ID-1,lp->HostName,lp->HNlen))
+              return i;
+        if (!seeklim--) {LTMutex.UnLock(); seeklim = MaxSeek; LTMutex.Lock();}
+       }
+   return -1;
+}
+
 /******************************************************************************/
 /*                                 S e t u p                                  */
 /******************************************************************************/
 
 int XrdLink::Setup(int maxfds, int idlewait)
 {
+   static const char *ctrName[] = {"in", "out", "ctot"};
+   static const char *queName[] = {"qwait", "disp", "requeue"};
    int numalloc, iticks, ichk;
 
+// Define our shared statistics
+//
+   shmCtr = XrdStatsShm::Define("link", ctrName, 3);
+   shmNum = XrdStatsShm::Define("link.num", XrdStatsShm::isGauge);
+   shmQue = XrdStatsShm::Define("link", queName, 3);
+
 // Compute the number of link objects we should allocate at a time. Generally,
 // we like to allocate 8k of them at a time but always as a power of two.
 //
@@ -1054,6 +1242,8 @@ int XrdLink::Setup(int maxfds, int idlewait)
    if (idlewait)
       {if (!(ichk = idlewait/3)) {iticks = 1; ichk = idlewait;}
           else iticks = 3;
+       idleSlots = iticks+1;
+       idleHead  = new XrdLink *[idleSlots]();
        XrdLinkScan *ls = new XrdLinkScan(XrdLog,XrdTrace,XrdSched,ichk,iticks);
        XrdSched->Schedule((XrdJob *)ls, ichk+time(0));
       }
@@ -1185,12 +1375,13 @@ int XrdLink::Stats(char *buff, int blen, int do_sync)
    static const char statfmt[] = "<stats id=\"link\"><num>%d</num>"
           "<maxn>%d</maxn><tot>%lld</tot><in>%lld</in><out>%lld</out>"
           "<ctime>%lld</ctime><tmo>%d</tmo><stall>%d</stall>"
-          "<sfps>%d</sfps></stats>";
+          "<sfps>%d</sfps><qwait>%lld</qwait><disp>%lld</disp>"
+          "<requeue>%lld</requeue></stats>";
    int i, myLTLast;
 
 // Check if actual length wanted
 //
-   if (!buff) return sizeof(statfmt)+17*6;
+   if (!buff) return sizeof(statfmt)+17*9;
 
 // We must synchronize the statistical counters
 //
@@ -1212,7 +1403,10 @@ int XrdLink::Stats(char *buff, int blen, int do_sync)
                                      AtomicGet(LinkConTime),
                                      AtomicGet(LinkTimeOuts),
                                      AtomicGet(LinkStalls),
-                                     AtomicGet(LinkSfIntr));
+                                     AtomicGet(LinkSfIntr),
+                                     AtomicGet(LinkQWait),
+                                     AtomicGet(LinkQNum),
+                                     AtomicGet(LinkRequeue));
    AtomicEnd(statsMutex);
    return i;
 }
@@ -1244,7 +1438,7 @@ void XrdLink::syncStats(int *ctime)
       {*ctime = time(0) - conTime;
        AtomicAdd(LinkConTime, *ctime);
        statsMutex.Lock();
-       if (LinkCount > 0) AtomicDec(LinkCount);
+       if (LinkCount > 0) {AtomicDec(LinkCount); XrdStatsShm::Add(shmNum, -1);}
        statsMutex.UnLock();
       }
 
@@ -1265,6 +1459,15 @@ void XrdLink::syncStats(int *ctime)
    AtomicAdd(LinkSfIntr, tmpI4);
    AtomicEnd(statsMutex); AtomicEnd(wrMutex);
 
+   AtomicBeg(statsMutex);
+   tmpLL = AtomicFAZ(qWait);
+   AtomicAdd(LinkQWait, tmpLL);    AtomicAdd(qWaitTot, tmpLL);
+   tmpI4 = AtomicFAZ(qNum);
+   AtomicAdd(LinkQNum, tmpI4);     AtomicAdd(qNumTot, tmpI4);
+   tmpI4 = AtomicFAZ(rqNum);
+   AtomicAdd(LinkRequeue, tmpI4);  AtomicAdd(rqNumTot, tmpI4);
+   AtomicEnd(statsMutex);
+
 // Make sure the protocol updates it's statistics as well
 //
    if (Protocol) Protocol->Stats(0, 0, 1);
@@ -1370,6 +1573,23 @@ int XrdLink::Terminate(const XrdLink *owner, int fdnum, unsigned int inst)
    return wTime;
 }
 
+/******************************************************************************/
+/*                              i d l e M o v e                               */
+/******************************************************************************/
+
+// Place a link taken off an idle list in the list for the tick. Must be called
+// with the idleMutex held.
+
+void XrdLinkScan::idleMove(XrdLink *lp, int tick)
+{
+   XrdLink **head = &XrdLink::idleHead[tick % XrdLink::idleSlots];
+
+   lp->idleTick = tick;
+   lp->idlePrev = 0;
+   if ((lp->idleNext = *head)) lp->idleNext->idlePrev = lp;
+   *head = lp;
+}
+
 /******************************************************************************/
 /*                              i d l e S c a n                               */
 /******************************************************************************/
@@ -1380,38 +1600,41 @@ int XrdLink::Terminate(const XrdLink *owner, int fdnum, unsigned int inst)
 void XrdLinkScan::idleScan()
 {
    XrdLink *lp;
-   int i, ltlast, lnum = 0, tmo = 0, tmod = 0;
-
-// Get the current link high watermark
-//
-   XrdLink::LTMutex.Lock();
-   ltlast = XrdLink::LTLast;
-   XrdLink::LTMutex.UnLock();
-
-// Scan across all links looking for idle links. Links are never deallocated
-// so we don't need any special kind of lock for these
-//
-   for (i = 0; i <= ltlast; i++)
-       {if (XrdLink::LinkBat[i] != XRDLINK_USED 
-        || !(lp = XrdLink::LinkTab[i])) continue;
-        lnum++;
-        lp->opMutex.Lock();
-        if (lp->isIdle) tmo++;
-        lp->isIdle++;
-        if ((int(lp->isIdle)) < idleTicks) {lp->opMutex.UnLock(); continue;}
-        lp->isIdle = 0;
-        if (!(lp->Poller) || !(lp->isEnabled))
-           XrdLog->Emsg("LinkScan","Link",lp->ID,"is disabled and idle.");
-           else if (lp->InUse == 1)
-                   {lp->Poller->Disable(lp, "idle timeout");
-                    tmod++;
-                   }
-        lp->opMutex.UnLock();
-       }
+   int tick, slot, lnum = 0, tmod = 0;
+
+// Advance the tick. The links that may have timed out are those whose last
+// known activity was idleTicks ago; they are all in a single list. Links that
+// were active since are moved to the list for the tick of that activity.
+// Links are never deallocated so we don't need any special kind of lock for
+// these but we must not wait for a link's opMutex while holding the idleMutex.
+//
+   XrdLink::idleMutex.Lock();
+   tick = ++XrdLink::curTick;
+   slot = (tick + 1) % XrdLink::idleSlots;  // (tick - idleTicks) mod slots
+   while((lp = XrdLink::idleHead[slot]))
+        {if ((XrdLink::idleHead[slot] = lp->idleNext))
+            lp->idleNext->idlePrev = 0;
+         lnum++;
+         if (tick - lp->lastTick < idleTicks || !lp->opMutex.CondLock())
+            {idleMove(lp, (tick - lp->lastTick < idleTicks ? lp->lastTick
+                                                            : tick));
+             continue;
+            }
+         if (!(lp->Poller) || !(lp->isEnabled))
+            XrdLog->Emsg("LinkScan","Link",lp->ID,"is disabled and idle.");
+            else if (lp->InUse == 1)
+                    {lp->Poller->Disable(lp, "idle timeout");
+                     tmod++;
+                    }
+         lp->opMutex.UnLock();
+         idleMove(lp, tick);
+        }
+   XrdLink::idleMutex.UnLock();
 
 // Trace what we did
 //
-   TRACE(CONN, lnum <<" links; " <<tmo <<" idle; " <<tmod <<" force closed");
+   TRACE(CONN, AtomicGet(XrdLink::LinkCount) <<" links; " <<lnum <<" checked; "
+               <<tmod <<" force closed");
 
 // Reschedule ourselves
 //
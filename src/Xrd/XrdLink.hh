@@ -121,6 +121,22 @@ static XrdLink *fd2link(int fd, unsigned int inst)
 
 static XrdLink *Find(int &curr, XrdLinkMatch *who=0);
 
+//-----------------------------------------------------------------------------
+//! Obtain the dispatch statistics for this link.
+//!
+//! @param  qwait   The total number of microseconds the link waited for a
+//!                 thread after it had a request ready.
+//! @param  qnum    The number of times the link was dispatched.
+//! @param  rqnum   The number of times the link gave up its thread to be fair
+//!                 to other links while it still had requests pending.
+//-----------------------------------------------------------------------------
+
+       void   getQStats(long long &qwait, int &qnum, int &rqnum)
+                       {qwait = qWait + qWaitTot;
+                        qnum  = qNum  + qNumTot;
+                        rqnum = rqNum + rqNumTot;
+                       }
+
        int    getIOStats(long long &inbytes, long long &outbytes,
                               int  &numstall,     int  &numtardy)
                         { inbytes = BytesIn + BytesInTot;
@@ -232,6 +248,18 @@ XrdProtocol  *setProtocol(XrdProtocol *pp);
 
 void          setRef(int cnt);                          // ASYNC Mode
 
+//-----------------------------------------------------------------------------
+//! Set the fairness quantum. A link that has processed the number of requests
+//! or transferred the number of bytes in a single dispatch gives up its thread
+//! and is queued behind other ready links if it still has requests pending.
+//!
+//! @param  reqs    The maximum number of requests per dispatch, 0 for no limit.
+//! @param  bytes   The maximum number of bytes per dispatch, 0 for no limit.
+//-----------------------------------------------------------------------------
+
+static void   setFair(int reqs, long long bytes)
+                     {fairReqs = reqs; fairBytes = bytes;}
+
 static int    Setup(int maxfd, int idlewait);
 
        void   Shutdown(bool getLock);
@@ -254,7 +282,16 @@ int           hasBridge() {return isBridged;}
 
 private:
 
+void   idleAdd(int tick);
+void   idleDel();
+bool   Pending();
+static
+long long qClock() {struct timespec ts; clock_gettime(CLOCK_MONOTONIC, &ts);
+                    return ts.tv_sec*1000000LL + ts.tv_nsec/1000;
+                   }
 void   Reset();
+static
+int    Seek(int curr, XrdLinkMatch *who);
 int    sendData(const char *Buff, int Blen);
 
 static XrdSysError  *XrdLog;
@@ -272,6 +309,14 @@ static int           devNull;
 static short         killWait;
 static short         waitKill;
 
+// Links are kept in one of idleSlots lists by the scan tick of their last known
+// activity so that the idle scan only looks at links that may have timed out.
+//
+static XrdSysMutex   idleMutex;  // For the idle lists only LTMutex->idleMutex
+static XrdLink     **idleHead;
+static int           idleSlots;
+static int           curTick;    // Current idle scan tick
+
 // Statistical area (global and local)
 //
 static long long    LinkBytesIn;
@@ -284,6 +329,14 @@ static int          LinkTimeOuts;
 static int          LinkStalls;
 static int          LinkSfIntr;
 static int          maxFD;
+static int          shmCtr;     // First shared statistics counter
+static int          shmNum;     // Shared statistics link count gauge
+static int          shmQue;     // First shared statistics dispatch counter
+static int          fairReqs;   // Requests per dispatch (0 -> no limit)
+static long long    fairBytes;  // Bytes per dispatch    (0 -> no limit)
+static long long    LinkQWait;
+static long long    LinkQNum;
+static long long    LinkRequeue;
        long long        BytesIn;
        long long        BytesInTot;
        long long        BytesOut;
@@ -326,10 +379,26 @@ int                 doPost;
 char                LockReads;
 char                KeepFD;
 char                isEnabled;
-char                isIdle;
+char                isIdle;         // No longer used
 char                inQ;    // Only used by PollPoll.icc
 char                isBridged;
 char                KillCnt;        // Protected by opMutex!
+
+// Dispatch statistics and idle list; kept at the end to preserve the layout of
+// the above
+//
+long long           qTime;          // When made ready for dispatch (usec)
+long long           qWait;
+long long           qWaitTot;
+int                 qNum;
+int                 qNumTot;
+int                 rqNum;
+int                 rqNumTot;
+XrdLink            *idleNext;       // Protected by idleMutex
+XrdLink            *idlePrev;       // Protected by idleMutex
+int                 idleTick;       // Tick of idle list we are in or -1
+int                 lastTick;       // Tick of last activity
+
 static const char   KillMax =   60;
 static const char   KillMsk = 0x7f;
 static const char   KillXwt = 0x80;
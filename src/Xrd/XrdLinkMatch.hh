@@ -37,12 +37,25 @@ class XrdLinkMatch
 public:
 
 
+// Host() returns the host name the target requires, if it names a single host.
+//
+inline const char *Host() {return (HnameL && !HnamelenL ? HnameL : 0);}
+
 int                Match(const char *uname, int unlen,
                          const char *hname, int hnlen);
 inline int         Match(const char *uname, int unlen,
                          const char *hname)
                         {return Match(uname, unlen, hname, strlen(hname));}
 
+// User() returns the user name the target requires, if it names a single user.
+//         The name is not null terminated; its length is returned in ulen.
+//
+inline const char *User(int &ulen)
+                       {if (Unamelen < 2 || Uname[Unamelen-1] != '.') return 0;
+                        ulen = Unamelen-1;
+                        return Uname;
+                       }
+
 // Target: [<user>][*][@[<hostpfx>][*][<hostsfx>]]
 //
        void        Set(const char *target);
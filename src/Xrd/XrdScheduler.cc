@@ -41,6 +41,7 @@
 
 #include "Xrd/XrdJob.hh"
 #include "Xrd/XrdScheduler.hh"
+#include "Xrd/XrdStatsShm.hh"
 #include "XrdSys/XrdSysError.hh"
 
 #define XRD_TRACE XrdTrace->
@@ -115,6 +116,8 @@ XrdScheduler::XrdScheduler(XrdSysError *eP, XrdOucTrace *tP,
     num_Layoffs =  0;
     num_Limited =  0;
     firstPID    =  0;
+    shmCtr      = XrdStatsShm::noCtr;
+    shmGge      = XrdStatsShm::noCtr;
     WorkFirst = WorkLast = TimerQueue = 0;
 
 // Make sure we are using the maximum number of threads allowed (Linux only)
@@ -325,9 +328,13 @@ void XrdScheduler::Run()
 
 // Wait for work then do it (an endless task for a worker thread)
 //
-   do {do {DispatchMutex.Lock();          idl_Workers++;DispatchMutex.UnLock();
+   do {do {DispatchMutex.Lock();          idl_Workers++;
+           XrdStatsShm::Set(shmGge+2, idl_Workers);
+           DispatchMutex.UnLock();
            WorkAvail.Wait();
-           DispatchMutex.Lock();waiting = --idl_Workers;DispatchMutex.UnLock();
+           DispatchMutex.Lock();waiting = --idl_Workers;
+           XrdStatsShm::Set(shmGge+2, idl_Workers);
+           DispatchMutex.UnLock();
            SchedMutex.Lock();
            if ((jp = WorkFirst))
               {if (!(WorkFirst = jp->NextJob)) WorkLast = 0;
@@ -339,12 +346,15 @@ void XrdScheduler::Run()
                   {num_Layoffs--;
                    if (waiting)
                       {num_TDestroy++; num_Workers--;
+                       XrdStatsShm::Add(shmCtr+2);
+                       XrdStatsShm::Set(shmGge+1, num_Workers);
                        TRACE(SCHED, "terminating thread; workers=" <<num_Workers);
                        SchedMutex.UnLock();
                        return;
                       }
                   }
               }
+           XrdStatsShm::Set(shmGge, num_JobsinQ);
            SchedMutex.UnLock();
           } while(!jp);
 
@@ -385,6 +395,8 @@ void XrdScheduler::Schedule(XrdJob *jp)
    num_Jobs++;
    num_JobsinQ++;
    if (num_JobsinQ > max_QLength) max_QLength = num_JobsinQ;
+   XrdStatsShm::Add(shmCtr);
+   XrdStatsShm::Set(shmGge, num_JobsinQ);
 
 // Unlock the data area and return
 //
@@ -416,6 +428,8 @@ void XrdScheduler::Schedule(int numjobs, XrdJob *jfirst, XrdJob *jlast)
    num_Jobs    += numjobs;
    num_JobsinQ += numjobs;
    if (num_JobsinQ > max_QLength) max_QLength = num_JobsinQ;
+   XrdStatsShm::Add(shmCtr, numjobs);
+   XrdStatsShm::Set(shmGge, num_JobsinQ);
 
 // Indicate number of jobs to work on
 //
@@ -511,9 +525,16 @@ void XrdScheduler::setParms(int minw, int maxw, int avlw, int maxi, int once)
   
 void XrdScheduler::Start() // Serialized one time call!
 {
+    static const char *ctrName[] = {"jobs", "tcr", "tde", "tlimr"};
+    static const char *ggeName[] = {"inq", "threads", "idle"};
     int retc, numw;
     pthread_t tid;
 
+// Define our shared statistics
+//
+   shmCtr = XrdStatsShm::Define("sched", ctrName, 4);
+   shmGge = XrdStatsShm::Define("sched", ggeName, 3, XrdStatsShm::isGauge);
+
 // Start a time based scheduler
 //
    if ((retc = XrdSysThread::Run(&tid, XrdStartTSched, (void *)this,
@@ -620,6 +641,7 @@ void XrdScheduler::hireWorker(int dotrace)
    SchedMutex.Lock();
    if (num_Workers >= max_Workers)
       {num_Limited++;
+       XrdStatsShm::Add(shmCtr+3);
        if ((num_Limited & 4095) == 1)
            XrdLog->Emsg("Scheduler","Thread limit has been reached!");
        SchedMutex.UnLock();
@@ -627,6 +649,8 @@ void XrdScheduler::hireWorker(int dotrace)
       }
    num_Workers++;
    num_TCreate++;
+   XrdStatsShm::Add(shmCtr+1);
+   XrdStatsShm::Set(shmGge+1, num_Workers);
    SchedMutex.UnLock();
 
 // Start a new thread. We do this without the schedMutex to avoid hang-ups. If
@@ -641,6 +665,8 @@ void XrdScheduler::hireWorker(int dotrace)
        SchedMutex.Lock();
        num_Workers--;
        num_TCreate--;
+       XrdStatsShm::Add(shmCtr+1, -1);
+       XrdStatsShm::Set(shmGge+1, num_Workers);
        max_Workers = num_Workers;
        min_Workers = (max_Workers/10 ? max_Workers/10 : 1);
        stk_Workers = max_Workers/4*3;
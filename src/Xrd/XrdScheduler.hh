@@ -114,6 +114,9 @@ XrdSysMutex            TimerMutex; // Protects scheduler area
 XrdSchedulerPID       *firstPID;
 XrdSysMutex            ReaperMutex;
 
+int                    shmCtr;     // First shared statistics counter
+int                    shmGge;     // First shared statistics gauge
+
 void hireWorker(int dotrace=1);
 void Monitor();
 void traceExit(pid_t pid, int status);
@@ -0,0 +1,220 @@
+/******************************************************************************/
+/*                                                                            */
+/*                        X r d S t a t s S h m . c c                         */
+/*                                                                            */
+/* This file is part of the XRootD software suite.                            */
+/*                                                                            */
+/* XRootD is free software: you can redistribute it and/or modify it under    */
+/* the terms of the GNU Lesser General Public License as published by the     */
+/* Free Software Foundation, either version 3 of the License, or (at your     */
+/* option) any later version.                                                 */
+/*                                                                            */
+/* XRootD is distributed in the hope that it will be useful, but WITHOUT      */
+/* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or      */
+/* FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public       */
+/* License for more details.                                                  */
+/*                                                                            */
+/* You should have received a copy of the GNU Lesser General Public License   */
+/* along with XRootD in a file called COPYING.LESSER (LGPL license) and file  */
+/* COPYING (GPL license).  If not, see <http://www.gnu.org/licenses/>.        */
+/*                                                                            */
+/* The copyright holder's institutional names and contributor's names may not */
+/* be used to endorse or promote products derived from this software without  */
+/* specific prior written permission of the institution or contributor.       */
+/******************************************************************************/
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "Xrd/XrdStatsShm.hh"
+#include "XrdSys/XrdSysError.hh"
+#include "XrdSys/XrdSysPlatform.hh"
+#include "XrdSys/XrdSysPthread.hh"
+
+/******************************************************************************/
+/*                               G l o b a l s                                */
+/******************************************************************************/
+
+namespace
+{
+XrdSysMutex defMutex;
+}
+
+thread_local int               XrdStatsShm::myLane = -1;
+std::atomic<int>               XrdStatsShm::nextLane(0);
+std::atomic<long long>        *XrdStatsShm::valBase  = 0;
+std::atomic<int>               XrdStatsShm::maxCtr(0);
+int                            XrdStatsShm::laneCtrs = 0;
+XrdStatsShm::Head             *XrdStatsShm::shmHead  = 0;
+XrdStatsShm::DirEnt           *XrdStatsShm::shmDir   = 0;
+XrdStatsShm::DirEnt            XrdStatsShm::pendDir[XrdStatsShm::maxPend];
+int                            XrdStatsShm::numDef   = 0;
+
+/******************************************************************************/
+/*                                D e f i n e                                 */
+/******************************************************************************/
+
+int XrdStatsShm::Define(const char *name, CtrType ctype)
+{
+   XrdSysMutexHelper mHelp(defMutex);
+   int ctr;
+
+   if ((ctr = Find(name)) < 0) ctr = Make(name, ctype);
+   return ctr;
+}
+
+/******************************************************************************/
+
+int XrdStatsShm::Define(const char *pfx, const char *const *names, int num,
+                        CtrType ctype)
+{
+   XrdSysMutexHelper mHelp(defMutex);
+   char cName[sizeof(DirEnt::name)];
+   int i, ctr, ctrLim;
+
+// If the first counter exists then so does the group
+//
+   snprintf(cName, sizeof(cName), "%s.%s", pfx, names[0]);
+   if ((ctr = Find(cName)) >= 0) return ctr;
+
+// Make sure there is room for all of them so that the ids are consecutive
+//
+   ctrLim = (shmHead ? static_cast<int>(shmHead->maxCtr) : maxPend);
+   if (numDef + num > ctrLim) return noCtr;
+
+// Define them
+//
+   ctr = Make(cName, ctype);
+   for (i = 1; i < num; i++)
+       {snprintf(cName, sizeof(cName), "%s.%s", pfx, names[i]);
+        Make(cName, ctype);
+       }
+   return ctr;
+}
+
+/******************************************************************************/
+/*                                  I n i t                                   */
+/******************************************************************************/
+
+bool XrdStatsShm::Init(XrdSysError *eP, const char *path, int ctrMax,
+                       const char *pgm, const char *ins)
+{
+   XrdSysMutexHelper mHelp(defMutex);
+   char tmpPath[MAXPATHLEN+8];
+   size_t dirOff, valOff, laneLen, segSize;
+   Head *hP;
+   void *segP;
+   int fd;
+
+// Compute the layout; each lane starts on a cache line
+//
+   if (ctrMax < numDef) ctrMax = numDef;
+   dirOff  = (sizeof(Head) + 63) & ~63;
+   valOff  = (dirOff + ctrMax*sizeof(DirEnt) + 4095) & ~4095;
+   laneLen = (ctrMax*sizeof(long long) + 63) & ~63;
+   segSize = valOff + nLanes*laneLen;
+
+// Create the segment under a temporary name and move it into place once it
+// is complete; anyone looking at a previous segment keeps looking at it.
+//
+   snprintf(tmpPath, sizeof(tmpPath), "%s.new", path);
+   if ((fd = open(tmpPath, O_RDWR|O_CREAT|O_TRUNC, 0644)) < 0)
+      {eP->Emsg("StatsShm", errno, "create stats segment", tmpPath);
+       return false;
+      }
+   if (ftruncate(fd, segSize)
+   ||  (segP = mmap(0, segSize, PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0))
+              == MAP_FAILED)
+      {eP->Emsg("StatsShm", errno, "map stats segment", tmpPath);
+       close(fd); unlink(tmpPath);
+       return false;
+      }
+   close(fd);
+
+// Fill out the header (the file is all zeroes to start with)
+//
+   hP = (Head *)segP;
+   hP->version = Version;
+   hP->hdrLen  = sizeof(Head);
+   hP->dirOff  = dirOff;
+   hP->valOff  = valOff;
+   hP->laneLen = laneLen;
+   hP->lanes   = nLanes;
+   hP->maxCtr  = ctrMax;
+   hP->tBoot   = static_cast<int64_t>(time(0));
+   hP->pid     = static_cast<int32_t>(getpid());
+   strlcpy(hP->pgm, (pgm ? pgm : ""), sizeof(hP->pgm));
+   strlcpy(hP->ins, (ins ? ins : ""), sizeof(hP->ins));
+
+// Copy in the counters defined so far
+//
+   shmDir = (DirEnt *)((char *)segP + dirOff);
+   memcpy(shmDir, pendDir, numDef*sizeof(DirEnt));
+   hP->numCtr.store(numDef, std::memory_order_relaxed);
+
+// Mark the segment valid and put it in place
+//
+   std::atomic_thread_fence(std::memory_order_release);
+   memcpy(hP->magic, "XrdStats", sizeof(hP->magic));
+   if (rename(tmpPath, path))
+      {eP->Emsg("StatsShm", errno, "rename stats segment to", path);
+       munmap(segP, segSize); unlink(tmpPath);
+       return false;
+      }
+
+// Start accepting updates
+//
+   valBase  = (std::atomic<long long> *)((char *)segP + valOff);
+   laneCtrs = laneLen / sizeof(long long);
+   shmHead  = hP;
+   maxCtr.store(ctrMax, std::memory_order_release);
+   return true;
+}
+
+/******************************************************************************/
+/*                       P r i v a t e   M e t h o d s                        */
+/******************************************************************************/
+/******************************************************************************/
+/*                                  F i n d                                   */
+/******************************************************************************/
+
+int XrdStatsShm::Find(const char *name) // defMutex must be locked
+{
+   DirEnt *dP = (shmHead ? shmDir : pendDir);
+
+   for (int i = 0; i < numDef; i++)
+       if (!strncmp(dP[i].name, name, sizeof(dP[i].name)-1)) return i;
+   return -1;
+}
+
+/******************************************************************************/
+/*                                  M a k e                                   */
+/******************************************************************************/
+
+int XrdStatsShm::Make(const char *name, CtrType ctype) // defMutex is locked
+{
+   DirEnt *dP;
+
+// Get the next directory entry
+//
+   if (shmHead)
+      {if (numDef >= static_cast<int>(shmHead->maxCtr)) return noCtr;
+       dP = &shmDir[numDef];
+      } else {
+       if (numDef >= maxPend) return noCtr;
+       dP = &pendDir[numDef];
+      }
+
+// Fill it out and make it visible
+//
+   strlcpy(dP->name, name, sizeof(dP->name));
+   dP->type = ctype;
+   numDef++;
+   if (shmHead) shmHead->numCtr.store(numDef, std::memory_order_release);
+   return numDef-1;
+}
@@ -0,0 +1,138 @@
+#ifndef __XRD_STATSSHM_H__
+#define __XRD_STATSSHM_H__
+/******************************************************************************/
+/*                                                                            */
+/*                        X r d S t a t s S h m . h h                         */
+/*                                                                            */
+/* This file is part of the XRootD software suite.                            */
+/*                                                                            */
+/* XRootD is free software: you can redistribute it and/or modify it under    */
+/* the terms of the GNU Lesser General Public License as published by the     */
+/* Free Software Foundation, either version 3 of the License, or (at your     */
+/* option) any later version.                                                 */
+/*                                                                            */
+/* XRootD is distributed in the hope that it will be useful, but WITHOUT      */
+/* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or      */
+/* FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public       */
+/* License for more details.                                                  */
+/*                                                                            */
+/* You should have received a copy of the GNU Lesser General Public License   */
+/* along with XRootD in a file called COPYING.LESSER (LGPL license) and file  */
+/* COPYING (GPL license).  If not, see <http://www.gnu.org/licenses/>.        */
+/*                                                                            */
+/* The copyright holder's institutional names and contributor's names may not */
+/* be used to endorse or promote products derived from this software without  */
+/* specific prior written permission of the institution or contributor.       */
+/******************************************************************************/
+
+#include <atomic>
+#include <stdint.h>
+
+class XrdSysError;
+
+// The XrdStatsShm class publishes counters in a memory mapped file so that
+// they can be read (e.g. by xrdshmstats) without going through the server and
+// its locks. Components define named counters and update them with relaxed
+// atomics. Each thread updates one of nLanes copies of every counter so that
+// threads rarely share a cache line; a counter's value is the sum of its
+// lanes. Counters may be defined before the segment exists (updates are then
+// ignored) or after; readers simply pick up new counters as they appear.
+//
+// The segment layout (all values in host byte order) is self-describing:
+//
+// Head   at offset 0, valid once magic is set to "XrdStats"
+// DirEnt at dirOff, one for each of the numCtr counters defined
+// lanes  at valOff, nLanes arrays of laneLen bytes each holding an int64_t
+//        value for every counter, indexed by the counter's directory slot.
+//
+class XrdStatsShm
+{
+public:
+
+enum CtrType {isCounter = 0, isGauge = 1};
+
+static const int  nLanes  = 16;
+static const int  Version = 1;
+
+struct Head
+      {char                  magic[8];  // "XrdStats"
+       uint32_t              version;   // Layout version
+       uint32_t              hdrLen;    // Size of this header
+       uint32_t              dirOff;    // Offset of the counter directory
+       uint32_t              valOff;    // Offset of the first lane
+       uint32_t              laneLen;   // Bytes in each lane
+       uint32_t              lanes;     // Number of lanes
+       uint32_t              maxCtr;    // Counters the segment can hold
+       std::atomic<uint32_t> numCtr;    // Counters defined so far
+       int64_t               tBoot;     // Time the segment was created
+       int32_t               pid;       // Process id of the server
+       char                  pgm[20];   // Program name
+       char                  ins[32];   // Instance name
+      };
+
+struct DirEnt
+      {char                  name[56];  // Null terminated counter name
+       uint32_t              type;      // CtrType
+       uint32_t              rsvd;
+      };
+
+// Add() adds n to a counter (a negative n lowers a gauge).
+//
+static void Add(int ctr, long long n=1)
+               {if ((unsigned int)ctr < (unsigned int)CtrMax())
+                   Lane()[ctr].fetch_add(n, std::memory_order_relaxed);
+               }
+
+// noCtr is returned by Define() when the segment is full. It stays an invalid
+//       id after adding the offset of any counter in a group, so that Add()
+//       and Set() simply ignore it.
+//
+static const int noCtr = -0x40000000;
+
+// Define() returns the id of the named counter, defining it if need be.
+//
+static int  Define(const char *name, CtrType ctype=isCounter);
+
+// Define() defines num counters named <pfx>.<name[i]> whose ids are
+//          consecutive and returns the id of the first one.
+//
+static int  Define(const char *pfx, const char *const *names, int num,
+                   CtrType ctype=isCounter);
+
+// Init() creates the segment at path holding up to ctrMax counters.
+//
+static bool Init(XrdSysError *eP, const char *path, int ctrMax,
+                 const char *pgm, const char *ins);
+
+// Set() sets a gauge that is only ever set, never added to.
+//
+static void Set(int ctr, long long val)
+               {if ((unsigned int)ctr < (unsigned int)CtrMax())
+                   valBase[ctr].store(val, std::memory_order_relaxed);
+               }
+
+private:
+
+static int  CtrMax() {return maxCtr.load(std::memory_order_acquire);}
+
+static std::atomic<long long> *Lane()
+               {if (myLane < 0) myLane = nextLane++ % nLanes;
+                return valBase + myLane*laneCtrs;
+               }
+
+static int  Find(const char *name);
+static int  Make(const char *name, CtrType ctype);
+
+static const int maxPend = 256;      // Counters defined before Init()
+
+static thread_local int        myLane;
+static std::atomic<int>        nextLane;
+static std::atomic<long long> *valBase;
+static std::atomic<int>        maxCtr;   // Zero until the segment exists
+static int                     laneCtrs; // Values in each lane
+static Head                   *shmHead;
+static DirEnt                 *shmDir;
+static DirEnt                  pendDir[maxPend];
+static int                     numDef;
+};
+#endif
@@ -94,6 +94,19 @@ if( NOT XRDCL_ONLY )
     XrdCl
     XrdUtils )
 
+  #-------------------------------------------------------------------------------
+  # xrdcmsbench
+  #-------------------------------------------------------------------------------
+  add_executable(
+    xrdcmsbench
+    XrdApps/XrdCmsBench.cc )
+
+  target_link_libraries(
+    xrdcmsbench
+    XrdCl
+    XrdUtils
+    pthread )
+
   #-------------------------------------------------------------------------------
   # xrdqstats
   #-------------------------------------------------------------------------------
@@ -108,6 +121,31 @@ if( NOT XRDCL_ONLY )
     XrdUtils
     ${EXTRA_LIBS} )
 
+  #-------------------------------------------------------------------------------
+  # xrdshmstats
+  #-------------------------------------------------------------------------------
+  add_executable(
+    xrdshmstats
+    XrdApps/XrdShmStats.cc )
+
+  target_link_libraries(
+    xrdshmstats
+    XrdUtils )
+
+  #-------------------------------------------------------------------------------
+  # xrdreplay
+  #-------------------------------------------------------------------------------
+  add_executable(
+    xrdreplay
+    XrdApps/XrdReplay.cc )
+
+  target_link_libraries(
+    xrdreplay
+    XrdCl
+    XrdUtils
+    ${ZLIB_LIBRARY}
+    pthread )
+
   #-------------------------------------------------------------------------------
   # xrdCp
   #-------------------------------------------------------------------------------
@@ -176,6 +214,7 @@ install(
 if( NOT XRDCL_ONLY )
   install(
     TARGETS xrdacctest xrdadler32 xrdcp-old cconfig mpxstats wait41 xrdmapc
+            xrdshmstats xrdreplay
     LIBRARY DESTINATION ${CMAKE_INSTALL_LIBDIR}
     RUNTIME DESTINATION ${CMAKE_INSTALL_BINDIR} )
 endif()
@@ -0,0 +1,347 @@
+/******************************************************************************/
+/*                                                                            */
+/*                        X r d C m s B e n c h . c c                         */
+/*                                                                            */
+/* This file is part of the XRootD software suite.                            */
+/*                                                                            */
+/* XRootD is free software: you can redistribute it and/or modify it under    */
+/* the terms of the GNU Lesser General Public License as published by the     */
+/* Free Software Foundation, either version 3 of the License, or (at your     */
+/* option) any later version.                                                 */
+/*                                                                            */
+/* XRootD is distributed in the hope that it will be useful, but WITHOUT      */
+/* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or      */
+/* FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public       */
+/* License for more details.                                                  */
+/*                                                                            */
+/* You should have received a copy of the GNU Lesser General Public License   */
+/* along with XRootD in a file called COPYING.LESSER (LGPL license) and file  */
+/* COPYING (GPL license).  If not, see <http://www.gnu.org/licenses/>.        */
+/*                                                                            */
+/* The copyright holder's institutional names and contributor's names may not */
+/* be used to endorse or promote products derived from this software without  */
+/* specific prior written permission of the institution or contributor.       */
+/******************************************************************************/
+
+/* This utility replays recorded locate/open traffic against a redirector at a
+   fixed request rate and reports the latency distribution seen by the client
+   for each kind of request. Syntax:
+
+   xrdcmsbench [-c <maxout>] [-d <sec>] [-r <rate>] <host>:<port> <trace>
+
+   The trace file holds one request per line: "[locate|read|write] <path>". A
+   line with only a path is a locate. Blank lines and lines starting with '#'
+   are ignored. The trace is replayed in a loop until the duration expires.
+   Note that read and write requests are real opens (the file is immediately
+   closed) and so include the time taken by the data server.
+*/
+
+/******************************************************************************/
+/*                         i n c l u d e   f i l e s                          */
+/******************************************************************************/
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "XrdCl/XrdClFile.hh"
+#include "XrdCl/XrdClFileSystem.hh"
+#include "XrdCl/XrdClURL.hh"
+#include "XrdCl/XrdClXRootDResponses.hh"
+#include "XrdSys/XrdSysPthread.hh"
+
+using namespace std;
+
+/******************************************************************************/
+/*                     L o c a l   D e f i n i t i o n s                      */
+/******************************************************************************/
+
+#define EMSG(x) cerr <<"xrdcmsbench: " <<x <<endl
+
+namespace
+{
+enum ReqType {rtLocate = 0, rtRead, rtWrite, rtNum};
+
+const char *ReqName[rtNum] = {"locate", "read", "write"};
+
+struct TraceReq
+      {ReqType     type;
+       std::string path;
+      };
+
+// Latencies (in microseconds) and error counts per request type
+//
+struct ReqStats
+      {std::vector<long> lat;
+       long long         errs;
+       ReqStats() : errs(0) {}
+      };
+
+XrdSysCondVar bCond(0);
+ReqStats      bStats[rtNum];
+int           bOut = 0;
+
+/******************************************************************************/
+/*                                   N o w                                    */
+/******************************************************************************/
+
+long long Now()
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return static_cast<long long>(ts.tv_sec)*1000000 + ts.tv_nsec/1000;
+}
+
+/******************************************************************************/
+/*                                R e c o r d                                 */
+/******************************************************************************/
+
+// Record the outcome of a request and, if done, release its slot
+
+void Record(ReqType rType, long long tStart, bool isOK, bool isDone)
+{
+   long lat = static_cast<long>(Now() - tStart);
+
+   bCond.Lock();
+   if (tStart)
+      {if (isOK) bStats[rType].lat.push_back(lat);
+          else   bStats[rType].errs++;
+      }
+   if (isDone) {bOut--; bCond.Signal();}
+   bCond.UnLock();
+}
+
+/******************************************************************************/
+/*                       R e s p o n s e   H a n d l e r                      */
+/******************************************************************************/
+
+class BenchHandler : public XrdCl::ResponseHandler
+{
+public:
+
+virtual void HandleResponse(XrdCl::XRootDStatus *status,
+                            XrdCl::AnyObject    *response)
+            {bool isOK = status->IsOK();
+             delete status;
+             delete response;
+
+             // The close of an opened file is not timed but the request
+             // keeps its slot until the file is closed.
+             //
+             if (closing) {Record(rType, 0, isOK, true); delete this; return;}
+             if (fileP && isOK)
+                {Record(rType, tStart, true, false);
+                 closing = true;
+                 if (fileP->Close(this).IsOK()) return;
+                 Record(rType, 0, false, true);
+                } else Record(rType, tStart, isOK, true);
+             delete this;
+            }
+
+             BenchHandler(ReqType rt, XrdCl::File *fP=0)
+                         : fileP(fP), tStart(Now()), rType(rt),
+                           closing(false) {}
+
+virtual     ~BenchHandler() {delete fileP;}
+
+XrdCl::File *fileP;
+long long    tStart;
+ReqType      rType;
+bool         closing;
+};
+
+/******************************************************************************/
+/*                                I s s u e                                   */
+/******************************************************************************/
+
+bool Issue(XrdCl::FileSystem &fs, const std::string &url, const TraceReq &req)
+{
+   BenchHandler *hP;
+   XrdCl::XRootDStatus st;
+
+   if (req.type == rtLocate)
+      {hP = new BenchHandler(rtLocate);
+       st = fs.Locate(req.path, XrdCl::OpenFlags::None, hP);
+      } else {
+       XrdCl::OpenFlags::Flags oFlags = (req.type == rtRead
+                                      ?  XrdCl::OpenFlags::Read
+                                      :  XrdCl::OpenFlags::Update);
+       hP = new BenchHandler(req.type, new XrdCl::File());
+       st = hP->fileP->Open(url + "/" + req.path, oFlags,
+                            XrdCl::Access::None, hP);
+      }
+
+   if (!st.IsOK())
+      {delete hP;
+       return false;
+      }
+   return true;
+}
+
+/******************************************************************************/
+/*                             R e a d T r a c e                              */
+/******************************************************************************/
+
+bool ReadTrace(const char *fn, std::vector<TraceReq> &trace)
+{
+   FILE *fp = fopen(fn, "r");
+   char line[4096], w1[4096], w2[4096];
+   TraceReq req;
+   int n;
+
+   if (!fp) {EMSG("Unable to open " <<fn <<"; " <<strerror(errno)); return false;}
+
+   while(fgets(line, sizeof(line), fp))
+        {if ((n = sscanf(line, "%4095s %4095s", w1, w2)) <= 0 || *w1 == '#')
+            continue;
+         if (n == 1) {req.type = rtLocate; req.path = w1;}
+            else {     if (!strcmp(w1, "locate")) req.type = rtLocate;
+                  else if (!strcmp(w1, "read"))   req.type = rtRead;
+                  else if (!strcmp(w1, "write"))  req.type = rtWrite;
+                  else {EMSG("Invalid request type '" <<w1 <<"' in " <<fn);
+                        fclose(fp);
+                        return false;
+                       }
+                  req.path = w2;
+                 }
+         trace.push_back(req);
+        }
+
+   fclose(fp);
+   if (trace.empty()) {EMSG("No requests found in " <<fn); return false;}
+   return true;
+}
+
+/******************************************************************************/
+/*                                R e p o r t                                 */
+/******************************************************************************/
+
+void Report(double elapsed, long long issued, long long failed, long long late)
+{
+   char buff[256];
+
+   cout <<"Issued " <<issued <<" requests in " <<elapsed <<" seconds ("
+        <<static_cast<long long>(issued/elapsed) <<"/s); "
+        <<failed <<" could not be sent, " <<late <<" were sent late." <<endl;
+
+   snprintf(buff, sizeof(buff), "%-7s %10s %8s %10s %9s %9s %9s %9s %9s",
+            "request", "count", "errors", "rate/s", "avg ms", "p50 ms",
+            "p95 ms", "p99 ms", "max ms");
+   cout <<buff <<endl;
+
+   for (int i = 0; i < rtNum; i++)
+       {std::vector<long> &lat = bStats[i].lat;
+        size_t n = lat.size();
+        double avg = 0;
+        if (!n && !bStats[i].errs) continue;
+        std::sort(lat.begin(), lat.end());
+        for (size_t j = 0; j < n; j++) avg += lat[j];
+        if (n) avg /= n;
+#define PCT(p) (n ? lat[std::min(n-1, (size_t)(n*(p)/100))]/1000.0 : 0.0)
+        snprintf(buff, sizeof(buff),
+                 "%-7s %10lu %8lld %10.0f %9.3f %9.3f %9.3f %9.3f %9.3f",
+                 ReqName[i], (unsigned long)n, bStats[i].errs, n/elapsed,
+                 avg/1000.0, PCT(50), PCT(95), PCT(99), PCT(100));
+#undef PCT
+        cout <<buff <<endl;
+       }
+}
+
+/******************************************************************************/
+/*                                 U s a g e                                  */
+/******************************************************************************/
+
+void Usage(int rc)
+{
+   cerr <<"\nUsage: xrdcmsbench [opts] <host>:<port> <trace>\n"
+          "\nopts: -c <maxout> -d <sec> -h -r <rate>\n"
+          "\n-c maximum number of outstanding requests, default 1000."
+          "\n-d number of seconds to run, default 30."
+          "\n-r number of requests per second to issue, default 1000.\n"
+          "\ntrace: file with one '[locate|read|write] <path>' per line."
+          <<endl;
+   exit(rc);
+}
+}
+
+/******************************************************************************/
+/*                                  m a i n                                   */
+/******************************************************************************/
+
+int main(int argc, char *argv[])
+{
+   extern char *optarg;
+   extern int optind;
+   std::vector<TraceReq> trace;
+   long long tStart, tEnd, tNext, tNow, interval;
+   long long issued = 0, failed = 0, late = 0;
+   int c, maxOut = 1000, duration = 30, rate = 1000;
+
+// Process the options
+//
+   while((c = getopt(argc, argv, "c:d:hr:")) != -1)
+        {switch(c)
+               {case 'c': if ((maxOut = atoi(optarg)) <= 0)
+                             {EMSG("Invalid maxout - " <<optarg); Usage(1);}
+                          break;
+                case 'd': if ((duration = atoi(optarg)) <= 0)
+                             {EMSG("Invalid duration - " <<optarg); Usage(1);}
+                          break;
+                case 'h': Usage(0);
+                          break;
+                case 'r': if ((rate = atoi(optarg)) <= 0)
+                             {EMSG("Invalid rate - " <<optarg); Usage(1);}
+                          break;
+                default:  Usage(1);
+               }
+        }
+
+   if (optind + 2 != argc) {EMSG("Host and trace file not specified."); Usage(1);}
+   if (!ReadTrace(argv[optind+1], trace)) exit(2);
+
+// Establish the redirector we will be talking to
+//
+   std::string url = std::string("root://") + argv[optind];
+   XrdCl::URL xURL(url);
+   if (!xURL.IsValid()) {EMSG("Invalid host - " <<argv[optind]); exit(1);}
+   XrdCl::FileSystem fs(xURL);
+
+// Issue the requests at the wanted rate. When we fall behind we send the
+// requests right away (and count them as late) to catch up.
+//
+   interval = 1000000 / rate;
+   tStart = tNext = Now();
+   tEnd = tStart + static_cast<long long>(duration) * 1000000;
+   for (size_t i = 0; (tNow = Now()) < tEnd; i = (i + 1) % trace.size())
+       {if (tNow < tNext) {usleep(static_cast<useconds_t>(tNext - tNow));}
+           else if (tNow - tNext > interval) late++;
+        tNext += interval;
+        bCond.Lock();
+        while(bOut >= maxOut) bCond.Wait();
+        bOut++;
+        bCond.UnLock();
+        if (Issue(fs, url, trace[i])) issued++;
+           else {failed++;
+                 bCond.Lock(); bOut--; bCond.UnLock();
+                }
+       }
+
+// Wait for outstanding requests to complete
+//
+   double elapsed = (Now() - tStart) / 1000000.0;
+   bCond.Lock();
+   while(bOut > 0) bCond.Wait();
+   bCond.UnLock();
+
+// Report the results
+//
+   Report(elapsed, issued, failed, late);
+   return 0;
+}
@@ -0,0 +1,924 @@
+/******************************************************************************/
+/*                                                                            */
+/*                          X r d R e p l a y . c c                           */
+/*                                                                            */
+/* This file is part of the XRootD software suite.                            */
+/*                                                                            */
+/* XRootD is free software: you can redistribute it and/or modify it under    */
+/* the terms of the GNU Lesser General Public License as published by the     */
+/* Free Software Foundation, either version 3 of the License, or (at your     */
+/* option) any later version.                                                 */
+/*                                                                            */
+/* XRootD is distributed in the hope that it will be useful, but WITHOUT      */
+/* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or      */
+/* FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public       */
+/* License for more details.                                                  */
+/*                                                                            */
+/* You should have received a copy of the GNU Lesser General Public License   */
+/* along with XRootD in a file called COPYING.LESSER (LGPL license) and file  */
+/* COPYING (GPL license).  If not, see <http://www.gnu.org/licenses/>.        */
+/*                                                                            */
+/* The copyright holder's institutional names and contributor's names may not */
+/* be used to endorse or promote products derived from this software without  */
+/* specific prior written permission of the institution or contributor.       */
+/******************************************************************************/
+
+#include <algorithm>
+#include <atomic>
+#include <errno.h>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <string.h>
+#include <thread>
+#include <time.h>
+#include <unistd.h>
+#include <unordered_map>
+#include <vector>
+#include <zlib.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+
+#include "XrdCl/XrdClFile.hh"
+#include "XrdCl/XrdClURL.hh"
+#include "XrdSys/XrdSysPlatform.hh"
+#include "XrdXrootd/XrdXrootdMonData.hh"
+
+using namespace std;
+
+// xrdreplay turns captured monitoring packets into a workload and replays it
+// against a server. The capture is a file of raw monitoring packets, one after
+// the other as they were received (xrdreplay -l records one). The following
+// packets are used, all others are ignored:
+//
+// 'd'     path mapping: gives the path and user of each file dictid
+// 't'     trace: opens, closes, reads, writes and readv's (with segments
+//         when "iov" monitoring was on) bracketed by time window marks
+// 'f','z' file stream: opens (with the path when "lfn" was on) and closes
+//         with the per file byte and request counts
+//
+// Files whose I/O was traced are replayed request by request. Files that only
+// appear in the file stream are replayed approximately: the number of reads,
+// readv's and writes of the average size recorded at close are issued
+// sequentially and evenly spread between the open and the close.
+//
+// Each file is replayed by one of a number of workers at the time it was
+// opened, scaled by the speed factor, using one of a number of connections
+// chosen by the original user. Files opened for writing are only replayed as
+// such with -w and then one writer at a time, as the server requires. The
+// latency of each kind of request and how late requests were issued relative
+// to the schedule are reported.
+
+/******************************************************************************/
+/*                          U n i t   G l o b a l s                           */
+/******************************************************************************/
+
+namespace
+{
+   const char   *MeMe     = "xrdreplay: ";
+   std::string   baseURL;
+   const char   *pathPfx  = "";     // -p
+   int           pathStrip= 0;      // -x
+   double        Speed    = 1.0;    // -s (0 is as fast as possible)
+   int           numWork  = 64;     // -c
+   int           numConn  = 16;     // -n
+   bool          makeFiles= false;  // -m
+   bool          doWrites = false;  // -w
+   bool          Verbose  = false;  // -v
+}
+
+#define SAY(x)  cerr <<MeMe <<x <<endl
+#define FMSG(x) {cerr <<MeMe <<x <<endl; exit(2);}
+
+/******************************************************************************/
+/*                         L o c a l   C l a s s e s                          */
+/******************************************************************************/
+
+// A request to replay. Readv segments are kept in the job's segment list.
+//
+struct ReqOp
+      {enum OpType {opRead = 0, opReadV, opWrite, opOpen, opClose, opNum};
+       double    tm;      // Trace time of the request
+       long long offset;  // Read/write offset or first segment for readv
+       int       len;     // Bytes or number of segments for readv
+       char      type;
+      };
+
+struct ReplayJob
+      {std::string               path;
+       std::string               user;
+       std::vector<ReqOp>        ops;
+       std::vector<std::pair<long long, int> > segs;
+       double                    tOpen;
+       double                    tClose;
+       long long                 fSize;
+       long long                 rTot, rvTot, wTot;      // From the close
+       int                       rNum, rvNum, rsNum, wNum;
+       long long                 rvNext;   // Offset of synthesized segments
+       size_t                    rvOp;     // Readv awaiting its segments
+       int                       rvLeft;   // Number of segments it awaits
+       std::mutex               *wLock;    // Serializes writers of the path
+       bool                      isRW;
+       bool                      hasXfr;   // The f-stream close was seen
+       bool                      approx;   // Requests were synthesized
+
+       long long Extent() const
+                {long long ext = fSize;
+                 for (size_t i = 0; i < ops.size(); i++)
+                     if (ops[i].type != ReqOp::opReadV
+                     &&  ops[i].offset + ops[i].len > ext)
+                        ext = ops[i].offset + ops[i].len;
+                 for (size_t i = 0; i < segs.size(); i++)
+                     if (segs[i].first + segs[i].second > ext)
+                        ext = segs[i].first + segs[i].second;
+                 return ext;
+                }
+
+       ReplayJob() : tOpen(-1), tClose(-1), fSize(0), rTot(0), rvTot(0),
+                     wTot(0), rNum(0), rvNum(0), rsNum(0), wNum(0),
+                     rvNext(0), rvOp(0), rvLeft(0), wLock(0), isRW(false), hasXfr(false), approx(false) {}
+      };
+
+// What the replay measured for each request type
+//
+struct ReplayStats
+      {std::vector<unsigned int> lat[ReqOp::opNum];   // Microseconds
+       long long                 bytes[ReqOp::opNum];
+       long long                 errs[ReqOp::opNum];
+       std::vector<unsigned int> late;                // Milliseconds
+       ReplayStats() {memset(bytes, 0, sizeof(bytes));
+                      memset(errs,  0, sizeof(errs));
+                     }
+      };
+
+// The trace being built. Dictionary ids are unique within a server instance,
+// which is identified by its start time, so both form the key.
+//
+class TraceDB
+{
+public:
+
+std::unordered_map<unsigned long long, std::string> pathMap;
+std::unordered_map<unsigned long long, ReplayJob*>  jobMap;
+long long numPkt, numBad, numIgn;
+
+ReplayJob *Job(kXR_int32 stod, kXR_unt32 dictid)
+              {ReplayJob *&jP = jobMap[Key(stod, dictid)];
+               if (!jP) jP = new ReplayJob;
+               return jP;
+              }
+
+static unsigned long long Key(kXR_int32 stod, kXR_unt32 dictid)
+              {return ((unsigned long long)(unsigned int)stod << 32) | dictid;}
+
+       TraceDB() : numPkt(0), numBad(0), numIgn(0) {}
+};
+
+TraceDB theDB;
+
+/******************************************************************************/
+/*                                   N o w                                    */
+/******************************************************************************/
+
+inline double Now()
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec + ts.tv_nsec/1e9;
+}
+
+/******************************************************************************/
+/*                               D o F S t r                                  */
+/******************************************************************************/
+
+// Process the records of an f-stream packet whose header has been removed.
+
+void DoFStr(kXR_int32 stod, const char *bP, int bLen)
+{
+   const XrdXrootdMonFileTOD *todP = (const XrdXrootdMonFileTOD *)bP;
+   const XrdXrootdMonFileHdr *hP;
+   double tBeg, tEnd, tNow;
+   int recSize, nRecs = 0, n = 0, off;
+
+// The time record comes first and gives the window
+//
+   if (bLen < (int)sizeof(XrdXrootdMonFileTOD)
+   ||  todP->Hdr.recType != XrdXrootdMonFileHdr::isTime)
+      {theDB.numBad++; return;}
+   tBeg = (int)ntohl(todP->tBeg);
+   tEnd = (int)ntohl(todP->tEnd);
+
+// Count the records so that we can spread them over the window
+//
+   for (off = sizeof(XrdXrootdMonFileTOD); off + 8 <= bLen; off += recSize)
+       {hP = (const XrdXrootdMonFileHdr *)(bP + off);
+        if ((recSize = ntohs(hP->recSize)) < 8) break;
+        nRecs++;
+       }
+
+// Process each record
+//
+   for (off = sizeof(XrdXrootdMonFileTOD); off + 8 <= bLen; off += recSize)
+       {hP = (const XrdXrootdMonFileHdr *)(bP + off);
+        if ((recSize = ntohs(hP->recSize)) < 8 || off + recSize > bLen) break;
+        tNow = tBeg + (tEnd - tBeg) * ++n / (nRecs + 1);
+        switch(hP->recType)
+              {case XrdXrootdMonFileHdr::isOpen:
+                    {const XrdXrootdMonFileOPN *oP =
+                           (const XrdXrootdMonFileOPN *)hP;
+                     ReplayJob *jP = theDB.Job(stod, hP->fileID);
+                     if (jP->tOpen < 0) jP->tOpen = tNow;
+                     jP->fSize = ntohll(oP->fsz);
+                     jP->isRW  = (hP->recFlag & XrdXrootdMonFileHdr::hasRW);
+                     if (hP->recFlag & XrdXrootdMonFileHdr::hasLFN)
+                        {int lMax = recSize - (sizeof(XrdXrootdMonFileOPN)
+                                  - sizeof(XrdXrootdMonFileLFN)) - 4;
+                         if (lMax > 0 && jP->path.empty())
+                            jP->path.assign(oP->ufn.lfn,
+                                            strnlen(oP->ufn.lfn, lMax));
+                         if (jP->user.empty())
+                            {char ubuff[16];
+                             snprintf(ubuff, sizeof(ubuff), "u%u",
+                                      oP->ufn.user);
+                             jP->user = ubuff;
+                            }
+                        }
+                    }
+                    break;
+               case XrdXrootdMonFileHdr::isClose:
+                    {const XrdXrootdMonFileCLS *cP =
+                           (const XrdXrootdMonFileCLS *)hP;
+                     ReplayJob *jP = theDB.Job(stod, hP->fileID);
+                     if (jP->tClose < 0) jP->tClose = tNow;
+                     jP->hasXfr = true;
+                     jP->rTot   = ntohll(cP->Xfr.read);
+                     jP->rvTot  = ntohll(cP->Xfr.readv);
+                     jP->wTot   = ntohll(cP->Xfr.write);
+                     if (hP->recFlag & XrdXrootdMonFileHdr::hasOPS)
+                        {jP->rNum  = ntohl(cP->Ops.read);
+                         jP->rvNum = ntohl(cP->Ops.readv);
+                         jP->rsNum = ntohll(cP->Ops.rsegs);
+                         jP->wNum  = ntohl(cP->Ops.write);
+                        }
+                    }
+                    break;
+               default: break;
+              }
+       }
+}
+
+/******************************************************************************/
+/*                                D o T S t r                                 */
+/******************************************************************************/
+
+// Process the entries of a trace packet whose header has been removed.
+
+void DoTStr(kXR_int32 stod, const char *bP, int bLen)
+{
+   const XrdXrootdMonTrace *tP = (const XrdXrootdMonTrace *)bP;
+   int nEnt = bLen / sizeof(XrdXrootdMonTrace);
+   std::vector<double> eTime(nEnt, 0.0);
+   std::vector<int> pend;
+   double tStart = 0;
+   kXR_char code;
+
+// Entries carry no time; they fall within the window started by the previous
+// window mark and ended by the next one. Spread them evenly over it.
+//
+   for (int i = 0; i < nEnt; i++)
+       {if (tP[i].arg0.id[0] == XROOTD_MON_WINDOW)
+           {double tEnd = (int)ntohl(tP[i].arg1.Window);
+            for (size_t k = 0; k < pend.size(); k++)
+                eTime[pend[k]] = tStart + (tEnd-tStart)*(k+1)/(pend.size()+1);
+            pend.clear();
+            tStart = (int)ntohl(tP[i].arg2.Window);
+           } else pend.push_back(i);
+       }
+   for (size_t k = 0; k < pend.size(); k++) eTime[pend[k]] = tStart;
+
+// Now process each entry
+//
+   for (int i = 0; i < nEnt; i++)
+       {code = tP[i].arg0.id[0];
+        if (code < XROOTD_MON_OPEN)
+           {ReplayJob *jP = theDB.Job(stod, tP[i].arg2.dictid);
+            ReqOp op;
+            int blen = (int)ntohl(tP[i].arg1.buflen);
+            op.tm     = eTime[i];
+            op.offset = ntohll(tP[i].arg0.val);
+            if (jP->rvLeft > 0 && blen >= 0)
+               {jP->segs.push_back(std::make_pair(op.offset, blen));
+                jP->ops[jP->rvOp].len++; jP->rvLeft--;
+                continue;
+               }
+            if (blen >= 0) {op.type = ReqOp::opRead;  op.len =  blen;}
+               else        {op.type = ReqOp::opWrite; op.len = -blen;
+                            jP->isRW = true; // Trace opens carry no r/w flag
+                           }
+            jP->ops.push_back(op);
+            continue;
+           }
+        switch(code)
+              {case XROOTD_MON_OPEN:
+                    {ReplayJob *jP = theDB.Job(stod, tP[i].arg2.dictid);
+                     jP->tOpen = eTime[i];
+                     jP->fSize = ntohll(tP[i].arg0.val) & 0x00ffffffffffffffLL;
+                    }
+                    break;
+               case XROOTD_MON_CLOSE:
+                    theDB.Job(stod, tP[i].arg2.dictid)->tClose = eTime[i];
+                    break;
+               case XROOTD_MON_READV:
+               case XROOTD_MON_READU:
+                    {ReplayJob *jP = theDB.Job(stod, tP[i].arg2.dictid);
+                     ReqOp op;
+                     int nSeg = ntohs(tP[i].arg0.sVal[1]);
+                     int blen = (int)ntohl(tP[i].arg1.buflen);
+                     op.tm     = eTime[i];
+                     op.type   = ReqOp::opReadV;
+                     op.offset = jP->segs.size();
+                     op.len    = 0;
+                     if (nSeg <= 0) break;
+
+                    // When readv's are traced in detail the segments follow,
+                    // possibly in the next packet. Otherwise, we only know the
+                    // size and use equal segments that read the file in order.
+                    //
+                     if (code == XROOTD_MON_READU)
+                        {jP->rvOp = jP->ops.size(); jP->rvLeft = nSeg;}
+                        else {int slen = (blen + nSeg - 1) / nSeg;
+                              for (int k = 0; k < nSeg; k++)
+                                  {if (jP->fSize && jP->rvNext + slen
+                                                  > jP->fSize) jP->rvNext = 0;
+                                   jP->segs.push_back(std::make_pair(
+                                                      jP->rvNext, slen));
+                                   jP->rvNext += slen;
+                                  }
+                              op.len = nSeg;
+                              jP->approx = true;
+                             }
+                     jP->ops.push_back(op);
+                    }
+                    break;
+               default: break;
+              }
+       }
+}
+
+/******************************************************************************/
+/*                                  L o a d                                   */
+/******************************************************************************/
+
+void Load(const char *fn)
+{
+   static const int hdrLen = sizeof(XrdXrootdMonHeader);
+   std::vector<char> ubuff;
+   XrdXrootdMonHeader hdr;
+   FILE *fP;
+   char buff[65536];
+   int plen;
+
+   if (!(fP = fopen(fn, "r")))
+      FMSG("Unable to open " <<fn <<"; " <<strerror(errno));
+
+// Run through each packet
+//
+   while(fread(&hdr, hdrLen, 1, fP) == 1)
+        {plen = ntohs(hdr.plen);
+         if (plen < hdrLen
+         || (plen > hdrLen && fread(buff, plen - hdrLen, 1, fP) != 1))
+            {theDB.numBad++; break;}
+         theDB.numPkt++;
+         plen -= hdrLen;
+         switch(hdr.code)
+               {case XROOTD_MON_MAPPATH:
+                     if (plen > (int)sizeof(kXR_unt32))
+                        {kXR_unt32 dictid;
+                         memcpy(&dictid, buff, sizeof(dictid));
+                         theDB.pathMap[TraceDB::Key(hdr.stod, dictid)] =
+                               std::string(buff + sizeof(dictid),
+                                           plen - sizeof(dictid));
+                        }
+                     break;
+                case XROOTD_MON_MAPTRCE:
+                     DoTStr(hdr.stod, buff, plen);
+                     break;
+                case XROOTD_MON_MAPFSTA:
+                     DoFStr(hdr.stod, buff, plen);
+                     break;
+                case XROOTD_MON_MAPZFST:
+                     {kXR_unt32 ulen;
+                      uLongf dlen;
+                      if (plen <= (int)sizeof(ulen)) {theDB.numBad++; break;}
+                      memcpy(&ulen, buff, sizeof(ulen));
+                      dlen = ntohl(ulen);
+                      if (dlen <= (uLongf)hdrLen || dlen > 1024*1024)
+                         {theDB.numBad++; break;}
+                      ubuff.resize(dlen);
+                      if (uncompress((Bytef *)&ubuff[0], &dlen,
+                                     (const Bytef *)buff + sizeof(ulen),
+                                     plen - sizeof(ulen)) != Z_OK)
+                         {theDB.numBad++; break;}
+                      DoFStr(hdr.stod, &ubuff[hdrLen], dlen - hdrLen);
+                     }
+                     break;
+                default: theDB.numIgn++;
+                     break;
+               }
+        }
+   fclose(fP);
+}
+
+/******************************************************************************/
+/*                               F i n i s h                                  */
+/******************************************************************************/
+
+// Complete each job, returning the ones that can be replayed in start order.
+
+void Synth(ReplayJob &job, long long tot, int num, int segs, char type)
+{
+   double tBeg = job.tOpen, tEnd = (job.tClose > tBeg ? job.tClose : tBeg);
+   long long offset = 0, fsz = (job.fSize > 0 ? job.fSize : tot);
+   ReqOp op;
+   int blen;
+
+   if (tot <= 0) return;
+   if (num <= 0) num = (tot + 1048575) / 1048576;
+   blen = (int)((tot + num - 1) / num);
+   for (int i = 0; i < num; i++)
+       {op.tm = tBeg + (tEnd - tBeg) * (i+1) / (num+1);
+        op.type = type;
+        if (type == ReqOp::opReadV)
+           {int nseg = (segs > 0 ? (segs + num - 1)/num : 1);
+            int slen = (blen + nseg - 1) / nseg;
+            op.offset = job.segs.size(); op.len = nseg;
+            for (int k = 0; k < nseg; k++)
+                {if (offset + slen > fsz) offset = 0;
+                 job.segs.push_back(std::make_pair(offset, slen));
+                 offset += slen;
+                }
+           } else {
+            if (offset + blen > fsz) offset = 0;
+            op.offset = offset; op.len = blen;
+            offset += blen;
+           }
+        job.ops.push_back(op);
+       }
+   job.approx = true;
+}
+
+std::vector<ReplayJob *> Finish(int &nDrop)
+{
+   std::vector<ReplayJob *> jobs;
+   std::unordered_map<unsigned long long, ReplayJob *>::iterator it;
+
+   nDrop = 0;
+   for (it = theDB.jobMap.begin(); it != theDB.jobMap.end(); ++it)
+       {ReplayJob *jP = it->second;
+        std::unordered_map<unsigned long long,std::string>::iterator pit;
+
+       // The path map has the user and path, use it when we have it
+       //
+        if ((pit = theDB.pathMap.find(it->first)) != theDB.pathMap.end())
+           {size_t nl = pit->second.find('\n');
+            if (nl != std::string::npos)
+               {jP->user = pit->second.substr(0, nl);
+                jP->path = pit->second.substr(nl+1);
+               } else jP->path = pit->second;
+            jP->path.resize(strlen(jP->path.c_str()));
+           }
+
+       // We must know the path and when the file was used
+       //
+        if (jP->path.empty()) {nDrop++; delete jP; continue;}
+        std::sort(jP->ops.begin(), jP->ops.end(),
+                  [](const ReqOp &a, const ReqOp &b) {return a.tm < b.tm;});
+        if (jP->tOpen < 0)
+           jP->tOpen = (jP->ops.empty() ? jP->tClose : jP->ops[0].tm);
+        if (jP->tOpen < 0) {nDrop++; delete jP; continue;}
+
+       // Synthesize the requests of files that were not traced
+       //
+        if (jP->ops.empty() && jP->hasXfr)
+           {Synth(*jP, jP->rTot,  jP->rNum,  0,         ReqOp::opRead);
+            Synth(*jP, jP->rvTot, jP->rvNum, jP->rsNum, ReqOp::opReadV);
+            Synth(*jP, jP->wTot,  jP->wNum,  0,         ReqOp::opWrite);
+            std::sort(jP->ops.begin(), jP->ops.end(),
+                      [](const ReqOp &a, const ReqOp &b) {return a.tm < b.tm;});
+           }
+        jobs.push_back(jP);
+       }
+
+   std::sort(jobs.begin(), jobs.end(),
+             [](const ReplayJob *a, const ReplayJob *b)
+               {return a->tOpen < b->tOpen;});
+   return jobs;
+}
+
+/******************************************************************************/
+/*                               F i l e U R L                                */
+/******************************************************************************/
+
+std::string FilePath(const ReplayJob &job)
+{
+   const char *pP = job.path.c_str();
+
+// Strip off leading path components, as wanted
+//
+   for (int i = 0; i < pathStrip && *pP; i++)
+       {const char *sP = strchr(pP+1, '/');
+        pP = (sP ? sP : pP + strlen(pP));
+       }
+   return std::string("/") + pathPfx + (*pP == '/' ? "" : "/") + pP;
+}
+
+std::string FileURL(const ReplayJob &job, const std::string &path)
+{
+   std::string url(baseURL);
+   char ubuff[32];
+   int conn;
+
+// The original user selects the connection
+//
+   conn = std::hash<std::string>()(job.user) % numConn;
+   snprintf(ubuff, sizeof(ubuff), "replay%d@", conn);
+   url.insert(url.find("://")+3, ubuff);
+   return url + path;
+}
+
+/******************************************************************************/
+/*                                  M a k e                                   */
+/******************************************************************************/
+
+// Create the files the replay needs, as large as the trace requires.
+
+void Make(std::vector<ReplayJob *> &jobs)
+{
+   std::map<std::string, long long> fSize;
+   std::map<std::string, long long>::iterator it;
+   XrdCl::XRootDStatus st;
+
+   for (size_t i = 0; i < jobs.size(); i++)
+       {long long &sz = fSize[FilePath(*jobs[i])];
+        long long ext = jobs[i]->Extent();
+        if (ext > sz) sz = ext;
+       }
+
+   for (it = fSize.begin(); it != fSize.end(); ++it)
+       {XrdCl::File file;
+        std::string url = baseURL + it->first;
+        st = file.Open(url, XrdCl::OpenFlags::Delete
+                                | XrdCl::OpenFlags::MakePath,
+                                  XrdCl::Access::UR | XrdCl::Access::UW);
+        if (st.IsOK()) st = file.Truncate(it->second);
+        if (!st.IsOK()) SAY("Unable to create " <<url <<"; "
+                            <<st.ToStr());
+        st = file.Close();
+       }
+   SAY("Created " <<fSize.size() <<" files.");
+}
+
+/******************************************************************************/
+/*                                R e p l a y                                 */
+/******************************************************************************/
+
+// Wait until a trace time, returning how late we are in milliseconds.
+
+unsigned int WaitFor(double tTrace, double tBase, double rBase)
+{
+   double tWant, tNow;
+
+   if (Speed <= 0) return 0;
+   tWant = rBase + (tTrace - tBase) / Speed;
+   if ((tNow = Now()) < tWant)
+      {usleep((useconds_t)((tWant - tNow) * 1e6)); return 0;}
+   return (unsigned int)((tNow - tWant) * 1000);
+}
+
+void Replay(std::vector<ReplayJob *> *jobs, std::atomic<size_t> *next,
+            double tBase, double rBase, ReplayStats *rs)
+{
+   std::vector<char> buff;
+   std::vector<XrdCl::ChunkInfo> chunks;
+   XrdCl::XRootDStatus st;
+   size_t jNum;
+   double tBeg;
+   uint32_t bRead;
+
+   while((jNum = (*next)++) < jobs->size())
+        {ReplayJob &job = *(*jobs)[jNum];
+         XrdCl::File file;
+         bool rw = doWrites && (job.isRW || job.wTot);
+         std::string url = FileURL(job, FilePath(job));
+         std::unique_lock<std::mutex> wLock;
+
+        // Only one writer may have a file open; replay them one at a time
+        //
+         if (rw && job.wLock) wLock = std::unique_lock<std::mutex>(*job.wLock);
+
+        // Open the file at the time it was opened
+        //
+         rs->late.push_back(WaitFor(job.tOpen, tBase, rBase));
+         tBeg = Now();
+         st = file.Open(url, (rw ? XrdCl::OpenFlags::Update
+                                 : XrdCl::OpenFlags::Read));
+         rs->lat[ReqOp::opOpen].push_back((Now() - tBeg) * 1e6);
+         if (!st.IsOK())
+            {rs->errs[ReqOp::opOpen]++;
+             if (Verbose) SAY("Unable to open " <<url <<"; " <<st.ToStr());
+             continue;
+            }
+
+        // Issue each request at its time
+        //
+         for (size_t i = 0; i < job.ops.size(); i++)
+             {ReqOp &op = job.ops[i];
+              if ((op.type == ReqOp::opWrite && !rw)
+              ||  (op.type == ReqOp::opReadV && !op.len)) continue;
+              rs->late.push_back(WaitFor(op.tm, tBase, rBase));
+              switch(op.type)
+                    {case ReqOp::opRead:
+                          if ((int)buff.size() < op.len) buff.resize(op.len);
+                          tBeg = Now();
+                          st = file.Read(op.offset, op.len, &buff[0], bRead);
+                          if (st.IsOK()) rs->bytes[ReqOp::opRead] += bRead;
+                          break;
+                     case ReqOp::opWrite:
+                          if ((int)buff.size() < op.len) buff.resize(op.len);
+                          tBeg = Now();
+                          st = file.Write(op.offset, op.len, &buff[0]);
+                          if (st.IsOK()) rs->bytes[ReqOp::opWrite] += op.len;
+                          break;
+                     case ReqOp::opReadV:
+                          {XrdCl::VectorReadInfo *vrP = 0;
+                           size_t need = 0;
+                           for (int k = 0; k < op.len; k++)
+                               need += job.segs[op.offset+k].second;
+                           if (buff.size() < need) buff.resize(need);
+                           chunks.clear();
+                           char *bP = &buff[0];
+                           for (int k = 0; k < op.len; k++)
+                               {std::pair<long long,int> &sg =
+                                                     job.segs[op.offset+k];
+                                chunks.push_back(XrdCl::ChunkInfo(sg.first,
+                                                            sg.second, bP));
+                                bP += sg.second;
+                               }
+                           tBeg = Now();
+                           st = file.VectorRead(chunks, 0, vrP);
+                           if (st.IsOK()) rs->bytes[ReqOp::opReadV] +=
+                                                           vrP->GetSize();
+                           delete vrP;
+                          }
+                          break;
+                     default: continue;
+                    }
+              rs->lat[(int)op.type].push_back((Now() - tBeg) * 1e6);
+              if (!st.IsOK())
+                 {rs->errs[(int)op.type]++;
+                  if (Verbose) SAY("Request failed for " <<url <<"; "
+                                   <<st.ToStr());
+                 }
+             }
+
+        // Close it at the time it was closed
+        //
+         if (job.tClose >= job.tOpen) WaitFor(job.tClose, tBase, rBase);
+         tBeg = Now();
+         st = file.Close();
+         rs->lat[ReqOp::opClose].push_back((Now() - tBeg) * 1e6);
+         if (!st.IsOK()) rs->errs[ReqOp::opClose]++;
+        }
+}
+
+/******************************************************************************/
+/*                                R e p o r t                                 */
+/******************************************************************************/
+
+void Report(std::vector<unsigned int> &lat, const char *what, const char *unit,
+            long long errs, long long bytes, double secs)
+{
+   static const double pct[] = {50.0, 90.0, 99.0, 99.9};
+
+   if (lat.empty() && !errs) return;
+   std::sort(lat.begin(), lat.end());
+   printf("%-6s %9zu", what, lat.size());
+   if (bytes >= 0) printf(" %9.2f MB/s", bytes/secs/(1024*1024));
+      else printf("%15s", "");
+   if (!lat.empty())
+      {printf("  %s", unit);
+       for (int i = 0; i < 4; i++)
+           printf(" p%g=%u", pct[i],
+                  lat[std::min(lat.size()-1, size_t(lat.size()*pct[i]/100))]);
+       printf(" max=%u", lat.back());
+      }
+   if (errs) printf("  errors=%lld", errs);
+   printf("\n");
+}
+
+/******************************************************************************/
+/*                               C a p t u r e                                */
+/******************************************************************************/
+
+// Record the monitoring packets sent to a UDP port in a file until killed.
+
+void Capture(int port, const char *fn)
+{
+   struct sockaddr_in6 sa;
+   char buff[65536];
+   long long nPkt = 0;
+   FILE *fP;
+   int sFD, n;
+
+   memset(&sa, 0, sizeof(sa));
+   sa.sin6_family = AF_INET6;
+   sa.sin6_addr   = in6addr_any;
+   sa.sin6_port   = htons(port);
+   if ((sFD = socket(AF_INET6, SOCK_DGRAM, 0)) < 0
+   ||  bind(sFD, (struct sockaddr *)&sa, sizeof(sa)))
+      FMSG("Unable to bind to port " <<port <<"; " <<strerror(errno));
+   n = 4*1024*1024;
+   setsockopt(sFD, SOL_SOCKET, SO_RCVBUF, &n, sizeof(n));
+   if (!(fP = fopen(fn, "a")))
+      FMSG("Unable to open " <<fn <<"; " <<strerror(errno));
+
+   SAY("Recording packets sent to port " <<port <<" in " <<fn);
+   while(1)
+        {if ((n = recv(sFD, buff, sizeof(buff), 0)) < 0)
+            {if (errno == EINTR) continue;
+             FMSG("Unable to receive packet; " <<strerror(errno));
+            }
+         if (n < (int)sizeof(XrdXrootdMonHeader)
+         ||  ntohs(((XrdXrootdMonHeader *)buff)->plen) != n) continue;
+         if (fwrite(buff, n, 1, fP) != 1 || fflush(fP))
+            FMSG("Unable to write " <<fn <<"; " <<strerror(errno));
+         if (Verbose && !(++nPkt % 1000)) SAY(nPkt <<" packets recorded.");
+        }
+}
+
+/******************************************************************************/
+/*                                 U s a g e                                  */
+/******************************************************************************/
+
+void Usage(int rc)
+{
+   cerr <<"\nUsage: xrdreplay [opts] <url> <capture> [<capture> [...]]"
+          "\n       xrdreplay -l <port> <capture>\n"
+          "\nopts: -c <workers> -m -n <conns> -p <pfx> -s <speed> -v -w -x <n>\n"
+          "\n-c number of files that may be replayed at the same time "
+          "(default 64)."
+          "\n-l record the monitoring packets sent to the udp port in the "
+          "capture file."
+          "\n-m create the files (as sparse files) before replaying."
+          "\n-n number of connections to spread the original users over "
+          "(default 16)."
+          "\n-p prefix to add to each path."
+          "\n-s speed relative to the original (default 1); 0 replays as fast "
+          "as possible."
+          "\n-v display failed requests."
+          "\n-w also replay writes; otherwise files are opened read-only."
+          "\n-x number of leading path components to remove.\n"
+          "\nurl: the server to replay against, e.g. root://host:port"
+          <<endl;
+   exit(rc);
+}
+
+/******************************************************************************/
+/*                                  m a i n                                   */
+/******************************************************************************/
+
+int main(int argc, char *argv[])
+{
+   static const char *opName[] = {"read", "readv", "write", "open", "close"};
+   extern char *optarg;
+   extern int optind, opterr, optopt;
+   std::vector<ReplayJob *> jobs;
+   std::map<std::string, std::mutex *> wLocks;
+   std::vector<ReplayStats> rs;
+   std::vector<std::thread> tv;
+   std::atomic<size_t> next(0);
+   std::vector<unsigned int> late;
+   double rBeg, rEnd;
+   long long nOps = 0, nApprox = 0;
+   int lPort = 0, nDrop;
+   char c, *eP;
+
+// Process the options
+//
+   opterr = 0;
+   while ((c = getopt(argc,argv,":c:hl:mn:p:s:vwx:"))
+      && ((unsigned char)c != 0xff))
+     { switch(c)
+       {
+       case 'c': if ((numWork = atoi(optarg)) <= 0)
+                    {SAY("Invalid worker count - " <<optarg); Usage(1);}
+                 break;
+       case 'h': Usage(0);
+                 break;
+       case 'l': if ((lPort = atoi(optarg)) <= 0 || lPort > 65535)
+                    {SAY("Invalid port - " <<optarg); Usage(1);}
+                 break;
+       case 'm': makeFiles = true;
+                 break;
+       case 'n': if ((numConn = atoi(optarg)) <= 0)
+                    {SAY("Invalid connection count - " <<optarg); Usage(1);}
+                 break;
+       case 'p': pathPfx = optarg;
+                 while(*pathPfx == '/') pathPfx++;
+                 break;
+       case 's': Speed = strtod(optarg, &eP);
+                 if (*eP || Speed < 0) {SAY("Invalid speed - " <<optarg);
+                                        Usage(1);
+                                       }
+                 break;
+       case 'v': Verbose = true;
+                 break;
+       case 'w': doWrites = true;
+                 break;
+       case 'x': if ((pathStrip = atoi(optarg)) < 0)
+                    {SAY("Invalid strip count - " <<optarg); Usage(1);}
+                 break;
+       default:  cerr <<MeMe <<'-' <<char(optopt);
+                 if (c == ':') cerr <<" value not specified." <<endl;
+                    else cerr <<" option is invalid" <<endl;
+                 Usage(1);
+                 break;
+       }
+     }
+
+// Handle recording
+//
+   if (lPort)
+      {if (optind >= argc) {SAY("Capture file not specified."); Usage(1);}
+       Capture(lPort, argv[optind]);
+       return 0;
+      }
+
+// Get the server and the captures
+//
+   if (optind + 1 >= argc) {SAY("Server or capture not specified."); Usage(1);}
+   XrdCl::URL url(argv[optind]);
+   if (!url.IsValid()) {SAY("Invalid url - " <<argv[optind]); Usage(1);}
+   baseURL = url.GetProtocol() + "://" + url.GetHostId() + "/";
+   for (int i = optind+1; i < argc; i++) Load(argv[i]);
+
+// Build the workload
+//
+   jobs = Finish(nDrop);
+   for (size_t i = 0; i < jobs.size(); i++)
+       {nOps += jobs[i]->ops.size();
+        if (jobs[i]->approx) nApprox++;
+        if (jobs[i]->isRW || jobs[i]->wTot)
+           {std::mutex *&mP = wLocks[FilePath(*jobs[i])];
+            if (!mP) mP = new std::mutex;
+            jobs[i]->wLock = mP;
+           }
+       }
+   printf("xrdreplay: %lld packets (%lld ignored, %lld bad); %zu files "
+          "(%lld approximated, %d without path or time); %lld requests\n",
+          theDB.numPkt, theDB.numIgn, theDB.numBad, jobs.size(), nApprox,
+          nDrop, nOps);
+   if (jobs.empty()) return 1;
+   printf("xrdreplay: trace spans %.0f seconds; replaying ",
+          jobs.back()->tOpen - jobs.front()->tOpen);
+   if (Speed > 0) printf("at x%g", Speed);
+      else printf("as fast as possible");
+   printf(" with %d workers\n", numWork);
+   fflush(stdout);
+   if (makeFiles) Make(jobs);
+
+// Replay
+//
+   signal(SIGPIPE, SIG_IGN);
+   rs.resize(numWork);
+   rBeg = Now();
+   for (int i = 0; i < numWork; i++)
+       tv.push_back(std::thread(Replay, &jobs, &next, jobs.front()->tOpen,
+                                rBeg, &rs[i]));
+   for (int i = 0; i < numWork; i++) tv[i].join();
+   rEnd = Now();
+
+// Merge and report the results
+//
+   printf("xrdreplay: replay took %.1f seconds\n", rEnd - rBeg);
+   for (int t = 0; t < ReqOp::opNum; t++)
+       {std::vector<unsigned int> lat;
+        long long errs = 0, bytes = 0;
+        for (int i = 0; i < numWork; i++)
+            {lat.insert(lat.end(), rs[i].lat[t].begin(), rs[i].lat[t].end());
+             errs += rs[i].errs[t]; bytes += rs[i].bytes[t];
+            }
+        Report(lat, opName[t], "lat us", errs,
+               (t < ReqOp::opOpen ? bytes : -1), rEnd - rBeg);
+       }
+   for (int i = 0; i < numWork; i++)
+       late.insert(late.end(), rs[i].late.begin(), rs[i].late.end());
+   if (Speed > 0) Report(late, "late", "ms", 0, -1, rEnd - rBeg);
+   return 0;
+}
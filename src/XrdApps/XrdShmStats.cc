@@ -0,0 +1,204 @@
+/******************************************************************************/
+/*                                                                            */
+/*                        X r d S h m S t a t s . c c                         */
+/*                                                                            */
+/* This file is part of the XRootD software suite.                            */
+/*                                                                            */
+/* XRootD is free software: you can redistribute it and/or modify it under    */
+/* the terms of the GNU Lesser General Public License as published by the     */
+/* Free Software Foundation, either version 3 of the License, or (at your     */
+/* option) any later version.                                                 */
+/*                                                                            */
+/* XRootD is distributed in the hope that it will be useful, but WITHOUT      */
+/* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or      */
+/* FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public       */
+/* License for more details.                                                  */
+/*                                                                            */
+/* You should have received a copy of the GNU Lesser General Public License   */
+/* along with XRootD in a file called COPYING.LESSER (LGPL license) and file  */
+/* COPYING (GPL license).  If not, see <http://www.gnu.org/licenses/>.        */
+/*                                                                            */
+/* The copyright holder's institutional names and contributor's names may not */
+/* be used to endorse or promote products derived from this software without  */
+/* specific prior written permission of the institution or contributor.       */
+/******************************************************************************/
+
+#include <errno.h>
+#include <fcntl.h>
+#include <iostream>
+#include <map>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "Xrd/XrdStatsShm.hh"
+
+using namespace std;
+
+// xrdshmstats displays the counters that a server publishes in shared memory
+// via the xrd.shmstats directive. It never talks to the server; hence, it can
+// be run as often as wanted without affecting it.
+
+/******************************************************************************/
+/*                                 U s a g e                                  */
+/******************************************************************************/
+
+void Usage(int rc)
+{
+   cerr <<"\nUsage: xrdshmstats [opts] <path>\n"
+          "\nopts: -h -i <sec> -n <cnt> -p <pfx> -z\n"
+          "\n-i number of seconds to wait before between redisplays; counters"
+          "\n   are then also displayed as a rate per second."
+          "\n-n number of redisplays; if -i is specified and -n is not, goes"
+          "\n   forever."
+          "\n-p only display counters whose name starts with <pfx>."
+          "\n-z does not display counters with a zero value.\n"
+          "\npath: the file specified in the xrd.shmstats directive."
+          <<endl;
+   exit(rc);
+}
+
+/******************************************************************************/
+/*                                  S h o w                                   */
+/******************************************************************************/
+
+// Display the counters in the segment once, returning false if the segment is
+// not (yet) valid. The previous values are kept in lastVal to compute rates.
+
+bool Show(const char *path, const char *pfx, bool nozed, int wTime,
+          map<string, long long> &lastVal)
+{
+   const XrdStatsShm::Head   *hP;
+   const XrdStatsShm::DirEnt *dP;
+   const std::atomic<long long> *vP;
+   struct stat Stat;
+   void *shmP;
+   long long val;
+   int fd, numCtr, pfxLen = (pfx ? strlen(pfx) : 0);
+
+// Map the segment. It is reopened each time as it is recreated when the
+// server restarts.
+//
+   if ((fd = open(path, O_RDONLY)) < 0)
+      {cerr <<"xrdshmstats: Unable to open " <<path <<"; "
+            <<strerror(errno) <<endl;
+       return false;
+      }
+   if (fstat(fd, &Stat) || Stat.st_size < (off_t)sizeof(XrdStatsShm::Head)
+   ||  (shmP = mmap(0, Stat.st_size, PROT_READ, MAP_SHARED, fd, 0))
+        == MAP_FAILED)
+      {cerr <<"xrdshmstats: Unable to map " <<path <<endl;
+       close(fd);
+       return false;
+      }
+   close(fd);
+
+// Verify that this is a segment we understand
+//
+   hP = (const XrdStatsShm::Head *)shmP;
+   if (strncmp(hP->magic, "XrdStats", sizeof(hP->magic))
+   ||  hP->version != (uint32_t)XrdStatsShm::Version
+   ||  (off_t)hP->valOff + (off_t)hP->lanes*hP->laneLen > Stat.st_size)
+      {cerr <<"xrdshmstats: " <<path <<" is not a valid statistics segment."
+            <<endl;
+       munmap(shmP, Stat.st_size);
+       return false;
+      }
+
+// Display each counter as the sum of its lanes
+//
+   numCtr = hP->numCtr.load(std::memory_order_acquire);
+   if (numCtr > (int)hP->maxCtr) numCtr = hP->maxCtr;
+   dP = (const XrdStatsShm::DirEnt *)((const char *)shmP + hP->dirOff);
+   for (int i = 0; i < numCtr; i++, dP++)
+       {if (pfxLen && strncmp(dP->name, pfx, pfxLen)) continue;
+        val = 0;
+        for (unsigned int j = 0; j < hP->lanes; j++)
+            {vP = (const std::atomic<long long> *)((const char *)shmP
+                + hP->valOff + (size_t)j*hP->laneLen) + i;
+             val += vP->load(std::memory_order_relaxed);
+            }
+        if (nozed && !val) continue;
+        std::string name(dP->name, strnlen(dP->name, sizeof(dP->name)));
+        cout <<name <<' ' <<val;
+        if (wTime && dP->type == XrdStatsShm::isCounter)
+           {map<string, long long>::iterator it = lastVal.find(name);
+            if (it != lastVal.end()) cout <<' ' <<(val - it->second)/wTime <<"/s";
+            lastVal[name] = val;
+           }
+        cout <<endl;
+       }
+
+   munmap(shmP, Stat.st_size);
+   return true;
+}
+
+/******************************************************************************/
+/*                                  m a i n                                   */
+/******************************************************************************/
+
+int main(int argc, char *argv[])
+{
+   extern char *optarg;
+   extern int optind, opterr, optopt;
+   map<string, long long> lastVal;
+   const char *pfx = 0, *pgm = "xrdshmstats: ";
+   int WTime = 0, Count = 0;
+   char c;
+   bool nozed = false, isOK = true;
+
+// Process the options
+//
+   opterr = 0;
+   while ((c = getopt(argc,argv,":hi:n:p:z")) && ((unsigned char)c != 0xff))
+     { switch(c)
+       {
+       case 'h': Usage(0);
+                 break;
+       case 'i': if ((WTime = atoi(optarg)) <= 0)
+                    {cerr <<pgm <<"Invalid interval - " <<optarg <<endl;
+                     Usage(1);
+                    }
+                 break;
+       case 'n': if ((Count = atoi(optarg)) <= 0)
+                    {cerr <<pgm <<"Invalid count - " <<optarg <<endl;
+                     Usage(1);
+                    }
+                 break;
+       case 'p': pfx = optarg;
+                 break;
+       case 'z': nozed = true;
+                 break;
+       default:  cerr <<pgm <<'-' <<char(optopt);
+                 if (c == ':') cerr <<" value not specified." <<endl;
+                    else cerr <<" option is invalid" <<endl;
+                 Usage(1);
+                 break;
+       }
+     }
+
+// Make sure the path has been specified
+//
+   if (optind >= argc)
+      {cerr <<pgm <<"Statistics path has not been specified." <<endl;
+       Usage(1);
+      }
+
+// Establish count and interval
+//
+   if (!WTime && Count) WTime = 10;
+      else if (WTime && !Count) Count = -1;
+              else if (!WTime && !Count) Count = 1;
+
+// Display the statistics
+//
+   while(Count--)
+        {isOK = Show(argv[optind], pfx, nozed, WTime, lastVal);
+         if (Count && WTime) {cout <<endl; sleep(WTime);}
+        }
+   return (isOK ? 0 : 2);
+}
@@ -74,6 +74,8 @@ namespace XrdCl
   const int DefaultMaxMetalinkWait         = 60;
   const int DefaultPreserveLocateTried     = 1;
   const int DefaultNotAuthorizedRetryLimit = 3;
+  const int DefaultDirListMaxInFlight      = 64;
+  const int DefaultDirListMaxPerServer     = 16;
 
   const char * const DefaultPollerPreference   = "built-in";
   const char * const DefaultNetworkStack       = "IPAuto";
@@ -29,6 +29,7 @@
 #include "XrdCl/XrdClDefaultEnv.hh"
 #include "XrdCl/XrdClLog.hh"
 #include "XrdCl/XrdClFileSystem.hh"
+#include "XrdCl/XrdClFileSystemUtils.hh"
 #include "XrdCl/XrdClUtils.hh"
 #include "XrdCl/XrdClDlgEnv.hh"
 #include "XrdSys/XrdSysPthread.hh"
@@ -410,8 +411,8 @@ XrdCpFile *IndexRemote( XrdCl::FileSystem *fs,
   log->Debug( AppMsg, "Indexing %s", basePath.c_str() );
 
   DirectoryList *dirList = 0;
-  XRootDStatus st = fs->DirList( URL( basePath ).GetPath(), DirListFlags::Recursive
-      | DirListFlags::Locate | DirListFlags::Merge, dirList );
+  XRootDStatus st = FileSystemUtils::ListRecursive( fs, URL( basePath ).GetPath(),
+      DirListFlags::Locate | DirListFlags::Merge, dirList );
   if( !st.IsOK() )
   {
     log->Info( AppMsg, "Failed to get directory listing for %s: %s",
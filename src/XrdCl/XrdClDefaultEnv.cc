@@ -294,6 +294,8 @@ namespace XrdCl
     REGISTER_VAR_INT( varsInt, "MaxMetalinkWait",         DefaultMaxMetalinkWait         );
     REGISTER_VAR_INT( varsInt, "PreserveLocateTried",     DefaultPreserveLocateTried     );
     REGISTER_VAR_INT( varsInt, "NotAuthorizedRetryLimit", DefaultNotAuthorizedRetryLimit );
+    REGISTER_VAR_INT( varsInt, "DirListMaxInFlight",      DefaultDirListMaxInFlight      );
+    REGISTER_VAR_INT( varsInt, "DirListMaxPerServer",     DefaultDirListMaxPerServer     );
 
     REGISTER_VAR_STR( varsStr, "PollerPreference",        DefaultPollerPreference        );
     REGISTER_VAR_STR( varsStr, "ClientMonitor",           DefaultClientMonitor           );
@@ -287,7 +287,11 @@ XRootDStatus DoLS( FileSystem                      *fs,
   // Ask for the list
   //----------------------------------------------------------------------------
   DirectoryList *list;
-  XRootDStatus st = fs->DirList( newPath, flags, list );
+  XRootDStatus st;
+  if( ( flags & DirListFlags::Recursive ) && !( flags & DirListFlags::Zip ) )
+    st = FileSystemUtils::ListRecursive( fs, newPath, flags, list );
+  else
+    st = fs->DirList( newPath, flags, list );
   if( !st.IsOK() )
   {
     log->Error( AppMsg, "Unable to list the path: %s", st.ToStr().c_str() );
@@ -24,6 +24,7 @@
 
 #include "XrdCl/XrdClMessageUtils.hh"
 #include "XrdCl/XrdClFileSystem.hh"
+#include "XrdCl/XrdClFile.hh"
 #include "XrdCl/XrdClDefaultEnv.hh"
 #include "XrdCl/XrdClLog.hh"
 #include "XrdCl/XrdClConstants.hh"
@@ -39,6 +40,7 @@
 #include "XrdSys/XrdSysPthread.hh"
 
 #include <sys/stat.h>
+#include <stdlib.h>
 
 #include <memory>
 #include <algorithm>
@@ -839,6 +841,234 @@ namespace
       std::set<ListEntry*, less>  uniquesofar;
       XrdCl::ResponseHandler     *pHandler;
   };
+
+  //----------------------------------------------------------------------------
+  // Collects the results of a batch of stat or open requests and notifies the
+  // user handler once the last of them is in. The pending count starts at one
+  // so that the batch cannot complete while requests are still being issued;
+  // the issuer drops it with a final call to Done.
+  //----------------------------------------------------------------------------
+  class BatchCtx
+  {
+    public:
+      BatchCtx( uint32_t size, XrdCl::ResponseHandler *handler ):
+        pInfo( new XrdCl::StatBatchInfo( size ) ), pHandler( handler ),
+        pPending( 1 )
+      {
+      }
+
+      void Add( uint32_t count )
+      {
+        XrdSysMutexHelper lck( pMutex );
+        pPending += count;
+      }
+
+      void Set( uint32_t index, const XrdCl::XRootDStatus &status,
+                XrdCl::StatInfo *info )
+      {
+        XrdSysMutexHelper lck( pMutex );
+        pInfo->Set( index, status, info );
+      }
+
+      void Done()
+      {
+        pMutex.Lock();
+        bool last = ( --pPending == 0 );
+        pMutex.UnLock();
+        if( !last )
+          return;
+
+        XrdCl::AnyObject *obj = new XrdCl::AnyObject();
+        obj->Set( pInfo );
+        pHandler->HandleResponse( new XrdCl::XRootDStatus(), obj );
+        delete this;
+      }
+
+    private:
+      XrdCl::StatBatchInfo   *pInfo;
+      XrdCl::ResponseHandler *pHandler;
+      XrdSysMutex             pMutex;
+      uint32_t                pPending;
+  };
+
+  //----------------------------------------------------------------------------
+  // Handles the response to a single stat or open within a batch
+  //----------------------------------------------------------------------------
+  class BatchItemHandler: public XrdCl::ResponseHandler
+  {
+    public:
+      BatchItemHandler( BatchCtx *ctx, uint32_t index, XrdCl::File *file = 0 ):
+        pCtx( ctx ), pIndex( index ), pFile( file )
+      {
+      }
+
+      virtual void HandleResponse( XrdCl::XRootDStatus *status,
+                                   XrdCl::AnyObject    *response )
+      {
+        using namespace XrdCl;
+
+        StatInfo *info = 0;
+        if( status->IsOK() )
+        {
+          //--------------------------------------------------------------------
+          // An open comes with the stat info which is cached by the file
+          //--------------------------------------------------------------------
+          if( pFile )
+          {
+            XRootDStatus st = pFile->Stat( false, info );
+            if( !st.IsOK() )
+              info = 0;
+          }
+          else if( response )
+          {
+            StatInfo *rspInfo = 0;
+            response->Get( rspInfo );
+            if( rspInfo )
+              info = new StatInfo( *rspInfo );
+          }
+        }
+
+        pCtx->Set( pIndex, *status, info );
+        delete status;
+        delete response;
+        pCtx->Done();
+        delete this;
+      }
+
+    private:
+      BatchCtx    *pCtx;
+      uint32_t     pIndex;
+      XrdCl::File *pFile;
+  };
+
+  //----------------------------------------------------------------------------
+  // Handles the response to a kXR_statx request covering a chunk of a stat
+  // batch. The server returns a line for each path; paths that it could not
+  // handle and all the paths of a server that does not understand the request
+  // are stated one by one.
+  //----------------------------------------------------------------------------
+  class StatBatchHandler: public XrdCl::ResponseHandler
+  {
+    public:
+      StatBatchHandler( XrdCl::FileSystem *fs, BatchCtx *ctx,
+                        const std::vector<std::string> &paths,
+                        uint32_t first, uint32_t count, uint16_t timeout ):
+        pFS( fs ), pCtx( ctx ),
+        pPaths( paths.begin() + first, paths.begin() + first + count ),
+        pFirst( first ), pTimeout( timeout )
+      {
+      }
+
+      virtual void HandleResponse( XrdCl::XRootDStatus *status,
+                                   XrdCl::AnyObject    *response )
+      {
+        using namespace XrdCl;
+
+        std::vector<std::string> lines;
+        Buffer *buff = 0;
+
+        if( !status->IsOK() )
+        {
+          for( uint32_t i = 0; i < pPaths.size(); ++i )
+            pCtx->Set( pFirst + i, *status, 0 );
+        }
+        else
+        {
+          if( response )
+            response->Get( buff );
+          if( buff && buff->GetSize() )
+            Split( std::string( buff->GetBuffer(), buff->GetSize() ), lines );
+
+          //--------------------------------------------------------------------
+          // Old servers answer with a flag for each path rather than the
+          // leadin line, we need to stat the paths ourselves
+          //--------------------------------------------------------------------
+          if( lines.empty() || lines[0] != "." )
+            lines.clear();
+
+          for( uint32_t i = 0; i < pPaths.size(); ++i )
+          {
+            if( i + 1 >= lines.size() )
+            {
+              Retry( i );
+              continue;
+            }
+
+            const std::string &line = lines[i+1];
+            char *end;
+            long code = strtol( line.c_str(), &end, 10 );
+            if( end == line.c_str() || code < 0 )
+            {
+              Retry( i );
+              continue;
+            }
+            if( *end == ' ' )
+              ++end;
+
+            if( code == 0 )
+            {
+              StatInfo *info = new StatInfo();
+              if( info->ParseServerResponse( end ) )
+                pCtx->Set( pFirst + i, XRootDStatus(), info );
+              else
+              {
+                delete info;
+                pCtx->Set( pFirst + i,
+                           XRootDStatus( stError, errInvalidResponse ), 0 );
+              }
+            }
+            else
+              pCtx->Set( pFirst + i, XRootDStatus( stError, errErrorResponse,
+                                                   code, end ), 0 );
+          }
+        }
+
+        delete status;
+        delete response;
+        pCtx->Done();
+        delete this;
+      }
+
+    private:
+      static void Split( const std::string &data,
+                         std::vector<std::string> &lines )
+      {
+        size_t len = data.find( '\0' );
+        if( len == std::string::npos )
+          len = data.length();
+
+        size_t pos = 0;
+        while( pos < len )
+        {
+          size_t end = data.find( '\n', pos );
+          if( end == std::string::npos || end > len )
+            end = len;
+          lines.push_back( data.substr( pos, end - pos ) );
+          pos = end + 1;
+        }
+      }
+
+      void Retry( uint32_t i )
+      {
+        using namespace XrdCl;
+
+        pCtx->Add( 1 );
+        BatchItemHandler *handler = new BatchItemHandler( pCtx, pFirst + i );
+        XRootDStatus st = pFS->Stat( pPaths[i], handler, pTimeout );
+        if( !st.IsOK() )
+        {
+          delete handler;
+          pCtx->Set( pFirst + i, st, 0 );
+          pCtx->Done();
+        }
+      }
+
+      XrdCl::FileSystem        *pFS;
+      BatchCtx                 *pCtx;
+      std::vector<std::string>  pPaths;
+      uint32_t                  pFirst;
+      uint16_t                  pTimeout;
+  };
 }
 
 namespace XrdCl
@@ -886,6 +1116,163 @@ namespace XrdCl
       ResponseHandler *pUserHandler;
   };
 
+  //----------------------------------------------------------------------------
+  //! Lists a directory one page at a time, asking for the next page as soon
+  //! as one arrives. The pages are either passed on to the user handler as
+  //! they come (chunked listings) or gathered into a single listing.
+  //----------------------------------------------------------------------------
+  class DirListPageHandler: public ResponseHandler
+  {
+    public:
+      //------------------------------------------------------------------------
+      // Constructor and destructor
+      //------------------------------------------------------------------------
+      DirListPageHandler( FileSystem        *fs,
+                          const std::string &path,
+                          bool               dstat,
+                          bool               chunked,
+                          ResponseHandler   *userHandler,
+                          uint16_t           timeout ):
+        pFS( fs ), pPath( path ), pDStat( dstat ), pChunked( chunked ),
+        pUserHandler( userHandler ), pTimeout( timeout ), pList( 0 ),
+        pPinned( false ) {}
+
+      virtual ~DirListPageHandler() {}
+
+      //------------------------------------------------------------------------
+      // Response callback
+      //------------------------------------------------------------------------
+      virtual void HandleResponseWithHosts( XRootDStatus *status,
+                                            AnyObject    *response,
+                                            HostList     *hostList )
+      {
+        DirectoryList *page = 0;
+        if( status->IsOK() && response )
+          response->Get( page );
+
+        if( !page )
+        {
+          if( status->IsOK() )
+          {
+            delete status;
+            status = new XRootDStatus( stError, errInvalidResponse );
+          }
+          delete response;
+          delete pList;
+          pUserHandler->HandleResponseWithHosts( status, 0, hostList );
+          delete this;
+          return;
+        }
+
+        std::string cursor = page->GetCursor();
+        page->SetCursor( "" );
+
+        //----------------------------------------------------------------------
+        // A cursor is only meaningful to the server that issued it, so the
+        // following pages must be asked for from the server that answered
+        //----------------------------------------------------------------------
+        if( !cursor.empty() && hostList && !hostList->empty() )
+        {
+          pServer = hostList->back().url;
+          pPinned = true;
+        }
+
+        //----------------------------------------------------------------------
+        // Pass the page on or add it to what we have so far
+        //----------------------------------------------------------------------
+        if( pChunked )
+        {
+          if( !cursor.empty() )
+            status->code = suContinue;
+          pUserHandler->HandleResponseWithHosts( status, response, hostList );
+        }
+        else
+        {
+          if( !pList )
+          {
+            pList = page;
+            response->Set( page, false );
+          }
+          else
+          {
+            DirectoryList::Iterator it;
+            for( it = page->Begin(); it != page->End(); ++it )
+            {
+              pList->Add( new DirectoryList::ListEntry( (*it)->GetHostAddress(),
+                                                        (*it)->GetName(),
+                                                        (*it)->GetStatInfo() ) );
+              (*it)->SetStatInfo( 0 );
+            }
+          }
+          delete response;
+
+          if( cursor.empty() )
+          {
+            AnyObject *obj = new AnyObject();
+            obj->Set( pList );
+            pUserHandler->HandleResponseWithHosts( status, obj, hostList );
+          }
+          else
+          {
+            delete status;
+            delete hostList;
+          }
+        }
+
+        if( cursor.empty() )
+        {
+          delete this;
+          return;
+        }
+
+        //----------------------------------------------------------------------
+        // Ask for the next page
+        //----------------------------------------------------------------------
+        XRootDStatus st = SendNext( cursor );
+        if( !st.IsOK() )
+        {
+          delete pList;
+          pUserHandler->HandleResponse( new XRootDStatus( st ), 0 );
+          delete this;
+        }
+      }
+
+    private:
+      XRootDStatus SendNext( const std::string &cursor )
+      {
+        std::string args = pPath + "\n" + cursor;
+
+        Message              *msg;
+        ClientDirlistRequest *req;
+        MessageUtils::CreateRequest( msg, req, args.length() );
+
+        req->requestid  = kXR_dirlist;
+        req->options[0] = kXR_dcursor | ( pDStat ? kXR_dstat : 0 );
+        req->dlen       = args.length();
+        msg->Append( args.c_str(), args.length(), 24 );
+        MessageSendParams params; params.timeout = pTimeout;
+        MessageUtils::ProcessSendParams( params );
+        XRootDTransport::SetDescription( msg );
+
+        if( pPinned )
+        {
+          params.followRedirects = false;
+          return MessageUtils::SendMessage( pServer, msg, this, params, 0 );
+        }
+        return pFS->Send( msg, this, params );
+      }
+
+      FileSystem      *pFS;
+      std::string      pPath;
+      bool             pDStat;
+      bool             pChunked;
+      ResponseHandler *pUserHandler;
+      uint16_t         pTimeout;
+      DirectoryList   *pList;
+      URL              pServer;
+      bool             pPinned;
+  };
+
 
   //----------------------------------------------------------------------------
   // Constructor
@@ -1390,6 +1777,165 @@ namespace XrdCl
     return MessageUtils::WaitForResponse( &handler, response );
   }
 
+  //----------------------------------------------------------------------------
+  // Obtain status information for many paths at once - async
+  //----------------------------------------------------------------------------
+  XRootDStatus FileSystem::StatBatch( const std::vector<std::string> &paths,
+                                      ResponseHandler                *handler,
+                                      uint16_t                        timeout )
+  {
+    static const uint32_t maxPaths = 1024;
+    static const uint32_t maxChunk = 65536;
+
+    BatchCtx *ctx = new BatchCtx( paths.size(), handler );
+
+    //--------------------------------------------------------------------------
+    // Plug-ins and local files don't know about kXR_statx so we stat the
+    // paths one by one
+    //--------------------------------------------------------------------------
+    if( pPlugIn || pUrl->IsLocalFile() )
+    {
+      for( uint32_t i = 0; i < paths.size(); ++i )
+      {
+        ctx->Add( 1 );
+        BatchItemHandler *ih = new BatchItemHandler( ctx, i );
+        XRootDStatus st = Stat( paths[i], ih, timeout );
+        if( !st.IsOK() )
+        {
+          delete ih;
+          ctx->Set( i, st, 0 );
+          ctx->Done();
+        }
+      }
+      ctx->Done();
+      return XRootDStatus();
+    }
+
+    //--------------------------------------------------------------------------
+    // Send the paths in chunks, each one in a single kXR_statx request
+    //--------------------------------------------------------------------------
+    uint32_t first = 0;
+    while( first < paths.size() )
+    {
+      std::string list;
+      uint32_t    count = 0;
+      while( first + count < paths.size() && count < maxPaths )
+      {
+        std::string fPath = FilterXrdClCgi( paths[first+count] );
+        if( count && list.length() + fPath.length() + 1 > maxChunk )
+          break;
+        if( count )
+          list += "\n";
+        list += fPath;
+        ++count;
+      }
+
+      Message            *msg;
+      ClientStatRequest  *req;
+      MessageUtils::CreateRequest( msg, req, list.length() );
+
+      req->requestid  = kXR_statx;
+      req->options    = kXR_sxinfo;
+      req->dlen       = list.length();
+      msg->Append( list.c_str(), list.length(), 24 );
+      MessageSendParams params; params.timeout = timeout;
+      MessageUtils::ProcessSendParams( params );
+      XRootDTransport::SetDescription( msg );
+
+      ctx->Add( 1 );
+      StatBatchHandler *bh = new StatBatchHandler( this, ctx, paths, first,
+                                                   count, timeout );
+      XRootDStatus st = Send( msg, bh, params );
+      if( !st.IsOK() )
+      {
+        delete bh;
+        for( uint32_t i = first; i < first + count; ++i )
+          ctx->Set( i, st, 0 );
+        ctx->Done();
+      }
+      first += count;
+    }
+
+    ctx->Done();
+    return XRootDStatus();
+  }
+
+  //----------------------------------------------------------------------------
+  // Obtain status information for many paths at once - sync
+  //----------------------------------------------------------------------------
+  XRootDStatus FileSystem::StatBatch( const std::vector<std::string>  &paths,
+                                      StatBatchInfo                  *&response,
+                                      uint16_t                         timeout )
+  {
+    SyncResponseHandler handler;
+    Status st = StatBatch( paths, &handler, timeout );
+    if( !st.IsOK() )
+      return st;
+
+    return MessageUtils::WaitForResponse( &handler, response );
+  }
+
+  //----------------------------------------------------------------------------
+  // Open many files at once - async
+  //----------------------------------------------------------------------------
+  XRootDStatus FileSystem::OpenBatch( const std::vector<std::string> &paths,
+                                      const std::vector<File*>       &files,
+                                      OpenFlags::Flags                flags,
+                                      Access::Mode                    mode,
+                                      ResponseHandler                *handler,
+                                      uint16_t                        timeout )
+  {
+    if( paths.size() != files.size() )
+      return XRootDStatus( stError, errInvalidArgs );
+
+    BatchCtx *ctx = new BatchCtx( paths.size(), handler );
+
+    //--------------------------------------------------------------------------
+    // Issue all the opens without waiting, the responses are collected by
+    // the batch context
+    //--------------------------------------------------------------------------
+    for( uint32_t i = 0; i < paths.size(); ++i )
+    {
+      URL    url( *pUrl );
+      size_t pos = paths[i].find( '?' );
+      url.SetPath( paths[i].substr( 0, pos ) );
+      if( pos != std::string::npos )
+        url.SetParams( paths[i].substr( pos + 1 ) );
+
+      ctx->Add( 1 );
+      BatchItemHandler *ih = new BatchItemHandler( ctx, i, files[i] );
+      XRootDStatus st = files[i]->Open( url.GetURL(), flags, mode, ih,
+                                        timeout );
+      if( !st.IsOK() )
+      {
+        delete ih;
+        ctx->Set( i, st, 0 );
+        ctx->Done();
+      }
+    }
+
+    ctx->Done();
+    return XRootDStatus();
+  }
+
+  //----------------------------------------------------------------------------
+  // Open many files at once - sync
+  //----------------------------------------------------------------------------
+  XRootDStatus FileSystem::OpenBatch( const std::vector<std::string>  &paths,
+                                      const std::vector<File*>        &files,
+                                      OpenFlags::Flags                 flags,
+                                      Access::Mode                     mode,
+                                      StatBatchInfo                  *&response,
+                                      uint16_t                         timeout )
+  {
+    SyncResponseHandler handler;
+    Status st = OpenBatch( paths, files, flags, mode, &handler, timeout );
+    if( !st.IsOK() )
+      return st;
+
+    return MessageUtils::WaitForResponse( &handler, response );
+  }
+
   //----------------------------------------------------------------------------
   // Obtain status information for a path - async
   //----------------------------------------------------------------------------
@@ -1509,9 +2055,21 @@ namespace XrdCl
     if( flags & DirListFlags::Merge )
       handler = new MergeDirListHandler( flags & DirListFlags::Chunked, handler );
 
+    //--------------------------------------------------------------------------
+    // Paged listings are chunked by page rather than by server response
+    //--------------------------------------------------------------------------
+    if( flags & DirListFlags::Paged )
+    {
+      req->options[0] |= kXR_dcursor;
+      handler = new DirListPageHandler( this, fPath,
+                                        req->options[0] & kXR_dstat,
+                                        flags & DirListFlags::Chunked,
+                                        handler, timeout );
+    }
+
     msg->Append( fPath.c_str(), fPath.length(), 24 );
     MessageSendParams params; params.timeout = timeout;
-    if( flags & DirListFlags::Chunked )
+    if( ( flags & DirListFlags::Chunked ) && !( flags & DirListFlags::Paged ) )
       params.chunkedResponse = true;
     MessageUtils::ProcessSendParams( params );
     XRootDTransport::SetDescription( msg );
@@ -39,6 +39,7 @@ namespace XrdCl
 {
   class PostMaster;
   class Message;
+  class File;
   class FileSystemPlugIn;
   struct MessageSendParams;
 
@@ -160,7 +161,8 @@ namespace XrdCl
       Recursive = 4,  //!< Do a recursive listing
       Merge     = 8,  //!< Merge duplicates
       Chunked   = 16, //!< Serve chunked results for better performance
-      Zip       = 32  //!< List content of ZIP files
+      Zip       = 32, //!< List content of ZIP files
+      Paged     = 64  //!< List in pages of bounded size, one request per page
     };
   };
   XRDOUC_ENUM_OPERATORS( DirListFlags::Flags )
@@ -195,6 +197,7 @@ namespace XrdCl
   class FileSystem
   {
     friend class AssignLBHandler;
+    friend class DirListPageHandler;
     friend class ForkHandler;
 
     public:
@@ -543,6 +546,88 @@ namespace XrdCl
                          uint16_t            timeout = 0 )
                          XRD_WARN_UNUSED_RESULT;
 
+      //------------------------------------------------------------------------
+      //! Obtain status information for many paths at once - async
+      //!
+      //! The paths are sent to the server in as few kXR_statx requests as
+      //! possible and the results are streamed back. Paths the server cannot
+      //! handle in a batch (e.g. because they are redirected elsewhere) and
+      //! servers that do not support batches are dealt with using individual
+      //! stat requests.
+      //!
+      //! @param paths   file/directory paths
+      //! @param handler handler to be notified when all the responses have
+      //!                arrived, the response parameter will hold a
+      //!                StatBatchInfo object with the result for each path
+      //! @param timeout timeout value, if 0 the environment default will
+      //!                be used
+      //! @return        status of the operation
+      //------------------------------------------------------------------------
+      XRootDStatus StatBatch( const std::vector<std::string> &paths,
+                              ResponseHandler                *handler,
+                              uint16_t                        timeout = 0 )
+                              XRD_WARN_UNUSED_RESULT;
+
+      //------------------------------------------------------------------------
+      //! Obtain status information for many paths at once - sync
+      //!
+      //! @param paths    file/directory paths
+      //! @param response the response (to be deleted by the user)
+      //! @param timeout  timeout value, if 0 the environment default will
+      //!                 be used
+      //! @return         status of the operation
+      //------------------------------------------------------------------------
+      XRootDStatus StatBatch( const std::vector<std::string>  &paths,
+                              StatBatchInfo                  *&response,
+                              uint16_t                         timeout = 0 )
+                              XRD_WARN_UNUSED_RESULT;
+
+      //------------------------------------------------------------------------
+      //! Open many files at once - async
+      //!
+      //! All the open requests are sent without waiting for any response so
+      //! that they are processed in a single round trip.
+      //!
+      //! @param paths   file paths relative to this file system
+      //! @param files   unopened file objects, one for each path
+      //! @param flags   open flags applied to all the files
+      //! @param mode    access mode for new files
+      //! @param handler handler to be notified when all the files have been
+      //!                dealt with, the response parameter will hold a
+      //!                StatBatchInfo object with the open status and the
+      //!                stat info for each file
+      //! @param timeout timeout value, if 0 the environment default will
+      //!                be used
+      //! @return        status of the operation
+      //------------------------------------------------------------------------
+      XRootDStatus OpenBatch( const std::vector<std::string> &paths,
+                              const std::vector<File*>       &files,
+                              OpenFlags::Flags                flags,
+                              Access::Mode                    mode,
+                              ResponseHandler                *handler,
+                              uint16_t                        timeout = 0 )
+                              XRD_WARN_UNUSED_RESULT;
+
+      //------------------------------------------------------------------------
+      //! Open many files at once - sync
+      //!
+      //! @param paths    file paths relative to this file system
+      //! @param files    unopened file objects, one for each path
+      //! @param flags    open flags applied to all the files
+      //! @param mode     access mode for new files
+      //! @param response the response (to be deleted by the user)
+      //! @param timeout  timeout value, if 0 the environment default will
+      //!                 be used
+      //! @return         status of the operation
+      //------------------------------------------------------------------------
+      XRootDStatus OpenBatch( const std::vector<std::string>  &paths,
+                              const std::vector<File*>        &files,
+                              OpenFlags::Flags                 flags,
+                              Access::Mode                     mode,
+                              StatBatchInfo                  *&response,
+                              uint16_t                         timeout = 0 )
+                              XRD_WARN_UNUSED_RESULT;
+
       //------------------------------------------------------------------------
       //! Obtain status information for a Virtual File System - async
       //!
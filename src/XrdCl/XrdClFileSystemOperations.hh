@@ -981,6 +981,124 @@ namespace XrdCl
       }
   };
   typedef PrepareImpl<false> Prepare;
+
+  //----------------------------------------------------------------------------
+  //! StatBatch operation (@see FileSystemOperation)
+  //----------------------------------------------------------------------------
+  template<bool HasHndl>
+  class StatBatchImpl: public FileSystemOperation<StatBatchImpl, HasHndl,
+      Resp<StatBatchInfo>, Arg<std::vector<std::string>>>
+  {
+    public:
+
+      //------------------------------------------------------------------------
+      //! Inherit constructors from FileSystemOperation (@see FileSystemOperation)
+      //------------------------------------------------------------------------
+      using FileSystemOperation<StatBatchImpl, HasHndl, Resp<StatBatchInfo>,
+                                Arg<std::vector<std::string>>>::FileSystemOperation;
+
+      //------------------------------------------------------------------------
+      //! Argument indexes in the args tuple
+      //------------------------------------------------------------------------
+      enum { PathsArg };
+
+      //------------------------------------------------------------------------
+      //! @return : name of the operation (@see Operation)
+      //------------------------------------------------------------------------
+      std::string ToString()
+      {
+        return "StatBatch";
+      }
+
+    protected:
+
+      //------------------------------------------------------------------------
+      //! RunImpl operation (@see Operation)
+      //!
+      //! @param params :  container with parameters forwarded from
+      //!                  previous operation
+      //! @return       :  status of the operation
+      //------------------------------------------------------------------------
+      XRootDStatus RunImpl()
+      {
+        try
+        {
+          std::vector<std::string> paths = std::get<PathsArg>( this->args ).Get();
+          return this->filesystem->StatBatch( paths, this->handler.get() );
+        }
+        catch( const PipelineException& ex )
+        {
+          return ex.GetError();
+        }
+        catch( const std::exception& ex )
+        {
+          return XRootDStatus( stError, ex.what() );
+        }
+      }
+  };
+  typedef StatBatchImpl<false> StatBatch;
+
+  //----------------------------------------------------------------------------
+  //! OpenBatch operation (@see FileSystemOperation)
+  //----------------------------------------------------------------------------
+  template<bool HasHndl>
+  class OpenBatchImpl: public FileSystemOperation<OpenBatchImpl, HasHndl,
+      Resp<StatBatchInfo>, Arg<std::vector<std::string>>, Arg<std::vector<File*>>,
+      Arg<OpenFlags::Flags>, Arg<Access::Mode>>
+  {
+    public:
+
+      //------------------------------------------------------------------------
+      //! Inherit constructors from FileSystemOperation (@see FileSystemOperation)
+      //------------------------------------------------------------------------
+      using FileSystemOperation<OpenBatchImpl, HasHndl, Resp<StatBatchInfo>,
+                                Arg<std::vector<std::string>>, Arg<std::vector<File*>>,
+                                Arg<OpenFlags::Flags>, Arg<Access::Mode>>::FileSystemOperation;
+
+      //------------------------------------------------------------------------
+      //! Argument indexes in the args tuple
+      //------------------------------------------------------------------------
+      enum { PathsArg, FilesArg, FlagsArg, ModeArg };
+
+      //------------------------------------------------------------------------
+      //! @return : name of the operation (@see Operation)
+      //------------------------------------------------------------------------
+      std::string ToString()
+      {
+        return "OpenBatch";
+      }
+
+    protected:
+
+      //------------------------------------------------------------------------
+      //! RunImpl operation (@see Operation)
+      //!
+      //! @param params :  container with parameters forwarded from
+      //!                  previous operation
+      //! @return       :  status of the operation
+      //------------------------------------------------------------------------
+      XRootDStatus RunImpl()
+      {
+        try
+        {
+          std::vector<std::string> paths = std::get<PathsArg>( this->args ).Get();
+          std::vector<File*>       files = std::get<FilesArg>( this->args ).Get();
+          OpenFlags::Flags         flags = std::get<FlagsArg>( this->args ).Get();
+          Access::Mode             mode  = std::get<ModeArg>( this->args ).Get();
+          return this->filesystem->OpenBatch( paths, files, flags, mode,
+              this->handler.get() );
+        }
+        catch( const PipelineException& ex )
+        {
+          return ex.GetError();
+        }
+        catch( const std::exception& ex )
+        {
+          return XRootDStatus( stError, ex.what() );
+        }
+      }
+  };
+  typedef OpenBatchImpl<false> OpenBatch;
 }
 
 #endif // __XRD_CL_FILE_SYSTEM_OPERATIONS_HH__
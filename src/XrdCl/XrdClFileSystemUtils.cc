@@ -24,13 +24,314 @@
 
 #include "XrdCl/XrdClFileSystemUtils.hh"
 #include "XrdCl/XrdClFileSystem.hh"
-#include "XrdCl/XrdClFileSystem.hh"
+#include "XrdCl/XrdClDefaultEnv.hh"
+#include "XrdCl/XrdClLog.hh"
+#include "XrdCl/XrdClConstants.hh"
 #include "XrdCl/XrdClUglyHacks.hh"
 #include "XrdCl/XrdClURL.hh"
+#include "XrdSys/XrdSysPthread.hh"
 
 #include <vector>
+#include <deque>
+#include <set>
 #include <utility>
 #include <memory>
+#include <algorithm>
+#include <ctime>
+
+namespace
+{
+  //----------------------------------------------------------------------------
+  // Walks a directory tree breadth first on one or more servers keeping the
+  // number of outstanding DirList requests bounded, both overall and for
+  // each server
+  //----------------------------------------------------------------------------
+  class DirListCrawler
+  {
+    public:
+      //------------------------------------------------------------------------
+      // Constructor
+      //------------------------------------------------------------------------
+      DirListCrawler( const std::string          &path,
+                      XrdCl::DirListFlags::Flags  flags,
+                      uint32_t                    maxInFlight,
+                      uint32_t                    maxPerServer,
+                      uint16_t                    timeout ):
+        pCond( 0 ), pMaxInFlight( maxInFlight ), pMaxPerServer( maxPerServer ),
+        pExpires( 0 ), pInFlight( 0 ), pRequests( 0 ), pErrors( 0 ),
+        pResult( new XrdCl::DirectoryList() )
+      {
+        using namespace XrdCl;
+
+        //----------------------------------------------------------------------
+        // Keep the opaque info aside so that we can append it to every
+        // subdirectory we list
+        //----------------------------------------------------------------------
+        std::string::size_type pos = path.find( '?' );
+        pBase = path.substr( 0, pos );
+        if( pos != std::string::npos )
+          pCgi = path.substr( pos );
+        if( pBase.empty() || pBase[pBase.length()-1] != '/' )
+          pBase += '/';
+        pResult->SetParentName( pBase );
+
+        //----------------------------------------------------------------------
+        // We take care of the recursion, the servers and the merging
+        //----------------------------------------------------------------------
+        pMerge = flags & DirListFlags::Merge;
+        pFlags = ( flags & ~( DirListFlags::Recursive | DirListFlags::Locate |
+                              DirListFlags::Merge | DirListFlags::Chunked |
+                              DirListFlags::Zip ) ) | DirListFlags::Stat;
+        if( !pMaxInFlight )  pMaxInFlight  = 1;
+        if( !pMaxPerServer ) pMaxPerServer = 1;
+        if( timeout )
+          pExpires = ::time( 0 ) + timeout;
+      }
+
+      //------------------------------------------------------------------------
+      // Destructor
+      //------------------------------------------------------------------------
+      ~DirListCrawler()
+      {
+        for( size_t i = 0; i < pServers.size(); ++i )
+          if( pServers[i].owned )
+            delete pServers[i].fs;
+        delete pResult;
+      }
+
+      //------------------------------------------------------------------------
+      // Add a server to walk the tree on
+      //------------------------------------------------------------------------
+      void AddServer( XrdCl::FileSystem *fs, bool owned )
+      {
+        Server srv;
+        srv.fs       = fs;
+        srv.owned    = owned;
+        srv.inFlight = 0;
+        srv.queue.push_back( std::string() );
+        pServers.push_back( srv );
+      }
+
+      //------------------------------------------------------------------------
+      // Walk the tree and wait until we are done
+      //------------------------------------------------------------------------
+      XrdCl::XRootDStatus Run( XrdCl::DirectoryList *&result )
+      {
+        using namespace XrdCl;
+
+        pCond.Lock();
+        Dispatch();
+        while( pInFlight )
+          pCond.Wait();
+        pCond.UnLock();
+
+        //----------------------------------------------------------------------
+        // The listings complete in any order, sort them so that the result
+        // does not depend on it
+        //----------------------------------------------------------------------
+        std::sort( pResult->Begin(), pResult->End(), ByName );
+
+        result = pResult; pResult = 0;
+        if( !pErrors )
+          return XRootDStatus();
+        if( pErrors == pRequests && !result->GetSize() )
+        {
+          delete result; result = 0;
+          return pLastError;
+        }
+        return XRootDStatus( stOK, suPartial );
+      }
+
+    private:
+      //------------------------------------------------------------------------
+      // Handle the listing of a single directory
+      //------------------------------------------------------------------------
+      class ItemHandler: public XrdCl::ResponseHandler
+      {
+        public:
+          ItemHandler( DirListCrawler *crawler, size_t server,
+                       const std::string &dir ):
+            pCrawler( crawler ), pServer( server ), pDir( dir ) {}
+
+          virtual void HandleResponse( XrdCl::XRootDStatus *status,
+                                       XrdCl::AnyObject    *response )
+          {
+            XrdCl::DirectoryList *list = 0;
+            if( status->IsOK() && response )
+              response->Get( list );
+            pCrawler->Done( pServer, pDir, *status, list );
+            delete status;
+            delete response;
+            delete this;
+          }
+
+        private:
+          DirListCrawler *pCrawler;
+          size_t          pServer;
+          std::string     pDir;
+      };
+
+      struct Server
+      {
+        XrdCl::FileSystem       *fs;
+        bool                     owned;
+        uint32_t                 inFlight;
+        std::deque<std::string>  queue; // directories relative to pBase
+      };
+
+      //------------------------------------------------------------------------
+      // Send as many queued requests as the limits allow, the caller must
+      // hold the lock which is released while a request is being sent
+      //------------------------------------------------------------------------
+      void Dispatch()
+      {
+        using namespace XrdCl;
+        Log  *log  = DefaultEnv::GetLog();
+        bool  sent = true;
+
+        while( sent && pInFlight < pMaxInFlight )
+        {
+          sent = false;
+          for( size_t i = 0; i < pServers.size() && pInFlight < pMaxInFlight; ++i )
+          {
+            Server &srv = pServers[i];
+            if( srv.queue.empty() || srv.inFlight >= pMaxPerServer )
+              continue;
+
+            std::string dir = srv.queue.front();
+            srv.queue.pop_front();
+            sent = true;
+            ++pRequests;
+
+            uint16_t timeout = 0;
+            if( pExpires )
+            {
+              time_t left = pExpires - ::time( 0 );
+              if( left <= 0 )
+              {
+                log->Error( FileMsg, "Recursive directory list operation for "
+                            "%s expired.", pBase.c_str() );
+                Failed( XRootDStatus( stError, errOperationExpired ) );
+                continue;
+              }
+              timeout = left;
+            }
+
+            ++pInFlight; ++srv.inFlight;
+            std::string  path    = pBase + dir + pCgi;
+            ItemHandler *handler = new ItemHandler( this, i, dir );
+            FileSystem  *fs      = srv.fs;
+            pCond.UnLock();
+            XRootDStatus st = fs->DirList( path, pFlags, handler, timeout );
+            pCond.Lock();
+            if( !st.IsOK() )
+            {
+              log->Error( FileMsg, "Recursive directory list operation for "
+                          "%s failed: %s", path.c_str(), st.ToString().c_str() );
+              delete handler;
+              --pInFlight; --pServers[i].inFlight;
+              Failed( st );
+            }
+          }
+        }
+      }
+
+      //------------------------------------------------------------------------
+      // Take in the listing of a directory and queue its subdirectories
+      //------------------------------------------------------------------------
+      void Done( size_t server, const std::string &dir,
+                 const XrdCl::XRootDStatus &status, XrdCl::DirectoryList *list )
+      {
+        using namespace XrdCl;
+        Log *log = DefaultEnv::GetLog();
+
+        XrdSysCondVarHelper scoped( pCond );
+        --pInFlight; --pServers[server].inFlight;
+
+        if( !status.IsOK() || !list )
+          Failed( status.IsOK() ? XRootDStatus( stError, errInternal ) : status );
+        else
+        {
+          if( status.code == suPartial )
+            ++pErrors;
+
+          DirectoryList::Iterator itr;
+          for( itr = list->Begin(); itr != list->End(); ++itr )
+          {
+            DirectoryList::ListEntry *entry = *itr;
+            StatInfo *info = entry->GetStatInfo();
+            if( !info )
+            {
+              log->Error( FileMsg, "Recursive directory list operation for %s "
+                          "failed: kXR_dirlist with stat operation not "
+                          "supported.", pBase.c_str() );
+              Failed( XRootDStatus( stError, errNotSupported ) );
+              break;
+            }
+
+            std::string name = dir + entry->GetName();
+            if( info->TestFlags( StatInfo::IsDir ) )
+              pServers[server].queue.push_back( name + "/" );
+
+            if( pMerge && !pSeen.insert( Key( name, info ) ).second )
+              continue;
+
+            entry->SetStatInfo( 0 ); // StatInfo is no longer owned by list
+            pResult->Add( new DirectoryList::ListEntry( entry->GetHostAddress(),
+                                                        name, info ) );
+          }
+        }
+
+        Dispatch();
+        if( !pInFlight )
+          pCond.Broadcast();
+      }
+
+      //------------------------------------------------------------------------
+      // Record a failure, the caller must hold the lock
+      //------------------------------------------------------------------------
+      void Failed( const XrdCl::XRootDStatus &status )
+      {
+        ++pErrors;
+        pLastError = status;
+      }
+
+      //------------------------------------------------------------------------
+      // Duplicates have the same name, size and flags
+      //------------------------------------------------------------------------
+      typedef std::pair<std::string, std::pair<uint64_t, uint32_t> > EntryKey;
+
+      static EntryKey Key( const std::string &name, const XrdCl::StatInfo *info )
+      {
+        return EntryKey( name, std::make_pair( info->GetSize(),
+                                               info->GetFlags() ) );
+      }
+
+      static bool ByName( const XrdCl::DirectoryList::ListEntry *x,
+                          const XrdCl::DirectoryList::ListEntry *y )
+      {
+        int rc = x->GetName().compare( y->GetName() );
+        if( rc ) return rc < 0;
+        return x->GetHostAddress() < y->GetHostAddress();
+      }
+
+      XrdSysCondVar                  pCond;
+      std::string                    pBase;
+      std::string                    pCgi;
+      XrdCl::DirListFlags::Flags     pFlags;
+      bool                           pMerge;
+      uint32_t                       pMaxInFlight;
+      uint32_t                       pMaxPerServer;
+      time_t                         pExpires;
+      uint32_t                       pInFlight;
+      uint32_t                       pRequests;
+      uint32_t                       pErrors;
+      XrdCl::XRootDStatus            pLastError;
+      std::vector<Server>            pServers;
+      std::set<EntryKey>             pSeen;
+      XrdCl::DirectoryList          *pResult;
+  };
+}
 
 namespace XrdCl
 {
@@ -112,4 +413,67 @@ namespace XrdCl
     st = XRootDStatus(); if( partial ) st.code = suPartial;
     return st;
   }
+
+  //----------------------------------------------------------------------------
+  // Recursively list the given directory
+  //----------------------------------------------------------------------------
+  XRootDStatus FileSystemUtils::ListRecursive( FileSystem           *fs,
+                                               const std::string    &path,
+                                               DirListFlags::Flags   flags,
+                                               DirectoryList       *&result,
+                                               uint32_t              maxInFlight,
+                                               uint32_t              maxPerServer,
+                                               uint16_t              timeout )
+  {
+    //--------------------------------------------------------------------------
+    // Get the limits
+    //--------------------------------------------------------------------------
+    Env *env = DefaultEnv::GetEnv();
+    int  val;
+    if( !maxInFlight )
+    {
+      val = DefaultDirListMaxInFlight;
+      env->GetInt( "DirListMaxInFlight", val );
+      maxInFlight = val > 0 ? val : 1;
+    }
+    if( !maxPerServer )
+    {
+      val = DefaultDirListMaxPerServer;
+      env->GetInt( "DirListMaxPerServer", val );
+      maxPerServer = val > 0 ? val : 1;
+    }
+
+    DirListCrawler crawler( path, flags, maxInFlight, maxPerServer, timeout );
+    bool           partial = false;
+
+    //--------------------------------------------------------------------------
+    // Locate all the disk servers holding the directory or just walk the tree
+    // on the one we have
+    //--------------------------------------------------------------------------
+    if( flags & DirListFlags::Locate )
+    {
+      LocationInfo *locations = 0;
+      XRootDStatus st = fs->DeepLocate( "*" + path,
+                                        OpenFlags::PrefName, locations,
+                                        timeout );
+      if( !st.IsOK() )
+        return st;
+
+      XRDCL_SMART_PTR_T<LocationInfo> locationsPtr( locations );
+      if( locations->GetSize() == 0 )
+        return XRootDStatus( stError, errNotFound );
+
+      partial = st.code == suPartial;
+      for( uint32_t i = 0; i < locations->GetSize(); ++i )
+        crawler.AddServer( new FileSystem( locations->At(i).GetAddress() ),
+                           true );
+    }
+    else
+      crawler.AddServer( fs, false );
+
+    XRootDStatus st = crawler.Run( result );
+    if( st.IsOK() && partial )
+      st.code = suPartial;
+    return st;
+  }
 }
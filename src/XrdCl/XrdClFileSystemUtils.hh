@@ -26,14 +26,13 @@
 #define __XRD_CL_FILE_SYSTEM_UTILS_HH__
 
 #include "XrdCl/XrdClXRootDResponses.hh"
+#include "XrdCl/XrdClFileSystem.hh"
 
 #include <string>
 #include <stdint.h>
 
 namespace XrdCl
 {
-  class FileSystem;
-
   //----------------------------------------------------------------------------
   //! A container for file system utility functions that do not belong in
   //! FileSystem
@@ -85,6 +84,35 @@ namespace XrdCl
       static XRootDStatus GetSpaceInfo( SpaceInfo         *&result,
                                         FileSystem         *fs,
                                         const std::string  &path );
+
+      //------------------------------------------------------------------------
+      //! Recursively list the given directory. The tree is walked breadth
+      //! first with a bounded number of DirList requests in flight instead of
+      //! one request per directory at a time. If the Locate flag is set the
+      //! tree is walked on every server holding the directory and the
+      //! per-server limit applies to each of them.
+      //!
+      //! @param fs           file system the path refers to
+      //! @param path         path to the directory
+      //! @param flags        DirListFlags, Recursive and Stat are implied
+      //! @param result       the listing, entry names are relative to path;
+      //!                     to be deleted by the user
+      //! @param maxInFlight  maximum number of outstanding requests, 0 means
+      //!                     XRD_DIRLISTMAXINFLIGHT
+      //! @param maxPerServer maximum number of outstanding requests to a
+      //!                     single server, 0 means XRD_DIRLISTMAXPERSERVER
+      //! @param timeout      timeout value for the whole listing, if 0 the
+      //!                     environment default will be used
+      //! @return             status of the operation, suPartial if some of
+      //!                     the directories could not be listed
+      //------------------------------------------------------------------------
+      static XRootDStatus ListRecursive( FileSystem           *fs,
+                                         const std::string    &path,
+                                         DirListFlags::Flags   flags,
+                                         DirectoryList       *&result,
+                                         uint32_t              maxInFlight  = 0,
+                                         uint32_t              maxPerServer = 0,
+                                         uint16_t              timeout      = 0 );
   };
 }
 
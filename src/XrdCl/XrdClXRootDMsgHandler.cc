@@ -1537,6 +1537,13 @@ namespace XrdCl
         path[req->dirlist.dlen] = 0;
         memcpy( path, pRequest->GetBuffer(24), req->dirlist.dlen );
 
+        //----------------------------------------------------------------------
+        // A paged listing may have the cursor after the path
+        //----------------------------------------------------------------------
+        char *cursor = strchr( path, '\n' );
+        if( cursor )
+          *cursor = 0;
+
         DirectoryList *data = new DirectoryList();
         data->SetParentName( path );
         delete [] path;
@@ -1545,6 +1552,21 @@ namespace XrdCl
         nullBuffer[length] = 0;
         memcpy( nullBuffer, buffer, length );
 
+        //----------------------------------------------------------------------
+        // If there are more pages the last line holds the cursor for the
+        // next one, it always starts with a slash
+        //----------------------------------------------------------------------
+        if( req->dirlist.options[0] & kXR_dcursor )
+        {
+          char *nl   = strrchr( nullBuffer, '\n' );
+          char *line = nl ? nl + 1 : nullBuffer;
+          if( *line == '/' )
+          {
+            data->SetCursor( line + 1 );
+            *( nl ? nl : nullBuffer ) = 0;
+          }
+        }
+
         bool invalidrsp = false;
 
         if( !pDirListStarted )
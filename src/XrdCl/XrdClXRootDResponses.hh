@@ -682,6 +682,23 @@ namespace XrdCl
           pParent += "/";
       }
 
+      //------------------------------------------------------------------------
+      //! Get the cursor to continue a paged listing, empty if the listing
+      //! is complete
+      //------------------------------------------------------------------------
+      const std::string &GetCursor() const
+      {
+        return pCursor;
+      }
+
+      //------------------------------------------------------------------------
+      //! Set the cursor to continue a paged listing
+      //------------------------------------------------------------------------
+      void SetCursor( const std::string &cursor )
+      {
+        pCursor = cursor;
+      }
+
       //------------------------------------------------------------------------
       //! Parse server response and fill up the object
       //------------------------------------------------------------------------
@@ -703,6 +720,7 @@ namespace XrdCl
     private:
       DirList     pDirList;
       std::string pParent;
+      std::string pCursor;
 
       static const std::string dStatPrefix;
   };
@@ -762,6 +780,72 @@ namespace XrdCl
       StatInfo *pStatInfo;
   };
 
+  //----------------------------------------------------------------------------
+  //! Results of a batch of stat or open requests, one entry for each path in
+  //! the order in which the paths were given
+  //----------------------------------------------------------------------------
+  class StatBatchInfo
+  {
+    public:
+      //------------------------------------------------------------------------
+      //! Constructor
+      //------------------------------------------------------------------------
+      StatBatchInfo( uint32_t size = 0 ):
+        pStatus( size ), pStatInfo( size, (StatInfo*)0 )
+      {
+      }
+
+      //------------------------------------------------------------------------
+      //! Destructor
+      //------------------------------------------------------------------------
+      ~StatBatchInfo()
+      {
+        for( uint32_t i = 0; i < pStatInfo.size(); ++i )
+          delete pStatInfo[i];
+      }
+
+      //------------------------------------------------------------------------
+      //! Get the number of entries
+      //------------------------------------------------------------------------
+      uint32_t GetSize() const
+      {
+        return pStatInfo.size();
+      }
+
+      //------------------------------------------------------------------------
+      //! Get the status of the request for the entry at index
+      //------------------------------------------------------------------------
+      const XRootDStatus &GetStatus( uint32_t index ) const
+      {
+        return pStatus[index];
+      }
+
+      //------------------------------------------------------------------------
+      //! Get the stat info of the entry at index, 0 if it is not available
+      //------------------------------------------------------------------------
+      const StatInfo *GetStatInfo( uint32_t index ) const
+      {
+        return pStatInfo[index];
+      }
+
+      //------------------------------------------------------------------------
+      //! Set the result for the entry at index, takes over the stat info
+      //------------------------------------------------------------------------
+      void Set( uint32_t index, const XRootDStatus &status, StatInfo *info )
+      {
+        pStatus[index] = status;
+        delete pStatInfo[index];
+        pStatInfo[index] = info;
+      }
+
+    private:
+      StatBatchInfo( const StatBatchInfo & );
+      StatBatchInfo &operator=( const StatBatchInfo & );
+
+      std::vector<XRootDStatus>  pStatus;
+      std::vector<StatInfo*>     pStatInfo;
+  };
+
   //----------------------------------------------------------------------------
   //! Describe a data chunk for vector read
   //----------------------------------------------------------------------------
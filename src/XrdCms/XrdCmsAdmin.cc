@@ -41,6 +41,7 @@
 
 #include "XrdCms/XrdCmsAdmin.hh"
 #include "XrdCms/XrdCmsConfig.hh"
+#include "XrdCms/XrdCmsFilter.hh"
 #include "XrdCms/XrdCmsManager.hh"
 #include "XrdCms/XrdCmsPrepare.hh"
 #include "XrdCms/XrdCmsState.hh"
@@ -801,6 +802,10 @@ void XrdCmsAdmin::do_RmDud(int isPfn)
           } else tp = apath;
       }
 
+// Add the path to our namespace filter before our managers hear about it
+//
+   NSFilter.Added(tp);
+
 // Check if we are relaying remove events and, if so, vector through that.
 //
    if (areFunc) AddEvent(tp, kYR_have, Mods);
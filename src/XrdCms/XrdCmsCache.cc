@@ -28,13 +28,22 @@
 /* specific prior written permission of the institution or contributor.       */
 /******************************************************************************/
   
+#include <errno.h>
+#include <fcntl.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <vector>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <sys/types.h>
 
 #include "XrdCms/XrdCmsCache.hh"
 #include "XrdCms/XrdCmsRRQ.hh"
 #include "XrdCms/XrdCmsTrace.hh"
 
+#include "XrdSys/XrdSysAtomics.hh"
+#include "XrdSys/XrdSysError.hh"
 #include "XrdSys/XrdSysTimer.hh"
 
 #include "Xrd/XrdJob.hh"
@@ -72,10 +81,34 @@ private:
 XrdCmsKeyItem *myList;
 };
 
+namespace
+{
+const char snapMagic[8] = {'X','r','d','C','m','s','C','1'};
+const int  snapVersion  = 1;
+
+// Arguments passed by Save() to SaveItem()
+//
+struct SnapArgs
+      {std::vector<char> *bP;
+       SMask_t            vVec;
+       long long          num;
+       unsigned int       bClock;
+       int                vecHi;
+       unsigned int       bounced[STMax];
+      };
+
+inline int snapPad(int n) {return (n + 7) & ~7;}
+}
+
 /******************************************************************************/
 /*            E x t e r n a l   T h r e a d   I n t e r f a c e s             */
 /******************************************************************************/
   
+void *XrdCmsStartSnapper(void *carg)
+     {XrdCmsCache *myCache = (XrdCmsCache *)carg;
+      return myCache->Snapper();
+     }
+
 void *XrdCmsStartTickTock(void *carg)
      {XrdCmsCache *myCache = (XrdCmsCache *)carg;
       return myCache->TickTock();
@@ -119,10 +152,12 @@ int XrdCmsCache::AddFile(XrdCmsSelect &Sel, SMask_t mask)
    XrdCmsKeyItem *iP;
    SMask_t xmask;
    int isrw = (Sel.Opts & XrdCmsSelect::Write), isnew = 0;
+   int shard = CTable.Shard(Sel.Path);
 
-// Serialize processing
+// Serialize processing for this key's shard. The fast path is safe as an item
+// can only have our hash, and thus be equivalent, while in our shard.
 //
-   myMutex.Lock();
+   CTable.Lock(shard);
 
 // Check for fast path processing
 //
@@ -137,8 +172,8 @@ int XrdCmsCache::AddFile(XrdCmsSelect &Sel, SMask_t mask)
           {iP->Loc.deadline = QDelay + time(0);
            iP->Loc.lifeline = nilTMO + iP->Loc.deadline;
            iP->Loc.hfvec = 0; iP->Loc.pfvec = 0; iP->Loc.qfvec = 0;
-           iP->Loc.TOD_B = BClock;
-           iP->Key.TOD = Tock;
+           iP->Loc.TOD_B = AtomicGet(BClock);
+           iP->Key.TOD = CTable.Tock(shard);
           } else {
            xmask = iP->Loc.pfvec;
            if (Sel.Opts & XrdCmsSelect::Pending) iP->Loc.pfvec |= mask;
@@ -155,11 +190,10 @@ int XrdCmsCache::AddFile(XrdCmsSelect &Sel, SMask_t mask)
                      }
           }
       } else if (!(Sel.Opts & XrdCmsSelect::Advisory))
-                {Sel.Path.TOD = Tock;
-                 if ((iP = CTable.Add(Sel.Path)))
+                {if ((iP = CTable.Add(Sel.Path)))
                     {iP->Loc.pfvec    = (Sel.Opts&XrdCmsSelect::Pending?mask:0);
                      iP->Loc.hfvec    = mask;
-                     iP->Loc.TOD_B    = BClock;
+                     iP->Loc.TOD_B    = AtomicGet(BClock);
                      iP->Loc.qfvec    = 0;
                      iP->Loc.deadline = QDelay + time(0);
                      iP->Loc.lifeline = nilTMO + iP->Loc.deadline;
@@ -170,7 +204,7 @@ int XrdCmsCache::AddFile(XrdCmsSelect &Sel, SMask_t mask)
 
 // All done
 //
-   myMutex.UnLock();
+   CTable.UnLock(shard);
    return isnew;
 }
   
@@ -191,11 +225,11 @@ int XrdCmsCache::AddFile(XrdCmsSelect &Sel, SMask_t mask)
 int XrdCmsCache::DelFile(XrdCmsSelect &Sel, SMask_t mask)
 {
    XrdCmsKeyItem *iP;
-   int gone4good;
+   int gone4good, shard = CTable.Shard(Sel.Path);
 
-// Lock the hash table
+// Lock the key's shard of the hash table
 //
-   myMutex.Lock();
+   CTable.Lock(shard);
 
 // Look up the entry and remove server
 //
@@ -205,14 +239,14 @@ int XrdCmsCache::DelFile(XrdCmsSelect &Sel, SMask_t mask)
        if ((gone4good = (iP->Loc.hfvec == 0)))
           {if (nilTMO) iP->Loc.lifeline = nilTMO + time(0);
            if (!(Sel.Opts & XrdCmsSelect::Advisory)
-           &&  XrdCmsKeyItem::Unload(iP) && !CTable.Recycle(iP))
-              Say.Emsg("DelFile", "Delete failed for", iP->Key.Val);
+           &&  CTable.Unload(iP) && !CTable.Recycle(iP))
+              Say.Emsg("DelFile", "Delete failed for", Sel.Path.Val);
           }
       } else gone4good = 0;
 
 // All done
 //
-   myMutex.UnLock();
+   CTable.UnLock(shard);
    return gone4good;
 }
   
@@ -232,18 +266,22 @@ int XrdCmsCache::DelFile(XrdCmsSelect &Sel, SMask_t mask)
 int  XrdCmsCache::GetFile(XrdCmsSelect &Sel, SMask_t mask)
 {
    XrdCmsKeyItem *iP;
-   SMask_t bVec;
-   int retc;
+   SMask_t bVec, vVec;
+   int retc, shard = CTable.Shard(Sel.Path);
 
-// Lock the hash table
+// Lock the key's shard of the hash table
 //
-   myMutex.Lock();
+   CTable.Lock(shard);
 
 // Look up the entry and return location information
 //
    if ((iP = CTable.Find(Sel.Path)))
-      {if ((bVec = (iP->Loc.TOD_B < BClock 
-                 ? getBVec(iP->Key.TOD, iP->Loc.TOD_B) & mask : 0)))
+      {bMutex.Lock();
+       bVec = (iP->Loc.TOD_B < BClock
+            ? getBVec(iP->Key.TOD, iP->Loc.TOD_B) & mask : 0);
+       vVec = okVec;
+       bMutex.UnLock();
+       if (bVec)
           {iP->Loc.hfvec &= ~bVec; 
            iP->Loc.pfvec &= ~bVec;
            iP->Loc.qfvec &= ~mask;
@@ -258,15 +296,15 @@ int  XrdCmsCache::GetFile(XrdCmsSelect &Sel, SMask_t mask)
        if (nilTMO && retc == 1 && iP->Loc.hfvec == 0
        &&  iP->Loc.lifeline <= time(0)) retc = 0;
 
-       Sel.Vec.hf      = okVec & iP->Loc.hfvec;
-       Sel.Vec.pf      = okVec & iP->Loc.pfvec;
-       Sel.Vec.bf      = okVec & (bVec | iP->Loc.qfvec); iP->Loc.qfvec = 0;
+       Sel.Vec.hf      = vVec & iP->Loc.hfvec;
+       Sel.Vec.pf      = vVec & iP->Loc.pfvec;
+       Sel.Vec.bf      = vVec & (bVec | iP->Loc.qfvec); iP->Loc.qfvec = 0;
        Sel.Path.Ref    = iP->Key.Ref;
       } else retc = 0;
 
 // All done
 //
-   myMutex.UnLock();
+   CTable.UnLock(shard);
    Sel.Path.TODRef = iP;
    return retc;
 }
@@ -279,10 +317,11 @@ int XrdCmsCache::UnkFile(XrdCmsSelect &Sel, SMask_t mask)
 {
    EPNAME("UnkFile");
    XrdCmsKeyItem *iP;
+   int shard = CTable.Shard(Sel.Path);
 
-// Make sure we have the proper information. If so, lock the hash table
+// Make sure we have the proper information. If so, lock the key's shard
 //
-   myMutex.Lock();
+   CTable.Lock(shard);
 
 // Look up the entry and if valid update the unqueried vector. Note that
 // this method may only be called after GetFile() or AddFile() for a new entry
@@ -294,7 +333,7 @@ int XrdCmsCache::UnkFile(XrdCmsSelect &Sel, SMask_t mask)
 
 // Return result
 //
-   myMutex.UnLock();
+   CTable.UnLock(shard);
    DEBUG("rc=" <<(iP ? 1 : 0) <<" path=" <<Sel.Path.Val);
    return (iP ? 1 : 0);
 }
@@ -308,12 +347,13 @@ int XrdCmsCache::WT4File(XrdCmsSelect &Sel, SMask_t mask)
    EPNAME("WT4File");
    XrdCmsKeyItem *iP;
    time_t  Now;
-   int     retc;
+   int     retc, shard;
 
-// Make sure we have the proper information. If so, lock the hash table
+// Make sure we have the proper information. If so, lock the key's shard
 //
    if (!Sel.InfoP) return DLTime;
-   myMutex.Lock();
+   shard = CTable.Shard(Sel.Path);
+   CTable.Lock(shard);
 
 // Look up the entry and if valid add it to the callback queue. Note that
 // this method may only be called after GetFile() or AddFile() for a new entry
@@ -328,7 +368,7 @@ int XrdCmsCache::WT4File(XrdCmsSelect &Sel, SMask_t mask)
 
 // Return result
 //
-   myMutex.UnLock();
+   CTable.UnLock(shard);
    DEBUG("rc=" <<retc <<" path=" <<Sel.Path.Val);
    return retc;
 }
@@ -345,11 +385,11 @@ void XrdCmsCache::Bounce(SMask_t smask, int SNum)
 
 // Simply indicate that this server bounced
 //
-   myMutex.Lock();
-   Bounced[SNum] = ++BClock;
+   bMutex.Lock();
+   Bounced[SNum] = AtomicInc(BClock)+1;
    okVec |= smask;
    if (SNum > vecHi) vecHi = SNum;
-   myMutex.UnLock();
+   bMutex.UnLock();
 }
 
 /******************************************************************************/
@@ -366,11 +406,11 @@ void XrdCmsCache::Drop(SMask_t smask, int SNum, int xHi)
 
 // Remove the node from the list of valid nodes
 //
-   myMutex.Lock();
+   bMutex.Lock();
    Bounced[SNum] = 0;
    okVec &= nmask;
    vecHi = xHi;
-   myMutex.UnLock();
+   bMutex.UnLock();
 }
 
 /******************************************************************************/
@@ -379,7 +419,6 @@ void XrdCmsCache::Drop(SMask_t smask, int SNum, int xHi)
   
 int XrdCmsCache::Init(int fxHold, int fxDelay, int fxQuery, int seFS, int nxHold)
 {
-   XrdCmsKeyItem *iP;
    pthread_t tid;
 
 // Indicate whether we are a shared-everything setup as this changes how we
@@ -411,15 +450,116 @@ int XrdCmsCache::Init(int fxHold, int fxDelay, int fxQuery, int seFS, int nxHold
 
 // Get the first reserve of cache items
 //
-   iP = XrdCmsKeyItem::Alloc(0);
-   XrdCmsKeyItem::Unload((unsigned int)0);
-   iP->Recycle();
+   XrdCmsKeyItem::Replenish();
+
+// Reload the snapshot, if we have one, and start saving the cache. Snapshots
+// are not used in shared-everything setups as any node may serve any file.
+//
+   if (snapPath)
+      {if (isDFS)
+          {Say.Say("Config warning: cache snapshots are not used with a "
+                   "shared file system.");
+          } else {
+           snapIdent = (char (*)[IdentLen])calloc(STMax, IdentLen);
+           SnapLoad(fxHold);
+           if (XrdSysThread::Run(&tid, XrdCmsStartSnapper, (void *)this,
+                                    0, "Cache snapshot"))
+              {Say.Emsg("Init", errno, "start cache snapshot");
+               return 0;
+              }
+          }
+      }
 
 // All done
 //
    return 1;
 }
 
+/******************************************************************************/
+/* public                        R e s t o r e                                */
+/******************************************************************************/
+
+// This method is called each time a node logs in. The node's identity is
+// recorded so that it can be saved with the next snapshot. If the node was in
+// the snapshot we loaded, its locations are added to the cache.
+
+void XrdCmsCache::Restore(const char *ident, int SNum, SMask_t smask)
+{
+   SnapHdr *hP;
+   char buff[32];
+   int i, num;
+
+// Snapshots may not be enabled
+//
+   if (!snapIdent) return;
+
+// Record the identity of the node in this slot
+//
+   sMutex.Lock();
+   strncpy(snapIdent[SNum], ident, IdentLen-1);
+   snapIdent[SNum][IdentLen-1] = 0;
+
+// Locations older than the hold time may no longer be valid, so nodes that
+// log in after that get nothing restored.
+//
+   if (snapLeft && time(0) > snapExp)
+      SnapDrop("Config cache snapshot expired before all its nodes logged in.");
+
+// Find the node in the snapshot, if it's still around
+//
+   if (snapLeft)
+      {hP = (SnapHdr *)snapMap;
+       char (*idP)[IdentLen] = (char (*)[IdentLen])(snapMap + sizeof(SnapHdr));
+       for (i = 0; i < hP->NumNodes; i++)
+           if (snapLeft & (1ULL << i) && !strcmp(idP[i], snapIdent[SNum]))
+              break;
+       if (i < hP->NumNodes)
+          {snapLeft &= ~(1ULL << i);
+           num = SnapRestore(SNum, smask, i);
+           sprintf(buff, "%d", num);
+           Say.Say("Config restored ", buff, " cached locations for ", ident);
+          }
+       if (!snapLeft)
+          SnapDrop("Config all nodes in the cache snapshot have logged in.");
+      }
+   sMutex.UnLock();
+}
+
+/******************************************************************************/
+/* public                        s e t S n a p                                */
+/******************************************************************************/
+
+void XrdCmsCache::setSnap(const char *path, int secs)
+{
+   if (snapPath) free(snapPath);
+   snapPath  = strdup(path);
+   snapEvery = secs;
+}
+
+/******************************************************************************/
+/* public                        S n a p p e r                                */
+/******************************************************************************/
+
+void *XrdCmsCache::Snapper()
+{
+
+// Periodically save the cache. A snapshot we loaded is released once its
+// locations are too old to be restored even if some nodes never came back.
+//
+   do {XrdSysTimer::Snooze(snapEvery);
+       sMutex.Lock();
+       if (snapLeft && time(0) > snapExp)
+          SnapDrop("Config cache snapshot expired before all its nodes "
+                   "logged in.");
+       sMutex.UnLock();
+       Save();
+      } while(1);
+
+// Keep compiler happy
+//
+   return (void *)0;
+}
+
 /******************************************************************************/
 /* public                       T i c k T o c k                               */
 /******************************************************************************/
@@ -427,15 +567,23 @@ int XrdCmsCache::Init(int fxHold, int fxDelay, int fxQuery, int seFS, int nxHold
 void *XrdCmsCache::TickTock()
 {
    XrdCmsKeyItem *iP;
+   unsigned int theTock;
+   int i;
 
-// Simply adjust the clock and trim old entries
+// Simply adjust the clock and trim old entries. Each shard is trimmed in turn
+// so that lookups in the other shards proceed while we do so.
 //
    do {XrdSysTimer::Snooze(Tick);
-       myMutex.Lock();
-       Tock = (Tock+1) & XrdCmsKeyItem::TickMask;
+       bMutex.Lock();
+       theTock = Tock = (Tock+1) & XrdCmsKeyItem::TickMask;
        Bhistory[Tock].Start = Bhistory[Tock].End = 0;
-       iP = XrdCmsKeyItem::Unload(Tock);
-       myMutex.UnLock();
+       bMutex.UnLock();
+       iP = 0;
+       for (i = 0; i < XrdCmsNash::NumShards; i++)
+           {CTable.Lock(i);
+            iP = CTable.Unload(i, theTock, iP);
+            CTable.UnLock(i);
+           }
        if (iP) Sched->Schedule((XrdJob *)new XrdCmsCacheJob(iP));
       } while(1);
 
@@ -502,6 +650,8 @@ void XrdCmsCache::Dispatch(XrdCmsSelect &Sel, XrdCmsKeyItem *iP,
 /*                               g e t B V e c                                */
 /******************************************************************************/
   
+// Must be called with bMutex held.
+//
 SMask_t XrdCmsCache::getBVec(unsigned int TODa, unsigned int &TODb)
 {
    EPNAME("getBVec");
@@ -534,8 +684,10 @@ SMask_t XrdCmsCache::getBVec(unsigned int TODa, unsigned int &TODb)
 void XrdCmsCache::Recycle(XrdCmsKeyItem *theList)
 {
    XrdCmsKeyItem *iP;
-   char msgBuff[100];
-   int numNull, numHave, numFree, numRecycled = 0;
+   char msgBuff[160];
+   long long pfxBytes;
+   int numNull, numHave, numFree, numRecycled = 0, shard;
+   int numItems, numSlots, numMoving, numPfx;
 
 // Recycle the list of cache items, as needed
 //
@@ -543,28 +695,286 @@ void XrdCmsCache::Recycle(XrdCmsKeyItem *theList)
         {theList = iP->Key.TODRef;
          if (iP->Loc.roPend) RRQ.Del(iP->Loc.roPend, iP);
          if (iP->Loc.rwPend) RRQ.Del(iP->Loc.rwPend, iP);
-         myMutex.Lock(); CTable.Recycle(iP); myMutex.UnLock();
+         shard = XrdCmsNash::Shard(iP->Loc.HashSave);
+         CTable.Lock(shard); CTable.Recycle(iP); CTable.UnLock(shard);
          numRecycled++;
         }
 
 // See if we have enough items in reserve
 //
-   myMutex.Lock();
    XrdCmsKeyItem::Stats(numHave, numFree, numNull);
    if (numFree < XrdCmsKeyItem::minFree)
-      {myMutex.UnLock();
-       if (!(numNull /= 4)) numNull = 1;
+      {if (!(numNull /= 4)) numNull = 1;
        numHave += XrdCmsKeyItem::minAlloc * numNull;
-       while(numNull--)
-            {myMutex.Lock();
-             numFree = XrdCmsKeyItem::Replenish();
-             myMutex.UnLock();
-            }
-      } else myMutex.UnLock();
+       while(numNull--) numFree = XrdCmsKeyItem::Replenish();
+      }
 
 // Log the stats
 //
-   sprintf(msgBuff, "%d cache items; %d allocated %d free",
-           numRecycled, numHave, numFree);
+   CTable.Stats(numItems, numSlots, numMoving);
+   XrdCmsKeyPfx::Stats(numPfx, pfxBytes);
+   snprintf(msgBuff, sizeof(msgBuff), "%d cache items; %d allocated %d free; "
+            "%d in %d slots (%d resizing); %d dirs %lld bytes",
+            numRecycled, numHave, numFree, numItems, numSlots, numMoving,
+            numPfx, pfxBytes);
    Say.Emsg("Recycle", msgBuff);
 }
+
+/******************************************************************************/
+/*                                  S a v e                                   */
+/******************************************************************************/
+
+// Write the locations of all valid entries to a new file that then replaces
+// the previous snapshot. Entries whose query is still pending, as well as the
+// locations of nodes that went away or bounced, are not saved.
+
+void XrdCmsCache::Save()
+{
+   EPNAME("Save");
+   std::vector<char> theBuff;
+   SnapArgs sArgs;
+   SnapHdr  theHdr;
+   char tmpPath[1024], *idBuff;
+   int fd, rc = 0, i;
+
+// Create the new snapshot file
+//
+   snprintf(tmpPath, sizeof(tmpPath), "%s.new", snapPath);
+   if ((fd = open(tmpPath, O_WRONLY|O_CREAT|O_TRUNC, 0640)) < 0)
+      {Say.Emsg("Save", errno, "create", tmpPath); return;}
+
+// Fill out the header and the identities of the nodes we currently have
+//
+   memset(&theHdr, 0, sizeof(theHdr));
+   memcpy(theHdr.Magic, snapMagic, sizeof(theHdr.Magic));
+   theHdr.Version  = snapVersion;
+   theHdr.NumNodes = STMax;
+   theHdr.Taken    = time(0);
+   theBuff.resize(sizeof(theHdr) + STMax*IdentLen);
+   idBuff = &theBuff[sizeof(theHdr)];
+   bMutex.Lock();
+   sArgs.vVec   = okVec;
+   sArgs.bClock = BClock;
+   sArgs.vecHi  = vecHi;
+   memcpy(sArgs.bounced, Bounced, sizeof(sArgs.bounced));
+   bMutex.UnLock();
+   sMutex.Lock();
+   for (i = 0; i < STMax; i++)
+       if (sArgs.vVec & (1ULL << i)) strcpy(idBuff+i*IdentLen, snapIdent[i]);
+   sMutex.UnLock();
+
+// Copy out the items one shard at a time and write them out with no lock held.
+// The bounce state copied above is used so that lookups are only ever held up
+// by the shard being copied.
+//
+   sArgs.bP = &theBuff; sArgs.num = 0;
+   for (i = 0; i < XrdCmsNash::NumShards && !rc; i++)
+       {CTable.Lock(i);
+        CTable.Apply(i, SaveItem, (void *)&sArgs);
+        CTable.UnLock(i);
+        if (!theBuff.empty()
+        &&  write(fd, theBuff.data(), theBuff.size()) != (ssize_t)theBuff.size())
+           rc = (errno ? errno : EIO);
+        theBuff.clear();
+       }
+
+// Fill in the item count and replace the previous snapshot
+//
+   theHdr.NumItems = sArgs.num;
+   if (!rc && pwrite(fd, &theHdr, sizeof(theHdr), 0) != (ssize_t)sizeof(theHdr))
+      rc = (errno ? errno : EIO);
+   if (!rc && fsync(fd)) rc = errno;
+   close(fd);
+   if (!rc && rename(tmpPath, snapPath)) rc = errno;
+   if (rc) {Say.Emsg("Save", rc, "write cache snapshot", tmpPath);
+            unlink(tmpPath);
+           }
+      else DEBUG(sArgs.num <<" cached locations saved in " <<snapPath);
+}
+
+/******************************************************************************/
+/*                              S a v e I t e m                               */
+/******************************************************************************/
+
+// Called with the shard lock held for each item in the shard.
+
+bool XrdCmsCache::SaveItem(XrdCmsKeyItem *iP, void *arg)
+{
+   SnapArgs &sArgs = *(SnapArgs *)arg;
+   SnapItem  theItem;
+   SMask_t   hVec;
+   char thePath[XrdCmsMAX_PATH_LEN+1];
+   int plen, iLen;
+
+// Only save resolved entries that have known locations
+//
+   if (iP->Loc.deadline || !(hVec = iP->Loc.hfvec & sArgs.vVec)) return true;
+   if (iP->Loc.TOD_B < sArgs.bClock)
+      for (int i = 0; i <= sArgs.vecHi; i++)
+          if (iP->Loc.TOD_B < sArgs.bounced[i]) hVec &= ~(1ULL << i);
+   if (!hVec || (plen = iP->Path(thePath, sizeof(thePath))) < 0) return true;
+
+// Append the item and its path
+//
+   memset(&theItem, 0, sizeof(theItem));
+   theItem.hfvec = hVec;
+   theItem.pfvec = iP->Loc.pfvec & hVec;
+   theItem.Len   = plen;
+   iLen = sizeof(theItem) + snapPad(plen+1);
+   size_t bOff = sArgs.bP->size();
+   sArgs.bP->resize(bOff + iLen, 0);
+   memcpy(&(*sArgs.bP)[bOff], &theItem, sizeof(theItem));
+   memcpy(&(*sArgs.bP)[bOff+sizeof(theItem)], thePath, plen);
+   sArgs.num++;
+   return true;
+}
+
+/******************************************************************************/
+/*                              S n a p D r o p                               */
+/******************************************************************************/
+
+// Release the snapshot being restored. The caller must hold the sMutex.
+
+void XrdCmsCache::SnapDrop(const char *why)
+{
+   munmap(snapMap, snapSize); snapMap = 0;
+   snapLeft = 0;
+   for (int i = 0; i < STMax; i++) std::vector<size_t>().swap(snapIdx[i]);
+   Say.Say(why);
+}
+
+/******************************************************************************/
+/*                              S n a p L o a d                               */
+/******************************************************************************/
+
+// Map the snapshot, if any, so that the locations can be restored as nodes log
+// in. Snapshots older than the cache lifetime are ignored as all of its
+// entries would have expired by now.
+
+void XrdCmsCache::SnapLoad(int fxHold)
+{
+   SnapHdr *hP;
+   struct stat Stat;
+   const char *eTxt = 0;
+   char *idP, buff[32];
+   void *mP;
+   int fd, i;
+
+// Open the snapshot
+//
+   if ((fd = open(snapPath, O_RDONLY)) < 0)
+      {if (errno != ENOENT) Say.Emsg("Config", errno, "open", snapPath);
+       return;
+      }
+
+// Map it in and validate it
+//
+   if (fstat(fd, &Stat)) {Say.Emsg("Config", errno, "stat", snapPath);
+                          close(fd); return;
+                         }
+   if (Stat.st_size < (off_t)(sizeof(SnapHdr) + STMax*IdentLen))
+      {Say.Emsg("Config", "Cache snapshot", snapPath, "is truncated.");
+       close(fd); return;
+      }
+   mP = mmap(0, Stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+   close(fd);
+   if (mP == MAP_FAILED) {Say.Emsg("Config", errno, "map", snapPath); return;}
+   hP = (SnapHdr *)mP;
+
+        if (memcmp(hP->Magic, snapMagic, sizeof(snapMagic))
+        ||  hP->Version != snapVersion || hP->NumNodes != STMax)
+           eTxt = "is not compatible.";
+   else if (hP->Taken + fxHold < time(0)) eTxt = "is stale.";
+
+   if (eTxt)
+      {Say.Emsg("Config", "Cache snapshot", snapPath, eTxt);
+       munmap(mP, Stat.st_size);
+       return;
+      }
+
+// Record the nodes we need to wait for
+//
+   idP = (char *)mP + sizeof(SnapHdr);
+   for (i = 0; i < STMax; i++)
+       if (idP[i*IdentLen]) snapLeft |= 1ULL << i;
+   if (!snapLeft) {munmap(mP, Stat.st_size); return;}
+
+   snapMap = (char *)mP; snapSize = Stat.st_size;
+   snapExp = hP->Taken + fxHold;
+
+// Index the items by node so that each node's items can be restored without
+// going through the whole snapshot each time a node logs in.
+//
+   SnapItem *sP;
+   char *bP = snapMap + sizeof(SnapHdr) + STMax*IdentLen, *bEnd = snapMap+snapSize;
+   for (long long n = 0; n < hP->NumItems; n++)
+       {sP = (SnapItem *)bP;
+        if (bP + sizeof(SnapItem) > bEnd
+        ||  sP->Len <= 0 || sP->Len >= XrdCmsMAX_PATH_LEN
+        ||  bP + sizeof(SnapItem) + snapPad(sP->Len+1) > bEnd) break;
+        for (i = 0; i < STMax; i++)
+            if (sP->hfvec & snapLeft & (1ULL << i))
+               snapIdx[i].push_back(bP - snapMap);
+        bP += sizeof(SnapItem) + snapPad(sP->Len+1);
+       }
+
+   sprintf(buff, "%lld", hP->NumItems);
+   Say.Say("Config loaded ", buff, " cached locations from ", snapPath);
+}
+
+/******************************************************************************/
+/*                           S n a p R e s t o r e                            */
+/******************************************************************************/
+
+// Add the locations that node snapNum of the snapshot had as belonging to the
+// node in slot SNum. Called with sMutex held; returns the number restored.
+
+int XrdCmsCache::SnapRestore(int SNum, SMask_t smask, int snapNum)
+{
+   XrdCmsKeyItem *iP;
+   SnapItem *sP;
+   SMask_t   snapMask = 1ULL << snapNum, bVec;
+   unsigned int todB;
+   int shard, num = 0;
+
+// Run through the node's items, which were validated when the snapshot was
+// loaded. Items the cache already has are updated as long as they are
+// resolved and no other node bounced since they were cached. Otherwise, we
+// leave them to be handled the usual way.
+//
+   for (size_t n = 0; n < snapIdx[snapNum].size(); n++)
+       {sP = (SnapItem *)(snapMap + snapIdx[snapNum][n]);
+
+        XrdCmsKey theKey((char *)(sP+1), sP->Len);
+        shard = CTable.Shard(theKey);
+        CTable.Lock(shard);
+        if ((iP = CTable.Find(theKey)))
+           {if (iP->Loc.deadline) iP = 0;
+               else {bMutex.Lock();
+                     todB = iP->Loc.TOD_B;
+                     bVec = (todB < BClock ? getBVec(iP->Key.TOD, todB) : 0);
+                     bMutex.UnLock();
+                     if (bVec & ~smask) iP = 0;
+                        else iP->Loc.TOD_B = todB;
+                    }
+           } else if ((iP = CTable.Add(theKey)))
+                     {iP->Loc.hfvec    = 0;
+                      iP->Loc.pfvec    = 0;
+                      iP->Loc.qfvec    = 0;
+                      iP->Loc.TOD_B    = AtomicGet(BClock);
+                      iP->Loc.deadline = 0;
+                      iP->Loc.lifeline = nilTMO + time(0);
+                     }
+        if (iP)
+           {iP->Loc.hfvec |= smask;
+            if (sP->pfvec & snapMask) iP->Loc.pfvec |= smask;
+            num++;
+           }
+        CTable.UnLock(shard);
+       }
+
+// The node's items are no longer needed
+//
+   std::vector<size_t>().swap(snapIdx[snapNum]);
+   return num;
+}
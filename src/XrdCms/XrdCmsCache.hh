@@ -31,6 +31,7 @@
 /******************************************************************************/
 
 #include <string.h>
+#include <vector>
   
 #include "Xrd/XrdJob.hh"
 #include "Xrd/XrdScheduler.hh"
@@ -76,6 +77,18 @@ void        Drop(SMask_t mask, int SNum, int xHi);
 
 int         Init(int fxHold, int fxDelay, int fxQuery, int seFS, int nxHold);
 
+// Restore() records the identity of the node that logged into slot SNum and
+// adds the locations the node had in the loaded snapshot, if any.
+//
+void        Restore(const char *ident, int SNum, SMask_t smask);
+
+// setSnap() sets the file where the cache is periodically saved every secs
+//           seconds and from which it is reloaded when we start.
+//
+void        setSnap(const char *path, int secs);
+
+void       *Snapper();
+
 void       *TickTock();
 
 static const int min_nxTime = 60;
@@ -83,7 +96,9 @@ static const int min_nxTime = 60;
             XrdCmsCache() : okVec(0), Tick(8*60*60), Tock(0), BClock(0), 
                             nilTMO(0),
                             DLTime(5), QDelay(5), Bhits(0), Bmiss(0), vecHi(-1),
-                            isDFS(0)
+                            isDFS(0), snapPath(0), snapIdent(0), snapMap(0),
+                            snapSize(0), snapLeft(0), snapExp(0),
+                            snapEvery(0)
                           {memset(Bounced,  0, sizeof(Bounced));
                            memset(Bhistory, 0, sizeof(Bhistory));
                           }
@@ -96,13 +111,18 @@ void          Dispatch(XrdCmsSelect &Sel, XrdCmsKeyItem *cinfo,
                        short roQ, short rwQ);
 SMask_t       getBVec(unsigned int todA, unsigned int &todB);
 void          Recycle(XrdCmsKeyItem *theList);
+int           SnapRestore(int SNum, SMask_t smask, int snapNum);
+void          Save();
+static bool   SaveItem(XrdCmsKeyItem *iP, void *arg);
+void          SnapDrop(const char *why);
+void          SnapLoad(int fxHold);
 
 struct  {SMask_t      Vec;
          unsigned int Start;
          unsigned int End;
         }             Bhistory[XrdCmsKeyItem::TickRate];
 
-XrdSysMutex   myMutex;
+XrdSysMutex   bMutex;   // Bounce state only; may be taken under a shard lock
 XrdCmsNash    CTable;
 unsigned int  Bounced[STMax];
 SMask_t       okVec;
@@ -116,6 +136,37 @@ unsigned int  BClock;
          int  Bmiss;
          int  vecHi;
          int  isDFS;
+
+// The snapshot is a header, the identities of the nodes indexed by slot and
+// the items. Each item is followed by its null terminated path padded to a
+// multiple of 8 bytes. All numbers are in host byte order.
+//
+static const int  IdentLen = 256;
+
+struct SnapHdr
+      {char         Magic[8];
+       int          Version;
+       int          NumNodes;
+       long long    Taken;
+       long long    NumItems;
+      };
+
+struct SnapItem
+      {SMask_t      hfvec;
+       SMask_t      pfvec;
+       int          Len;
+       int          Rsvd;
+      };
+
+XrdSysMutex   sMutex;   // Snapshot identities and restore state
+char         *snapPath;
+char        (*snapIdent)[IdentLen]; // Identity of the node in each slot
+char         *snapMap;  // Snapshot being restored
+size_t        snapSize;
+SMask_t       snapLeft; // Snapshot nodes that have not yet logged in
+std::vector<size_t> snapIdx[STMax]; // Offsets of each snapshot node's items
+time_t        snapExp;  // When the snapshot's locations are no longer valid
+         int  snapEvery;
 };
 
 namespace XrdCms
@@ -48,6 +48,7 @@
 #include "XrdCms/XrdCmsConfig.hh"
 #include "XrdCms/XrdCmsCluster.hh"
 #include "XrdCms/XrdCmsClustID.hh"
+#include "XrdCms/XrdCmsFilter.hh"
 #include "XrdCms/XrdCmsNode.hh"
 #include "XrdCms/XrdCmsRole.hh"
 #include "XrdCms/XrdCmsRRQ.hh"
@@ -70,6 +71,46 @@ using namespace XrdCms;
 
        XrdCmsCluster   XrdCms::Cluster;
 
+/******************************************************************************/
+/*                       L o c a l   F u n c t i o n s                        */
+/******************************************************************************/
+
+namespace
+{
+// Return the index of the lowest bit set in a non-zero mask
+//
+inline int XrdCmsSnapLow(SMask_t mVec)
+{
+#if defined(__GNUC__)
+   return __builtin_ctzll(mVec);
+#else
+   int n = 0;
+   while(!(mVec & 1)) {mVec >>= 1; n++;}
+   return n;
+#endif
+}
+
+// Return the number of bits set in a mask
+//
+inline int XrdCmsSnapCount(SMask_t mVec)
+{
+#if defined(__GNUC__)
+   return __builtin_popcountll(mVec);
+#else
+   int n = 0;
+   while(mVec) {mVec &= (mVec - 1); n++;}
+   return n;
+#endif
+}
+
+// Set or clear the bits in mask depending on whether or not onoff is zero
+//
+inline void XrdCmsSnapSet(SMask_t &mask, SMask_t bits, int onoff)
+{
+   mask = (mask & ~bits) | (bits & (0 - (SMask_t)(onoff != 0)));
+}
+}
+
 /******************************************************************************/
 /*                      L o c a l   S t r u c t u r e s                       */
 /******************************************************************************/
@@ -122,6 +163,7 @@ XrdCmsCluster::XrdCmsCluster()
      resetMask = 0;
      peerHost  = 0;
      peerMask  = ~peerHost;
+     memset((void *)&Snap, 0, sizeof(Snap));
 }
   
 /******************************************************************************/
@@ -253,6 +295,12 @@ XrdCmsNode *XrdCmsCluster::Add(XrdLink *lp, int port, int Status, int sport,
       else         peerHost &= ~nP->NodeMask;
    peerMask = ~peerHost;
 
+// Make the node state visible to selection. Any namespace filter we have for
+// the slot is stale; the node sends its own after login.
+//
+   NSFilter.Reset(nP->NodeID);
+   Refresh(nP);
+
 // Document login
 //
    if (QTRACE(Debug))
@@ -364,6 +412,7 @@ void XrdCmsCluster::BlackList(XrdOucTList *blP)
                 nP->isBad &= ~(XrdCmsNode::isBlisted | XrdCmsNode::isDoomed);
                 Say.Emsg("Manager", nP->Name(), "removed from blacklist.");
                }
+            Refresh(nP);
             nP->n2gLock(STMutex);
            }
        }
@@ -648,12 +697,20 @@ int XrdCmsCluster::Locate(XrdCmsSelect &Sel)
 // First check if we have seen this file before. If so, get nodes that have it.
 // A Refresh request kills this because it's as if we hadn't seen it before.
 // If the file was found but either a query is in progress or we have a server
-// bounce; the client must wait.
+// bounce; the client must wait. Unless refreshing, only nodes whose namespace
+// filter may hold the file are asked. A filter may not yet know about a newly
+// created file so, if none of them match, all of the nodes are asked. We accept
+// that a file which reached a node without a have notification is not found
+// when another node's filter falsely matches, until the node rebuilds its
+// filter.
 //
    if (Sel.Opts & XrdCmsSelect::Refresh 
    || !(retc = Cache.GetFile(Sel, pinfo.rovec)))
-      {Cache.AddFile(Sel, 0);
-       qfVec = pinfo.rovec; Sel.Vec.hf = 0;
+      {if (Sel.Opts & XrdCmsSelect::Refresh) qfVec = pinfo.rovec;
+          else qfVec = NSFilter.Match(Sel.Path.Val,Sel.Path.Len,pinfo.rovec);
+       if (!qfVec) qfVec = pinfo.rovec;
+       Cache.AddFile(Sel, 0);
+       Sel.Vec.hf = 0;
       } else qfVec = Sel.Vec.bf;
 
 // Compute the delay, if any
@@ -731,6 +788,7 @@ void *XrdCmsCluster::MonRefs()
                     {if (resetW || doReset) nP->RefW=0;
                      if (resetR || doReset) nP->RefR=0;
                      nP->Shrem = nP->Share;
+                     SnapRefs(nP);
                     }
             if (resetWR)
                {if (resetW) {SelWtot += SelWcnt; SelWcnt = 0;}
@@ -815,6 +873,7 @@ void XrdCmsCluster::Remove(const char *reason, XrdCmsNode *theNode, int immed)
 // Mark node as being offline and remove any drop job from it
 //
    theNode->isOffline = 1; // STMutex is held here
+   Refresh(theNode);
 
 // If the node is connected we simply close the connection. This will cause
 // the connection handler to re-initiate the node removal. This condition
@@ -858,6 +917,8 @@ void XrdCmsCluster::Remove(const char *reason, XrdCmsNode *theNode, int immed)
    && (altNode = theNode->cidP->RemNode(theNode)))
       {if (altNode->isBound) NodeCnt++;
        NodeTab[NodeID] = altNode;
+       NSFilter.Reset(NodeID);
+       Refresh(altNode);
        if (Config.asManager())
           CmsState.Update(XrdCmsState::Counts,
                           altNode->isBad & XrdCmsNode::isSuspend ? 0 :  1,
@@ -892,6 +953,40 @@ void XrdCmsCluster::Remove(const char *reason, XrdCmsNode *theNode, int immed)
       else DEBUG(theNode->Ident <<" node " <<NodeID <<'.' <<Inst);
 }
 
+/******************************************************************************/
+/*                               R e f r e s h                                */
+/******************************************************************************/
+
+void XrdCmsCluster::Refresh(XrdCmsNode *nP)
+{
+   int slot = nP->NodeID;
+   SMask_t bit = nP->NodeMask;
+
+// Only nodes in the node table are selectable (alternates and managers we
+// subscribe to are not) so there is nothing to do for other nodes.
+//
+   if (slot < 0 || slot >= STMax || NodeTab[slot] != nP) return;
+
+// Update the snapshot from the node
+//
+   SnapMutex.Lock();
+   Snap.Load[slot] = nP->myLoad;
+   Snap.Mass[slot] = nP->myMass;
+   Snap.Cost[slot] = nP->myCost;
+   Snap.Inst[slot] = nP->Instance;
+   Snap.RefR[slot] = nP->RefR;
+   Snap.RefW[slot] = nP->RefW;
+   XrdCmsSnapSet(Snap.Offline, bit, nP->isOffline);
+   XrdCmsSnapSet(Snap.Bad,     bit, nP->isBad);
+   XrdCmsSnapSet(Snap.NoStage, bit, nP->isNoStage);
+   XrdCmsSnapSet(Snap.DiskLow, bit, nP->DiskFree < nP->DiskMinF);
+   XrdCmsSnapSet(Snap.Ovld,    bit, nP->myLoad > Config.MaxLoad);
+   for (int i = 0; i < 4; i++)
+       XrdCmsSnapSet(Snap.Net[i], bit, nP->hasNet & (1 << i));
+   Snap.Present |= bit;
+   SnapMutex.UnLock();
+}
+
 /******************************************************************************/
 /*                              R e s e t R e f                               */
 /******************************************************************************/
@@ -923,7 +1018,7 @@ int XrdCmsCluster::Select(XrdCmsSelect &Sel)
    XrdCmsPInfo  pinfo;
    const char  *Amode;
    int dowt = 0, retc = 0, isRW, fRD, noSel = (Sel.Opts & XrdCmsSelect::Defer);
-   SMask_t amask, smask, pmask;
+   SMask_t amask, smask, pmask, qmask;
 
 // Establish some local options
 //
@@ -977,7 +1072,13 @@ int XrdCmsCluster::Select(XrdCmsSelect &Sel)
 // have servers that we can query regarding the file. Note that for files being
 // opened in write mode, only one writable copy may exist unless this is a
 // meta-operation (e.g., remove) in which case the file itself remain unmodified
-// or a replica request, in which case we select a new target server.
+// or a replica request, in which case we select a new target server. For a
+// file not in the cache only the nodes whose namespace filter may hold it are
+// queried. A filter miss is not authoritative (the file may have been created
+// since the filter was built) so, when no filter matches, all nodes are asked.
+// However, a file which reached a node without a have notification is not
+// found when another node's filter falsely matches, until the node rebuilds
+// its filter. We accept this as the price of not querying every node.
 //
    if (!(Sel.Opts & XrdCmsSelect::Refresh)
    &&   (retc = Cache.GetFile(Sel, pinfo.rovec)))
@@ -1011,7 +1112,10 @@ int XrdCmsCluster::Select(XrdCmsSelect &Sel)
        if (Sel.Vec.hf & Sel.nmask) Cache.UnkFile(Sel, Sel.nmask);
       } else {
        Cache.AddFile(Sel, 0); 
-       Sel.Vec.bf = pinfo.rovec; 
+       if (Sel.Opts & XrdCmsSelect::Refresh
+       || !(qmask = NSFilter.Match(Sel.Path.Val, Sel.Path.Len, pinfo.rovec)))
+          qmask = pinfo.rovec;
+       Sel.Vec.bf = qmask;
        Sel.Vec.hf = Sel.Vec.pf = pmask = smask = 0;
        retc = 0;
       }
@@ -1134,6 +1238,7 @@ int XrdCmsCluster::Select(SMask_t pmask, int &port, char *hbuff, int &hlen,
    if (nP)
       {hlen = nP->netIF.GetName(hbuff, port, nType) + 1;
        nP->RefR++;
+       SnapRefs(nP);
        STMutex.UnLock();
        return hlen != 1;
       }
@@ -1419,6 +1524,7 @@ int XrdCmsCluster::Drop(int sent, int sinst, XrdCmsDrop *djp)
 // Cleanup status
 //
    NodeTab[sent] = 0;
+   SnapClear(sent);
    nP->isOffline = 1; // STMutex is locked
    nP->DropTime  = 0;
    nP->DropJob   = 0;
@@ -1534,6 +1640,39 @@ void XrdCmsCluster::Record(char *path, const char *reason, bool force)
    if (!skipmsg) Say.Emsg(epname, "client defered;", reason, path);
 }
  
+/******************************************************************************/
+/*                             S n a p C l e a r                              */
+/******************************************************************************/
+
+// Caller must have the STMutex locked.
+
+void XrdCmsCluster::SnapClear(int slot)
+{
+   SMask_t bits = ~((SMask_t)1 << slot);
+
+   SnapMutex.Lock();
+   Snap.Present &= bits;
+   Snap.Offline &= bits;
+   Snap.Bad     &= bits;
+   Snap.NoStage &= bits;
+   Snap.DiskLow &= bits;
+   Snap.Ovld    &= bits;
+   for (int i = 0; i < 4; i++) Snap.Net[i] &= bits;
+   SnapMutex.UnLock();
+}
+
+/******************************************************************************/
+/*                              S n a p R e f s                               */
+/******************************************************************************/
+
+// Caller must have the STMutex locked.
+
+inline void XrdCmsCluster::SnapRefs(XrdCmsNode *nP)
+{
+   Snap.RefR[nP->NodeID] = nP->RefR;
+   Snap.RefW[nP->NodeID] = nP->RefW;
+}
+
 /******************************************************************************/
 /*                               S e l N o d e                                */
 /******************************************************************************/
@@ -1660,6 +1799,44 @@ int XrdCmsCluster::SelNode(XrdCmsSelect &Sel, SMask_t pmask, SMask_t amask)
    return Unuseable(Sel);
 }
 
+/******************************************************************************/
+/*                               S e l M a s k                                */
+/******************************************************************************/
+
+// Compute the nodes in mask that can be selected using the snapshot. This sets
+// all of the selector's flags as the node by node scan used to do. The full
+// mask holds the nodes to be avoided for lack of space (zero if none needed).
+
+// Caller must have the STMutex locked.
+
+SMask_t XrdCmsCluster::SelMask(SMask_t mask, XrdCmsSelector &selR,
+                               SMask_t full, bool chkLoad)
+{
+   SMask_t cand, netOK = 0, noNet, vMask;
+
+// Get the candidate nodes and those reachable via a usable network
+//
+   cand = mask & Snap.Present;
+   for (int i = 0; i < 4; i++)
+       netOK |= Snap.Net[i] & (0 - (SMask_t)((selR.needNet >> i) & 1));
+   noNet = cand & ~netOK;
+   cand &= netOK;
+
+// Weed out the nodes in the same order as the original checks so that the
+// reason reported for an unsuccessful selection remains the same.
+//
+   selR.xNoNet = noNet != 0;
+   selR.nPick  = static_cast<short>(XrdCmsSnapCount(cand));
+   vMask = cand & Snap.Offline;                  selR.xOff  = vMask != 0;
+   cand &= ~vMask;
+   vMask = cand & Snap.Bad;                      selR.xSusp = vMask != 0;
+   cand &= ~vMask;
+   vMask = cand & Snap.Ovld & (0 - (SMask_t)chkLoad); selR.xOvld = vMask != 0;
+   cand &= ~vMask;
+   vMask = cand & full;                          selR.xFull = vMask != 0;
+   return cand & ~vMask;
+}
+  
 /******************************************************************************/
 /*                              R e f C o u n t                               */
 /******************************************************************************/
@@ -1673,7 +1850,8 @@ int XrdCmsCluster::SelNode(XrdCmsSelect &Sel, SMask_t pmask, SMask_t amask)
         if (sPMulti && sP->Share && !sP->Shrem--)              \
            {sP->RefW += sP->Shrip; sP->RefR += sP->Shrip;      \
             sP->Shrem = sP->Share; sP->Shrin++;                \
-           }
+           }                                                   \
+        SnapRefs(sP)
   
 /******************************************************************************/
 /*                             S e l b y C o s t                              */
@@ -1686,39 +1864,40 @@ int XrdCmsCluster::SelNode(XrdCmsSelect &Sel, SMask_t pmask, SMask_t amask)
 
 XrdCmsNode *XrdCmsCluster::SelbyCost(SMask_t mask, XrdCmsSelector &selR)
 {
-    XrdCmsNode *np, *sp = 0;
-    bool Multi = false;
+    XrdCmsNode *sP;
+    SMask_t full, elig;
+    int i, sp;
+    bool Multi;
 
-// Scan for a node (sp points to the selected one)
+// Compute the eligible nodes and pick the first one
 //
    selR.Reset(); SelTcnt++;
-   for (int i = 0; i <= STHi; i++)
-       if ((np = NodeTab[i]) && (np->NodeMask & mask))
-          {if (!(selR.needNet &  np->hasNet))    {selR.xNoNet= true; continue;}
-           selR.nPick++;
-           if (np->isOffline)                    {selR.xOff  = true; continue;}
-           if (np->isBad)                        {selR.xSusp = true; continue;}
-           if (selR.needSpace && np->isNoStage)  {selR.xFull = true; continue;}
-           if (!sp) sp = np;
-              else{if (abs(sp->myCost - np->myCost) <= Config.P_fuzz)
-                      {     if (selR.selPack)
-                               {if (sp->Inst() > np->Inst()) sp=np;}
-                       else if (selR.needSpace)
-                               {if (sp->RefW > (np->RefW+Config.DiskLinger))
-                                   sp=np;
-                               }
-                       else if (sp->RefR > np->RefR) sp=np;
-                      }
-                       else if (sp->myCost > np->myCost) sp=np;
-                   Multi = true;
-                  }
-          }
+   full = Snap.NoStage & (0 - (SMask_t)(selR.needSpace != 0));
+   if (!(elig = SelMask(mask, selR, full, false))) return calcDelay(selR);
+   sp = XrdCmsSnapLow(elig); elig &= elig - 1;
+   Multi = elig != 0;
+
+// Scan the remaining eligible nodes (sp is the index of the selected one)
+//
+   while(elig)
+        {i = XrdCmsSnapLow(elig); elig &= elig - 1;
+         if (abs(Snap.Cost[sp] - Snap.Cost[i]) <= Config.P_fuzz)
+            {     if (selR.selPack)
+                     {if (Snap.Inst[sp] > Snap.Inst[i]) sp = i;}
+             else if (selR.needSpace)
+                     {if (Snap.RefW[sp] > (Snap.RefW[i]+Config.DiskLinger))
+                         sp = i;
+                     }
+             else if (Snap.RefR[sp] > Snap.RefR[i]) sp = i;
+            }
+             else if (Snap.Cost[sp] > Snap.Cost[i]) sp = i;
+        }
 
-// Check for overloaded node and return result
+// Return result
 //
-   if (!sp) return calcDelay(selR);
-   RefCount(sp, Multi, selR.needSpace);
-   return sp;
+   sP = NodeTab[sp];
+   RefCount(sP, Multi, selR.needSpace);
+   return sP;
 }
   
 /******************************************************************************/
@@ -1729,48 +1908,50 @@ XrdCmsNode *XrdCmsCluster::SelbyCost(SMask_t mask, XrdCmsSelector &selR)
   
 XrdCmsNode *XrdCmsCluster::SelbyLoad(SMask_t mask, XrdCmsSelector &selR)
 {
-    XrdCmsNode *np, *sp = 0;
-    bool Multi = false, reqSS = (selR.needSpace & XrdCmsNode::allowsSS) != 0;
+    XrdCmsNode *sP;
+    SMask_t full, elig;
+    int i, sp;
+    bool Multi, reqSS = (selR.needSpace & XrdCmsNode::allowsSS) != 0;
 
-// Scan for a node (preset possible, suspended, overloaded, full, and dead)
+// Compute the eligible nodes (i.e. not suspended, overloaded, full, and dead)
 //
    selR.Reset(); SelTcnt++;
-   for (int i = 0; i <= STHi; i++)
-       if ((np = NodeTab[i]) && (np->NodeMask & mask))
-          {if (!(selR.needNet & np->hasNet))      {selR.xNoNet= true; continue;}
-           selR.nPick++;
-           if (np->isOffline)                     {selR.xOff  = true; continue;}
-           if (np->isBad)                         {selR.xSusp = true; continue;}
-           if (np->myLoad > Config.MaxLoad)       {selR.xOvld = true; continue;}
-           if (selR.needSpace && (np->DiskFree < np->DiskMinF
-                                  || (reqSS && np->isNoStage)))
-              {selR.xFull = true; continue;}
-           if (!sp) sp = np;
-              else{if (selR.needSpace)
-                      {if (abs(sp->myMass - np->myMass) <= Config.P_fuzz)
-                          {if (selR.selPack)
-                              {if (sp->Inst() > np->Inst())             sp=np;}
-                           else
-                           if (sp->RefW > (np->RefW+Config.DiskLinger)) sp=np;
-                          }
-                          else if (sp->myMass > np->myMass)             sp=np;
-                      } else {
-                       if (abs(sp->myLoad - np->myLoad) <= Config.P_fuzz)
-                          {if (selR.selPack)
-                              {if (sp->Inst() > np->Inst())             sp=np;}
-                              else if (sp->RefR > np->RefR)             sp=np;
-                          }
-                          else if (sp->myLoad > np->myLoad)             sp=np;
-                      }
-                   Multi = true;
-                  }
-          }
+   full = (Snap.DiskLow | (Snap.NoStage & (0 - (SMask_t)reqSS)))
+        & (0 - (SMask_t)(selR.needSpace != 0));
+   if (!(elig = SelMask(mask, selR, full, true))) return calcDelay(selR);
+   sp = XrdCmsSnapLow(elig); elig &= elig - 1;
+   Multi = elig != 0;
+
+// Scan the remaining eligible nodes (sp is the index of the selected one)
+//
+   if (selR.needSpace)
+      {while(elig)
+            {i = XrdCmsSnapLow(elig); elig &= elig - 1;
+             if (abs(Snap.Mass[sp] - Snap.Mass[i]) <= Config.P_fuzz)
+                {if (selR.selPack)
+                    {if (Snap.Inst[sp] > Snap.Inst[i])                 sp = i;}
+                 else
+                 if (Snap.RefW[sp] > (Snap.RefW[i]+Config.DiskLinger)) sp = i;
+                }
+                else if (Snap.Mass[sp] > Snap.Mass[i])                 sp = i;
+            }
+      } else {
+       while(elig)
+            {i = XrdCmsSnapLow(elig); elig &= elig - 1;
+             if (abs(Snap.Load[sp] - Snap.Load[i]) <= Config.P_fuzz)
+                {if (selR.selPack)
+                    {if (Snap.Inst[sp] > Snap.Inst[i])                 sp = i;}
+                    else if (Snap.RefR[sp] > Snap.RefR[i])             sp = i;
+                }
+                else if (Snap.Load[sp] > Snap.Load[i])                 sp = i;
+            }
+      }
 
-// Check for overloaded node and return result
+// Return result
 //
-   if (!sp) return calcDelay(selR);
-   RefCount(sp, Multi, selR.needSpace);
-   return sp;
+   sP = NodeTab[sp];
+   RefCount(sP, Multi, selR.needSpace);
+   return sP;
 }
 
 /******************************************************************************/
@@ -1781,35 +1962,45 @@ XrdCmsNode *XrdCmsCluster::SelbyLoad(SMask_t mask, XrdCmsSelector &selR)
 
 XrdCmsNode *XrdCmsCluster::SelbyRef(SMask_t mask, XrdCmsSelector &selR)
 {
-    XrdCmsNode *np, *sp = 0;
-    bool Multi = false, reqSS = (selR.needSpace & XrdCmsNode::allowsSS) != 0;
+    XrdCmsNode *sP;
+    SMask_t full, elig;
+    int i, sp;
+    bool Multi, reqSS = (selR.needSpace & XrdCmsNode::allowsSS) != 0;
 
-// Scan for a node (sp points to the selected one)
+// Compute the eligible nodes
 //
    selR.Reset(); SelTcnt++;
-   for (int i = 0; i <= STHi; i++)
-       if ((np = NodeTab[i]) && (np->NodeMask & mask))
-          {if (!(selR.needNet & np->hasNet))    {selR.xNoNet= true; continue;}
-           selR.nPick++;
-           if (np->isOffline)                   {selR.xOff  = true; continue;}
-           if (np->isBad)                       {selR.xSusp = true; continue;}
-           if (selR.needSpace && (np->DiskFree < np->DiskMinF
-                                  || (reqSS && np->isNoStage)))
-              {selR.xFull = true; continue;}
-           if (!sp) sp = np;
-              else {Multi = true;
-                         if (selR.selPack) {if (sp->Inst() > np->Inst())sp=np;}
-                    else if (selR.needSpace)
-                            {if (sp->RefW > (np->RefW+Config.DiskLinger)) sp=np;}
-                    else if (sp->RefR > np->RefR)                         sp=np;
-                   }
-          }
+   full = (Snap.DiskLow | (Snap.NoStage & (0 - (SMask_t)reqSS)))
+        & (0 - (SMask_t)(selR.needSpace != 0));
+   if (!(elig = SelMask(mask, selR, full, false))) return calcDelay(selR);
+   sp = XrdCmsSnapLow(elig); elig &= elig - 1;
+   Multi = elig != 0;
+
+// Scan the remaining eligible nodes (sp is the index of the selected one)
+//
+        if (selR.selPack)
+           {while(elig)
+                 {i = XrdCmsSnapLow(elig); elig &= elig - 1;
+                  if (Snap.Inst[sp] > Snap.Inst[i]) sp = i;
+                 }
+           }
+   else if (selR.needSpace)
+           {while(elig)
+                 {i = XrdCmsSnapLow(elig); elig &= elig - 1;
+                  if (Snap.RefW[sp] > (Snap.RefW[i]+Config.DiskLinger)) sp = i;
+                 }
+           }
+   else    {while(elig)
+                 {i = XrdCmsSnapLow(elig); elig &= elig - 1;
+                  if (Snap.RefR[sp] > Snap.RefR[i]) sp = i;
+                 }
+           }
 
-// Check for overloaded node and return result
+// Return result
 //
-   if (!sp) return calcDelay(selR);
-   RefCount(sp, Multi, selR.needSpace);
-   return sp;
+   sP = NodeTab[sp];
+   RefCount(sP, Multi, selR.needSpace);
+   return sP;
 }
  
 /******************************************************************************/
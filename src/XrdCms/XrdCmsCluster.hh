@@ -182,6 +182,11 @@ void            Remove(const char *reason, XrdCmsNode *theNode, int immed=0);
 //
 void            ResetRef(SMask_t smask);
 
+// Called whenever the selection state of a node changes (load, space, status)
+// so that the selection snapshot reflects it. The node need not be locked.
+//
+void            Refresh(XrdCmsNode *nP);
+
 // Called to select the best possible node to serve a file (two forms)
 //
 static const int RetryErr = -3;
@@ -220,6 +225,8 @@ bool        maxBits(SMask_t mVec, int mbits);
 int         Multiple(SMask_t mVec);
 enum        {eExists, eDups, eROfs, eNoRep, eNoSel, eNoEnt}; // Passed to SelFail
 int         SelFail(XrdCmsSelect &Sel, int rc);
+SMask_t     SelMask(SMask_t mask, XrdCmsSelector &selR, SMask_t full,
+                    bool chkLoad);
 int         SelNode(XrdCmsSelect &Sel, SMask_t  pmask, SMask_t  amask);
 XrdCmsNode *SelbyCost(SMask_t, XrdCmsSelector &selR);
 XrdCmsNode *SelbyLoad(SMask_t, XrdCmsSelector &selR);
@@ -255,6 +262,35 @@ char          AltMans[STMax*AltSize]; // ||123.123.123.123:12345|| = 21
 char         *AltMend;
 int           AltMent;
 
+// The selection snapshot holds the node state used for selection as bit masks
+// and arrays indexed by node slot so that a selection filters candidates with
+// a handful of mask operations and then only scans the eligible slots in a
+// few contiguous arrays. Updates are serialized by the SnapMutex while readers
+// only need the STMutex; each value is a single aligned word. The reference
+// counts are only changed under the STMutex.
+//
+struct SelSnap
+      {SMask_t Present;         // Slot holds a node (i.e. NodeTab[i] != 0)
+       SMask_t Offline;         // Node is offline
+       SMask_t Bad;             // Node is unselectable (isBad)
+       SMask_t NoStage;         // Node can't stage
+       SMask_t DiskLow;         // Node has less than the minimum free space
+       SMask_t Ovld;            // Node load exceeds the maximum load
+       SMask_t Net[4];          // Nodes usable for each network selection bit
+       int     Load[STMax];     // myLoad
+       int     Mass[STMax];     // myMass
+       int     Cost[STMax];     // myCost
+       int     Inst[STMax];     // Instance
+       int     RefR[STMax];     // RefR
+       int     RefW[STMax];     // RefW
+      };
+
+XrdSysMutex   SnapMutex;
+SelSnap       Snap;
+
+void          SnapClear(int slot);
+inline void   SnapRefs(XrdCmsNode *nP);
+
 // The foloowing three variables are protected by the STMutex
 //
 SMask_t       resetMask;        // Nodes to receive a reset event
@@ -53,6 +53,7 @@
 #include "XrdCms/XrdCmsCache.hh"
 #include "XrdCms/XrdCmsCluster.hh"
 #include "XrdCms/XrdCmsConfig.hh"
+#include "XrdCms/XrdCmsFilter.hh"
 #include "XrdCms/XrdCmsManager.hh"
 #include "XrdCms/XrdCmsMeter.hh"
 #include "XrdCms/XrdCmsNode.hh"
@@ -137,6 +138,8 @@ void *XrdCmsStartMonRefs(void *carg) { return Cluster.MonRefs(); }
 
 void *XrdCmsStartMonStat(void *carg) { return CmsState.Monitor(); }
 
+void *XrdCmsStartFilter(void *carg) { return NSFilter.Builder(); }
+
 void *XrdCmsStartAdmin(void *carg)
       {return XrdCms::Admin.Start((XrdNetSocket *)carg);
       }
@@ -500,6 +503,7 @@ int XrdCmsConfig::ConfigXeq(char *var, XrdOucStream &CFile, XrdSysError *eDest)
    TS_Xeq("allow",         xallow);  // Manager, non-dynamic
    TS_Xeq("altds",         xaltds);  // Server,  non-dynamic
    TS_Xeq("blacklist",     xblk);    // Manager, non-dynamic
+   TS_Xeq("cachesnap",     xcsn);    // Manager, non-dynamic
    TS_Xeq("cidtag",        xcid);    // Any,     non-dynamic
    TS_Xeq("defaults",      xdefs);   // Server,  non-dynamic
    TS_Xeq("dfs",           xdfs);    // Any,     non-dynamic
@@ -510,6 +514,7 @@ int XrdCmsConfig::ConfigXeq(char *var, XrdOucStream &CFile, XrdSysError *eDest)
    TS_Xeq("namelib",       xnml);    // Server,  non-dynamic
    TS_Xeq("vnid",          xvnid);   // Server,  non-dynamic
    TS_Xeq("nbsendq",       xnbsq);   // Any      non-dynamic
+   TS_Xeq("nsfilter",      xnsfl);   // Any,     non-dynamic
    TS_Xeq("osslib",        xolib);   // Any,     non-dynamic
    TS_Xeq("perf",          xperf);   // Server,  non-dynamic
    TS_Xeq("pidpath",       xpidf);   // Any,     non-dynamic
@@ -598,6 +603,14 @@ void XrdCmsConfig::DoIt()
 //
    if (isManager || isServer || isPeer) XrdCmsManager::Start(ManList);
 
+// Start building the namespace filter if we are a data server that uses one.
+// Staging servers don't as they can provide files that they don't have.
+//
+   if (NSFilter.Enabled() && DiskOK && !isManager && !isPeer && !DiskSS)
+      if (XrdSysThread::Run(&tid, XrdCmsStartFilter, (void *)0,
+                            0, "Namespace filter"))
+         Say.Emsg("cmsd", errno, "start namespace filter");
+
 // Start state monitoring thread
 //
    if (XrdSysThread::Run(&tid, XrdCmsStartMonStat, (void *)0,
@@ -1446,6 +1459,60 @@ int XrdCmsConfig::xblk(XrdSysError *eDest, XrdOucStream &CFile, bool iswl)
    return 0;
 }
   
+/******************************************************************************/
+/*                                  x c s n                                   */
+/******************************************************************************/
+
+/* Function: xcsn
+
+   Purpose:  To parse the directive: cachesnap <path> [every <time>]
+
+             <path>    the file where the location cache is saved and from
+                       which it is reloaded upon restart.
+             <time>    how often to save the cache. The default is 5 minutes.
+
+  Output: 0 upon success or !0 upon failure.
+*/
+
+int XrdCmsConfig::xcsn(XrdSysError *eDest, XrdOucStream &CFile)
+{
+    char *val, *path;
+    int every = 300;
+
+// We only support this for managers
+//
+   if (!isManager) return CFile.noEcho();
+
+// Get the path
+//
+   if (!(val = CFile.GetWord()) || !val[0])
+      {eDest->Emsg("Config", "cachesnap path not specified"); return 1;}
+   if (*val != '/')
+      {eDest->Emsg("Config", "cachesnap path not absolute"); return 1;}
+   path = strdup(val);
+
+// Process any options
+//
+   while((val = CFile.GetWord()))
+        {if (!strcmp(val, "every"))
+            {if (!(val = CFile.GetWord()) || !val[0])
+                {eDest->Emsg("Config", "cachesnap interval not specified");
+                 free(path); return 1;
+                }
+             if (XrdOuca2x::a2tm(*eDest, "cachesnap interval", val,
+                                 &every, 10)) {free(path); return 1;}
+            } else {eDest->Emsg("Config", "invalid cachesnap option -", val);
+                    free(path); return 1;
+                   }
+        }
+
+// Record the values
+//
+   Cache.setSnap(path, every);
+   free(path);
+   return 0;
+}
+  
 /******************************************************************************/
 /*                                  x c i d                                   */
 /******************************************************************************/
@@ -2133,6 +2200,56 @@ int XrdCmsConfig::xnml(XrdSysError *eDest, XrdOucStream &CFile)
    return 0;
 }
   
+/******************************************************************************/
+/*                                 x n s f l                                  */
+/******************************************************************************/
+
+/* Function: xnsfl
+
+   Purpose:  To parse the directive: nsfilter [off] [bpe <n>] [every <tm>]
+
+             off       disables namespace filters, the default.
+             bpe       the number of filter bits per path used by data servers.
+                       The default is 10 (about 1% false positives).
+             every     the time (seconds, M, H) between namespace walks done by
+                       data servers. Removed files remain in the filter until
+                       the next walk. The default is 1 hour.
+
+   Type: Any, non-dynamic. Managers use the filters that data servers send.
+
+   Output: 0 upon success or !0 upon failure.
+*/
+int XrdCmsConfig::xnsfl(XrdSysError *eDest, XrdOucStream &CFile)
+{   int bpe = 10, every = 3600;
+    bool isOn = true;
+    char *val;
+
+    while((val = CFile.GetWord()))
+        {     if (!strcmp("off", val)) isOn = false;
+         else if (!strcmp("bpe", val))
+                 {if (!(val = CFile.GetWord()))
+                     {eDest->Emsg("Config", "nsfilter bpe value not specified");
+                      return 1;
+                     }
+                  if (XrdOuca2x::a2i(*eDest,"nsfilter bpe",val,&bpe,1,64))
+                     return 1;
+                 }
+         else if (!strcmp("every", val))
+                 {if (!(val = CFile.GetWord()))
+                     {eDest->Emsg("Config","nsfilter every value not specified");
+                      return 1;
+                     }
+                  if (XrdOuca2x::a2tm(*eDest,"nsfilter every",val,&every,60))
+                     return 1;
+                 }
+         else {eDest->Emsg("Config", "invalid nsfilter option -", val);
+               return 1;
+              }
+        }
+    NSFilter.setParms(isOn, bpe, every);
+    return 0;
+}
+  
 /******************************************************************************/
 /*                                 x o l i b                                  */
 /******************************************************************************/
@@ -216,6 +216,7 @@ int  xaltds(XrdSysError *edest, XrdOucStream &CFile);
 int  Fsysadd(XrdSysError *edest, int chk, char *fn);
 int  xblk(XrdSysError *edest, XrdOucStream &CFile, bool iswl=false);
 int  xcid(XrdSysError *edest, XrdOucStream &CFile);
+int  xcsn(XrdSysError *edest, XrdOucStream &CFile);
 int  xdelay(XrdSysError *edest, XrdOucStream &CFile);
 int  xdefs(XrdSysError *edest, XrdOucStream &CFile);
 int  xdfs(XrdSysError *edest, XrdOucStream &CFile);
@@ -226,6 +227,7 @@ int  xlclrt(XrdSysError *edest, XrdOucStream &CFile);
 int  xmang(XrdSysError *edest, XrdOucStream &CFile);
 int  xnbsq(XrdSysError *edest, XrdOucStream &CFile);
 int  xnml(XrdSysError *edest, XrdOucStream &CFile);
+int  xnsfl(XrdSysError *edest, XrdOucStream &CFile);
 int  xolib(XrdSysError *edest, XrdOucStream &CFile);
 int  xperf(XrdSysError *edest, XrdOucStream &CFile);
 int  xpidf(XrdSysError *edest, XrdOucStream &CFile);
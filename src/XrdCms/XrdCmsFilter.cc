@@ -0,0 +1,533 @@
+/******************************************************************************/
+/*                                                                            */
+/*                       X r d C m s F i l t e r . c c                        */
+/*                                                                            */
+/* This file is part of the XRootD software suite.                            */
+/*                                                                            */
+/* XRootD is free software: you can redistribute it and/or modify it under    */
+/* the terms of the GNU Lesser General Public License as published by the     */
+/* Free Software Foundation, either version 3 of the License, or (at your     */
+/* option) any later version.                                                 */
+/*                                                                            */
+/* XRootD is distributed in the hope that it will be useful, but WITHOUT      */
+/* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or      */
+/* FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public       */
+/* License for more details.                                                  */
+/*                                                                            */
+/* You should have received a copy of the GNU Lesser General Public License   */
+/* along with XRootD in a file called COPYING.LESSER (LGPL license) and file  */
+/* COPYING (GPL license).  If not, see <http://www.gnu.org/licenses/>.        */
+/*                                                                            */
+/* The copyright holder's institutional names and contributor's names may not */
+/* be used to endorse or promote products derived from this software without  */
+/* specific prior written permission of the institution or contributor.       */
+/******************************************************************************/
+
+#include <errno.h>
+#include <set>
+#include <string>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <netinet/in.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+
+#include "XProtocol/YProtocol.hh"
+
+#include "XrdCms/XrdCmsConfig.hh"
+#include "XrdCms/XrdCmsFilter.hh"
+#include "XrdCms/XrdCmsManager.hh"
+#include "XrdCms/XrdCmsNode.hh"
+#include "XrdCms/XrdCmsPList.hh"
+#include "XrdCms/XrdCmsTrace.hh"
+
+#include "XrdOss/XrdOss.hh"
+#include "XrdOuc/XrdOucEnv.hh"
+#include "XrdSys/XrdSysTimer.hh"
+
+using namespace XrdCms;
+
+/******************************************************************************/
+/*                        G l o b a l   O b j e c t s                         */
+/******************************************************************************/
+
+namespace XrdCms
+{
+       XrdCmsFilter NSFilter;
+}
+
+/******************************************************************************/
+/*                           C o n s t r u c t o r                            */
+/******************************************************************************/
+
+XrdCmsFilter::XrdCmsFilter() : hasFilter(0), Walking(false), isOn(false),
+                               BitsPE(10), Every(3600)
+{
+   memset(Active,    0, sizeof(Active));
+   memset(Pending,   0, sizeof(Pending));
+   memset(&myFilter, 0, sizeof(myFilter));
+}
+
+/******************************************************************************/
+/*                                   A d d                                    */
+/******************************************************************************/
+
+void XrdCmsFilter::Add(int slot, const char *path, int plen)
+{
+   SMask_t bit;
+   HashPair hp;
+   bool isKnown;
+
+// We only need to do something if the node has a filter
+//
+   if (slot < 0 || slot >= STMax) return;
+   bit = 1ULL << slot;
+   if (!(hasFilter & bit) || !Hash(path, plen, hp)) return;
+
+// Most paths reported by a node are already in its filter (that's why the node
+// was asked about it). So, check that first to avoid an exclusive lock.
+//
+   bfLock.ReadLock();
+   isKnown = !Active[slot].Bits || Has(Active[slot], hp);
+   bfLock.UnLock();
+   if (isKnown) return;
+
+// Add the path to the node's filter and to any filter being received
+//
+   bfLock.WriteLock();
+   if (Active[slot].Bits)  Set(Active[slot],  hp);
+   if (Pending[slot].Bits) Set(Pending[slot], hp);
+   bfLock.UnLock();
+}
+
+/******************************************************************************/
+/*                                 A d d e d                                  */
+/******************************************************************************/
+
+void XrdCmsFilter::Added(const char *path)
+{
+   HashPair hp;
+
+// Add the path to the current filter and, if we are walking the namespace,
+// to the list of paths that need to be added to the new filter.
+//
+   if (!isOn || !Hash(path, strlen(path), hp)) return;
+   fMutex.Lock();
+   if (Walking) Adds.push_back(hp);
+   if (myFilter.Bits) Set(myFilter, hp);
+   fMutex.UnLock();
+}
+
+/******************************************************************************/
+/*                               B u i l d e r                                */
+/******************************************************************************/
+
+void *XrdCmsFilter::Builder()
+{
+
+// Periodically rebuild the filter. This is the only way paths of removed files
+// are ever dropped from it.
+//
+   do {Build();
+       XrdSysTimer::Snooze(Every);
+      } while(1);
+
+// We never get here
+//
+   return (void *)0;
+}
+
+/******************************************************************************/
+/*                                 M a t c h                                  */
+/******************************************************************************/
+
+SMask_t XrdCmsFilter::Match(const char *path, int plen, SMask_t mask)
+{
+   SMask_t bit, fMask;
+   HashPair hp;
+   int i;
+
+// Quickly return if no node in the mask can be filtered
+//
+   if (!isOn || !(mask & hasFilter) || !Hash(path, plen, hp)) return mask;
+
+// Remove each node whose filter says that it does not have the path
+//
+   bfLock.ReadLock();
+   fMask = mask & hasFilter;
+   for (i = 0; fMask && i < STMax; i++)
+       {bit = 1ULL << i;
+        if (fMask & bit)
+           {if (!Has(Active[i], hp)) mask &= ~bit;
+            fMask &= ~bit;
+           }
+       }
+   bfLock.UnLock();
+   return mask;
+}
+
+/******************************************************************************/
+/*                               P u b l i s h                                */
+/******************************************************************************/
+
+void XrdCmsFilter::Publish(XrdCmsNode *nP)
+{
+
+// Send the filter we have, if any. A new manager gets the next one otherwise.
+//
+   if (isOn) Send(nP);
+}
+
+/******************************************************************************/
+/*                                 R e s e t                                  */
+/******************************************************************************/
+
+void XrdCmsFilter::Reset(int slot)
+{
+   if (slot < 0 || slot >= STMax) return;
+
+   bfLock.WriteLock();
+   if (Active[slot].Bits)  free(Active[slot].Bits);
+   if (Pending[slot].Bits) free(Pending[slot].Bits);
+   memset(&Active[slot],  0, sizeof(Bloom));
+   memset(&Pending[slot], 0, sizeof(Bloom));
+   hasFilter &= ~(1ULL << slot);
+   bfLock.UnLock();
+}
+
+/******************************************************************************/
+/*                                U p d a t e                                 */
+/******************************************************************************/
+
+const char *XrdCmsFilter::Update(int slot, const char *data, int dlen,
+                                 bool isLast)
+{
+   static const int fhLen = sizeof(CmsFilterRequest) - sizeof(CmsRRHdr);
+   CmsFilterRequest fReq;
+   unsigned int gen, size, offset, n;
+   int hashes;
+
+// Extract the chunk information (data is not necessarily aligned)
+//
+   if (slot < 0 || slot >= STMax) return "node has no slot for a filter";
+   if (dlen < fhLen) return "filter chunk is too short";
+   memcpy(&fReq.Gen, data, fhLen);
+   gen    = ntohl(fReq.Gen);
+   size   = ntohl(fReq.Size);
+   offset = ntohl(fReq.Offset);
+   hashes = fReq.Hashes;
+   data  += fhLen;
+   n      = static_cast<unsigned int>(dlen - fhLen);
+
+// Validate the chunk
+//
+   if (size < 8 || size > (unsigned int)MaxSize || (size & (size-1)))
+      return "invalid filter size";
+   if (hashes < 1 || hashes > 16) return "invalid filter hash count";
+   if (offset > size || n > size - offset) return "invalid filter offset";
+
+// The first chunk starts a new filter. Others must continue the current one.
+//
+   bfLock.WriteLock();
+   Bloom &bf = Pending[slot];
+   if (!offset)
+      {if (bf.Bits) free(bf.Bits);
+       if (!(bf.Bits = (unsigned char *)calloc(size, 1)))
+          {memset(&bf, 0, sizeof(Bloom));
+           bfLock.UnLock();
+           return "insufficient memory for filter";
+          }
+       bf.Size = size; bf.Gen = gen; bf.Hashes = hashes; bf.Rcvd = 0;
+      } else if (!bf.Bits || bf.Gen != gen || bf.Size != size
+             ||  bf.Rcvd != offset)
+                {if (bf.Bits) free(bf.Bits);
+                 memset(&bf, 0, sizeof(Bloom));
+                 bfLock.UnLock();
+                 return "filter chunk out of sequence";
+                }
+
+// Merge in the chunk. Paths may have been added while the filter was sent.
+//
+   for (unsigned int i = 0; i < n; i++)
+       bf.Bits[offset+i] |= static_cast<unsigned char>(data[i]);
+   bf.Rcvd += n;
+
+// If this is the last chunk, the filter replaces the current one
+//
+   if (isLast)
+      {if (bf.Rcvd != bf.Size)
+          {free(bf.Bits);
+           memset(&bf, 0, sizeof(Bloom));
+           bfLock.UnLock();
+           return "incomplete filter";
+          }
+       if (Active[slot].Bits) free(Active[slot].Bits);
+       Active[slot] = bf;
+       memset(&bf, 0, sizeof(Bloom));
+       hasFilter |= 1ULL << slot;
+      }
+   bfLock.UnLock();
+   return 0;
+}
+
+/******************************************************************************/
+/*                       P r i v a t e   M e t h o d s                        */
+/******************************************************************************/
+/******************************************************************************/
+/*                                 B u i l d                                  */
+/******************************************************************************/
+
+void XrdCmsFilter::Build()
+{
+   std::vector<std::string> Paths;
+   std::vector<HashPair> hv;
+   XrdCmsPList *pP;
+   Bloom bf;
+   unsigned long long nBits;
+   unsigned int i, j, plen;
+   char buff[256];
+
+// Get the list of exported paths
+//
+   Config.PathList.Lock();
+   for (pP = Config.PathList.First(); pP; pP = pP->Next())
+       Paths.push_back(pP->Path());
+   Config.PathList.UnLock();
+
+// Indicate that we are walking the namespace so added paths are recorded
+//
+   fMutex.Lock();
+   Walking = true;
+   Adds.clear();
+   fMutex.UnLock();
+
+// Walk each exported path unless it lies within another one
+//
+   for (i = 0; i < Paths.size(); i++)
+       {for (j = 0; j < Paths.size(); j++)
+            {plen = Paths[j].size();
+             if (i != j && plen < Paths[i].size()
+             &&  !strncmp(Paths[i].c_str(), Paths[j].c_str(), plen)
+             &&  (Paths[j][plen-1] == '/' || Paths[i][plen] == '/')) break;
+            }
+        if (j >= Paths.size()) Walk(Paths[i].c_str(), hv);
+       }
+
+// Add whatever was created while we walked
+//
+   fMutex.Lock();
+   hv.insert(hv.end(), Adds.begin(), Adds.end());
+   Adds.clear();
+   Walking = false;
+
+// Size the filter: a power of two of at least the wanted bits per path with
+// the number of hashes that minimizes false positives for that size.
+//
+   nBits = static_cast<unsigned long long>(hv.size()) * BitsPE;
+   bf.Size = 8192;
+   while(bf.Size*8ULL < nBits && bf.Size < (unsigned int)MaxSize) bf.Size <<= 1;
+   bf.Hashes = static_cast<int>(bf.Size*8.0/(hv.empty() ? 1 : hv.size())*0.693
+                                + 0.5);
+   if (bf.Hashes < 1) bf.Hashes = 1;
+      else if (bf.Hashes > 16) bf.Hashes = 16;
+   bf.Rcvd = bf.Size;
+   bf.Gen  = myFilter.Gen + 1;
+   if (!(bf.Bits = (unsigned char *)calloc(bf.Size, 1)))
+      {fMutex.UnLock();
+       Say.Emsg("Filter", ENOMEM, "allocate namespace filter");
+       return;
+      }
+   for (i = 0; i < hv.size(); i++) Set(bf, hv[i]);
+
+// Replace the current filter and send it to our managers
+//
+   if (myFilter.Bits) free(myFilter.Bits);
+   myFilter = bf;
+   fMutex.UnLock();
+   Send(0);
+
+// Document what we did
+//
+   snprintf(buff, sizeof(buff), "%lu paths in %u bytes using %d hashes.",
+            static_cast<unsigned long>(hv.size()), bf.Size, bf.Hashes);
+   Say.Emsg("Filter", "Namespace filter has", buff);
+}
+
+/******************************************************************************/
+/*                                  H a s h                                   */
+/******************************************************************************/
+
+// Compute the two base hashes of a path from a 64 bit FNV-1a hash. Repeated
+// and trailing slashes are ignored as these refer to the same path. Paths
+// with "." or ".." components cannot be matched and false is returned.
+
+bool XrdCmsFilter::Hash(const char *path, int plen, HashPair &hp)
+{
+   unsigned long long h = 14695981039346656037ULL;
+   int i = 0, j;
+
+   while(plen > 1 && path[plen-1] == '/') plen--;
+
+   while(i < plen)
+        {if (path[i] == '/')
+            {while(i+1 < plen && path[i+1] == '/') i++;
+             if (i+1 < plen && path[i+1] == '.')
+                {j = i+2;
+                 if (j < plen && path[j] == '.') j++;
+                 if (j >= plen || path[j] == '/') return false;
+                }
+            }
+         h ^= static_cast<unsigned char>(path[i++]);
+         h *= 1099511628211ULL;
+        }
+
+   hp.h1 = static_cast<unsigned int>(h);
+   hp.h2 = static_cast<unsigned int>(h >> 32) | 1;
+   return true;
+}
+
+/******************************************************************************/
+/*                                   H a s                                    */
+/******************************************************************************/
+
+bool XrdCmsFilter::Has(Bloom &bf, const HashPair &hp)
+{
+   unsigned int bit, bMask = bf.Size*8 - 1;
+
+   for (int i = 0; i < bf.Hashes; i++)
+       {bit = (hp.h1 + i*hp.h2) & bMask;
+        if (!(bf.Bits[bit >> 3] & (1 << (bit & 7)))) return false;
+       }
+   return true;
+}
+
+/******************************************************************************/
+/*                                  S e n d                                   */
+/******************************************************************************/
+
+// Only one filter is sent at a time so that chunks of different filters never
+// mix. We send a copy of the current filter so that paths can be added to it
+// while we wait on the network.
+
+void XrdCmsFilter::Send(XrdCmsNode *nP)
+{
+   static const unsigned int maxChunk = 16384  // Protocol maximum data length
+                      - (sizeof(CmsFilterRequest) - sizeof(CmsRRHdr));
+   CmsFilterRequest fReq;
+   struct iovec ioV[2];
+   unsigned int n, offset;
+   Bloom bf;
+
+// Make sure we have something to send and copy it
+//
+   sMutex.Lock();
+   fMutex.Lock();
+   bf = myFilter;
+   if (bf.Bits && (bf.Bits = (unsigned char *)malloc(bf.Size)))
+      memcpy(bf.Bits, myFilter.Bits, bf.Size);
+      else if (myFilter.Bits)
+              Say.Emsg("Filter", ENOMEM, "copy namespace filter");
+   fMutex.UnLock();
+   if (!bf.Bits) {sMutex.UnLock(); return;}
+
+// Send the filter in chunks of the maximum allowed size
+//
+   memset(&fReq, 0, sizeof(fReq));
+   fReq.Hdr.rrCode = kYR_filter;
+   fReq.Gen        = htonl(bf.Gen);
+   fReq.Size       = htonl(bf.Size);
+   fReq.Hashes     = static_cast<kXR_char>(bf.Hashes);
+   ioV[0].iov_base = (char *)&fReq;
+   ioV[0].iov_len  = sizeof(fReq);
+
+   for (offset = 0; offset < bf.Size; offset += n)
+       {n = bf.Size - offset;
+        if (n > maxChunk) n = maxChunk;
+        fReq.Hdr.modifier = kYR_raw;
+        if (offset + n >= bf.Size)
+           fReq.Hdr.modifier |= CmsFilterRequest::kYR_last;
+        fReq.Hdr.datalen = htons(static_cast<unsigned short>
+                                 (sizeof(fReq) - sizeof(CmsRRHdr) + n));
+        fReq.Offset      = htonl(offset);
+        ioV[1].iov_base  = (char *)bf.Bits + offset;
+        ioV[1].iov_len   = n;
+        if (!nP) XrdCmsManager::Inform("filter", ioV, 2, sizeof(fReq) + n);
+           else if (nP->Send(ioV, 2, sizeof(fReq) + n) < 0) break;
+       }
+
+// All done
+//
+   sMutex.UnLock();
+   free(bf.Bits);
+}
+
+/******************************************************************************/
+/*                                   S e t                                    */
+/******************************************************************************/
+
+void XrdCmsFilter::Set(Bloom &bf, const HashPair &hp)
+{
+   unsigned int bit, bMask = bf.Size*8 - 1;
+
+   for (int i = 0; i < bf.Hashes; i++)
+       {bit = (hp.h1 + i*hp.h2) & bMask;
+        bf.Bits[bit >> 3] |= static_cast<unsigned char>(1 << (bit & 7));
+       }
+}
+
+/******************************************************************************/
+/*                                  W a l k                                   */
+/******************************************************************************/
+
+void XrdCmsFilter::Walk(const char *path, std::vector<HashPair> &hv)
+{
+   EPNAME("Walk");
+   std::vector<std::string> Dirs(1, std::string(path));
+   std::set<std::pair<dev_t, ino_t> > Seen;
+   std::string dir, fn;
+   XrdOucEnv   myEnv;
+   XrdOssDF   *dP;
+   struct stat Stat;
+   HashPair hp;
+   char dname[XrdCmsMAX_PATH_LEN];
+   bool autoStat;
+   int rc;
+
+// The exported path itself may be looked up
+//
+   if (Hash(path, strlen(path), hp)) hv.push_back(hp);
+
+// Walk the tree adding every file and directory. We avoid symlink loops by
+// never entering the same directory twice.
+//
+   while(!Dirs.empty())
+        {dir = Dirs.back(); Dirs.pop_back();
+         if (!(dP = Config.ossFS->newDir("cmsd"))) break;
+         if ((rc = dP->Opendir(dir.c_str(), myEnv)))
+            {DEBUG("unable to open " <<dir <<"; rc=" <<rc);
+             delete dP;
+             continue;
+            }
+         autoStat = !dP->StatRet(&Stat);
+         if (dir.empty() || dir[dir.size()-1] != '/') dir += '/';
+
+         do {*dname = 0;
+             rc = dP->Readdir(dname, sizeof(dname));
+             if (!*dname) break;
+             if (*dname == '.' && (!dname[1] || (dname[1] == '.' && !dname[2])))
+                continue;
+             fn = dir; fn += dname;
+             if (Hash(fn.c_str(), fn.size(), hp)) hv.push_back(hp);
+             if (!autoStat) rc = Config.ossFS->Stat(fn.c_str(), &Stat,
+                                                    XRDOSS_resonly);
+             if (!rc && S_ISDIR(Stat.st_mode)
+             &&  Seen.insert(std::make_pair(Stat.st_dev, Stat.st_ino)).second)
+                Dirs.push_back(fn);
+            } while(1);
+
+         dP->Close();
+         delete dP;
+        }
+}
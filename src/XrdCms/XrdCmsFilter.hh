@@ -0,0 +1,134 @@
+#ifndef __XRDCMSFILTER_HH__
+#define __XRDCMSFILTER_HH__
+/******************************************************************************/
+/*                                                                            */
+/*                       X r d C m s F i l t e r . h h                        */
+/*                                                                            */
+/* This file is part of the XRootD software suite.                            */
+/*                                                                            */
+/* XRootD is free software: you can redistribute it and/or modify it under    */
+/* the terms of the GNU Lesser General Public License as published by the     */
+/* Free Software Foundation, either version 3 of the License, or (at your     */
+/* option) any later version.                                                 */
+/*                                                                            */
+/* XRootD is distributed in the hope that it will be useful, but WITHOUT      */
+/* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or      */
+/* FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public       */
+/* License for more details.                                                  */
+/*                                                                            */
+/* You should have received a copy of the GNU Lesser General Public License   */
+/* along with XRootD in a file called COPYING.LESSER (LGPL license) and file  */
+/* COPYING (GPL license).  If not, see <http://www.gnu.org/licenses/>.        */
+/*                                                                            */
+/* The copyright holder's institutional names and contributor's names may not */
+/* be used to endorse or promote products derived from this software without  */
+/* specific prior written permission of the institution or contributor.       */
+/******************************************************************************/
+
+#include <vector>
+
+#include "XrdCms/XrdCmsTypes.hh"
+#include "XrdSys/XrdSysPthread.hh"
+
+class XrdCmsNode;
+
+// The XrdCmsFilter object holds Bloom filter summaries of data server
+// namespaces. A data server periodically walks its exported paths and sends
+// the resulting filter to its managers (kYR_filter), adding newly created
+// files to it as they are reported. A manager keeps the filter of each node
+// and uses it on a cache miss to only query the nodes that may have the file.
+// A node without a filter is always queried and, as a filter may miss files
+// created since it was built, all nodes are queried when none of them match. As a Bloom filter cannot forget
+// a path, removed files linger in the filter until the next full walk.
+//
+class XrdCmsFilter
+{
+public:
+
+// Manager side: record that the node in slot has path (e.g. via have).
+//
+void           Add(int slot, const char *path, int plen);
+
+// Manager side: return the nodes in mask that may have the path.
+//
+SMask_t        Match(const char *path, int plen, SMask_t mask);
+
+// Manager side: forget the filter of the node in slot.
+//
+void           Reset(int slot);
+
+// Manager side: merge a filter chunk sent by the node in slot. Returns 0 upon
+// success and an error message text otherwise.
+//
+const char    *Update(int slot, const char *data, int dlen, bool isLast);
+
+// Server side: record a newly created path.
+//
+void           Added(const char *path);
+
+// Server side: walk the namespace and send the filter every Every seconds.
+//
+void          *Builder();
+
+// Server side: send the current filter, if any, to the indicated manager.
+//
+void           Publish(XrdCmsNode *nP);
+
+// Configuration: enable filtering with the given number of bits per path and
+// the number of seconds between namespace walks.
+//
+void           setParms(bool on, int bpe, int every)
+                       {isOn = on; BitsPE = bpe; Every = every;}
+
+bool           Enabled() {return isOn;}
+
+               XrdCmsFilter();
+              ~XrdCmsFilter() {} // Never gets deleted
+
+static const int MaxSize = 64*1024*1024; // Maximum filter size in bytes
+
+private:
+
+struct Bloom
+      {unsigned char *Bits;
+       unsigned int    Size;    // Bytes, a power of two
+       unsigned int    Gen;
+       unsigned int    Rcvd;    // Bytes received (pending filters only)
+       int             Hashes;
+      };
+
+struct HashPair {unsigned int h1, h2;};
+
+static bool    Hash(const char *path, int plen, HashPair &hp);
+static bool    Has(Bloom &bf, const HashPair &hp);
+static void    Set(Bloom &bf, const HashPair &hp);
+
+void           Build();
+void           Send(XrdCmsNode *nP);
+void           Walk(const char *path, std::vector<HashPair> &hv);
+
+// Manager side
+//
+XrdSysRWLock   bfLock;
+Bloom          Active[STMax];
+Bloom          Pending[STMax];
+SMask_t        hasFilter;       // Slots with an active filter
+
+// Server side
+//
+XrdSysMutex    fMutex;
+XrdSysMutex    sMutex;          // Serializes sending the filter
+Bloom          myFilter;
+std::vector<HashPair> Adds;     // Paths added while walking the namespace
+bool           Walking;
+
+bool           isOn;
+int            BitsPE;
+int            Every;
+};
+
+namespace XrdCms
+{
+extern XrdCmsFilter NSFilter;
+}
+#endif
@@ -29,6 +29,7 @@
 /******************************************************************************/
 
 #include <errno.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include "XrdCms/XrdCmsKey.hh"
@@ -51,6 +52,149 @@ void XrdCmsKey::setHash()
      if (!(Hash = XrdOucCRC::CRC32((const unsigned char *)Val, Len))) Hash = 1;
 }
 
+/******************************************************************************/
+/*                    C l a s s   X r d C m s K e y P f x                     */
+/******************************************************************************/
+/******************************************************************************/
+/*                         L o c a l   O b j e c t s                          */
+/******************************************************************************/
+
+namespace
+{
+// Prefixes are only looked up when a key is added to or removed from the
+// cache, so a few stripes, each a simple chained table, are plenty. Note that
+// the stripe is selected by the high bits of the hash and the bucket by the
+// low bits as the table size is a power of two.
+//
+struct XrdCmsKeyPfxStripe
+      {XrdSysMutex    Mutex;
+       XrdCmsKeyPfx **Table;
+       int            Size;
+       int            Num;
+       long long      Bytes;
+
+       void           Expand();
+
+       XrdCmsKeyPfxStripe() : Table(0), Size(0), Num(0), Bytes(0) {}
+      };
+
+static const int  pfxStripeBits = 4;
+static const int  pfxStripes    = 1 << pfxStripeBits;
+static const int  pfxMinSize    = 256;
+
+XrdCmsKeyPfxStripe pfxTable[pfxStripes];
+
+/******************************************************************************/
+/*                                E x p a n d                                 */
+/******************************************************************************/
+
+void XrdCmsKeyPfxStripe::Expand()
+{
+   XrdCmsKeyPfx **newTab, *pP, *nP;
+   int newSize = (Size ? Size*2 : pfxMinSize), i;
+
+// Allocate the new table. If we can't, we simply continue with longer chains.
+//
+   if (!(newTab = (XrdCmsKeyPfx **)calloc(newSize, sizeof(XrdCmsKeyPfx *))))
+      return;
+
+// Redistribute the entries
+//
+   for (i = 0; i < Size; i++)
+       {pP = Table[i];
+        while(pP)
+             {nP = pP->Next;
+              pP->Next = newTab[pP->Hash & (newSize-1)];
+              newTab[pP->Hash & (newSize-1)] = pP;
+              pP = nP;
+             }
+       }
+
+// Plug in the new table
+//
+   if (Table) free(Table);
+   Table = newTab;
+   Size  = newSize;
+}
+}
+
+/******************************************************************************/
+/* static public                     G e t                                    */
+/******************************************************************************/
+  
+XrdCmsKeyPfx *XrdCmsKeyPfx::Get(const char *path, int plen)
+{
+   unsigned int hash = XrdOucCRC::CRC32((const unsigned char *)path, plen);
+   XrdCmsKeyPfxStripe &S = pfxTable[hash >> (32 - pfxStripeBits)];
+   XrdCmsKeyPfx *pP;
+   XrdSysMutexHelper mHelp(S.Mutex);
+
+// Look for an existing prefix and return it if found
+//
+   if (S.Size)
+      {pP = S.Table[hash & (S.Size-1)];
+       while(pP && (pP->Hash != hash || pP->Len != plen
+                ||  memcmp(pP->Val, path, plen))) pP = pP->Next;
+       if (pP) {pP->Refs++; return pP;}
+      }
+
+// Make room if need be and create a new prefix. The name follows the object.
+//
+   if (S.Num >= S.Size) S.Expand();
+   if (!S.Size || !(pP = (XrdCmsKeyPfx *)malloc(sizeof(XrdCmsKeyPfx)+plen+1)))
+      return 0;
+   pP->Val  = (char *)(pP+1);
+   memcpy(pP->Val, path, plen); pP->Val[plen] = 0;
+   pP->Hash = hash;
+   pP->Len  = plen;
+   pP->Refs = 1;
+   pP->Next = S.Table[hash & (S.Size-1)];
+   S.Table[hash & (S.Size-1)] = pP;
+   S.Num++;
+   S.Bytes += sizeof(XrdCmsKeyPfx)+plen+1;
+   return pP;
+}
+
+/******************************************************************************/
+/* public                        R e l e a s e                                */
+/******************************************************************************/
+  
+void XrdCmsKeyPfx::Release()
+{
+   XrdCmsKeyPfxStripe &S = pfxTable[Hash >> (32 - pfxStripeBits)];
+   XrdCmsKeyPfx *pP, *xP = 0;
+
+// Drop the reference and remove the prefix when it is no longer used
+//
+   S.Mutex.Lock();
+   if (--Refs > 0) {S.Mutex.UnLock(); return;}
+   pP = S.Table[Hash & (S.Size-1)];
+   while(pP && pP != this) {xP = pP; pP = pP->Next;}
+   if (pP)
+      {if (xP) xP->Next = Next;
+          else S.Table[Hash & (S.Size-1)] = Next;
+       S.Num--;
+       S.Bytes -= sizeof(XrdCmsKeyPfx)+Len+1;
+      }
+   S.Mutex.UnLock();
+   if (pP) free(this);
+}
+
+/******************************************************************************/
+/* static public                   S t a t s                                  */
+/******************************************************************************/
+
+void XrdCmsKeyPfx::Stats(int &numPfx, long long &pfxBytes)
+{
+   numPfx = 0; pfxBytes = 0;
+   for (int i = 0; i < pfxStripes; i++)
+       {pfxTable[i].Mutex.Lock();
+        numPfx   += pfxTable[i].Num;
+        pfxBytes += pfxTable[i].Bytes;
+        pfxTable[i].Mutex.UnLock();
+       }
+}
+
 /******************************************************************************/
 /*                   C l a s s   X r d C m s K e y I t e m                    */
 /******************************************************************************/
@@ -58,7 +202,7 @@ void XrdCmsKey::setHash()
 /*                           S t a t i c   D a t a                            */
 /******************************************************************************/
   
-XrdCmsKeyItem *XrdCmsKeyItem::TockTable[TickRate] = {0};
+XrdSysMutex    XrdCmsKeyItem::freeMutex;
 XrdCmsKeyItem *XrdCmsKeyItem::Free    = 0;
 int            XrdCmsKeyItem::numFree = 0;
 int            XrdCmsKeyItem::numHave = 0;
@@ -68,24 +212,26 @@ int            XrdCmsKeyItem::numNull = 0;
 /* static public                   A l l o c                                  */
 /******************************************************************************/
   
-XrdCmsKeyItem *XrdCmsKeyItem::Alloc(unsigned int theTock)
+// The free list has its own lock as items are allocated and recycled while
+// holding the lock of any one of the cache shards.
+//
+XrdCmsKeyItem *XrdCmsKeyItem::Alloc()
 {
   XrdCmsKeyItem *kP;
 
 // Try to allocate an existing item or replenish the list
 //
-   do {if ((kP = Free))
+   do {freeMutex.Lock();
+       if ((kP = Free))
           {Free = kP->Next;
            numFree--;
-           theTock &= TickMask;
-           kP->Key.TOD    = theTock;
-           kP->Key.TODRef = TockTable[theTock];
-           TockTable[theTock] = kP;
+           freeMutex.UnLock();
            if (!(kP->Key.Ref++)) kP->Key.Ref = 1;
-            kP->Loc.roPend = kP->Loc.rwPend = 0;
+           kP->Loc.roPend = kP->Loc.rwPend = 0;
            return kP;
           }
        numNull++;
+       freeMutex.UnLock();
        } while(Replenish());
 
 // We failed
@@ -94,6 +240,23 @@ XrdCmsKeyItem *XrdCmsKeyItem::Alloc(unsigned int theTock)
    return (XrdCmsKeyItem *)0;
 }
 
+/******************************************************************************/
+/* public                           P a t h                                   */
+/******************************************************************************/
+  
+// Reconstruct the full path of the key into buff, returning its length or -1
+// if it does not fit.
+//
+int XrdCmsKeyItem::Path(char *buff, int blen)
+{
+   int plen = (Pfx ? Pfx->Len : 0), nlen = strlen(Key.Val);
+
+   if (plen + nlen >= blen) return -1;
+   if (plen) memcpy(buff, Pfx->Val, plen);
+   strcpy(buff+plen, Key.Val);
+   return plen + nlen;
+}
+
 /******************************************************************************/
 /* public                        R e c y c l e                                */
 /******************************************************************************/
@@ -104,24 +267,17 @@ void XrdCmsKeyItem::Recycle()
 
 // Clear up data areas
 //
-   if (Key.Val && Key.Val != noKey) {free(Key.Val); Key.Val = noKey;}
+   if (Pfx) {Pfx->Release(); Pfx = 0;}
+   if (Key.Val && Key.Val != noKey && Key.Val != Name) free(Key.Val);
+   Key.Val = noKey;
    Key.Ref++; Key.Hash = 0;
 
 // Put entry on the free list
 //
+   freeMutex.Lock();
    Next = Free; Free = this;
    numFree++;
-}
-
-/******************************************************************************/
-/* public                         R e l o a d                                 */
-/******************************************************************************/
-  
-void XrdCmsKeyItem::Reload()
-{
-   Key.TOD &= static_cast<unsigned char>(TickMask);
-   Key.TODRef = TockTable[Key.TOD];
-   TockTable[Key.TOD] = this;
+   freeMutex.UnLock();
 }
 
 /******************************************************************************/
@@ -132,79 +288,65 @@ int XrdCmsKeyItem::Replenish()
 {
    EPNAME("Replenish");
    XrdCmsKeyItem *kP;
-   int i;
+   int i, nFree;
 
-// Allocate a quantum of free elements and chain them into the free list
+// Allocate a quantum of free elements
 //
    if (!(kP = new XrdCmsKeyItem[minAlloc])) return 0;
-   DEBUG("old free " <<numFree <<" + " <<minAlloc <<" = " <<numHave+minAlloc);
 
 // We would do this in an initializer but that causes problems when alloacting
 // temporary items on the stack. So, manually put these on the free list.
 //
+   freeMutex.Lock();
+   DEBUG("old free " <<numFree <<" + " <<minAlloc <<" = " <<numHave+minAlloc);
    i = minAlloc;
    while(i--) {kP->Next = Free; Free = kP; kP++;}
   
 // Return the number we have free
 //
    numHave += minAlloc;
-   numFree += minAlloc;
-   return numFree;
+   nFree = (numFree += minAlloc);
+   freeMutex.UnLock();
+   return nFree;
 }
 
 /******************************************************************************/
-/* static public                   S t a t s                                  */
+/* public                         S e t K e y                                 */
 /******************************************************************************/
-
-void XrdCmsKeyItem::Stats(int &isAlloc, int &isFree, int &wasNull)
+  
+// Set the key of a newly allocated item from a fully hashed lookup key. The
+// directory part is interned and the name is copied into the item if it fits.
+//
+void XrdCmsKeyItem::SetKey(XrdCmsKey &theKey)
 {
+   const char *bP = strrchr(theKey.Val, '/');
+   int plen = (bP ? bP - theKey.Val + 1 : 0), nlen;
 
-   isAlloc  = numHave;
-   isFree   = numFree;
-   wasNull  = numNull;
-   numNull  = 0;
+// Get the prefix; should that fail we store the full path as the name
+//
+   if (!plen || !(Pfx = XrdCmsKeyPfx::Get(theKey.Val, plen))) plen = 0;
+   nlen = theKey.Len - plen;
+
+// Copy the name
+//
+   if (nlen < NameMax) Key.Val = Name;
+      else Key.Val = (char *)malloc(nlen+1);
+   memcpy(Key.Val, theKey.Val+plen, nlen); Key.Val[nlen] = 0;
+   Key.Hash = theKey.Hash;
+   Key.Len  = theKey.Len;
 }
 
 /******************************************************************************/
-/* static public                  U n l o a d                                 */
+/* static public                   S t a t s                                  */
 /******************************************************************************/
-  
-XrdCmsKeyItem *XrdCmsKeyItem::Unload(unsigned int theTock)
-{
-   XrdCmsKeyItem myItem, *nP, *pP = &myItem;
-
-// Remove all entries from the indicated list. If any entries have been
-// reassigned to a different list, move them to the right list. Otherwise,
-// make the entry unfindable by clearing the hash code. Since item recycling
-// requires knowing the hash code, we save it elsewhere in the object.
-//
-   theTock &= TickMask;
-   myItem.Key.TODRef = TockTable[theTock]; TockTable[theTock] = 0;
-   while((nP = pP->Key.TODRef))
-         if (nP->Key.TOD == theTock) 
-            {nP->Loc.HashSave = nP->Key.Hash; nP->Key.Hash = 0; pP = nP;}
-            else {pP->Key.TODRef = nP->Key.TODRef;
-                  nP->Key.TODRef = TockTable[nP->Key.TOD];
-                  TockTable[nP->Key.TOD] = nP;
-                 }
-   return myItem.Key.TODRef;
-}
 
-/******************************************************************************/
-  
-XrdCmsKeyItem *XrdCmsKeyItem::Unload(XrdCmsKeyItem *theItem)
+void XrdCmsKeyItem::Stats(int &isAlloc, int &isFree, int &wasNull)
 {
-   XrdCmsKeyItem *kP, *pP = 0;
-   unsigned int theTock = theItem->Key.TOD & TickMask;
 
-// Remove the entry from the right list
-//
-   kP = TockTable[theTock];
-   while(kP && kP != theItem) {pP = kP; kP = kP->Key.TODRef;}
-   if (kP)
-      {if (pP) pP->Key.TODRef     = kP->Key.TODRef;
-          else TockTable[theTock] = kP->Key.TODRef;
-       kP->Loc.HashSave = kP->Key.Hash; kP->Key.Hash = 0;
-      }
-   return kP;
+   freeMutex.Lock();
+   isAlloc  = numHave;
+   isFree   = numFree;
+   wasNull  = numNull;
+   numNull  = 0;
+   freeMutex.UnLock();
 }
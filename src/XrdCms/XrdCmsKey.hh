@@ -33,6 +33,7 @@
 #include <string.h>
 
 #include "XrdCms/XrdCmsTypes.hh"
+#include "XrdSys/XrdSysPthread.hh"
 
 /******************************************************************************/
 /*                       C l a s s   X r d C m s K e y                        */
@@ -114,13 +115,42 @@ XrdCmsKeyLoc&  operator=(const XrdCmsKeyLoc &rhs)
               ~XrdCmsKeyLoc() {}
 };
   
+/******************************************************************************/
+/*                    C l a s s   X r d C m s K e y P f x                     */
+/******************************************************************************/
+
+// The XrdCmsKeyPfx object holds a directory prefix (i.e. the path up to and
+// including the last slash) shared by all cached keys in that directory. The
+// prefixes are interned in a lock striped table and reference counted so that
+// each directory name is kept only once no matter how many files it has.
+//
+class XrdCmsKeyPfx
+{
+public:
+
+static XrdCmsKeyPfx *Get(const char *path, int plen);
+
+       void          Release();
+
+static void          Stats(int &numPfx, long long &pfxBytes);
+
+       XrdCmsKeyPfx *Next;
+       char         *Val;
+       unsigned int  Hash;
+       int           Len;
+       int           Refs;
+};
+
 /******************************************************************************/
 /*                   C l a s s   X r d C m s K e y I t e m                    */
 /******************************************************************************/
   
 // The XrdCmsKeyItem object marries the XrdCmsKey and XrdCmsKeyLoc objects in
 // the key cache. It is only used by logical manipulator, XrdCmsCache, which
-// always front-ends the physical manipulator, XrdCmsNash.
+// always front-ends the physical manipulator, XrdCmsNash. The key is stored
+// compactly: the directory is an interned XrdCmsKeyPfx and Key.Val only holds
+// the file name, kept in the item itself unless it is unusually long. Hence,
+// Key.Len is the length of the full path while Key.Val is just the name.
 //
 class XrdCmsKeyItem
 {
@@ -129,32 +159,42 @@ public:
        XrdCmsKeyLoc   Loc;
        XrdCmsKey      Key;
        XrdCmsKeyItem *Next;
+       XrdCmsKeyItem *TODPrev;  // Previous item in the Key.TODRef list
+       XrdCmsKeyPfx  *Pfx;
 
-static XrdCmsKeyItem *Alloc(unsigned int theTock);
+static XrdCmsKeyItem *Alloc();
 
-       void           Recycle();
+inline bool           Matches(XrdCmsKey &oth)
+                             {int plen = (Pfx ? Pfx->Len : 0);
+                              return Key.Hash == oth.Hash && Key.Len == oth.Len
+                                  && (!plen || !memcmp(Pfx->Val,oth.Val,plen))
+                                  && !strcmp(Key.Val, oth.Val+plen);
+                             }
 
-       void           Reload();
+       int            Path(char *buff, int blen);
 
-static int            Replenish();
+       void           Recycle();
 
-static void           Stats(int &isAlloc, int &isFree, int &wasEmpty);
+static int            Replenish();
 
-static XrdCmsKeyItem *Unload(unsigned int   theTock);
+       void           SetKey(XrdCmsKey &theKey);
 
-static XrdCmsKeyItem *Unload(XrdCmsKeyItem *theItem);
+static void           Stats(int &isAlloc, int &isFree, int &wasEmpty);
 
-       XrdCmsKeyItem() {}  // Warning see the constructor!
+       XrdCmsKeyItem() : Pfx(0) {}  // Warning see Replenish()!
       ~XrdCmsKeyItem() {}  // These are usually never deleted
 
 static const unsigned int TickRate =   64;
 static const unsigned int TickMask =   63;
 static const          int minAlloc = 4096;
 static const          int minFree  = 1024;
+static const          int NameMax  =   40; // Longer names are allocated
 
 private:
 
-static XrdCmsKeyItem *TockTable[TickRate];
+       char           Name[NameMax];
+
+static XrdSysMutex    freeMutex;
 static XrdCmsKeyItem *Free;
 static int            numFree;
 static int            numHave;
@@ -32,19 +32,39 @@
 
 #include "XrdCms/XrdCmsNash.hh"
 
+/******************************************************************************/
+/*                         L o c a l   M e t h o d s                          */
+/******************************************************************************/
+
+namespace
+{
+// Items made unfindable by Unload() are still in the table until recycled and
+// their hash value is then in Loc.HashSave.
+//
+inline unsigned int HashOf(XrdCmsKeyItem *iP)
+                          {return (iP->Key.Hash ? iP->Key.Hash
+                                                : iP->Loc.HashSave);
+                          }
+}
+  
 /******************************************************************************/
 /*                           C o n s t r u c t o r                            */
 /******************************************************************************/
   
 XrdCmsNash::XrdCmsNash(int psize, int csize)
 {
-     prevtablesize = psize;
-     nashtablesize = csize;
-     Threshold     = (csize * LoadMax) / 100;
-     nashnum       = 0;
-     nashtable     = (XrdCmsKeyItem **)
-                     malloc( (size_t)(csize*sizeof(XrdCmsKeyItem *)) );
-     memset((void *)nashtable, 0, (size_t)(csize*sizeof(XrdCmsKeyItem *)));
+   for (int i = 0; i < NumShards; i++)
+       {NashShard &S = Shards[i];
+        S.prevSize  = psize;
+        S.Size      = csize;
+        S.Threshold = (csize * LoadMax) / 100;
+        S.Num       = 0;
+        S.Table     = (XrdCmsKeyItem **)calloc(csize, sizeof(XrdCmsKeyItem *));
+        S.OldTable  = 0;
+        S.oldSize   = S.Moved = 0;
+        S.Tock      = 0;
+        memset((void *)S.TockTable, 0, sizeof(S.TockTable));
+       }
 }
 
 /******************************************************************************/
@@ -53,73 +73,102 @@ XrdCmsNash::XrdCmsNash(int psize, int csize)
   
 XrdCmsKeyItem *XrdCmsNash::Add(XrdCmsKey &Key)
 {
-   XrdCmsKeyItem *hip;
-   unsigned int kent;
+   NashShard &S = Shards[Shard(Key)];
+   XrdCmsKeyItem *hip, **bP;
 
 // Allocate the entry
 //
-   if (!(hip = XrdCmsKeyItem::Alloc(Key.TOD))) return (XrdCmsKeyItem *)0;
+   if (!(hip = XrdCmsKeyItem::Alloc())) return (XrdCmsKeyItem *)0;
 
-// Check if we should expand the table
+// Check if we should expand the table or continue a previous expansion
 //
-   if (++nashnum > Threshold) Expand();
+   if (++S.Num > S.Threshold) Expand(S);
+      else if (S.OldTable) Migrate(S, MoveMax);
 
-// Fill out the key data
+// Fill out the key data and place it in the current time-of-day list
 //
-   if (!Key.Hash) Key.setHash();
-   hip->Key = Key;
+   hip->SetKey(Key);
+   hip->Key.TOD = S.Tock;
+   Link(S, hip);
 
 // Add the entry to the table
 //
-   kent = Key.Hash % nashtablesize;
-   hip->Next = nashtable[kent];
-   nashtable[kent] = hip;
+   bP = Bucket(S, Key.Hash);
+   hip->Next = *bP;
+   *bP = hip;
    return hip;
 }
+
+/******************************************************************************/
+/* private                        B u c k e t                                 */
+/******************************************************************************/
+
+// An item lives in the old table as long as its bucket there was not migrated.
+//
+XrdCmsKeyItem **XrdCmsNash::Bucket(NashShard &S, unsigned int hash)
+{
+   if (S.OldTable)
+      {int kent = hash % S.oldSize;
+       if (kent >= S.Moved) return &S.OldTable[kent];
+      }
+   return &S.Table[hash % S.Size];
+}
   
 /******************************************************************************/
 /* private                        E x p a n d                                 */
 /******************************************************************************/
   
-void XrdCmsNash::Expand()
+void XrdCmsNash::Expand(NashShard &S)
 {
-   int newsize, newent, i;
-   size_t memlen;
-   XrdCmsKeyItem **newtab, *nip, *nextnip;
+   int newsize;
+   XrdCmsKeyItem **newtab;
+
+// If the previous expansion has not completed (unlikely) finish it now
+//
+   if (S.OldTable) Migrate(S, S.oldSize);
 
 // Compute new size for table using a fibonacci series
 //
-   newsize = prevtablesize + nashtablesize;
+   newsize = S.prevSize + S.Size;
 
 // Allocate the new table
 //
-   memlen = (size_t)(newsize*sizeof(XrdCmsKeyItem *));
-   if (!(newtab = (XrdCmsKeyItem **) malloc(memlen))) return;
-   memset((void *)newtab, 0, memlen);
-
-// Redistribute all of the current items
-//
-   for (i = 0; i < nashtablesize; i++)
-       {nip = nashtable[i];
-        while(nip)
-             {nextnip = nip->Next;
-              newent  = nip->Key.Hash % newsize;
-              nip->Next = newtab[newent];
-              newtab[newent] = nip;
-              nip = nextnip;
-             }
-       }
+   if (!(newtab = (XrdCmsKeyItem **)calloc(newsize, sizeof(XrdCmsKeyItem *))))
+      return;
 
-// Free the old table and plug in the new table
+// Keep the current table around; its items are migrated as we go along
 //
-   free((void *)nashtable);
-   nashtable     = newtab;
-   prevtablesize = nashtablesize;
-   nashtablesize = newsize;
+   S.OldTable = S.Table;
+   S.oldSize  = S.Size;
+   S.Moved    = 0;
+   S.Table    = newtab;
+   S.prevSize = S.Size;
+   S.Size     = newsize;
 
 // Compute new expansion threshold
 //
-   Threshold = static_cast<int>((static_cast<long long>(newsize)*LoadMax)/100);
+   S.Threshold = static_cast<int>((static_cast<long long>(newsize)*LoadMax)/100);
+}
+
+/******************************************************************************/
+/* public                          A p p l y                                  */
+/******************************************************************************/
+
+int XrdCmsNash::Apply(int shard, bool (*func)(XrdCmsKeyItem *, void *),
+                      void *arg)
+{
+   NashShard &S = Shards[shard];
+   XrdCmsKeyItem *iP;
+   int num = 0;
+
+// Every findable item is in exactly one of the time-of-day lists
+//
+   for (unsigned int i = 0; i < XrdCmsKeyItem::TickRate; i++)
+       for (iP = S.TockTable[i]; iP; iP = iP->Key.TODRef)
+           {num++;
+            if (!func(iP, arg)) return num;
+           }
+   return num;
 }
 
 /******************************************************************************/
@@ -128,24 +177,64 @@ void XrdCmsNash::Expand()
   
 XrdCmsKeyItem *XrdCmsNash::Find(XrdCmsKey &Key)
 {
+  NashShard &S = Shards[Shard(Key)];
   XrdCmsKeyItem *nip;
-  unsigned int kent;
 
-// Check if we already have a hash value and get one if not
+// Help along any expansion in progress
 //
-   if (!Key.Hash) Key.setHash();
-
-// Compute position of the hash table entry
-//
-   kent = Key.Hash%nashtablesize;
+   if (S.OldTable) Migrate(S, MoveMax);
 
 // Find the entry
 //
-   nip = nashtable[kent];
-   while(nip && nip->Key != Key) nip = nip->Next;
+   nip = *Bucket(S, Key.Hash);
+   while(nip && !nip->Matches(Key)) nip = nip->Next;
    return nip;
 }
 
+/******************************************************************************/
+/* private                          L i n k                                   */
+/******************************************************************************/
+
+// Place the item at the front of the time-of-day list given by its Key.TOD.
+//
+void XrdCmsNash::Link(NashShard &S, XrdCmsKeyItem *iP)
+{
+   XrdCmsKeyItem *hP = S.TockTable[iP->Key.TOD];
+
+   iP->TODPrev    = 0;
+   iP->Key.TODRef = hP;
+   if (hP) hP->TODPrev = iP;
+   S.TockTable[iP->Key.TOD] = iP;
+}
+
+/******************************************************************************/
+/* private                       M i g r a t e                                */
+/******************************************************************************/
+  
+void XrdCmsNash::Migrate(NashShard &S, int n)
+{
+   XrdCmsKeyItem *nip, *nextnip;
+   int newent;
+
+// Move the next n buckets of the old table into the new one
+//
+   while(n-- > 0 && S.OldTable)
+        {nip = S.OldTable[S.Moved];
+         while(nip)
+              {nextnip = nip->Next;
+               newent  = HashOf(nip) % S.Size;
+               nip->Next = S.Table[newent];
+               S.Table[newent] = nip;
+               nip = nextnip;
+              }
+         if (++S.Moved >= S.oldSize)
+            {free((void *)S.OldTable);
+             S.OldTable = 0;
+             S.oldSize  = S.Moved = 0;
+            }
+        }
+}
+
 /******************************************************************************/
 /* public                        R e c y c l e                                */
 /******************************************************************************/
@@ -155,25 +244,96 @@ XrdCmsKeyItem *XrdCmsNash::Find(XrdCmsKey &Key)
 //
 int XrdCmsNash::Recycle(XrdCmsKeyItem *rip)
 {
-   XrdCmsKeyItem *nip, *pip = 0;
-   unsigned int kent;
-
-// Compute position of the hash table entry
-//
-   kent = rip->Loc.HashSave%nashtablesize;
+   NashShard &S = Shards[Shard(rip->Loc.HashSave)];
+   XrdCmsKeyItem *nip, *pip = 0, **bP;
 
 // Find the entry
 //
-   nip = nashtable[kent];
+   bP  = Bucket(S, rip->Loc.HashSave);
+   nip = *bP;
    while(nip && nip != rip) {pip = nip; nip = nip->Next;}
 
 // Remove and recycle if found
 //
    if (nip)
       {if (pip) pip->Next = nip->Next;
-          else nashtable[kent] = nip->Next;
+          else *bP = nip->Next;
           rip->Recycle();
-          nashnum--;
+          S.Num--;
       }
    return nip != 0;
 }
+
+/******************************************************************************/
+/* public                          S t a t s                                  */
+/******************************************************************************/
+
+void XrdCmsNash::Stats(int &numItems, int &numSlots, int &numMigrating)
+{
+   numItems = numSlots = numMigrating = 0;
+   for (int i = 0; i < NumShards; i++)
+       {Lock(i);
+        numItems += Shards[i].Num;
+        numSlots += Shards[i].Size;
+        if (Shards[i].OldTable) numMigrating++;
+        UnLock(i);
+       }
+}
+
+/******************************************************************************/
+/* public                         U n l o a d                                 */
+/******************************************************************************/
+  
+XrdCmsKeyItem *XrdCmsNash::Unload(int shard, unsigned int theTock,
+                                  XrdCmsKeyItem *theList)
+{
+   NashShard &S = Shards[shard];
+   XrdCmsKeyItem myItem, *nP, *pP = &myItem;
+
+// Remove all entries from the indicated list. If any entries have been
+// reassigned to a different list, move them to the right list. Otherwise,
+// make the entry unfindable by clearing the hash code. Since item recycling
+// requires knowing the hash code, we save it elsewhere in the object. New
+// entries in this shard now go into the list we just emptied.
+//
+   theTock &= XrdCmsKeyItem::TickMask;
+   S.Tock = theTock;
+   myItem.Key.TODRef = S.TockTable[theTock]; S.TockTable[theTock] = 0;
+   while((nP = pP->Key.TODRef))
+         if (nP->Key.TOD == theTock) 
+            {nP->Loc.HashSave = nP->Key.Hash; nP->Key.Hash = 0; pP = nP;}
+            else {pP->Key.TODRef = nP->Key.TODRef;
+                  Link(S, nP);
+                 }
+   pP->Key.TODRef = theList;
+   return myItem.Key.TODRef;
+}
+
+/******************************************************************************/
+
+// The time-of-day lists are doubly linked so that an item can be removed
+// without searching the list. An item may sit in the list of an earlier
+// tick than its Key.TOD (see Unload() above), so when it is at the head we
+// need to find the list it heads.
+//
+XrdCmsKeyItem *XrdCmsNash::Unload(XrdCmsKeyItem *theItem)
+{
+   NashShard &S = Shards[Shard(theItem->Key.Hash)];
+   XrdCmsKeyItem *nP = theItem->Key.TODRef;
+   unsigned int i;
+
+// Remove the entry from its list
+//
+   if (theItem->TODPrev) theItem->TODPrev->Key.TODRef = nP;
+      else {for (i = 0; i < XrdCmsKeyItem::TickRate; i++)
+                if (S.TockTable[i] == theItem) break;
+            if (i >= XrdCmsKeyItem::TickRate) return 0;
+            S.TockTable[i] = nP;
+           }
+   if (nP) nP->TODPrev = theItem->TODPrev;
+
+// Make it unfindable
+//
+   theItem->Loc.HashSave = theItem->Key.Hash; theItem->Key.Hash = 0;
+   return theItem;
+}
@@ -31,33 +31,93 @@
 /******************************************************************************/
 
 #include "XrdCms/XrdCmsKey.hh"
-  
+#include "XrdSys/XrdSysPthread.hh"
+
+// The XrdCmsNash object is the physical key cache. It is split into shards,
+// selected by the high bits of the key hash, each with its own lock, hash
+// table and time-of-day lists. The caller locks the shard of the key (see
+// Shard() and Lock()) around any of the methods below so that lookups only
+// contend with other lookups of keys in the same shard. Tables are resized
+// incrementally: on expansion the old table is kept and its buckets migrated
+// a few at a time as the shard is used, so no call ever rehashes a shard.
+//
 class XrdCmsNash
 {
 public:
 XrdCmsKeyItem *Add(XrdCmsKey &Key);
 
+// Apply() calls func with each item in the shard until it returns false and
+// returns the number of items visited. Items must not be added or removed.
+//
+int            Apply(int shard, bool (*func)(XrdCmsKeyItem *, void *),
+                     void *arg);
+
 XrdCmsKeyItem *Find(XrdCmsKey &Key);
 
+inline void    Lock(int shard)   {Shards[shard].Mutex.Lock();}
+
 int            Recycle(XrdCmsKeyItem *rip);
 
-// When allocateing a new nash, specify the required starting size. Make
-// sure that the previous number is the correct Fibonocci antecedent. The
-// series is simply n[j] = n[j-1] + n[j-2].
+// Return the shard of a key, computing the hash as needed, or of a hash value.
+//
+inline int     Shard(XrdCmsKey &Key)
+                    {if (!Key.Hash) Key.setHash();
+                     return static_cast<int>(Key.Hash >> (32 - ShardBits));
+                    }
+
+static inline
+       int     Shard(unsigned int hash)
+                    {return static_cast<int>(hash >> (32 - ShardBits));}
+
+void           Stats(int &numItems, int &numSlots, int &numMigrating);
+
+// Return the current time-of-day tick of the shard.
 //
-    XrdCmsNash(int psize = 17711, int size = 28657);
+inline unsigned int Tock(int shard) {return Shards[shard].Tock;}
+
+inline void    UnLock(int shard) {Shards[shard].Mutex.UnLock();}
+
+// Unload() makes all items in the indicated time-of-day list of the shard
+// unfindable and returns them chained via Key.TODRef with theList appended.
+//
+XrdCmsKeyItem *Unload(int shard, unsigned int theTock, XrdCmsKeyItem *theList);
+
+XrdCmsKeyItem *Unload(XrdCmsKeyItem *theItem);
+
+static const int ShardBits = 6;
+static const int NumShards = 1 << ShardBits;
+
+// When allocateing a new nash, specify the required starting size of each
+// shard. Make sure that the previous number is the correct Fibonocci
+// antecedent. The series is simply n[j] = n[j-1] + n[j-2].
+//
+    XrdCmsNash(int psize = 377, int size = 610);
    ~XrdCmsNash() {} // Never gets deleted
 
 private:
 
 static const int LoadMax = 80;
+static const int MoveMax = 8;   // Buckets migrated per call while expanding
+
+struct NashShard
+      {XrdSysMutex      Mutex;
+       XrdCmsKeyItem  **Table;
+       XrdCmsKeyItem  **OldTable; // Table being migrated, if any
+       XrdCmsKeyItem   *TockTable[XrdCmsKeyItem::TickRate];
+       int              prevSize;
+       int              Size;
+       int              oldSize;
+       int              Moved;    // OldTable buckets already migrated
+       int              Num;
+       int              Threshold;
+       unsigned int     Tock;
+      };
 
-void               Expand();
+XrdCmsKeyItem    **Bucket(NashShard &S, unsigned int hash);
+void               Expand(NashShard &S);
+void               Link(NashShard &S, XrdCmsKeyItem *iP);
+void               Migrate(NashShard &S, int n);
 
-XrdCmsKeyItem  **nashtable;
-int              prevtablesize;
-int              nashtablesize;
-int              nashnum;
-int              Threshold;
+NashShard          Shards[NumShards];
 };
 #endif
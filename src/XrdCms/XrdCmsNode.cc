@@ -46,6 +46,7 @@
 #include "XrdCms/XrdCmsCluster.hh"
 #include "XrdCms/XrdCmsClustID.hh"
 #include "XrdCms/XrdCmsConfig.hh"
+#include "XrdCms/XrdCmsFilter.hh"
 #include "XrdCms/XrdCmsManager.hh"
 #include "XrdCms/XrdCmsManList.hh"
 #include "XrdCms/XrdCmsMeter.hh"
@@ -312,6 +313,7 @@ void XrdCmsNode::Disc(const char *reason, int needLock)
 //
    if (needLock) nodeMutex.Lock();
    isOffline = 1;         // STMutex is already held if needed
+   Cluster.Refresh(this);
 
 // If we are still connected, initiate a teardown. This may be done async as
 // we are asking for a defered close which will be followed by a full close.
@@ -342,6 +344,7 @@ const char *XrdCmsNode::do_Avail(XrdCmsRRData &Arg)
 //
    DiskFree = Arg.dskFree;
    DiskUtil = static_cast<int>(Arg.dskUtil);
+   Cluster.Refresh(this);
 
 // Do some debugging
 //
@@ -403,10 +406,39 @@ const char *XrdCmsNode::do_Disc(XrdCmsRRData &Arg)
 // Close the link and return an error
 //
    isOffline = 1;  // STMutex not needed here
+   Cluster.Refresh(this);
    Link->Close(1);
    return ".";   // Signal disconnect
 }
 
+/******************************************************************************/
+/*                             d o _ F i l t e r                              */
+/******************************************************************************/
+  
+// Filter requests are sent by a data server to describe its namespace. Each
+// request holds a chunk of the filter which we merge into the node's filter.
+
+const char *XrdCmsNode::do_Filter(XrdCmsRRData &Arg)
+{
+   EPNAME("do_Filter")
+   const char *eTxt;
+   bool isLast = (Arg.Request.modifier & CmsFilterRequest::kYR_last) != 0;
+
+// Ignore filters unless we are a manager that uses them
+//
+   if (!Config.asManager() || !NSFilter.Enabled()) return 0;
+
+// Merge the chunk into the node's filter
+//
+   if ((eTxt = NSFilter.Update(NodeID, Arg.Buff, Arg.Dlen, isLast)))
+      Say.Emsg("Node", Ident, "sent a bad filter;", eTxt);
+      else if (isLast) DEBUG(Ident <<" namespace filter updated");
+
+// All done
+//
+   return 0;
+}
+
 /******************************************************************************/
 /*                               d o _ G o n e                                */
 /******************************************************************************/
@@ -485,7 +517,9 @@ const char *XrdCmsNode::do_Have(XrdCmsRRData &Arg)
             if (baseFS.isDFS())
                {Sel.Vec.hf = pinfo.rovec; Sel.Vec.wf = pinfo.rwvec;
                 isnew       = Cache.AddFile(Sel, allNodes);
-               } else isnew = Cache.AddFile(Sel, NodeMask);
+               } else {isnew = Cache.AddFile(Sel, NodeMask);
+                       NSFilter.Add(NodeID, Arg.Path, Arg.PathLen-1);
+                      }
            }
 
 // Return if we have no managers or we already informed the managers
@@ -527,6 +561,7 @@ const char *XrdCmsNode::do_Load(XrdCmsRRData &Arg)
    myMass = Meter.calcLoad(myLoad, pdsk);
    DiskFree = Arg.dskFree;
    DiskUtil = pdsk;
+   Cluster.Refresh(this);
 
 // Do some debugging
 //
@@ -1670,6 +1705,7 @@ const char *XrdCmsNode::do_Status(XrdCmsRRData &Arg)
                         }
                     }
        else         {add2Activ =  0; srvMsg = 0;}
+    if (add2Activ || add2Stage) Cluster.Refresh(this);
 
 // Get the most important message out (advisory isOffline doen't need STMutex)
 //
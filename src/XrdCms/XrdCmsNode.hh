@@ -30,6 +30,7 @@
 /* specific prior written permission of the institution or contributor.       */
 /******************************************************************************/
 
+#include <stdio.h>
 #include <string.h>
 #include <unistd.h>
 #include <netinet/in.h>
@@ -93,6 +94,7 @@ unsigned int    ConfigID;     // Configuration identifier
 const  char  *do_Avail(XrdCmsRRData &Arg);
 const  char  *do_Chmod(XrdCmsRRData &Arg);
 const  char  *do_Disc(XrdCmsRRData &Arg);
+const  char  *do_Filter(XrdCmsRRData &Arg);
 const  char  *do_Gone(XrdCmsRRData &Arg);
 const  char  *do_Have(XrdCmsRRData &Arg);
 const  char  *do_Load(XrdCmsRRData &Arg);
@@ -131,6 +133,14 @@ const  char  *do_Usage(XrdCmsRRData &Arg);
 
 inline int    ID(int &INum) {INum = Instance; return NodeID;}
 
+// Identity() returns the slot independent identity of the node (host, port
+// and node id) which remains the same across logins.
+//
+inline int    Identity(char *buff, int blen)
+                      {return snprintf(buff, blen, "%s:%d %s",
+                                       Name(), netIF.Port(), myNID);
+                      }
+
 inline int    Inst() {return Instance;}
 
        bool   inDomain() {return netIF.InDomain(&netID);}
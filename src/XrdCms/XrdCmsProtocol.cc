@@ -50,6 +50,7 @@
 #include "XrdCms/XrdCmsCache.hh"
 #include "XrdCms/XrdCmsCluster.hh"
 #include "XrdCms/XrdCmsConfig.hh"
+#include "XrdCms/XrdCmsFilter.hh"
 #include "XrdCms/XrdCmsJob.hh"
 #include "XrdCms/XrdCmsLogin.hh"
 #include "XrdCms/XrdCmsManager.hh"
@@ -396,6 +397,7 @@ void XrdCmsProtocol::Pander(const char *manager, int mport)
                    Say.Emsg("Protocol", "Logged into", sname, Link->Name());
                    if (Data.SID)
                       Manager->Verify(Link, (const char *)Data.SID, sname);
+                   NSFilter.Publish(myNode);
                    Reason = Dispatch(isUp, TimeOut, 2);
                    rc = 0;
                    loginData.fSpace= Meter.FreeSpace(fsUtil);
@@ -474,6 +476,7 @@ int XrdCmsProtocol::Process(XrdLink *lp)
        myNode->UnLock();
        if ((Reason = Dispatch(myWay, tOut, 2))) lp->setEtext(Reason);
        Cluster.SLock(true); myNode->isOffline = 1; Cluster.SLock(false);
+       Cluster.Refresh(myNode);
       }
 
 // Serialize all activity on the link before we proceed. This makes sure that
@@ -690,6 +693,7 @@ XrdCmsRouting *XrdCmsProtocol::Admit()
    myNode->DiskFree  = Data.fSpace;
    myNode->DiskNums  = Data.fsNum;
    myNode->DiskUtil  = Data.fsUtil;
+   Cluster.Refresh(myNode);
    Meter.setVirtUpdt();
 
 // Check for any configuration changes and then process all of the paths.
@@ -728,6 +732,16 @@ XrdCmsRouting *XrdCmsProtocol::Admit()
    Cluster.ResetRef(servset);
    if (Config.asManager()) {Manager->Reset(); myNode->SyncSpace();}
    myNode->isBad &= ~XrdCmsNode::isDisabled;
+   Cluster.Refresh(myNode);
+
+// Restore any locations this node had before we restarted
+//
+   if (Config.asManager())
+      {char idBuff[256];
+       int inst;
+       myNode->Identity(idBuff, sizeof(idBuff));
+       Cache.Restore(idBuff, myNode->ID(inst), myNode->Mask());
+      }
 
 // At this point we can switch to nonblocking sendq for this node
 //
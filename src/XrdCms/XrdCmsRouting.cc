@@ -60,6 +60,7 @@ XrdCmsRouter::theRoute initRouter[] =
 /* Server */
        {kYR_avail,   "avail",  &XrdCmsNode::do_Avail},
        {kYR_disc,    "disc",   &XrdCmsNode::do_Disc},
+       {kYR_filter,  "filter", &XrdCmsNode::do_Filter},
        {kYR_gone,    "gone",   &XrdCmsNode::do_Gone},
        {kYR_have,    "have",   &XrdCmsNode::do_Have},
        {kYR_load,    "load",   &XrdCmsNode::do_Load},
@@ -154,6 +155,7 @@ namespace XrdCms
 XrdCmsRouting::theRouting initRSProuting[] =
      {{kYR_avail,   XrdCmsRouting::isSync},
       {kYR_disc,    XrdCmsRouting::isSync | XrdCmsRouting::noArgs},
+      {kYR_filter,  XrdCmsRouting::isSync},
       {kYR_gone,    XrdCmsRouting::isSync},
       {kYR_have,    XrdCmsRouting::AsyncQ0},
       {kYR_load,    XrdCmsRouting::isSync},
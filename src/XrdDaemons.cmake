@@ -35,6 +35,7 @@ add_executable(
   XrdCms/XrdCmsCluster.cc         XrdCms/XrdCmsCluster.hh
   XrdCms/XrdCmsClustID.cc         XrdCms/XrdCmsClustID.hh
   XrdCms/XrdCmsConfig.cc          XrdCms/XrdCmsConfig.hh
+  XrdCms/XrdCmsFilter.cc          XrdCms/XrdCmsFilter.hh
   XrdCms/XrdCmsJob.cc             XrdCms/XrdCmsJob.hh
   XrdCms/XrdCmsKey.cc             XrdCms/XrdCmsKey.hh
   XrdCms/XrdCmsManager.cc         XrdCms/XrdCmsManager.hh
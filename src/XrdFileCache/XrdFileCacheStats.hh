@@ -19,6 +19,7 @@
 // along with XRootD.  If not, see <http://www.gnu.org/licenses/>.
 //----------------------------------------------------------------------------------
 
+#include "Xrd/XrdStatsShm.hh"
 #include "XrdOuc/XrdOucCache.hh"
 #include "XrdSys/XrdSysPthread.hh"
 
@@ -50,6 +51,21 @@ public:
       m_BytesMissed += Src.m_BytesMissed;
 
       m_MutexXfc.UnLock();
+
+      PublishStats(Src);
+   }
+
+   //----------------------------------------------------------------------
+   //! Add the bytes of Src to the process-wide shared statistics.
+   //----------------------------------------------------------------------
+   static void PublishStats(const Stats &Src)
+   {
+      static const char *names[] = {"disk", "ram", "miss"};
+      static const int   shmId   = XrdStatsShm::Define("pfc", names, 3);
+
+      XrdStatsShm::Add(shmId,     Src.m_BytesDisk);
+      XrdStatsShm::Add(shmId + 1, Src.m_BytesRam);
+      XrdStatsShm::Add(shmId + 2, Src.m_BytesMissed);
    }
 
    Stats Clone()
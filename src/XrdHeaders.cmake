@@ -13,6 +13,7 @@ set( XROOTD_PUBLIC_HEADERS
   Xrd/XrdLinkMatch.hh
   Xrd/XrdProtocol.hh
   Xrd/XrdScheduler.hh
+  Xrd/XrdStatsShm.hh
   XrdNet/XrdNet.hh
   XrdNet/XrdNetAddr.hh
   XrdNet/XrdNetAddrInfo.hh
@@ -159,6 +160,7 @@ if( NOT XRDCL_ONLY )
     XrdSsi/XrdSsiResource.hh
     XrdSsi/XrdSsiService.hh
     XrdSsi/XrdSsiStream.hh
+    XrdSsi/XrdSsiStreamQ.hh
 
     XrdOss/XrdOssApi.hh
     XrdOss/XrdOssConfig.hh
@@ -27,6 +27,8 @@ if( BUILD_HTTP )
     XrdHttp/XrdHttpReq.cc         XrdHttp/XrdHttpReq.hh
                                   XrdHttp/XrdHttpSecXtractor.hh
     XrdHttp/XrdHttpExtHandler.cc  XrdHttp/XrdHttpExtHandler.hh
+    XrdHttp/XrdHttpSessionCache.cc XrdHttp/XrdHttpSessionCache.hh
+    XrdHttp/XrdHttpTicketKeys.cc  XrdHttp/XrdHttpTicketKeys.hh
                                   XrdHttp/XrdHttpStatic.hh
     XrdHttp/XrdHttpTrace.cc       XrdHttp/XrdHttpTrace.hh
     XrdHttp/XrdHttpUtils.cc       XrdHttp/XrdHttpUtils.hh )
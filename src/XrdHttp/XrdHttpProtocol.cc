@@ -41,6 +41,8 @@
 #include "XrdHttpUtils.hh"
 #include "XrdHttpSecXtractor.hh"
 #include "XrdHttpExtHandler.hh"
+#include "XrdHttpSessionCache.hh"
+#include "XrdHttpTicketKeys.hh"
 
 #include <openssl/err.h>
 #include <openssl/ssl.h>
@@ -93,6 +95,12 @@ XrdOucGMap *XrdHttpProtocol::servGMap = 0;  // Grid mapping service
 int XrdHttpProtocol::sslverifydepth = 9;
 SSL_CTX *XrdHttpProtocol::sslctx = 0;
 BIO *XrdHttpProtocol::sslbio_err = 0;
+XrdHttpSessionCache *XrdHttpProtocol::sesCache = 0;
+XrdHttpTicketKeys *XrdHttpProtocol::tktKeys = 0;
+bool XrdHttpProtocol::tlsreuse = false;
+int XrdHttpProtocol::tlsreuselife = 3600;
+int XrdHttpProtocol::tlsreusecache = 16384;
+char *XrdHttpProtocol::tlsreusekeyfile = 0;
 XrdCryptoFactory *XrdHttpProtocol::myCryptoFactory = 0;
 XrdHttpSecXtractor *XrdHttpProtocol::secxtractor = 0;
 struct XrdHttpProtocol::XrdHttpExtHandlerInfo XrdHttpProtocol::exthandler[MAX_XRDHTTPEXTHANDLERS];
@@ -283,6 +291,21 @@ int XrdHttpProtocol::GetVOMSData(XrdLink *lp) {
   TRACEI(DEBUG, " Extracting auth info.");
 
   X509 *peer_cert;
+  char sesKey[XrdHttpSessionCache::keyLen], lnkName[9] = "";
+  bool haveKey = false;
+
+  // A resumed session carries the certificate that was fully processed when
+  // the session was established, so we can reuse what we extracted back then
+  // and skip the (expensive) secxtractor altogether
+  if (sesCache && (haveKey = XrdHttpSessionCache::MakeKey(ssl, sesKey, sizeof(sesKey)))
+      && SSL_session_reused(ssl)) {
+    if (sesCache->Find(sesKey, SecEntity, lnkName, sizeof(lnkName))) {
+      TRACEI(DEBUG, " Reusing auth info of resumed session for '"
+             << (SecEntity.moninfo ? SecEntity.moninfo : "") << "'");
+      if (*lnkName) lp->setID(lnkName, 0);
+      return 0;
+    }
+  }
 
   // No external plugin, hence we fill our XrdSec with what we can do here
   peer_cert = SSL_get_peer_certificate(ssl);
@@ -327,6 +350,7 @@ int XrdHttpProtocol::GetVOMSData(XrdLink *lp) {
         SecEntity.name = strdup(bufname);
         TRACEI(DEBUG, " Setting link name: '" << bufname2+j << "'");
         lp->setID(bufname2+j, 0);
+        strcpy(lnkName, bufname2+j);
       }
     }
     
@@ -369,14 +393,17 @@ int XrdHttpProtocol::GetVOMSData(XrdLink *lp) {
   // This will fill the XrdSec thing with VOMS info, if VOMS is
   // installed. If we have no sec extractor then do nothing, just plain https
   // will work.
+  int r = 0;
   if (secxtractor) {
-    int r = secxtractor->GetSecData(lp, SecEntity, ssl);
+    r = secxtractor->GetSecData(lp, SecEntity, ssl);
     if (r)
       TRACEI(ALL, " Certificate data extraction failed: " << SecEntity.moninfo << " Failed. err: " << r);
-    return r;
   }
 
-  return 0;
+  // Remember what we found for the sessions that will be resumed later
+  if (!r && haveKey) sesCache->Add(sesKey, SecEntity, lnkName);
+
+  return r;
 }
 
 char *XrdHttpProtocol::GetClientIPStr() {
@@ -996,6 +1023,7 @@ int XrdHttpProtocol::Stats(char *buff, int blen, int do_sync) {
   //  //
   //  return SI->Stats(buff, blen, do_sync);
 
+  if (sesCache) return sesCache->Stats(buff, blen);
   return 0;
 }
 
@@ -1083,6 +1111,7 @@ int XrdHttpProtocol::Config(const char *ConfigFN, XrdOucEnv *myEnv) {
       else if TS_Xeq("staticpreload", xstaticpreload);
       else if TS_Xeq("listingdeny", xlistdeny);
       else if TS_Xeq("header2cgi", xheader2cgi);
+      else if TS_Xeq("tlsreuse", xtlsreuse);
       else {
         eDest.Say("Config warning: ignoring unknown directive '", var, "'.");
         Config.Echo();
@@ -1753,6 +1782,22 @@ int XrdHttpProtocol::InitSecurity() {
 
   if (secxtractor) secxtractor->Init(sslctx, XrdHttpTrace->What);
 
+  // Enable session resumption through both the session id cache and
+  // tickets, whose keys we manage so that they can be rotated and shared
+  if (tlsreuse) {
+    SSL_CTX_set_timeout(sslctx, tlsreuselife);
+    SSL_CTX_sess_set_cache_size(sslctx, tlsreusecache);
+    tktKeys = new XrdHttpTicketKeys(&eDest, tlsreuselife, tlsreusekeyfile);
+    if (!tktKeys->Init(sslctx, Sched)) {
+      TRACE(EMSG, " Error setting up the TLS session ticket keys.");
+      exit(1);
+    }
+    sesCache = new XrdHttpSessionCache(tlsreusecache, tlsreuselife);
+    TRACE(ALL, " TLS session reuse enabled, lifetime " << tlsreuselife
+          << "s" << (tlsreusekeyfile ? " keyfile " : "")
+          << (tlsreusekeyfile ? tlsreusekeyfile : ""));
+  }
+
   ERR_print_errors(sslbio_err);
   return 0;
 }
@@ -2559,6 +2604,81 @@ int XrdHttpProtocol::xheader2cgi(XrdOucStream & Config) {
 
 
 
+/******************************************************************************/
+/*                               x t l s r e u s e                            */
+/******************************************************************************/
+
+/* Function: xtlsreuse
+
+   Purpose:  To parse the directive: tlsreuse {off | on} [lifetime <sec>]
+                                              [cache <num>] [keyfile <path>]
+
+             off        do not manage session resumption (the default)
+             on         resume TLS sessions through session ids and tickets,
+                        and reuse the security information that was extracted
+                        when the session was established
+             <sec>      the lifetime of sessions and the rotation interval of
+                        the ticket keys. The default is 3600.
+             <num>      the max number of sessions and identities to cache.
+                        The default is 16384.
+             <path>     the file holding the ticket keys. Servers sharing the
+                        file accept each other's tickets. The file is created
+                        if it does not exist.
+
+  Output: 0 upon success or !0 upon failure.
+ */
+
+int XrdHttpProtocol::xtlsreuse(XrdOucStream & Config) {
+  char *val;
+  int num;
+
+  // Get the on/off switch
+  //
+  val = Config.GetWord();
+  if (!val || !val[0]) {
+    eDest.Emsg("Config", "tlsreuse argument not specified");
+    return 1;
+  }
+  if (!strcmp(val, "off")) {
+    tlsreuse = false;
+    return 0;
+  }
+  if (strcmp(val, "on")) {
+    eDest.Emsg("Config", "invalid tlsreuse argument -", val);
+    return 1;
+  }
+  tlsreuse = true;
+
+  // Process the options
+  //
+  while ((val = Config.GetWord())) {
+    if (!strcmp(val, "lifetime") || !strcmp(val, "cache")) {
+      bool islife = (*val == 'l');
+      if (!(val = Config.GetWord()) || (num = atoi(val)) <= 0) {
+        eDest.Emsg("Config", "invalid tlsreuse", (islife ? "lifetime" : "cache"),
+                   "value");
+        return 1;
+      }
+      if (islife) tlsreuselife = num;
+        else tlsreusecache = num;
+    } else if (!strcmp(val, "keyfile")) {
+      if (!(val = Config.GetWord()) || *val != '/') {
+        eDest.Emsg("Config", "tlsreuse keyfile must be an absolute path");
+        return 1;
+      }
+      if (tlsreusekeyfile) free(tlsreusekeyfile);
+      tlsreusekeyfile = strdup(val);
+    } else {
+      eDest.Emsg("Config", "invalid tlsreuse option -", val);
+      return 1;
+    }
+  }
+
+  return 0;
+}
+
+
+
 
 
 
@@ -72,6 +72,8 @@ class XrdHttpSecXtractor;
 class XrdHttpExtHandler;
 struct XrdVersionInfo;
 class XrdOucGMap;
+class XrdHttpSessionCache;
+class XrdHttpTicketKeys;
 
 class XrdHttpProtocol : public XrdProtocol {
   
@@ -181,6 +183,7 @@ private:
   static int xsslverifydepth(XrdOucStream &Config);
   static int xsecretkey(XrdOucStream &Config);
   static int xheader2cgi(XrdOucStream &Config);
+  static int xtlsreuse(XrdOucStream &Config);
   
   static XrdHttpSecXtractor *secxtractor;
   
@@ -264,6 +267,12 @@ private:
   /// bio to print SSL errors
   static BIO *sslbio_err;
 
+  /// Security info of resumed TLS sessions, null if tls reuse is disabled
+  static XrdHttpSessionCache *sesCache;
+
+  /// The provider of the session ticket keys, null if tls reuse is disabled
+  static XrdHttpTicketKeys *tktKeys;
+
   /// Tells if the client is https
   bool ishttps;
 
@@ -348,6 +357,13 @@ protected:
   /// Depth of verification of a certificate chain
   static int sslverifydepth;
 
+  /// TLS session reuse: enabled, lifetime of sessions/tickets, max number
+  /// of cached identities and the optional file to share ticket keys
+  static bool tlsreuse;
+  static int tlsreuselife;
+  static int tlsreusecache;
+  static char *tlsreusekeyfile;
+
   /// True if the redirections must be towards https targets
   static bool isdesthttps;
   
@@ -0,0 +1,177 @@
+//------------------------------------------------------------------------------
+// This file is part of XrdHTTP: A pragmatic implementation of the
+// HTTP/WebDAV protocol for the Xrootd framework
+//
+// Copyright (c) 2013 by European Organization for Nuclear Research (CERN)
+// File Date: Oct 2026
+//------------------------------------------------------------------------------
+// XRootD is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// XRootD is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with XRootD.  If not, see <http://www.gnu.org/licenses/>.
+//------------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <openssl/evp.h>
+#include <openssl/x509.h>
+
+#include "XrdSec/XrdSecEntity.hh"
+#include "XrdHttpSessionCache.hh"
+
+/******************************************************************************/
+/*                           L o c a l   M a c r o s                          */
+/******************************************************************************/
+
+#define DUPIT(x) (x ? strdup(x) : 0)
+#define FREEIT(x) if (x) free(x)
+
+/******************************************************************************/
+/*                           C o n s t r u c t o r                            */
+/******************************************************************************/
+
+XrdHttpSessionCache::XrdHttpSessionCache(int maxEnt, int lifeTime)
+                    : maxEntries(maxEnt), entLife(lifeTime),
+                      numHits(0), numMiss(0), numFull(0)
+{
+}
+
+/******************************************************************************/
+/*                                 E n t r y                                  */
+/******************************************************************************/
+
+XrdHttpSessionCache::Entry::Entry(const XrdSecEntity &ent, const char *ln,
+                                  time_t tExp)
+{
+  name         = DUPIT(ent.name);
+  vorg         = DUPIT(ent.vorg);
+  role         = DUPIT(ent.role);
+  grps         = DUPIT(ent.grps);
+  endorsements = DUPIT(ent.endorsements);
+  moninfo      = DUPIT(ent.moninfo);
+  lname        = DUPIT(ln);
+  expires      = tExp;
+}
+
+XrdHttpSessionCache::Entry::~Entry()
+{
+  FREEIT(name);
+  FREEIT(vorg);
+  FREEIT(role);
+  FREEIT(grps);
+  FREEIT(endorsements);
+  FREEIT(moninfo);
+  FREEIT(lname);
+}
+
+/******************************************************************************/
+/*                                   A d d                                    */
+/******************************************************************************/
+
+void XrdHttpSessionCache::Add(const char *key, const XrdSecEntity &ent,
+                              const char *lname)
+{
+  time_t now = time(0);
+  XrdSysMutexHelper mHelp(cacheMutex);
+
+  // If the table is full, get rid of whatever has expired. If that did not
+  // free anything we simply do not cache this identity; it will be extracted
+  // again the next time it shows up.
+  //
+  if (cacheTab.Num() >= maxEntries)
+    {cacheTab.Apply(Expired, (void *)&now);
+     if (cacheTab.Num() >= maxEntries) {numFull++; return;}
+    }
+
+  cacheTab.Rep(key, new Entry(ent, lname, now+entLife), entLife);
+}
+
+/******************************************************************************/
+/*                               E x p i r e d                                */
+/******************************************************************************/
+
+int XrdHttpSessionCache::Expired(const char *key, Entry *ent, void *arg)
+{
+  return (ent->expires < *(time_t *)arg ? -1 : 0);
+}
+
+/******************************************************************************/
+/*                                  F i n d                                   */
+/******************************************************************************/
+
+bool XrdHttpSessionCache::Find(const char *key, XrdSecEntity &ent,
+                               char *lname, int lnlen)
+{
+  XrdSysMutexHelper mHelp(cacheMutex);
+  Entry *eP;
+
+  if (!(eP = cacheTab.Find(key))) {numMiss++; return false;}
+  numHits++;
+
+  FREEIT(ent.name);         ent.name         = DUPIT(eP->name);
+  FREEIT(ent.vorg);         ent.vorg         = DUPIT(eP->vorg);
+  FREEIT(ent.role);         ent.role         = DUPIT(eP->role);
+  FREEIT(ent.grps);         ent.grps         = DUPIT(eP->grps);
+  FREEIT(ent.endorsements); ent.endorsements = DUPIT(eP->endorsements);
+  FREEIT(ent.moninfo);      ent.moninfo      = DUPIT(eP->moninfo);
+
+  if (eP->lname) snprintf(lname, lnlen, "%s", eP->lname);
+     else *lname = 0;
+  return true;
+}
+
+/******************************************************************************/
+/*                               M a k e K e y                                */
+/******************************************************************************/
+
+bool XrdHttpSessionCache::MakeKey(SSL *ssl, char *key, int klen)
+{
+  static const char hv[] = "0123456789abcdef";
+  unsigned char md[EVP_MAX_MD_SIZE];
+  unsigned int  mdlen = 0, i;
+  X509 *peer_cert;
+
+  if (!(peer_cert = SSL_get_peer_certificate(ssl))) return false;
+
+  if (!X509_digest(peer_cert, EVP_sha256(), md, &mdlen)
+  ||  (int)(mdlen*2) >= klen)
+     {X509_free(peer_cert);
+      return false;
+     }
+  X509_free(peer_cert);
+
+  for (i = 0; i < mdlen; i++)
+      {*key++ = hv[md[i] >> 4];
+       *key++ = hv[md[i] & 0x0f];
+      }
+  *key = 0;
+  return true;
+}
+
+/******************************************************************************/
+/*                                 S t a t s                                  */
+/******************************************************************************/
+
+int XrdHttpSessionCache::Stats(char *buff, int blen)
+{
+  static const char statfmt[] = "<sescache><num>%d</num><hit>%lld</hit>"
+                                "<miss>%lld</miss><full>%lld</full></sescache>";
+  int n;
+
+  if (!buff) return sizeof(statfmt) + 16*4;
+
+  cacheMutex.Lock();
+  n = snprintf(buff, blen, statfmt, cacheTab.Num(), numHits, numMiss, numFull);
+  cacheMutex.UnLock();
+  return (n < blen ? n : blen-1);
+}
@@ -0,0 +1,90 @@
+//------------------------------------------------------------------------------
+// This file is part of XrdHTTP: A pragmatic implementation of the
+// HTTP/WebDAV protocol for the Xrootd framework
+//
+// Copyright (c) 2013 by European Organization for Nuclear Research (CERN)
+// File Date: Oct 2026
+//------------------------------------------------------------------------------
+// XRootD is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// XRootD is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with XRootD.  If not, see <http://www.gnu.org/licenses/>.
+//------------------------------------------------------------------------------
+
+/** @file  XrdHttpSessionCache.hh
+ * @brief  Cache of the security information extracted at TLS handshake time
+ *
+ * When a client resumes a TLS session (either through the server side session
+ * id cache or through a session ticket) the certificate it authenticated with
+ * is the one recorded in the session. The identity that was extracted from it
+ * (DN mapping and, above all, the VOMS attributes obtained by the secxtractor
+ * plugin) is therefore the same, and can be reused instead of running the
+ * extraction again. Entries are keyed by the digest of the peer certificate
+ * and only consulted for resumed sessions.
+ */
+
+#ifndef __XRDHTTPSESSIONCACHE_HH__
+#define __XRDHTTPSESSIONCACHE_HH__
+
+#include <time.h>
+#include <openssl/ssl.h>
+
+#include "XrdOuc/XrdOucHash.hh"
+#include "XrdSys/XrdSysPthread.hh"
+
+class XrdSecEntity;
+
+class XrdHttpSessionCache
+{
+public:
+
+  /// Length of the key computed by MakeKey(), including the null byte
+  static const int keyLen = 2*EVP_MAX_MD_SIZE+1;
+
+  /// Compute the cache key for the peer of the given (handshaked) ssl object.
+  /// Returns false if the peer presented no certificate.
+  static bool MakeKey(SSL *ssl, char *key, int klen);
+
+  /// Look up the key and, if found, fill in the entity and the link name.
+  /// The entity members are replaced by strdup'ed copies of the cached ones.
+  bool Find(const char *key, XrdSecEntity &ent, char *lname, int lnlen);
+
+  /// Record the security information of a freshly extracted entity
+  void Add(const char *key, const XrdSecEntity &ent, const char *lname);
+
+  /// Print the hit/miss counters into buff, returns the number of bytes used
+  int Stats(char *buff, int blen);
+
+  /// The cache keeps at most maxEnt entries, each one for lifeTime seconds
+  XrdHttpSessionCache(int maxEnt, int lifeTime);
+  ~XrdHttpSessionCache() {}
+
+private:
+
+  struct Entry {
+    char  *name, *vorg, *role, *grps, *endorsements, *moninfo, *lname;
+    time_t expires;
+
+    Entry(const XrdSecEntity &ent, const char *ln, time_t tExp);
+    ~Entry();
+  };
+
+  static int Expired(const char *key, Entry *ent, void *arg);
+
+  XrdSysMutex         cacheMutex;
+  XrdOucHash<Entry>   cacheTab;
+  int                 maxEntries;
+  int                 entLife;
+  long long           numHits;
+  long long           numMiss;
+  long long           numFull;
+};
+#endif
@@ -0,0 +1,302 @@
+//------------------------------------------------------------------------------
+// This file is part of XrdHTTP: A pragmatic implementation of the
+// HTTP/WebDAV protocol for the Xrootd framework
+//
+// Copyright (c) 2013 by European Organization for Nuclear Research (CERN)
+// File Date: Oct 2026
+//------------------------------------------------------------------------------
+// XRootD is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// XRootD is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with XRootD.  If not, see <http://www.gnu.org/licenses/>.
+//------------------------------------------------------------------------------
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+
+#include <openssl/evp.h>
+#include <openssl/rand.h>
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+#include <openssl/core_names.h>
+#include <openssl/params.h>
+#endif
+
+#include "Xrd/XrdScheduler.hh"
+#include "XrdSys/XrdSysError.hh"
+#include "XrdHttpTicketKeys.hh"
+
+/******************************************************************************/
+/*                        S t a t i c   O b j e c t s                         */
+/******************************************************************************/
+
+XrdHttpTicketKeys *XrdHttpTicketKeys::Instance = 0;
+
+/******************************************************************************/
+/*                           C o n s t r u c t o r                            */
+/******************************************************************************/
+
+XrdHttpTicketKeys::XrdHttpTicketKeys(XrdSysError *erp, int lifeTime,
+                                     const char *keyFile)
+                  : XrdJob("ticket key refresh"), eDest(erp), Sched(0),
+                    kFile(keyFile ? strdup(keyFile) : 0), keyLife(lifeTime)
+{
+  memset(&keys, 0, sizeof(keys));
+}
+
+/******************************************************************************/
+/*                            D e s t r u c t o r                             */
+/******************************************************************************/
+
+XrdHttpTicketKeys::~XrdHttpTicketKeys()
+{
+  if (Instance == this) Instance = 0;
+  if (kFile) free(kFile);
+  memset(&keys, 0, sizeof(keys));
+}
+
+/******************************************************************************/
+/*                                  D o I t                                   */
+/******************************************************************************/
+
+void XrdHttpTicketKeys::DoIt()
+{
+  Sched->Schedule((XrdJob *)this, Refresh(time(0)));
+}
+
+/******************************************************************************/
+/*                                G e t K e y                                 */
+/******************************************************************************/
+
+bool XrdHttpTicketKeys::GetKey(const unsigned char *kname, TicketKey &key,
+                               bool &cur)
+{
+  for (int i = 0; i < keys.cnt; i++)
+      {if (!memcmp(kname, keys.tab[i].name, sizeof(keys.tab[i].name)))
+          {key = keys.tab[i];
+           cur = (i == 0);
+           return true;
+          }
+      }
+  return false;
+}
+
+/******************************************************************************/
+/*                                  I n i t                                   */
+/******************************************************************************/
+
+bool XrdHttpTicketKeys::Init(SSL_CTX *ctx, XrdScheduler *sched)
+{
+  time_t next;
+
+// Get the initial key now so that configuration errors show up at startup
+//
+   Sched = sched;
+   next = Refresh(time(0));
+   if (!keys.cnt) return false;
+
+// Install ourselves as the ticket key provider. There can only be one.
+//
+   Instance = this;
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+   SSL_CTX_set_tlsext_ticket_key_evp_cb(ctx, TicketCB);
+#else
+   SSL_CTX_set_tlsext_ticket_key_cb(ctx, TicketCB);
+#endif
+   SSL_CTX_clear_options(ctx, SSL_OP_NO_TICKET);
+
+// Keep the keys fresh from now on
+//
+   Sched->Schedule((XrdJob *)this, next);
+   return true;
+}
+
+/******************************************************************************/
+/*                                N e w K e y                                 */
+/******************************************************************************/
+
+bool XrdHttpTicketKeys::NewKey(TicketKey &key)
+{
+  if (RAND_bytes((unsigned char *)&key, sizeof(key)) != 1)
+     {eDest->Emsg("TicketKeys", "Unable to generate a random ticket key.");
+      return false;
+     }
+  return true;
+}
+
+/******************************************************************************/
+/*                              R e a d K e y s                               */
+/******************************************************************************/
+
+bool XrdHttpTicketKeys::ReadKeys(int fd, KeySet &ks)
+{
+  TicketKey newTab[keyNum];
+  ssize_t rlen;
+
+  do {rlen = pread(fd, newTab, sizeof(newTab), 0);}
+     while(rlen < 0 && errno == EINTR);
+
+  if (rlen < (ssize_t)sizeof(TicketKey))
+     {eDest->Emsg("TicketKeys", "Ticket key file", kFile, "is truncated.");
+      return false;
+     }
+
+  ks.cnt = rlen / sizeof(TicketKey);
+  memcpy(ks.tab, newTab, ks.cnt*sizeof(TicketKey));
+  memset(newTab, 0, sizeof(newTab));
+  return true;
+}
+
+/******************************************************************************/
+/*                               R e f r e s h                                */
+/******************************************************************************/
+
+// Returns when the keys should be looked at again. The keys are worked on in a
+// copy so that handshakes are not held up while we wait for the key file. Only
+// one thread (Init() or the scheduled job) calls this at any one time.
+//
+time_t XrdHttpTicketKeys::Refresh(time_t now)
+{
+  KeySet ks;
+  struct stat Stat;
+  time_t next;
+  bool update = false;
+  int fd, rc;
+
+   keyMutex.Lock(); ks = keys; keyMutex.UnLock();
+
+// Without a key file we simply rotate in memory
+//
+   if (!kFile)
+      {if (!ks.cnt || ks.made + keyLife <= now) update = Rotate(ks, now);
+       next = ks.made + keyLife;
+      }
+
+// With a key file we look at it every so often. The first process that finds
+// the keys stale rotates them for everybody.
+//
+   else
+      {next = now + (keyLife < 240 ? keyLife/4+1 : 60);
+       if ((fd = open(kFile, O_RDWR|O_CREAT, S_IRUSR|S_IWUSR)) < 0)
+          {eDest->Emsg("TicketKeys", errno, "open ticket key file", kFile);
+           return next;
+          }
+
+       do {rc = flock(fd, LOCK_EX);} while(rc < 0 && errno == EINTR);
+       if (rc || fstat(fd, &Stat))
+          {eDest->Emsg("TicketKeys", errno, "lock ticket key file", kFile);
+           close(fd);
+           return next;
+          }
+
+       if (Stat.st_size < (off_t)sizeof(TicketKey)
+       ||  Stat.st_mtime + keyLife <= now)
+          {if (Stat.st_size >= (off_t)sizeof(TicketKey)) ReadKeys(fd, ks);
+           if ((update = Rotate(ks, now)))
+              {if (pwrite(fd, ks.tab, ks.cnt*sizeof(TicketKey), 0) < 0
+               ||  ftruncate(fd, ks.cnt*sizeof(TicketKey)) || fsync(fd))
+                  eDest->Emsg("TicketKeys",errno,"write ticket key file",kFile);
+              }
+          } else if ((update = ReadKeys(fd, ks))) ks.made = Stat.st_mtime;
+
+       close(fd);  // This also releases the lock
+      }
+
+// Install the new keys
+//
+   if (update) {keyMutex.Lock(); keys = ks; keyMutex.UnLock();}
+   memset(&ks, 0, sizeof(ks));
+   return (next > now ? next : now + 60);
+}
+
+/******************************************************************************/
+/*                                R o t a t e                                 */
+/******************************************************************************/
+
+bool XrdHttpTicketKeys::Rotate(KeySet &ks, time_t now)
+{
+  TicketKey newKey;
+
+  if (!NewKey(newKey)) return false;
+
+  memmove(&ks.tab[1], &ks.tab[0], (keyNum-1)*sizeof(TicketKey));
+  ks.tab[0] = newKey;
+  if (ks.cnt < keyNum) ks.cnt++;
+  ks.made = now;
+  memset(&newKey, 0, sizeof(newKey));
+  return true;
+}
+
+/******************************************************************************/
+/*                              T i c k e t C B                               */
+/******************************************************************************/
+
+// Returns (see SSL_CTX_set_tlsext_ticket_key_cb(3)):
+//   -1 on error, 0 if the ticket cannot be decrypted (full handshake),
+//    1 on success and 2 if the ticket should be renewed with the current key.
+//
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+int XrdHttpTicketKeys::TicketCB(SSL *ssl, unsigned char *kname,
+                                unsigned char *iv, EVP_CIPHER_CTX *ectx,
+                                EVP_MAC_CTX *hctx, int enc)
+#else
+int XrdHttpTicketKeys::TicketCB(SSL *ssl, unsigned char *kname,
+                                unsigned char *iv, EVP_CIPHER_CTX *ectx,
+                                HMAC_CTX *hctx, int enc)
+#endif
+{
+  XrdHttpTicketKeys *tkP = Instance;
+  TicketKey key;
+  bool isCur = true;
+  int rc;
+
+  if (!tkP) return -1;
+
+// Get the key to use
+//
+   tkP->keyMutex.Lock();
+   if (enc)
+      {if (!tkP->keys.cnt) {tkP->keyMutex.UnLock(); return -1;}
+       key = tkP->keys.tab[0];
+      } else if (!tkP->GetKey(kname, key, isCur))
+                {tkP->keyMutex.UnLock(); return 0;}
+   tkP->keyMutex.UnLock();
+
+// Setup the cipher and the mac
+//
+   if (enc)
+      {memcpy(kname, key.name, sizeof(key.name));
+       if (RAND_bytes(iv, EVP_MAX_IV_LENGTH) != 1) return -1;
+       rc = EVP_EncryptInit_ex(ectx, EVP_aes_256_cbc(), 0, key.aesKey, iv);
+      } else
+       rc = EVP_DecryptInit_ex(ectx, EVP_aes_256_cbc(), 0, key.aesKey, iv);
+   if (rc != 1) return -1;
+
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+   OSSL_PARAM params[3];
+   params[0] = OSSL_PARAM_construct_octet_string(OSSL_MAC_PARAM_KEY,
+                                       key.hmacKey, sizeof(key.hmacKey));
+   params[1] = OSSL_PARAM_construct_utf8_string(OSSL_MAC_PARAM_DIGEST,
+                                       (char *)"SHA256", 0);
+   params[2] = OSSL_PARAM_construct_end();
+   rc = EVP_MAC_CTX_set_params(hctx, params);
+#else
+   rc = HMAC_Init_ex(hctx, key.hmacKey, sizeof(key.hmacKey), EVP_sha256(), 0);
+#endif
+   memset(&key, 0, sizeof(key));
+   if (rc != 1) return -1;
+
+   return (isCur ? 1 : 2);
+}
@@ -0,0 +1,99 @@
+//------------------------------------------------------------------------------
+// This file is part of XrdHTTP: A pragmatic implementation of the
+// HTTP/WebDAV protocol for the Xrootd framework
+//
+// Copyright (c) 2013 by European Organization for Nuclear Research (CERN)
+// File Date: Oct 2026
+//------------------------------------------------------------------------------
+// XRootD is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// XRootD is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with XRootD.  If not, see <http://www.gnu.org/licenses/>.
+//------------------------------------------------------------------------------
+
+/** @file  XrdHttpTicketKeys.hh
+ * @brief  Management of the keys protecting TLS session tickets
+ *
+ * Tickets are encrypted with the current key and accepted if they were
+ * encrypted with the current or the previous one. Keys are rotated every
+ * ticket lifetime. When a key file is configured the keys are read from it
+ * (and rotated into it under an exclusive lock), so that all the processes
+ * sharing the file accept each other's tickets. The file is looked at and the
+ * keys rotated by a scheduler job; the handshake callback only copies keys.
+ */
+
+#ifndef __XRDHTTPTICKETKEYS_HH__
+#define __XRDHTTPTICKETKEYS_HH__
+
+#include <time.h>
+#include <openssl/hmac.h>
+#include <openssl/ssl.h>
+
+#include "Xrd/XrdJob.hh"
+#include "XrdSys/XrdSysPthread.hh"
+
+class XrdScheduler;
+class XrdSysError;
+
+class XrdHttpTicketKeys : public XrdJob
+{
+public:
+
+  /// Refresh or rotate the keys and reschedule ourselves.
+  void DoIt();
+
+  /// Install the ticket callback in the context and start refreshing the
+  /// keys using the scheduler. Returns false on failure.
+  bool Init(SSL_CTX *ctx, XrdScheduler *sched);
+
+  XrdHttpTicketKeys(XrdSysError *erp, int lifeTime, const char *keyFile = 0);
+  ~XrdHttpTicketKeys();
+
+private:
+
+  struct TicketKey {
+    unsigned char name[16];
+    unsigned char aesKey[32];
+    unsigned char hmacKey[32];
+  };
+
+  static const int keyNum = 2;       // Current key and previous key
+
+  struct KeySet {
+    TicketKey tab[keyNum];
+    int       cnt;
+    time_t    made;                    // When tab[0] was created
+  };
+
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+  static int   TicketCB(SSL *ssl, unsigned char *kname, unsigned char *iv,
+                        EVP_CIPHER_CTX *ectx, EVP_MAC_CTX *hctx, int enc);
+#else
+  static int   TicketCB(SSL *ssl, unsigned char *kname, unsigned char *iv,
+                        EVP_CIPHER_CTX *ectx, HMAC_CTX *hctx, int enc);
+#endif
+
+  bool         GetKey(const unsigned char *kname, TicketKey &key, bool &cur);
+  bool         NewKey(TicketKey &key);
+  bool         ReadKeys(int fd, KeySet &ks);
+  time_t       Refresh(time_t now);
+  bool         Rotate(KeySet &ks, time_t now);
+
+  static XrdHttpTicketKeys *Instance;
+
+  XrdSysMutex   keyMutex;    // Protects keys, which the callback copies
+  XrdSysError  *eDest;
+  XrdScheduler *Sched;
+  char         *kFile;
+  KeySet        keys;
+  int           keyLife;
+};
+#endif
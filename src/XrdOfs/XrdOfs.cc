@@ -623,6 +623,8 @@ int XrdOfsFile::open(const char          *path,      // In
        isRW ? OfsStats.Data.numOpenW++ : OfsStats.Data.numOpenR++;
        if (oP.poscNum > 0) OfsStats.Data.numOpenP++;
        OfsStats.sdMutex.UnLock();
+       OfsStats.Pub(isRW ? OfsStats.Data.numOpenW : OfsStats.Data.numOpenR);
+       if (oP.poscNum > 0) OfsStats.Pub(OfsStats.Data.numOpenP);
        return oP.OK();
       }
 
@@ -641,6 +643,10 @@ int XrdOfsFile::open(const char          *path,      // In
            error.getUCap() & XrdOucEI::uLclF)) open_flag |= O_DIRECT;
       }
 
+// Tell the storage system if the file will be read sequentially
+//
+   if (open_mode & SFS_O_SEQIO) Open_Env.Put("oss.seqio", "1");
+
 // Open the file
 //
    if ((retc = oP.fP->Open(path, open_flag, Mode, Open_Env)))
@@ -692,6 +698,8 @@ int XrdOfsFile::open(const char          *path,      // In
    isRW ? OfsStats.Data.numOpenW++ : OfsStats.Data.numOpenR++;
    if (oP.poscNum > 0) OfsStats.Data.numOpenP++;
    OfsStats.sdMutex.UnLock();
+   OfsStats.Pub(isRW ? OfsStats.Data.numOpenW : OfsStats.Data.numOpenR);
+   if (oP.poscNum > 0) OfsStats.Pub(OfsStats.Data.numOpenP);
 
 // All done
 //
@@ -751,6 +759,11 @@ int XrdOfsFile::close()  // In
             if (hP->isRW == XrdOfsHandle::opPC) OfsStats.Data.numOpenP--;
            }
    OfsStats.sdMutex.UnLock();
+   if (!(hP->isRW)) OfsStats.Pub(OfsStats.Data.numOpenR, -1);
+      else {OfsStats.Pub(OfsStats.Data.numOpenW, -1);
+            if (hP->isRW == XrdOfsHandle::opPC)
+               OfsStats.Pub(OfsStats.Data.numOpenP, -1);
+           }
 
 // If this file was tagged as a POSC then we need to make sure it will persist
 // Note that we unpersist the file immediately when it's inactive or if no hold
@@ -2252,7 +2265,7 @@ int XrdOfs::Forward(int &Result, XrdOucErrInfo &Resp, struct fwdOpt &Fwd,
 
    Resp.setErrInfo(Fwd.Port, Fwd.Host);
    Result = SFS_REDIRECT;
-   OfsStats.Data.numRedirect++;
+   OfsStats.Bump(OfsStats.Data.numRedirect);
    return 1;
 }
 
@@ -2265,11 +2278,16 @@ int XrdOfs::fsError(XrdOucErrInfo &myError, int rc)
 
 // Screen the error code (update statistics w/o a lock for speed!)
 //
-   if (rc == SFS_REDIRECT) {OfsStats.Data.numRedirect++; return SFS_REDIRECT;}
-   if (rc == SFS_STARTED)  {OfsStats.Data.numStarted++;  return SFS_STARTED; }
-   if (rc > 0)             {OfsStats.Data.numDelays++;   return rc;          }
-   if (rc == SFS_DATA)     {OfsStats.Data.numReplies++;  return SFS_DATA;    }
-                           {OfsStats.Data.numErrors++;   return SFS_ERROR;   }
+   if (rc == SFS_REDIRECT)
+      {OfsStats.Bump(OfsStats.Data.numRedirect); return SFS_REDIRECT;}
+   if (rc == SFS_STARTED)
+      {OfsStats.Bump(OfsStats.Data.numStarted);  return SFS_STARTED; }
+   if (rc > 0)
+      {OfsStats.Bump(OfsStats.Data.numDelays);   return rc;          }
+   if (rc == SFS_DATA)
+      {OfsStats.Bump(OfsStats.Data.numReplies);  return SFS_DATA;    }
+   OfsStats.Bump(OfsStats.Data.numErrors);
+   return SFS_ERROR;
 }
 
 /******************************************************************************/
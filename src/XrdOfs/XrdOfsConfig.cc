@@ -332,6 +332,7 @@ int XrdOfs::Configure(XrdSysError &Eroute, XrdOucEnv *EnvInfo) {
 // Setup statistical monitoring
 //
    OfsStats.setRole(myRole);
+   OfsStats.Share();
 
 // Display final configuration
 //
@@ -71,3 +71,33 @@ int XrdOfsStats::Report(char *buff, int blen)
                     myData.numTPCgrant, myData.numTPCdeny,
                     myData.numTPCerrs,  myData.numTPCexpr);
 }
+
+/******************************************************************************/
+/*                                 S h a r e                                  */
+/******************************************************************************/
+
+void XrdOfsStats::Share()
+{
+   static const struct {const char *name; XrdStatsShm::CtrType type;}
+          shmTab[] = {{"ofs.opr",      XrdStatsShm::isGauge},
+                      {"ofs.opw",      XrdStatsShm::isGauge},
+                      {"ofs.opp",      XrdStatsShm::isGauge},
+                      {"ofs.ups",      XrdStatsShm::isCounter},
+                      {"ofs.han",      XrdStatsShm::isGauge},
+                      {"ofs.rdr",      XrdStatsShm::isCounter},
+                      {"ofs.bxq",      XrdStatsShm::isCounter},
+                      {"ofs.rep",      XrdStatsShm::isCounter},
+                      {"ofs.err",      XrdStatsShm::isCounter},
+                      {"ofs.dly",      XrdStatsShm::isCounter},
+                      {"ofs.sok",      XrdStatsShm::isCounter},
+                      {"ofs.ser",      XrdStatsShm::isCounter},
+                      {"ofs.tpc.grnt", XrdStatsShm::isCounter},
+                      {"ofs.tpc.deny", XrdStatsShm::isCounter},
+                      {"ofs.tpc.err",  XrdStatsShm::isCounter},
+                      {"ofs.tpc.exp",  XrdStatsShm::isCounter}};
+   static_assert(sizeof(shmTab)/sizeof(shmTab[0]) == sizeof(shmId)/sizeof(int),
+                 "ofs shared statistics table does not match StatsData");
+
+   for (int i = 0; i < (int)(sizeof(shmId)/sizeof(int)); i++)
+       shmId[i] = XrdStatsShm::Define(shmTab[i].name, shmTab[i].type);
+}
@@ -30,7 +30,9 @@
 /******************************************************************************/
 
 #include <stdlib.h>
+#include <string.h>
 
+#include "Xrd/XrdStatsShm.hh"
 #include "XrdSys/XrdSysPthread.hh"
 
 class XrdOfsStats
@@ -59,19 +61,39 @@ int         numTPCexpr;
 
 XrdSysMutex sdMutex;
 
-inline void Add(int &Cntr) {sdMutex.Lock(); Cntr++; sdMutex.UnLock();}
+inline void Add(int &Cntr) {sdMutex.Lock(); Cntr++; sdMutex.UnLock();
+                            Pub(Cntr);
+                           }
 
-inline void Dec(int &Cntr) {sdMutex.Lock(); Cntr--; sdMutex.UnLock();}
+// Bump() adds one to a counter without a lock, as fsError() does for speed.
+//
+inline void Bump(int &Cntr) {Cntr++; Pub(Cntr);}
+
+inline void Dec(int &Cntr) {sdMutex.Lock(); Cntr--; sdMutex.UnLock();
+                            Pub(Cntr, -1);
+                           }
+
+// Pub() reflects a change to a Data counter in the shared statistics.
+//
+inline void Pub(int &Cntr, int n=1)
+               {XrdStatsShm::Add(shmId[&Cntr - &Data.numOpenR], n);}
 
        int  Report(char *Buff, int Blen);
 
        void setRole(const char *theRole) {myRole = theRole;}
 
-            XrdOfsStats() : myRole("?") {memset(&Data, 0, sizeof(Data));}
+// Share() defines the shared statistics counters mirroring Data.
+//
+       void Share();
+
+            XrdOfsStats() : myRole("?") {memset(&Data, 0, sizeof(Data));
+                                         memset(shmId, -1, sizeof(shmId));
+                                        }
            ~XrdOfsStats() {}
 
 private:
 
 const char *myRole;
+int         shmId[sizeof(StatsData)/sizeof(int)];
 };
 #endif
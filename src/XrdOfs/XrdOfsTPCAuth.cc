@@ -290,6 +290,7 @@ do{authMutex.Lock();
       {OfsStats.sdMutex.Lock();
        OfsStats.Data.numTPCexpr += numExp;
        OfsStats.sdMutex.UnLock();
+       OfsStats.Pub(OfsStats.Data.numTPCexpr, numExp);
       }
 
 // Wait as long as possible for a recan
@@ -35,8 +35,10 @@
 #include <errno.h>
 #include <fcntl.h>
 #include <signal.h>
+#include <string.h>
 #include <strings.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <sys/file.h>
 #include <sys/stat.h>
 #include <sys/types.h>
@@ -44,9 +46,14 @@
 #ifdef __solaris__
 #include <sys/vnode.h>
 #endif
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
 
 #include "XrdVersion.hh"
 
+#include "Xrd/XrdStatsShm.hh"
+
 #include "XrdFrc/XrdFrcXAttr.hh"
 #include "XrdOss/XrdOssApi.hh"
 #include "XrdOss/XrdOssCache.hh"
@@ -70,6 +77,38 @@
 #include "oocx_CXFile.h"
 #endif
 
+/******************************************************************************/
+/*                      L o c a l   S t r u c t u r e s                       */
+/******************************************************************************/
+
+#ifdef __linux__
+// The layout of an entry returned by the getdents64 system call
+//
+struct XrdOssDirent64
+      {unsigned long long d_ino;
+       long long          d_off;
+       unsigned short     d_reclen;
+       unsigned char      d_type;
+       char               d_name[1];
+      };
+#endif
+
+// Direct reads that are not suitably aligned go through a per-thread bounce
+// buffer. Its size must be a multiple of the largest allowed alignment.
+//
+namespace
+{
+static const size_t dioBSize = 1048576;
+
+struct XrdOssDioBuff
+      {char *data;
+             XrdOssDioBuff() : data(0) {}
+            ~XrdOssDioBuff() {if (data) free(data);}
+      };
+
+thread_local XrdOssDioBuff dioBuff;
+}
+
 /******************************************************************************/
 /*                  E r r o r   R o u t i n g   O b j e c t                   */
 /******************************************************************************/
@@ -559,8 +598,32 @@ int XrdOssDir::Readdir(char *buff, int blen)
 //
    if (!isopen) return -XRDOSS_E8002;
 
-// Perform local reads if this is a local directory
-//
+// Perform local reads if this is a local directory. On Linux we read entries
+// in bulk using a buffer larger than the one readdir() uses so that very
+// large directories take fewer system calls to list.
+//
+#ifdef __linux__
+   if (lclfd && (dBuff || (dBuff = (char *)malloc(dBuffSz))))
+      {XrdOssDirent64 *dp;
+       if (dBoff >= dBlen)
+          {dBoff = 0;
+           if ((dBlen = syscall(SYS_getdents64, dirfd(lclfd), dBuff, dBuffSz))
+               <= 0)
+              {int rc = (dBlen ? -errno : XrdOssOK);
+               *buff = '\0'; ateof = 1; dBlen = 0;
+               return rc;
+              }
+          }
+       dp = (XrdOssDirent64 *)(dBuff + dBoff);
+       dBoff += dp->d_reclen;
+       strlcpy(buff, dp->d_name, blen);
+#ifdef HAVE_FSTATAT
+       if (Stat && fstatat(dirFD, dp->d_name, Stat, 0)) return -errno;
+#endif
+       return XrdOssOK;
+      }
+#endif
+
    if (lclfd)
       {errno = 0;
        if ((rp = readdir(lclfd)))
@@ -653,6 +716,7 @@ int XrdOssDir::Close(long long *retsz)
 
 // Close whichever handle is open
 //
+    if (dBuff) {free(dBuff); dBuff = 0; dBlen = dBoff = 0;}
     if (lclfd) {if (!(retc = closedir(lclfd))) lclfd = 0;}
        else if (mssfd) { if (!(retc = XrdOssSS->MSS_Closedir(mssfd))) mssfd = 0;}
                else retc = 0;
@@ -759,6 +823,27 @@ int XrdOssFile::Open(const char *path, int Oflag, mode_t Mode, XrdOucEnv &Env)
        if (mopts) mmFile = XrdOssMio::Map(local_path, fd, mopts);
       } else mmFile = 0;
 
+// Large reads from large read/only files may bypass the page cache. We open a
+// second descriptor with O_DIRECT so that small or unaligned reads can still
+// be served from the page cache using the original one. File systems that do
+// not support O_DIRECT simply leave the file buffered. The sequential i/o hint
+// is only honoured when direct i/o is configured; otherwise the page cache is
+// left alone (it may be shared with other readers of the file).
+//
+   dioFD = -1; dioOK = false;
+   dioSeq = (XrdOssSS->dioMinSz && Env.Get("oss.seqio") != 0);
+   if (fd >= 0 && !(Oflag & (O_WRONLY | O_RDWR)))
+      {
+#if defined(__linux__)
+       if (dioSeq) posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+#ifdef O_DIRECT
+       if (XrdOssSS->dioMinSz && !mmFile && !cxobj
+       &&  buf.st_size >= (dioSeq ? XrdOssSS->dioSeqSz : XrdOssSS->dioMinSz))
+          dioOK = (dioFD = XrdSysFD_Open(local_path, O_RDONLY | O_DIRECT)) >= 0;
+#endif
+      }
+
 // Return the result of this open
 //
    return (fd < 0 ? fd : XrdOssOK);
@@ -786,6 +871,7 @@ int XrdOssFile::Close(long long *retsz)
            XrdOssCache::Adjust(cacheP, buf.st_size - FSize);
         if (retsz) *retsz = buf.st_size;
        }
+    if (dioFD >= 0) {dioOK = false; close(dioFD); dioFD = -1;}
     if (close(fd)) return -errno;
     if (mmFile) {XrdOssMio::Recycle(mmFile); mmFile = 0;}
 #ifdef XRDOSSCX
@@ -843,6 +929,24 @@ ssize_t XrdOssFile::Read(void *buff, off_t offset, size_t blen)
 
      if (fd < 0) return (ssize_t)-XRDOSS_E8004;
 
+// Large reads go directly to the device when the file allows it. Should the
+// file system reject the request we quietly fall back to buffered reads. The
+// direct descriptor is only closed by Close() as the file may be shared by
+// other threads that are reading it right now.
+//
+     if (dioOK.load(std::memory_order_relaxed)
+     &&  (long long)blen >= (dioSeq ? XrdOssSS->dioSeqSz : XrdOssSS->dioMinSz))
+        {retval = ReadDirect(buff, offset, blen);
+         if (retval != -EINVAL && retval != -ENOMEM)
+            {if (retval > 0 && XrdOssSS->dioShm >= 0)
+                {XrdStatsShm::Add(XrdOssSS->dioShm);
+                 XrdStatsShm::Add(XrdOssSS->dioShm+1, retval);
+                }
+             return retval;
+            }
+         if (retval == -EINVAL) dioOK = false;
+        }
+
 #ifdef XRDOSSCX
      if (cxobj)  
         if (XrdOssSS->DirFlags & XrdOssNOSSDEC) return (ssize_t)-XRDOSS_E8021;
@@ -852,7 +956,77 @@ ssize_t XrdOssFile::Read(void *buff, off_t offset, size_t blen)
              do { retval = pread(fd, buff, blen, offset); }
                 while(retval < 0 && errno == EINTR);
 
-     return (retval >= 0 ? retval : (ssize_t)-errno);
+     if (retval < 0) return (ssize_t)-errno;
+
+// Sequentially read data is unlikely to be read again, so don't let it push
+// more useful pages out of the page cache.
+//
+#if defined(__linux__)
+     if (dioSeq && retval) posix_fadvise(fd, offset, retval, POSIX_FADV_DONTNEED);
+#endif
+
+     if (XrdOssSS->dioShm >= 0)
+        {XrdStatsShm::Add(XrdOssSS->dioShm+2);
+         XrdStatsShm::Add(XrdOssSS->dioShm+3, retval);
+        }
+     return retval;
+}
+
+/******************************************************************************/
+/*                            R e a d D i r e c t                             */
+/******************************************************************************/
+
+/*
+  Function: Read `blen' bytes using the O_DIRECT descriptor. Aligned requests
+            are read straight into 'buff'; others go through a bounce buffer.
+
+  Input:    buff      - Address of the buffer in which to place the data.
+            offset    - The absolute 64-bit byte offset at which to read.
+            blen      - The size of the buffer.
+
+  Output:   Returns the number bytes read upon success and -errno upon failure.
+*/
+
+ssize_t XrdOssFile::ReadDirect(void *buff, off_t offset, size_t blen)
+{
+     const size_t aMask = XrdOssSS->dioAlign - 1;
+     char *bP = (char *)buff;
+     ssize_t retval, total = 0;
+     size_t skip, rlen, dlen;
+     off_t  aOff;
+
+// If the offset, length, and buffer are all aligned we can avoid a copy
+//
+     if (!(((size_t)offset | blen | (size_t)buff) & aMask))
+        {do {retval = pread(dioFD, buff, blen, offset);}
+            while(retval < 0 && errno == EINTR);
+         return (retval >= 0 ? retval : (ssize_t)-errno);
+        }
+
+// Get a bounce buffer for this thread if we don't have one yet
+//
+     if (!dioBuff.data
+     &&  posix_memalign((void **)&dioBuff.data, 65536, dioBSize))
+        {dioBuff.data = 0; return (ssize_t)-ENOMEM;}
+
+// Read aligned chunks into the bounce buffer copying out what was asked for
+//
+     while(blen)
+          {aOff = offset & ~(off_t)aMask;
+           skip = offset - aOff;
+           rlen = (skip + blen + aMask) & ~aMask;
+           if (rlen > dioBSize) rlen = dioBSize;
+           do {retval = pread(dioFD, dioBuff.data, rlen, aOff);}
+              while(retval < 0 && errno == EINTR);
+           if (retval < 0) return (total ? total : (ssize_t)-errno);
+           if ((size_t)retval <= skip) break;
+           dlen = retval - skip;
+           if (dlen > blen) dlen = blen;
+           memcpy(bP, dioBuff.data + skip, dlen);
+           bP += dlen; offset += dlen; blen -= dlen; total += dlen;
+           if ((size_t)retval < rlen) break;
+          }
+     return total;
 }
 
 /******************************************************************************/
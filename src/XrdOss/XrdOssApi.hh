@@ -32,6 +32,7 @@
 
 #include <sys/types.h>
 #include <errno.h>
+#include <atomic>
 #include "XrdSys/XrdSysHeaders.hh"
 
 #include "XrdOss/XrdOss.hh"
@@ -58,10 +59,13 @@ int     StatRet(struct stat *buff);
 
         // Constructor and destructor
         XrdOssDir(const char *tid) : lclfd(0), mssfd(0), Stat(0), tident(tid),
-                                     pflags(0), ateof(0), isopen(0), dirFD(0)
+                                     pflags(0), ateof(0), isopen(0), dirFD(0),
+                                     dBuff(0), dBlen(0), dBoff(0)
                                    {}
        ~XrdOssDir() {if (isopen > 0) Close(); isopen = 0;}
 private:
+static const int    dBuffSz = 65536;  // Size of the bulk directory read buffer
+
          DIR       *lclfd;
          void      *mssfd;
 struct   stat      *Stat;
@@ -70,6 +74,9 @@ unsigned long long  pflags;
          int        ateof;
          int        isopen;
          int        dirFD;
+         char      *dBuff;  // Entries read in bulk (Linux only)
+         int        dBlen;
+         int        dBoff;
 };
   
 /******************************************************************************/
@@ -96,7 +103,7 @@ int     Fstat(struct stat *);
 int     Fsync();
 int     Fsync(XrdSfsAio *aiop);
 int     Ftruncate(unsigned long long);
-int     getFD() {return fd;}
+int     getFD() {return (dioOK ? -1 : fd);}
 off_t   getMmap(void **addr);
 int     isCompressed(char *cxidp=0);
 ssize_t Read(               off_t, size_t);
@@ -110,13 +117,15 @@ int     Write(XrdSfsAio *aiop);
         // Constructor and destructor
         XrdOssFile(const char *tid)
                   {cxobj = 0; rawio = 0; cxpgsz = 0; cxid[0] = '\0';
-                   mmFile = 0; tident = tid;
+                   mmFile = 0; tident = tid; dioFD = -1; dioOK = false;
+                   dioSeq = 0;
                   }
 
 virtual ~XrdOssFile() {if (fd >= 0) Close();}
 
 private:
 int     Open_ufs(const char *, int, int, unsigned long long);
+ssize_t ReadDirect(void *, off_t, size_t);
 
 static int      AioFailure;
 oocx_CXFile    *cxobj;
@@ -127,6 +136,9 @@ long long       FSize;
 int             rawio;
 int             cxpgsz;
 char            cxid[4];
+int             dioFD;    // O_DIRECT descriptor for large reads or -1
+std::atomic<bool> dioOK;  // Direct reads are enabled (dioFD is valid)
+char            dioSeq;   // File was opened for sequential i/o
 };
 
 /******************************************************************************/
@@ -275,6 +287,11 @@ int               prActive;  //    preread activity count
 short             prDepth;   //    preread depth
 short             prQSize;   //    preread maximum allowed
 
+long long         dioMinSz;  //    Direct read threshold (0 -> no direct i/o)
+long long         dioSeqSz;  //    Direct read threshold for sequential files
+int               dioAlign;  //    Direct read alignment
+int               dioShm;    //    Direct read shared statistics ids
+
 XrdVersionInfo   *myVersion; //    Compilation version set by constructor
    
          XrdOssSys();
@@ -343,6 +360,7 @@ int    xalloc(XrdOucStream &Config, XrdSysError &Eroute);
 int    xcache(XrdOucStream &Config, XrdSysError &Eroute);
 int    xcachescan(XrdOucStream &Config, XrdSysError &Eroute);
 int    xdefault(XrdOucStream &Config, XrdSysError &Eroute);
+int    xdio(XrdOucStream &Config, XrdSysError &Eroute);
 int    xfdlimit(XrdOucStream &Config, XrdSysError &Eroute);
 int    xmaxsz(XrdOucStream &Config, XrdSysError &Eroute);
 int    xmemf(XrdOucStream &Config, XrdSysError &Eroute);
@@ -42,6 +42,8 @@
 
 #include "XrdVersion.hh"
 
+#include "Xrd/XrdStatsShm.hh"
+
 #include "XrdFrc/XrdFrcProxy.hh"
 #include "XrdOss/XrdOssPath.hh"
 #include "XrdOss/XrdOssApi.hh"
@@ -212,6 +214,10 @@ XrdOssSys::XrdOssSys()
    prActive      = 0;
    prDepth       = 0;
    prQSize       = 0;
+   dioMinSz      = 0;
+   dioSeqSz      = 0;
+   dioAlign      = 4096;
+   dioShm        = XrdStatsShm::noCtr;
    STT_Lib       = 0;
    STT_Parms     = 0;
    STT_Func      = 0;
@@ -310,6 +316,13 @@ int XrdOssSys::Configure(const char *configfn, XrdSysError &Eroute,
 //
    if (!NoGo) ConfigMio(Eroute);
 
+// Publish direct read statistics if direct reads are enabled
+//
+   if (!NoGo && dioMinSz)
+      {static const char *dioNames[] = {"dio", "dio.bytes", "buf", "buf.bytes"};
+       dioShm = XrdStatsShm::Define("oss.rd", dioNames, 4);
+      }
+
 // Establish the actual default path settings (modified by the above)
 //
    RPList.Set(DirFlags);
@@ -417,6 +430,12 @@ void XrdOssSys::Config_Display(XrdSysError &Eroute)
 
      Eroute.Say(buff);
 
+     if (dioMinSz)
+        {snprintf(buff, sizeof(buff), "       oss.directio     minsize %lld "
+                  "seqsize %lld align %d", dioMinSz, dioSeqSz, dioAlign);
+         Eroute.Say(buff);
+        }
+
      XrdOssMio::Display(Eroute);
 
      XrdOssCache::List("       oss.", Eroute);
@@ -975,6 +994,7 @@ int XrdOssSys::ConfigXeq(char *var, XrdOucStream &Config, XrdSysError &Eroute)
    TS_Xeq("cache",         xcache);
    TS_Xeq("cachescan",     xcachescan);
    TS_Xeq("defaults",      xdefault);
+   TS_Xeq("directio",      xdio);
    TS_Xeq("fdlimit",       xfdlimit);
    TS_Xeq("maxsize",       xmaxsz);
    TS_Xeq("memfile",       xmemf);
@@ -1381,6 +1401,75 @@ int XrdOssSys::xpath(XrdOucStream &Config, XrdSysError &Eroute)
    return 1;
 }
 
+/******************************************************************************/
+/*                                  x d i o                                   */
+/******************************************************************************/
+
+/* Function: xdio
+
+   Purpose:  To parse the directive: directio {off | [minsize <sz>]
+                                              [seqsize <ssz>] [align <n>]}
+
+             off      reads always go through the page cache (the default).
+             <sz>     reads of at least <sz> bytes from files opened read/only
+                      bypass the page cache using O_DIRECT. The default is 1m.
+             <ssz>    the same for files opened for sequential i/o (kXR_seqio)
+                      whose smaller reads are advised not to be kept in the
+                      page cache. The default is 128k.
+             <n>      the alignment direct reads require; a power of two
+                      between 512 and 64k. The default is 4k.
+
+   Output: 0 upon success or !0 upon failure.
+*/
+
+int XrdOssSys::xdio(XrdOucStream &Config, XrdSysError &Eroute)
+{
+    static const long long m1 = 1048576LL;
+    char *val;
+    long long minsz = m1, seqsz = 131072, algn = 4096;
+
+      if (!(val = Config.GetWord()))
+         {Eroute.Emsg("Config", "directio parameters not specified"); return 1;}
+
+      if (!strcmp(val, "off")) {dioMinSz = 0; return 0;}
+
+      do {     if (!strcmp(val, "minsize"))
+                  {if (!(val = Config.GetWord()))
+                      {Eroute.Emsg("Config","directio minsize not specified");
+                       return 1;
+                      }
+                   if (XrdOuca2x::a2sz(Eroute,"directio minsize",val,&minsz,
+                                       512, 1024*m1)) return 1;
+                  }
+          else if (!strcmp(val, "seqsize"))
+                  {if (!(val = Config.GetWord()))
+                      {Eroute.Emsg("Config","directio seqsize not specified");
+                       return 1;
+                      }
+                   if (XrdOuca2x::a2sz(Eroute,"directio seqsize",val,&seqsz,
+                                       512, 1024*m1)) return 1;
+                  }
+          else if (!strcmp(val, "align"))
+                  {if (!(val = Config.GetWord()))
+                      {Eroute.Emsg("Config","directio align not specified");
+                       return 1;
+                      }
+                   if (XrdOuca2x::a2sz(Eroute,"directio align",val,&algn,
+                                       512, 65536)) return 1;
+                   if (algn & (algn-1))
+                      {Eroute.Emsg("Config","directio align is not a power of 2");
+                       return 1;
+                      }
+                  }
+          else {Eroute.Emsg("Config","invalid directio option -",val); return 1;}
+         } while((val = Config.GetWord()));
+
+      dioMinSz = minsz;
+      dioSeqSz = seqsz;
+      dioAlign = static_cast<int>(algn);
+      return 0;
+}
+
 /******************************************************************************/
 /*                                x p r e r d                                 */
 /******************************************************************************/
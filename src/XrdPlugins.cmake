@@ -26,6 +26,8 @@ add_library(
   XrdPss/XrdPss.cc           XrdPss/XrdPss.hh
   XrdPss/XrdPssCks.cc        XrdPss/XrdPssCks.hh
   XrdPss/XrdPssConfig.cc
+  XrdPss/XrdPssMetaCache.cc  XrdPss/XrdPssMetaCache.hh
+  XrdPss/XrdPssStream.cc     XrdPss/XrdPssStream.hh
                              XrdPss/XrdPssTrace.hh
   XrdPss/XrdPssUrlInfo.cc    XrdPss/XrdPssUrlInfo.hh )
 
@@ -134,6 +136,8 @@ add_library(
   XrdThrottle/XrdThrottleFileSystemConfig.cc
   XrdThrottle/XrdThrottleFile.cc
   XrdThrottle/XrdThrottleManager.cc    XrdThrottle/XrdThrottleManager.hh
+  XrdThrottle/XrdThrottleBuckets.cc    XrdThrottle/XrdThrottleBuckets.hh
+  XrdThrottle/XrdThrottleLoadMonitor.cc XrdThrottle/XrdThrottleLoadMonitor.hh
 )
 
 target_link_libraries(
@@ -65,12 +65,12 @@ XrdPosixPrepIO *PrepIO;
 XrdCl::File     clFile;
 
        long long     addOffset(long long offs, int updtSz=0)
-                              {updMutex.Lock();
-                               currOffset += offs;
-                               if (updtSz && currOffset > (long long)mySize)
-                                  mySize = currOffset;
-                               long long retOffset = currOffset;
-                               updMutex.UnLock();
+                              {long long retOffset;
+                               AtomicBeg(updMutex);
+                               AtomicFAdd(retOffset, currOffset, offs);
+                               AtomicEnd(updMutex);
+                               retOffset += offs;
+                               if (updtSz) UpdtSize(retOffset);
                                return retOffset;
                               }
 
@@ -120,11 +120,19 @@ static void          DelayedDestroy(XrdPosixFile *fp);
                             int n);
 
        long long     setOffset(long long offs)
+#ifdef HAVE_ATOMICS
+                              {long long oldOffset;
+                               do {oldOffset = AtomicGet(currOffset);
+                                  } while(!AtomicCAS(currOffset,oldOffset,offs));
+                               return offs;
+                              }
+#else
                               {updMutex.Lock();
                                currOffset = offs;
                                updMutex.UnLock();
                                return offs;
                               }
+#endif
 
        bool          Stat(XrdCl::XRootDStatus &Status, bool force=false);
 
@@ -135,10 +143,18 @@ static void          DelayedDestroy(XrdPosixFile *fp);
        int           Trunc(long long Offset);
 
        void          UpdtSize(size_t newsz)
+#ifdef HAVE_ATOMICS
+                              {size_t oldsz;
+                               do {oldsz = AtomicGet(mySize);
+                                  } while(newsz > oldsz
+                                      && !AtomicCAS(mySize, oldsz, newsz));
+                              }
+#else
                               {updMutex.Lock();
                                if (newsz > mySize) mySize = newsz;
                                updMutex.UnLock();
                               }
+#endif
 
        using         XrdPosixObject::Who;
 
@@ -42,6 +42,7 @@
 /*                        S t a t i c   M e m b e r s                         */
 /******************************************************************************/
 
+XrdSysRWLock     XrdPosixObject::fdLocks[XrdPosixObject::fdStripes];
 XrdSysMutex      XrdPosixObject::fdMutex;
 XrdPosixObject **XrdPosixObject::myFiles  =  0;
 int              XrdPosixObject::highFD   = -1;
@@ -79,9 +80,12 @@ bool XrdPosixObject::AssignFD(bool isStream)
 
 // Enter object in out vector of objects and assign it the FD
 //
+   XrdSysRWLock &tLock = fdLock(fd + baseFD);
+   tLock.WriteLock();
    myFiles[fd] = this;
-   if (fd > highFD) highFD = fd;
    fdNum  = fd + baseFD;
+   tLock.UnLock();
+   if (fd > highFD) highFD = fd;
 
 // All done.
 //
@@ -104,32 +108,35 @@ XrdPosixDir *XrdPosixObject::Dir(int fd, bool glk)
 do{if (fd >= lastFD || fd < baseFD)
       {errno = EBADF; return (XrdPosixDir *)0;}
 
-// Obtain the file object, if any
+// Obtain the file object, if any. Only the table stripe for this fd is locked
+// and only in read mode unless the object is to be released.
 //
-   fdMutex.Lock();
+   XrdSysRWLock &tLock = fdLock(fd);
+   if (glk) tLock.WriteLock();
+      else  tLock.ReadLock();
    if (!(oP = myFiles[fd - baseFD]) || !(oP->Who(&dP)))
-      {fdMutex.UnLock(); errno = EBADF; return (XrdPosixDir *)0;}
+      {tLock.UnLock(); errno = EBADF; return (XrdPosixDir *)0;}
 
 // Attempt to lock the object in the appropriate mode. If we fail, then we need
-// to retry this after dropping the global lock. We pause a bit to let the
+// to retry this after dropping the table lock. We pause a bit to let the
 // current lock holder a chance to unlock the lock. We only do this a limited
 // amount of time (1 minute) so that we don't get stuck here forever.
 //
    if (glk) haveLock = oP->objMutex.CondWriteLock();
       else  haveLock = oP->objMutex.CondReadLock();
    if (!haveLock)
-      {fdMutex.UnLock();
+      {tLock.UnLock();
        waitCount++;
        if (waitCount > 120) break;
        XrdSysTimer::Wait(500); // We wait 500 milliseconds
        continue;
       }
 
-// If the global lock is to be held, then release the object lock as this
+// If the table lock is to be held, then release the object lock as this
 // is a call to destroy the object and there is no need for the local lock.
 //
    if (glk) oP->UnLock();
-      else  fdMutex.UnLock();
+      else  tLock.UnLock();
    return dP;
   } while(1);
 
@@ -155,32 +162,35 @@ XrdPosixFile *XrdPosixObject::File(int fd, bool glk)
 do{if (fd >= lastFD || fd < baseFD)
       {errno = EBADF; return (XrdPosixFile *)0;}
 
-// Obtain the file object, if any
+// Obtain the file object, if any. Only the table stripe for this fd is locked
+// and only in read mode unless the object is to be released.
 //
-   fdMutex.Lock();
+   XrdSysRWLock &tLock = fdLock(fd);
+   if (glk) tLock.WriteLock();
+      else  tLock.ReadLock();
    if (!(oP = myFiles[fd - baseFD]) || !(oP->Who(&fP)))
-      {fdMutex.UnLock(); errno = EBADF; return (XrdPosixFile *)0;}
+      {tLock.UnLock(); errno = EBADF; return (XrdPosixFile *)0;}
 
 // Attempt to lock the object in the appropriate mode. If we fail, then we need
-// to retry this after dropping the global lock. We pause a bit to let the
+// to retry this after dropping the table lock. We pause a bit to let the
 // current lock holder a chance to unlock the lock. We only do this a limited
 // amount of time (1 minute) so that we don't get stuck here forever.
 //
    if (glk) haveLock = oP->objMutex.CondWriteLock();
       else  haveLock = oP->objMutex.CondReadLock();
    if (!haveLock)
-      {fdMutex.UnLock();
+      {tLock.UnLock();
        waitCount++;
        if (waitCount > 120) break;
        XrdSysTimer::Wait(500); // We wait 500 milliseconds
        continue;
       }
 
-// If the global lock is to be held, then release the object lock as this
+// If the table lock is to be held, then release the object lock as this
 // is a call to destroy the object and there is no need for the local lock.
 //
    if (glk) oP->UnLock();
-      else  fdMutex.UnLock();
+      else  tLock.UnLock();
    return fP;
   } while(1);
 
@@ -244,25 +254,32 @@ int XrdPosixObject::Init(int fdnum)
   
 void XrdPosixObject::Release(XrdPosixObject *oP, bool needlk)
 {
+   int myFD = oP->fdNum;
+   XrdSysRWLock &tLock = fdLock(myFD);
+
 // Get the lock if need be
 //
-   if (needlk) fdMutex.Lock();
+   if (needlk) tLock.WriteLock();
 
 // Remove the object from the table
 //
-   if (baseFD)
-      {int myFD = oP->fdNum - baseFD;
-       if (myFD < freeFD) freeFD = myFD;
-       myFiles[myFD] = 0;
-      } else {
-       myFiles[oP->fdNum] = 0;
-       close(oP->fdNum);
-      }
+   if (baseFD) myFiles[myFD - baseFD] = 0;
+      else    {myFiles[myFD] = 0;
+               close(myFD);
+              }
 
-// Zorch the object fd and release the global lock
+// Zorch the object fd and release the table lock
 //
    oP->fdNum = -1;
-   fdMutex.UnLock();
+   tLock.UnLock();
+
+// Make the virtual fd available for reuse
+//
+   if (baseFD)
+      {fdMutex.Lock();
+       if (myFD - baseFD < freeFD) freeFD = myFD - baseFD;
+       fdMutex.UnLock();
+      }
 }
 
 /******************************************************************************/
@@ -316,7 +333,9 @@ void XrdPosixObject::Shutdown()
    if (myFiles)
       {for (i = 0; i <= highFD; i++) 
            if ((oP = myFiles[i]))
-              {myFiles[i] = 0;
+              {fdLock(i + baseFD).WriteLock();
+               myFiles[i] = 0;
+               fdLock(i + baseFD).UnLock();
                if (oP->fdNum >= 0) close(oP->fdNum);
                oP->fdNum = -1;
                delete oP;
@@ -98,6 +98,15 @@ protected:
 
 private:
 
+// The fd table is protected by striped r/w locks so that lookups of different
+// files by different threads do not contend with each other. The fdMutex only
+// serializes the allocation of new file descriptors.
+//
+static const int        fdStripes = 64;    // Must be a power of 2
+
+static XrdSysRWLock    &fdLock(int fd) {return fdLocks[fd & (fdStripes-1)];}
+
+static XrdSysRWLock     fdLocks[fdStripes];
 static XrdSysMutex      fdMutex;
 static XrdPosixObject **myFiles;
 static int              lastFD;
@@ -99,6 +99,29 @@ static const char *osslclCGI = "oss.lcl=1";
 static const int   PBsz = 4096;
 
        XrdSysTrace SysTrace("Pss",0);
+
+       XrdPssMetaCache mdCache;
+
+// Return the identity a request is made with for the metadata cache. The
+// origin sees the client's name and cgi (which may hold an authorization
+// token), so both must match for a cached result to be used.
+//
+std::string mdcUser(XrdOucEnv *envP)
+{
+   const XrdSecEntity *secP = (envP ? envP->secEnv() : 0);
+   const char *cgi, *dot;
+   std::string user;
+   int cgiLen;
+
+   if (secP)
+      {if (secP->name && *secP->name) user = secP->name;
+          else if (secP->tident && (dot = index(secP->tident, '.')))
+                  user.assign(secP->tident, dot - secP->tident);
+      }
+   if (envP && (cgi = envP->Env(cgiLen)) && cgiLen)
+      {user += '?'; user.append(cgi, cgiLen);}
+   return user;
+}
 }
 
 using namespace XrdProxy;
@@ -292,7 +315,10 @@ int XrdPssSys::Mkdir(const char *path, mode_t mode, int mkpath, XrdOucEnv *eP)
 
 // Simply return the proxied result here
 //
-   return (XrdPosixXrootd::Mkdir(pbuff, mode) ? -errno : XrdOssOK);
+   if (mdCache.Enabled()) mdCache.Invalidate(path);
+   rc = (XrdPosixXrootd::Mkdir(pbuff, mode) ? -errno : XrdOssOK);
+   if (mdCache.Enabled()) mdCache.Invalidate(path);
+   return rc;
 }
   
 /******************************************************************************/
@@ -334,9 +360,14 @@ int XrdPssSys::Remdir(const char *path, int Opts, XrdOucEnv *eP)
 //
    DEBUG(uInfo.Tident(),"url="<<pbuff);
 
-// Issue unlink and return result
+// Issue unlink and return result. What we know about the path is dropped both
+// before and after so that nothing cached while the request was in flight
+// survives it.
 //
-   return (XrdPosixXrootd::Rmdir(pbuff) ? -errno : XrdOssOK);
+   if (mdCache.Enabled()) mdCache.Invalidate(path, true);
+   rc = (XrdPosixXrootd::Rmdir(pbuff) ? -errno : XrdOssOK);
+   if (mdCache.Enabled()) mdCache.Invalidate(path, true);
+   return rc;
 }
 
 /******************************************************************************/
@@ -380,7 +411,12 @@ int XrdPssSys::Rename(const char *oldname, const char *newname,
 
 // Execute the rename and return result
 //
-   return (XrdPosixXrootd::Rename(oldName, newName) ? -errno : XrdOssOK);
+   if (mdCache.Enabled())
+      {mdCache.Invalidate(oldname, true); mdCache.Invalidate(newname, true);}
+   rc = (XrdPosixXrootd::Rename(oldName, newName) ? -errno : XrdOssOK);
+   if (mdCache.Enabled())
+      {mdCache.Invalidate(oldname, true); mdCache.Invalidate(newname, true);}
+   return rc;
 }
 
 /******************************************************************************/
@@ -407,6 +443,9 @@ int XrdPssSys::Stat(const char *path, struct stat *buff, int Opts, XrdOucEnv *eP
    const char *Cgi = "";
    int rc;
    char pbuff[PBsz];
+   bool useMDC = mdCache.Enabled() && *path == '/'
+              && !(Opts & XRDOSS_resonly);
+   std::string mdUser;
 
 // Setup any required special cgi information
 //
@@ -417,6 +456,14 @@ int XrdPssSys::Stat(const char *path, struct stat *buff, int Opts, XrdOucEnv *eP
 //
    XrdPssUrlInfo uInfo(eP, path, Cgi);
 
+// Use the cached result, if we have one
+//
+   if (useMDC) mdUser = mdcUser(eP);
+   if (useMDC && mdCache.GetStat(path, mdUser, *buff, rc))
+      {DEBUG(uInfo.Tident(),"cached rc="<<rc<<" path="<<path);
+       return rc;
+      }
+
 // Generate an ID if we need to
 //
    if (sidP) uInfo.setID(sidP);
@@ -429,9 +476,55 @@ int XrdPssSys::Stat(const char *path, struct stat *buff, int Opts, XrdOucEnv *eP
 //
    DEBUG(uInfo.Tident(),"url="<<pbuff);
 
-// Return proxied stat
+// Return proxied stat, recording the result
 //
-   return (XrdPosixXrootd::Stat(pbuff, buff) ? -errno : XrdOssOK);
+   rc = (XrdPosixXrootd::Stat(pbuff, buff) ? -errno : XrdOssOK);
+   if (useMDC) mdCache.PutStat(path, mdUser, buff, rc);
+   return rc;
+}
+
+/******************************************************************************/
+/*                                 S t a t s                                  */
+/******************************************************************************/
+
+/*
+  Function: Return statistics.
+
+  Input:    buff        - Buffer where the statistics are to be placed.
+            blen        - The length of the buffer.
+
+  Output:   Returns number of bytes placed in the buffer less null byte or,
+            when buff is nil, the maximum number of bytes that may be needed.
+*/
+
+int XrdPssSys::Stats(char *buff, int blen)
+{
+   static const char statfmt1[] = "<stats id=\"pss\">";
+   static const char statfmt2[] = "</stats>";
+   static const int  statflen = sizeof(statfmt1) + sizeof(statfmt2);
+   char *bp = buff;
+   int n;
+
+// We only have statistics when the metadata cache is enabled
+//
+   if (!mdCache.Enabled()) return 0;
+
+// If only size wanted, return what size we need
+//
+   if (!buff) return statflen + mdCache.Stats(0, 0);
+
+// Make sure we have enough space
+//
+   if (blen < statflen + mdCache.Stats(0, 0)) return 0;
+   strcpy(bp, statfmt1);
+   bp += sizeof(statfmt1)-1; blen -= sizeof(statfmt1)-1;
+
+// Generate the cache statistics and add the trailer
+//
+   n = mdCache.Stats(bp, blen);
+   bp += n;
+   strcpy(bp, statfmt2); bp += (sizeof(statfmt2)-1);
+   return bp - buff;
 }
 
 /******************************************************************************/
@@ -470,7 +563,10 @@ int XrdPssSys::Truncate(const char *path, unsigned long long flen,
 // Return proxied truncate. We only do this on a single machine because the
 // redirector will forbid the trunc() if multiple copies exist.
 //
-   return (XrdPosixXrootd::Truncate(pbuff, flen) ? -errno : XrdOssOK);
+   if (mdCache.Enabled()) mdCache.Invalidate(path);
+   rc = (XrdPosixXrootd::Truncate(pbuff, flen) ? -errno : XrdOssOK);
+   if (mdCache.Enabled()) mdCache.Invalidate(path);
+   return rc;
 }
   
 /******************************************************************************/
@@ -514,7 +610,10 @@ int XrdPssSys::Unlink(const char *path, int Opts, XrdOucEnv *envP)
 
 // Unlink the file and return result.
 //
-   return (XrdPosixXrootd::Unlink(pbuff) ? -errno : XrdOssOK);
+   if (mdCache.Enabled()) mdCache.Invalidate(path);
+   rc = (XrdPosixXrootd::Unlink(pbuff) ? -errno : XrdOssOK);
+   if (mdCache.Enabled()) mdCache.Invalidate(path);
+   return rc;
 }
 
 /******************************************************************************/
@@ -540,7 +639,7 @@ int XrdPssDir::Opendir(const char *dir_path, XrdOucEnv &Env)
 
 // Return an error if this object is already open
 //
-   if (myDir) return -XRDOSS_E8001;
+   if (myDir || dList) return -XRDOSS_E8001;
 
 // Open directories are not supported for object id's
 //
@@ -549,6 +648,16 @@ int XrdPssDir::Opendir(const char *dir_path, XrdOucEnv &Env)
 // Setup url info
 //
    XrdPssUrlInfo uInfo(&Env, dir_path);
+
+// Use the cached listing, if we have one
+//
+   if (mdCache.Enabled()) dUser = mdcUser(&Env);
+   if (mdCache.Enabled() && mdCache.GetDir(dir_path, dUser, dList, rc))
+      {DEBUG(uInfo.Tident(),"cached rc="<<rc<<" path="<<dir_path);
+       if (rc) {dList.reset(); return rc;}
+       dNext = 0;
+       return XrdOssOK;
+      }
    uInfo.setID();
 
 // Convert path to URL
@@ -563,7 +672,18 @@ int XrdPssDir::Opendir(const char *dir_path, XrdOucEnv &Env)
 // Open the directory
 //
    myDir = XrdPosixXrootd::Opendir(pbuff);
-   if (!myDir) return -errno;
+   if (!myDir)
+      {rc = -errno;
+       if (mdCache.Enabled()) mdCache.PutStat(dir_path, dUser, 0, rc);
+       return rc;
+      }
+
+// Record the listing as it is read so that it can be cached
+//
+   if (mdCache.Enabled() && mdCache.DirMax() > 0)
+      {dBuild = new std::vector<std::string>;
+       dPath  = strdup(dir_path);
+      }
    return XrdOssOK;
 }
 
@@ -588,14 +708,34 @@ int XrdPssDir::Opendir(const char *dir_path, XrdOucEnv &Env)
 */
 int XrdPssDir::Readdir(char *buff, int blen)
 {
-// Check if we are directly reading the directory
+// Check if we are returning a cached listing
+//
+   if (dList)
+      {if (dNext < dList->size()) strlcpy(buff, (*dList)[dNext++].c_str(), blen);
+          else *buff = 0;
+       return XrdOssOK;
+      }
+
+// Check if we are directly reading the directory. Once the whole listing has
+// been read, it is handed to the metadata cache, unless it is too long.
 //
    if (myDir)
       {dirent *entP, myEnt;
        int    rc = XrdPosixXrootd::Readdir_r(myDir, &myEnt, &entP);
-       if (rc) return -rc;
-       if (!entP) *buff = 0;
-          else strlcpy(buff, myEnt.d_name, blen);
+       if (rc) {if (dBuild) {delete dBuild; dBuild = 0;}
+                return -rc;
+               }
+       if (!entP)
+          {*buff = 0;
+           if (dBuild) {mdCache.PutDir(dPath, dUser, dBuild); dBuild = 0;}
+          } else {
+           strlcpy(buff, myEnt.d_name, blen);
+           if (dBuild)
+              {if ((int)dBuild->size() < mdCache.DirMax())
+                  dBuild->push_back(myEnt.d_name);
+                  else {delete dBuild; dBuild = 0;}
+              }
+          }
        return XrdOssOK;
       }
 
@@ -619,6 +759,12 @@ int XrdPssDir::Close(long long *retsz)
 {
    DIR *theDir;
 
+// Release any cached listing
+//
+   if (dList) {dList.reset(); return XrdOssOK;}
+   if (dBuild) {delete dBuild; dBuild = 0;}
+   if (dPath)  {free(dPath);   dPath  = 0;}
+
 // Close the directory proper if it exists. POSIX specified that directory
 // stream is no longer available after closedir() regardless if return value.
 //
@@ -672,6 +818,16 @@ int XrdPssFile::Open(const char *path, int Oflag, mode_t Mode, XrdOucEnv &Env)
 //
    if (fd >= 0 || tpcPath) return -XRDOSS_E8003;
 
+// Check whether we already know that the file does not exist. Anything that
+// may change the file invalidates what we know about it.
+//
+   if (mdCache.Enabled() && *path == '/' && !tpcMode)
+      {if (!rwMode)
+          {if (mdCache.GetNeg(path, mdcUser(&Env), rc))
+              {DEBUG(tident,"cached rc="<<rc<<" path="<<path); return rc;}
+          } else mdCache.Invalidate(path);
+      }
+
 // If we are opening this in r/w mode make sure we actually can
 //
    if (rwMode && (popts & XRDEXP_NOTRW))
@@ -718,7 +874,14 @@ int XrdPssFile::Open(const char *path, int Oflag, mode_t Mode, XrdOucEnv &Env)
 // Try to open and if we failed, return an error
 //
    if (!XrdPssSys::dcaCheck || !ioCache)
-      {if ((fd = XrdPosixXrootd::Open(pbuff,Oflag,Mode)) < 0) return -errno;
+      {if ((fd = XrdPosixXrootd::Open(pbuff,Oflag,Mode)) < 0)
+          {rc = -errno;
+           if (mdCache.Enabled() && *path == '/')
+              {if (!rwMode) mdCache.PutStat(path, mdcUser(&Env), 0, rc);
+                  else mdCache.Invalidate(path);
+              }
+           return rc;
+          }
       } else {
        XrdPosixInfo Info;
        if (XrdPosixConfig::OpenFC(pbuff,Oflag,Mode,Info))
@@ -729,6 +892,21 @@ int XrdPssFile::Open(const char *path, int Oflag, mode_t Mode, XrdOucEnv &Env)
        if (fd < 0) return -errno;
       }
 
+// Stream the file if so wanted. Note that the file may have been forced to be
+// opened read/only.
+//
+   if (XrdPssStream::Enabled() && (!XrdPssSys::dcaCheck || !ioCache))
+      myStream = XrdPssStream::Alloc(fd,
+                                     (Oflag & (O_WRONLY|O_RDWR|O_APPEND)) != 0);
+
+// Opening the file for writing may have created it and changes to the file
+// invalidate its cached information again when it is closed.
+//
+   if (mdCache.Enabled() && *path == '/' && rwMode)
+      {mdCache.Invalidate(path);
+       rwPath = strdup(path);
+      }
+
 // All done
 //
    return XrdOssOK;
@@ -746,7 +924,7 @@ int XrdPssFile::Open(const char *path, int Oflag, mode_t Mode, XrdOucEnv &Env)
   Output:   Returns XrdOssOK upon success aud -errno upon failure.
 */
 int XrdPssFile::Close(long long *retsz)
-{   int rc;
+{   int rc, src = 0;
 
 // We don't support returning the size (we really should fix this)
 //
@@ -761,11 +939,20 @@ int XrdPssFile::Close(long long *retsz)
         return XrdOssOK;
        }
 
+// Write out any buffered data, reporting any failure after the file is closed
+//
+    if (myStream)
+       {src = myStream->Close();
+        delete myStream;
+        myStream = 0;
+       }
+
 // Close the file
 //
     rc = XrdPosixXrootd::Close(fd);
     fd = -1;
-    return (rc == 0 ? XrdOssOK : -errno);
+    if (rwPath) {mdCache.Invalidate(rwPath); free(rwPath); rwPath = 0;}
+    return (rc == 0 ? src : -errno);
 }
 
 /******************************************************************************/
@@ -811,6 +998,8 @@ ssize_t XrdPssFile::Read(void *buff, off_t offset, size_t blen)
 
      if (fd < 0) return (ssize_t)-XRDOSS_E8004;
 
+     if (myStream) return myStream->Read(buff, offset, blen);
+
      return (retval = XrdPosixXrootd::Pread(fd, buff, blen, offset)) < 0
             ? (ssize_t)-errno : retval;
 }
@@ -838,6 +1027,8 @@ ssize_t XrdPssFile::ReadV(XrdOucIOVec     *readV,     // In
 
     if (fd < 0) return (ssize_t)-XRDOSS_E8004;
 
+    if (myStream && (retval = myStream->Flush())) return retval;
+
     return (retval = XrdPosixXrootd::VRead(fd, readV, readCount)) < 0 ? (ssize_t)-errno : retval;;
 }
 
@@ -883,6 +1074,8 @@ ssize_t XrdPssFile::Write(const void *buff, off_t offset, size_t blen)
 
      if (fd < 0) return (ssize_t)-XRDOSS_E8004;
 
+     if (myStream) return myStream->Write(buff, offset, blen);
+
      return (retval = XrdPosixXrootd::Pwrite(fd, buff, blen, offset)) < 0
             ? (ssize_t)-errno : retval;
 }
@@ -901,6 +1094,8 @@ ssize_t XrdPssFile::Write(const void *buff, off_t offset, size_t blen)
 
 int XrdPssFile::Fstat(struct stat *buff)
 {
+    int rc;
+
     if (fd < 0)
        {if (!tpcPath) return -XRDOSS_E8004;
         if (XrdProxySS.Stat(tpcPath, buff))
@@ -908,6 +1103,8 @@ int XrdPssFile::Fstat(struct stat *buff)
         return XrdOssOK;
        }
 
+    if (myStream && (rc = myStream->Flush())) return rc;
+
     return (XrdPosixXrootd::Fstat(fd, buff) ? -errno : XrdOssOK);
 }
 
@@ -924,8 +1121,12 @@ int XrdPssFile::Fstat(struct stat *buff)
 */
 int XrdPssFile::Fsync(void)
 {
+    int rc;
+
     if (fd < 0) return -XRDOSS_E8004;
 
+    if (myStream && (rc = myStream->Flush())) return rc;
+
     return (XrdPosixXrootd::Fsync(fd) ? -errno : XrdOssOK);
 }
 
@@ -953,8 +1154,12 @@ int XrdPssFile::Fsync(void)
 */
 int XrdPssFile::Ftruncate(unsigned long long flen)
 {
+    int rc;
+
     if (fd < 0) return -XRDOSS_E8004;
 
+    if (myStream && (rc = myStream->Flush())) return rc;
+
     return (XrdPosixXrootd::Ftruncate(fd, flen) ?  -errno : XrdOssOK);
 }
 
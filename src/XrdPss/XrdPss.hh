@@ -39,6 +39,8 @@
 #include "XrdOuc/XrdOucPList.hh"
 #include "XrdOuc/XrdOucSid.hh"
 #include "XrdOss/XrdOss.hh"
+#include "XrdPss/XrdPssMetaCache.hh"
+#include "XrdPss/XrdPssStream.hh"
 
 /******************************************************************************/
 /*                             X r d P s s D i r                              */
@@ -52,11 +54,17 @@ int     Opendir(const char *, XrdOucEnv &);
 int     Readdir(char *buff, int blen);
 
         // Constructor and destructor
-        XrdPssDir(const char *tid) : tident(tid), myDir(0) {}
-       ~XrdPssDir() {if (myDir) Close();}
+        XrdPssDir(const char *tid) : tident(tid), myDir(0), dNext(0),
+                                     dBuild(0), dPath(0) {}
+       ~XrdPssDir() {if (myDir || dList) Close();}
 private:
 const    char      *tident;
          DIR       *myDir;
+XrdPssMetaCache::DirList dList;  // Cached listing being returned
+         size_t     dNext;
+std::vector<std::string> *dBuild; // Listing being recorded for the cache
+         char      *dPath;
+std::string         dUser;  // Identity the listing was obtained with
 };
   
 /******************************************************************************/
@@ -92,17 +100,20 @@ ssize_t Write(const void *, off_t, size_t);
 int     Write(XrdSfsAio *aiop);
  
          // Constructor and destructor
-         XrdPssFile(const char *tid) : tident(tid), tpcPath(0)
-                                       {fd = -1;}
+         XrdPssFile(const char *tid) : tident(tid), tpcPath(0), rwPath(0),
+                                       myStream(0) {fd = -1;}
 
 virtual ~XrdPssFile() {if (fd >= 0) Close();
                        if (tpcPath) free(tpcPath);
+                       if (rwPath)  free(rwPath);
                       }
 
 private:
 
 const char *tident;
       char *tpcPath;
+      char *rwPath;  // Path to invalidate in the metadata cache upon close
+XrdPssStream *myStream; // Readahead and write-behind, if enabled
 };
 
 /******************************************************************************/
@@ -139,6 +150,7 @@ int       Remdir(const char *, int Opts=0, XrdOucEnv *eP=0);
 int       Rename(const char *, const char *,
                  XrdOucEnv *eP1=0, XrdOucEnv *eP2=0);
 int       Stat(const char *, struct stat *, int opts=0, XrdOucEnv *eP=0);
+int       Stats(char *bp, int bl);
 int       Truncate(const char *, unsigned long long, XrdOucEnv *eP=0);
 int       Unlink(const char *, int Opts=0, XrdOucEnv *eP=0);
 
@@ -192,8 +204,10 @@ char  *getDomain(const char *hName);
 int    xconf(XrdSysError *Eroute, XrdOucStream &Config);
 int    xdef( XrdSysError *Eroute, XrdOucStream &Config);
 int    xdca( XrdSysError *errp,   XrdOucStream &Config);
+int    xmdc( XrdSysError *errp,   XrdOucStream &Config);
 int    xexp( XrdSysError *Eroute, XrdOucStream &Config);
 int    xperm(XrdSysError *errp,   XrdOucStream &Config);
 int    xorig(XrdSysError *errp,   XrdOucStream &Config);
+int    xstr( XrdSysError *errp,   XrdOucStream &Config);
 };
 #endif
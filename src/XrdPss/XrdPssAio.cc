@@ -51,6 +51,14 @@
 int XrdPssFile::Fsync(XrdSfsAio *aiop)
 {
 
+// Streamed files are synced synchronously as buffered data must go out first
+//
+   if (myStream)
+      {aiop->Result = Fsync();
+       aiop->doneWrite();
+       return 0;
+      }
+
 // Execute this request in an asynchronous fashion
 //
    XrdPosixXrootd::Fsync(fd, XrdPssAioCB::Alloc(aiop, true));
@@ -75,6 +83,16 @@ int XrdPssFile::Fsync(XrdSfsAio *aiop)
 int XrdPssFile::Read(XrdSfsAio *aiop)
 {
 
+// Streamed files are read through the stream so that readahead is used
+//
+   if (myStream)
+      {aiop->Result = Read((void *)aiop->sfsAio.aio_buf,
+                           (off_t)aiop->sfsAio.aio_offset,
+                           (size_t)aiop->sfsAio.aio_nbytes);
+       aiop->doneRead();
+       return 0;
+      }
+
 // Execute this request in an asynchronous fashion
 //
    XrdPosixXrootd::Pread(fd, (void *)aiop->sfsAio.aio_buf,
@@ -102,6 +120,16 @@ int XrdPssFile::Read(XrdSfsAio *aiop)
 int XrdPssFile::Write(XrdSfsAio *aiop)
 {
 
+// Streamed files are written through the stream which gathers small writes
+//
+   if (myStream)
+      {aiop->Result = Write((const void *)aiop->sfsAio.aio_buf,
+                            (off_t)aiop->sfsAio.aio_offset,
+                            (size_t)aiop->sfsAio.aio_nbytes);
+       aiop->doneWrite();
+       return 0;
+      }
+
 // Execute this request in an asynchronous fashion
 //
    XrdPosixXrootd::Pwrite(fd, (const void *)aiop->sfsAio.aio_buf,
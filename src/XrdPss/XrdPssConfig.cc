@@ -119,6 +119,8 @@ extern XrdOucSid       *sidP;
 
 extern XrdSysTrace      SysTrace;
 
+extern XrdPssMetaCache  mdCache;
+
 static const int maxHLen = 1024;
 }
 
@@ -222,6 +224,13 @@ int XrdPssSys::Configure(const char *cfn)
        XrdOucEnv::Export("XRDXROOTD_CACHERDRDR", buff);
       }
 
+// Readahead and write-behind only make sense when we go directly to the origin
+//
+   if (XrdPssStream::Enabled() && (psxConfig->theCache || psxConfig->theCache2))
+      {eDest.Say("Config warning: ignoring stream directive; a cache is in use.");
+       XrdPssStream::setParms(0, 0, 0);
+      }
+
 // All done with the configurator
 //
    delete psxConfig;
@@ -352,9 +361,11 @@ int XrdPssSys::ConfigXeq(char *var, XrdOucStream &Config)
    TS_DBG("debug",         TRACEPSS_Debug);
    TS_Xeq("export",        xexp);
    TS_PSX("inetmode",      ParseINet);
+   TS_Xeq("mdcache",       xmdc);
    TS_Xeq("origin",        xorig);
    TS_Xeq("permit",        xperm);
    TS_PSX("setopt",        ParseSet);
+   TS_Xeq("stream",        xstr);
    TS_PSX("trace",         ParseTrace);
 
    // Copy the variable name as this may change because it points to an
@@ -558,6 +569,82 @@ int XrdPssSys::xexp(XrdSysError *Eroute, XrdOucStream &Config)
    return 0;
 }
 
+/******************************************************************************/
+/*                                  x m d c                                   */
+/******************************************************************************/
+
+/* Function: xmdc
+
+   Purpose:  To parse the directive: mdcache {off | <opts>}
+
+             <opts>: [entries <n>] [ttl <tm>] [negttl <tm>] [dirmax <n>]
+
+             off       do not cache metadata (the default).
+             entries   the maximum number of paths to cache, default 65536.
+             ttl       how long stat results and listings are kept, default 60s.
+             negttl    how long ENOENT results are kept, default 10s.
+             dirmax    the maximum number of entries of a cached directory
+                       listing, default 4096. Zero disables caching listings.
+
+   Output: 0 upon success or 1 upon failure.
+*/
+
+int XrdPssSys::xmdc(XrdSysError *errp, XrdOucStream &Config)
+{
+    static const int maxsz = 0x7fffffff;
+    char *val;
+    int ents = 65536, ttl = 60, nttl = 10, dmax = 4096;
+
+// Check for "off"
+//
+    if ((val = Config.GetWord()) && !strcmp(val, "off"))
+       {mdCache.setParms(0, ttl, nttl, dmax); return 0;}
+
+// Process the options
+//
+    while(val)
+         {     if (!strcmp(val, "entries"))
+                  {if (!(val = Config.GetWord()))
+                      {errp->Emsg("Config","mdcache entries not specified");
+                       return 1;
+                      }
+                   if (XrdOuca2x::a2i(*errp,"mdcache entries",val,&ents,1,maxsz))
+                      return 1;
+                  }
+          else if (!strcmp(val, "ttl"))
+                  {if (!(val = Config.GetWord()))
+                      {errp->Emsg("Config","mdcache ttl not specified");
+                       return 1;
+                      }
+                   if (XrdOuca2x::a2tm(*errp,"mdcache ttl",val,&ttl,1,maxsz))
+                      return 1;
+                  }
+          else if (!strcmp(val, "negttl"))
+                  {if (!(val = Config.GetWord()))
+                      {errp->Emsg("Config","mdcache negttl not specified");
+                       return 1;
+                      }
+                   if (XrdOuca2x::a2tm(*errp,"mdcache negttl",val,&nttl,0,maxsz))
+                      return 1;
+                  }
+          else if (!strcmp(val, "dirmax"))
+                  {if (!(val = Config.GetWord()))
+                      {errp->Emsg("Config","mdcache dirmax not specified");
+                       return 1;
+                      }
+                   if (XrdOuca2x::a2i(*errp,"mdcache dirmax",val,&dmax,0,maxsz))
+                      return 1;
+                  }
+          else {errp->Emsg("Config","invalid mdcache option -", val); return 1;}
+          val = Config.GetWord();
+         }
+
+// Set the values
+//
+   mdCache.setParms(ents, ttl, nttl, dmax);
+   return 0;
+}
+  
 /******************************************************************************/
 /*                                 x o r i g                                  */
 /******************************************************************************/
@@ -712,3 +799,73 @@ do {if (!(val = Config.GetWord()))
 
     return 0;
 }
+  
+/******************************************************************************/
+/*                                  x s t r                                   */
+/******************************************************************************/
+
+/* Function: xstr
+
+   Purpose:  To parse the directive: stream {off | <opts>}
+
+             <opts>: [rdahead <sz>] [wrbehind <sz>] [maxmem <sz>]
+
+             off       do not stream files (the default).
+             rdahead   the size of each readahead window, default 1m. Zero
+                       disables readahead.
+             wrbehind  the size of the buffer gathering writes, default 1m.
+                       Zero disables write-behind.
+             maxmem    the maximum amount of memory used for buffers by all
+                       files, default 256m.
+
+   Output: 0 upon success or 1 upon failure.
+*/
+
+int XrdPssSys::xstr(XrdSysError *errp, XrdOucStream &Config)
+{
+    static const long long maxsz = 0x40000000LL;
+    char *val;
+    long long rdsz = 1048576, wrsz = 1048576, maxmem = 256*1048576LL;
+
+// Check for "off"
+//
+    if ((val = Config.GetWord()) && !strcmp(val, "off"))
+       {XrdPssStream::setParms(0, 0, 0); return 0;}
+
+// Process the options
+//
+    while(val)
+         {     if (!strcmp(val, "rdahead"))
+                  {if (!(val = Config.GetWord()))
+                      {errp->Emsg("Config","stream rdahead not specified");
+                       return 1;
+                      }
+                   if (XrdOuca2x::a2sz(*errp,"stream rdahead",val,&rdsz,0,maxsz))
+                      return 1;
+                  }
+          else if (!strcmp(val, "wrbehind"))
+                  {if (!(val = Config.GetWord()))
+                      {errp->Emsg("Config","stream wrbehind not specified");
+                       return 1;
+                      }
+                   if (XrdOuca2x::a2sz(*errp,"stream wrbehind",val,&wrsz,0,maxsz))
+                      return 1;
+                  }
+          else if (!strcmp(val, "maxmem"))
+                  {if (!(val = Config.GetWord()))
+                      {errp->Emsg("Config","stream maxmem not specified");
+                       return 1;
+                      }
+                   if (XrdOuca2x::a2sz(*errp,"stream maxmem",val,&maxmem,1))
+                      return 1;
+                  }
+          else {errp->Emsg("Config","invalid stream option -", val); return 1;}
+          val = Config.GetWord();
+         }
+
+// Set the values
+//
+   XrdPssStream::setParms(static_cast<int>(rdsz), static_cast<int>(wrsz),
+                          maxmem);
+   return 0;
+}
@@ -0,0 +1,308 @@
+/******************************************************************************/
+/*                                                                            */
+/*                    X r d P s s M e t a C a c h e . c c                     */
+/*                                                                            */
+/* This file is part of the XRootD software suite.                            */
+/*                                                                            */
+/* XRootD is free software: you can redistribute it and/or modify it under    */
+/* the terms of the GNU Lesser General Public License as published by the     */
+/* Free Software Foundation, either version 3 of the License, or (at your     */
+/* option) any later version.                                                 */
+/*                                                                            */
+/* XRootD is distributed in the hope that it will be useful, but WITHOUT      */
+/* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or      */
+/* FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public       */
+/* License for more details.                                                  */
+/*                                                                            */
+/* You should have received a copy of the GNU Lesser General Public License   */
+/* along with XRootD in a file called COPYING.LESSER (LGPL license) and file  */
+/* COPYING (GPL license).  If not, see <http://www.gnu.org/licenses/>.        */
+/*                                                                            */
+/* The copyright holder's institutional names and contributor's names may not */
+/* be used to endorse or promote products derived from this software without  */
+/* specific prior written permission of the institution or contributor.       */
+/******************************************************************************/
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "XrdPss/XrdPssMetaCache.hh"
+
+/******************************************************************************/
+/*                                G e t D i r                                 */
+/******************************************************************************/
+
+bool XrdPssMetaCache::GetDir(const char *path, const std::string &user,
+                             DirList &list, int &rc)
+{
+   XrdSysMutexHelper mHelp(mcMutex);
+   Entry *eP = Get(path, user, false);
+   time_t now = time(0);
+
+// A listing or a failed stat of the path will do
+//
+   if (eP)
+      {if (eP->dirExp > now)
+          {Touch(eP); list = eP->dList; rc = 0; dirHits++; return true;}
+       if (eP->statExp > now && eP->statRC)
+          {Touch(eP); rc = eP->statRC; negHits++; return true;}
+      }
+   dirMisses++;
+   return false;
+}
+
+/******************************************************************************/
+/*                                G e t N e g                                 */
+/******************************************************************************/
+
+bool XrdPssMetaCache::GetNeg(const char *path, const std::string &user,
+                             int &rc)
+{
+   XrdSysMutexHelper mHelp(mcMutex);
+   Entry *eP = Get(path, user, false);
+
+   if (eP && eP->statExp > time(0) && eP->statRC)
+      {Touch(eP); rc = eP->statRC; negHits++; return true;}
+   return false;
+}
+
+/******************************************************************************/
+/*                               G e t S t a t                                */
+/******************************************************************************/
+
+bool XrdPssMetaCache::GetStat(const char *path, const std::string &user,
+                              struct stat &buff, int &rc)
+{
+   XrdSysMutexHelper mHelp(mcMutex);
+   Entry *eP = Get(path, user, false);
+
+   if (eP && eP->statExp > time(0))
+      {Touch(eP);
+       if (!(rc = eP->statRC)) {buff = eP->statBuff; Hits++;}
+          else negHits++;
+       return true;
+      }
+   Misses++;
+   return false;
+}
+
+/******************************************************************************/
+/*                            I n v a l i d a t e                             */
+/******************************************************************************/
+
+void XrdPssMetaCache::Invalidate(const char *path, bool tree)
+{
+   XrdSysMutexHelper mHelp(mcMutex);
+   std::string cPath = Canon(path);
+   std::string::size_type slash;
+   PathMap::iterator it;
+
+// Drop the path itself
+//
+   DropAll(cPath);
+
+// Drop everything below the path if it was renamed or removed as a directory
+//
+   if (tree && cPath != "/")
+      {std::string pfx = cPath + '/';
+       while((it = pathMap.lower_bound(pfx)) != pathMap.end()
+       &&    !it->first.compare(0, pfx.size(), pfx))
+            {Drop(it->second); Invals++;}
+      }
+
+// Drop the parent directory as its listing and times have changed. The root
+// is the parent of a top-level path.
+//
+   if ((slash = cPath.rfind('/')) != std::string::npos && cPath != "/")
+      DropAll(slash ? cPath.substr(0, slash) : std::string("/"));
+}
+
+/******************************************************************************/
+/*                                P u t D i r                                 */
+/******************************************************************************/
+
+void XrdPssMetaCache::PutDir(const char *path, const std::string &user,
+                             const std::vector<std::string> *list)
+{
+   XrdSysMutexHelper mHelp(mcMutex);
+   Entry *eP = Get(path, user, true);
+
+   eP->dList.reset(list);
+   eP->dirExp = time(0) + posTTL;
+}
+
+/******************************************************************************/
+/*                               P u t S t a t                                */
+/******************************************************************************/
+
+void XrdPssMetaCache::PutStat(const char *path, const std::string &user,
+                              const struct stat *buff, int rc)
+{
+   Entry *eP;
+
+// We only remember that a path does not exist; other errors may be transient
+// or particular to the client.
+//
+   if (rc && rc != -ENOENT) return;
+
+// Record the result
+//
+   XrdSysMutexHelper mHelp(mcMutex);
+   eP = Get(path, user, true);
+   eP->statRC  = rc;
+   eP->statExp = time(0) + (rc ? negTTL : posTTL);
+   if (!rc) eP->statBuff = *buff;
+      else {eP->dList.reset(); eP->dirExp = 0;}
+}
+
+/******************************************************************************/
+/*                                 S t a t s                                  */
+/******************************************************************************/
+
+int XrdPssMetaCache::Stats(char *buff, int blen)
+{
+   static const char statfmt[] = "<mdc><num>%d</num><hits>%lld</hits>"
+          "<miss>%lld</miss><nhits>%lld</nhits><dhits>%lld</dhits>"
+          "<dmiss>%lld</dmiss><inval>%lld</inval><evict>%lld</evict></mdc>";
+   static const int  statflen = sizeof(statfmt) + 10 + 7*20;
+   int n;
+
+// If only size wanted, return what size we need
+//
+   if (!buff) return statflen;
+   if (blen < statflen) return 0;
+
+// Format the statistics
+//
+   mcMutex.Lock();
+   n = snprintf(buff, blen, statfmt, static_cast<int>(mcMap.size()), Hits,
+                Misses, negHits, dirHits, dirMisses, Invals, Evicts);
+   mcMutex.UnLock();
+   return n;
+}
+
+/******************************************************************************/
+/*                       P r i v a t e   M e t h o d s                        */
+/******************************************************************************/
+/******************************************************************************/
+/*                                 C a n o n                                  */
+/******************************************************************************/
+
+// Return the path without trailing slashes so that "/a/" and "/a" are the
+// same entry; the root remains "/".
+
+std::string XrdPssMetaCache::Canon(const char *path)
+{
+   std::string cPath(path);
+   std::string::size_type n = cPath.find_last_not_of('/');
+
+   if (n == std::string::npos) return (cPath.empty() ? cPath : "/");
+   cPath.erase(n+1);
+   return cPath;
+}
+
+/******************************************************************************/
+/*                                  D r o p                                   */
+/******************************************************************************/
+
+void XrdPssMetaCache::Drop(Entry *eP)
+{
+   std::pair<PathMap::iterator, PathMap::iterator> pRange;
+
+   if (eP->prev) eP->prev->next = eP->next;
+      else lruHead = eP->next;
+   if (eP->next) eP->next->prev = eP->prev;
+      else lruTail = eP->prev;
+   mcMap.erase(eP->key);
+   pRange = pathMap.equal_range(eP->path);
+   for (PathMap::iterator it = pRange.first; it != pRange.second; ++it)
+       if (it->second == eP) {pathMap.erase(it); break;}
+   delete eP;
+}
+
+/******************************************************************************/
+/*                               D r o p A l l                                */
+/******************************************************************************/
+
+// Drop the entries of every user for path. The caller must hold the mcMutex.
+
+void XrdPssMetaCache::DropAll(const std::string &path)
+{
+   PathMap::iterator it;
+
+   while((it = pathMap.find(path)) != pathMap.end())
+        {Drop(it->second); Invals++;}
+}
+
+/******************************************************************************/
+/*                                   G e t                                    */
+/******************************************************************************/
+
+// Find the entry for path and user, optionally adding it (evicting the least
+// recently used entry if we are full). The caller must hold the mcMutex.
+
+XrdPssMetaCache::Entry *XrdPssMetaCache::Get(const char *path,
+                                             const std::string &user,
+                                             bool addit)
+{
+   std::string cPath = Canon(path), key(cPath);
+   EntryMap::iterator it;
+   Entry *eP;
+
+// Paths never contain a null byte, so it separates the path from the user
+//
+   key += '\0'; key += user;
+   it = mcMap.find(key);
+
+// Return the entry if we have it
+//
+   if (it != mcMap.end())
+      {if (addit) Touch(it->second);
+       return it->second;
+      }
+   if (!addit) return 0;
+
+// Make room, if need be
+//
+   while(lruTail && static_cast<int>(mcMap.size()) >= maxEnt)
+        {Drop(lruTail); Evicts++;}
+
+// Add a new entry at the head of the list
+//
+   eP = new Entry;
+   eP->key     = key;
+   eP->path    = cPath;
+   eP->statExp = eP->dirExp = 0;
+   eP->statRC  = 0;
+   eP->prev    = 0;
+   eP->next    = lruHead;
+   if (lruHead) lruHead->prev = eP;
+      else lruTail = eP;
+   lruHead = eP;
+   mcMap[eP->key] = eP;
+   pathMap.insert(PathMap::value_type(eP->path, eP));
+   return eP;
+}
+
+/******************************************************************************/
+/*                                 T o u c h                                  */
+/******************************************************************************/
+
+void XrdPssMetaCache::Touch(Entry *eP)
+{
+   if (eP == lruHead) return;
+
+// Unlink the entry
+//
+   eP->prev->next = eP->next;
+   if (eP->next) eP->next->prev = eP->prev;
+      else lruTail = eP->prev;
+
+// Put it at the front
+//
+   eP->prev = 0;
+   eP->next = lruHead;
+   lruHead->prev = eP;
+   lruHead = eP;
+}
@@ -0,0 +1,145 @@
+#ifndef _XRDPSS_METACACHE_H
+#define _XRDPSS_METACACHE_H
+/******************************************************************************/
+/*                                                                            */
+/*                    X r d P s s M e t a C a c h e . h h                     */
+/*                                                                            */
+/* This file is part of the XRootD software suite.                            */
+/*                                                                            */
+/* XRootD is free software: you can redistribute it and/or modify it under    */
+/* the terms of the GNU Lesser General Public License as published by the     */
+/* Free Software Foundation, either version 3 of the License, or (at your     */
+/* option) any later version.                                                 */
+/*                                                                            */
+/* XRootD is distributed in the hope that it will be useful, but WITHOUT      */
+/* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or      */
+/* FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public       */
+/* License for more details.                                                  */
+/*                                                                            */
+/* You should have received a copy of the GNU Lesser General Public License   */
+/* along with XRootD in a file called COPYING.LESSER (LGPL license) and file  */
+/* COPYING (GPL license).  If not, see <http://www.gnu.org/licenses/>.        */
+/*                                                                            */
+/* The copyright holder's institutional names and contributor's names may not */
+/* be used to endorse or promote products derived from this software without  */
+/* specific prior written permission of the institution or contributor.       */
+/******************************************************************************/
+
+#include <memory>
+#include <string>
+#include <map>
+#include <unordered_map>
+#include <vector>
+#include <time.h>
+#include <sys/stat.h>
+
+#include "XrdSys/XrdSysPthread.hh"
+
+// The XrdPssMetaCache object holds the results of recent stat, opendir and
+// open requests sent to the origin so that repeated requests for the same path
+// are answered locally. Successful results are kept for the ttl and ENOENT
+// failures for the negative ttl. The number of paths is bounded and the least
+// recently used ones are evicted. Anything changed through this proxy is
+// invalidated, for all clients, along with the listing of its parent
+// directory. As the origin may authorize each client differently, entries
+// are keyed by path and by the identity (user) the request was made with.
+//
+class XrdPssMetaCache
+{
+public:
+
+typedef std::shared_ptr<const std::vector<std::string> > DirList;
+
+// GetDir() returns true if the listing of path is cached and sets list or, for
+//          a cached failure, rc (a -errno).
+//
+bool    GetDir(const char *path, const std::string &user, DirList &list,
+               int &rc);
+
+// GetNeg() returns true if path is known not to exist and sets rc.
+//
+bool    GetNeg(const char *path, const std::string &user, int &rc);
+
+// GetStat() returns true if the stat of path is cached and sets rc to zero,
+//           filling out buff, or to the cached -errno.
+//
+bool    GetStat(const char *path, const std::string &user, struct stat &buff,
+                int &rc);
+
+// Invalidate() drops whatever any user knows about path and its parent
+//              directory. When tree is true (rename or directory removal),
+//              everything known about the paths below path is dropped too.
+//
+void    Invalidate(const char *path, bool tree=false);
+
+// PutDir() records the complete listing of path.
+//
+void    PutDir(const char *path, const std::string &user,
+               const std::vector<std::string> *list);
+
+// PutStat() records the result of a stat (rc == 0) or of a failed request
+//           (rc is a -errno). Only ENOENT failures are cached.
+//
+void    PutStat(const char *path, const std::string &user,
+                const struct stat *buff, int rc);
+
+// Stats() reports the cache statistics in the oss summary stats format.
+//
+int     Stats(char *buff, int blen);
+
+bool    Enabled() {return maxEnt > 0;}
+
+int     DirMax() {return dirMax;}
+
+void    setParms(int ents, int ttl, int nttl, int dmax)
+                {maxEnt = ents; posTTL = ttl; negTTL = nttl; dirMax = dmax;}
+
+        XrdPssMetaCache() : lruHead(0), lruTail(0), maxEnt(0), posTTL(60),
+                            negTTL(10), dirMax(4096), Hits(0), Misses(0),
+                            negHits(0), dirHits(0), dirMisses(0), Invals(0),
+                            Evicts(0) {}
+       ~XrdPssMetaCache() {} // Never gets deleted
+
+private:
+
+struct Entry
+      {Entry       *prev;
+       Entry       *next;
+       std::string  key;       // Path and user
+       std::string  path;
+       DirList      dList;
+       time_t       statExp;   // Zero if the stat result is not valid
+       time_t       dirExp;    // Zero if the listing is not valid
+       int          statRC;
+       struct stat  statBuff;
+      };
+
+static
+std::string Canon(const char *path);
+Entry  *Get(const char *path, const std::string &user, bool addit);
+void    DropAll(const std::string &path);
+void    Drop(Entry *eP);
+void    Touch(Entry *eP);
+
+typedef std::unordered_map<std::string, Entry *> EntryMap;
+typedef std::multimap<std::string, Entry *> PathMap;
+
+XrdSysMutex  mcMutex;
+EntryMap     mcMap;    // Keyed by path and user
+PathMap      pathMap;  // Keyed by path alone, ordered to find subtrees
+Entry       *lruHead;  // Most recently used
+Entry       *lruTail;  // Least recently used
+int          maxEnt;
+int          posTTL;
+int          negTTL;
+int          dirMax;
+
+long long    Hits;
+long long    Misses;
+long long    negHits;
+long long    dirHits;
+long long    dirMisses;
+long long    Invals;
+long long    Evicts;
+};
+#endif
@@ -0,0 +1,404 @@
+/******************************************************************************/
+/*                                                                            */
+/*                       X r d P s s S t r e a m . c c                        */
+/*                                                                            */
+/* This file is part of the XRootD software suite.                            */
+/*                                                                            */
+/* XRootD is free software: you can redistribute it and/or modify it under    */
+/* the terms of the GNU Lesser General Public License as published by the     */
+/* Free Software Foundation, either version 3 of the License, or (at your     */
+/* option) any later version.                                                 */
+/*                                                                            */
+/* XRootD is distributed in the hope that it will be useful, but WITHOUT      */
+/* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or      */
+/* FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public       */
+/* License for more details.                                                  */
+/*                                                                            */
+/* You should have received a copy of the GNU Lesser General Public License   */
+/* along with XRootD in a file called COPYING.LESSER (LGPL license) and file  */
+/* COPYING (GPL license).  If not, see <http://www.gnu.org/licenses/>.        */
+/*                                                                            */
+/* The copyright holder's institutional names and contributor's names may not */
+/* be used to endorse or promote products derived from this software without  */
+/* specific prior written permission of the institution or contributor.       */
+/******************************************************************************/
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "XrdPosix/XrdPosixCallBack.hh"
+#include "XrdPosix/XrdPosixXrootd.hh"
+#include "XrdPss/XrdPssStream.hh"
+
+/******************************************************************************/
+/*                               G l o b a l s                                */
+/******************************************************************************/
+
+XrdSysMutex XrdPssStream::memMutex;
+long long   XrdPssStream::memUsed = 0;
+long long   XrdPssStream::memMax  = 256*1024*1024LL;
+int         XrdPssStream::rdSize  = 0;
+int         XrdPssStream::wrSize  = 0;
+
+/******************************************************************************/
+/*                         L o c a l   C l a s s e s                          */
+/******************************************************************************/
+
+// The IOCB object is the callback for an asynchronous readahead (bP is set) or
+// write (wbP is set).
+//
+class XrdPssStream::IOCB : public XrdPosixCallBackIO
+{
+public:
+
+void     Complete(ssize_t result)
+                 {sP->Done(bP, wbP, (result >= 0 && result < wLen
+                                     ? -1 : result), (result < 0 ? errno : EIO));
+                  delete this;
+                 }
+
+         IOCB(XrdPssStream *sp, Block *bp, char *wbp=0, int wlen=0)
+             : sP(sp), bP(bp), wbP(wbp), wLen(wlen) {}
+        ~IOCB() {}
+
+private:
+
+XrdPssStream *sP;
+Block        *bP;
+char         *wbP;
+int           wLen;
+};
+
+/******************************************************************************/
+/*                           C o n s t r u c t o r                            */
+/******************************************************************************/
+
+XrdPssStream::XrdPssStream(int fd, bool isRW)
+             : sCond(0), rNext(0), rSeq(0), rPend(0), wBuff(0), wOffset(0),
+               wLen(0), wNext(-1), wPend(0), wErr(0), fileFD(fd),
+               isWrite(isRW)
+{
+   memset(rBlock, 0, sizeof(rBlock));
+}
+
+/******************************************************************************/
+/*                            D e s t r u c t o r                             */
+/******************************************************************************/
+
+XrdPssStream::~XrdPssStream()
+{
+   for (int i = 0; i < rdNum; i++)
+       if (rBlock[i].buff) RetBuff(rBlock[i].buff, rdSize);
+   if (wBuff) RetBuff(wBuff, wrSize);
+}
+
+/******************************************************************************/
+/*                                 A l l o c                                  */
+/******************************************************************************/
+
+XrdPssStream *XrdPssStream::Alloc(int fd, bool isRW)
+{
+   if (isRW ? wrSize <= 0 : rdSize <= 0) return 0;
+   return new XrdPssStream(fd, isRW);
+}
+
+/******************************************************************************/
+/*                                 C l o s e                                  */
+/******************************************************************************/
+
+int XrdPssStream::Close()
+{
+   int rc = Flush();
+
+// Wait for any readahead to complete as it refers to us
+//
+   sCond.Lock();
+   while(rPend) sCond.Wait();
+   Release(-1);
+   sCond.UnLock();
+   return rc;
+}
+
+/******************************************************************************/
+/*                                 F l u s h                                  */
+/******************************************************************************/
+
+int XrdPssStream::Flush()
+{
+   int rc;
+
+   sCond.Lock();
+   if (wLen) WriteOut();
+   Drain();
+   rc = wErr; wErr = 0;
+   sCond.UnLock();
+   return rc;
+}
+
+/******************************************************************************/
+/*                                  R e a d                                   */
+/******************************************************************************/
+
+ssize_t XrdPssStream::Read(void *buff, off_t offset, size_t blen)
+{
+   char   *bp = (char *)buff;
+   ssize_t retval, got = 0;
+   size_t  n;
+   bool    atEOF = false;
+   int     i;
+
+// Writers must see what they wrote
+//
+   if (isWrite)
+      {if ((retval = Flush())) return retval;
+       retval = XrdPosixXrootd::Pread(fileFD, buff, blen, offset);
+       return (retval < 0 ? (ssize_t)-errno : retval);
+      }
+
+// Track sequential access
+//
+   sCond.Lock();
+   if (offset == rNext) rSeq++;
+      else rSeq = 0;
+   rNext = offset + blen;
+
+// Copy whatever part of the request we have read ahead
+//
+   while(blen)
+        {for (i = 0; i < rdNum; i++)
+             if (rBlock[i].state != isIdle && offset >= rBlock[i].offset
+             &&  offset < rBlock[i].offset + rdSize) break;
+         if (i >= rdNum) break;
+         Block &blk = rBlock[i];
+         if (blk.state == isPending) {sCond.Wait(); continue;}
+         if (blk.state != isReady) break;
+         if (offset >= blk.offset + blk.dlen) {atEOF = true; break;}
+         n = blk.offset + blk.dlen - offset;
+         if (n > blen) n = blen;
+         memcpy(bp, blk.buff + (offset - blk.offset), n);
+         bp += n; offset += n; blen -= n; got += n;
+         if (blk.dlen < rdSize && offset >= blk.offset + blk.dlen) atEOF = true;
+        }
+
+// Drop the windows we are done with and read further ahead if this is a
+// sequential stream
+//
+   Release(rNext);
+   if (rSeq >= seqMin && !atEOF) Ahead();
+   sCond.UnLock();
+
+// Read whatever is left directly
+//
+   if (blen && !atEOF)
+      {if ((retval = XrdPosixXrootd::Pread(fileFD, bp, blen, offset)) < 0)
+          return (got ? got : (ssize_t)-errno);
+       got += retval;
+      }
+   return got;
+}
+
+/******************************************************************************/
+/*                                 W r i t e                                  */
+/******************************************************************************/
+
+ssize_t XrdPssStream::Write(const void *buff, off_t offset, size_t blen)
+{
+   ssize_t retval;
+
+// Readers don't buffer writes
+//
+   if (!isWrite)
+      {retval = XrdPosixXrootd::Pwrite(fileFD, buff, blen, offset);
+       return (retval < 0 ? (ssize_t)-errno : retval);
+      }
+
+// Report any previous failure
+//
+   sCond.Lock();
+   if (wErr) {retval = wErr; wErr = 0; sCond.UnLock(); return retval;}
+
+// Add the data to the buffer if it follows the data we already have
+//
+   if (wLen && offset == wOffset + wLen && wLen + blen <= (size_t)wrSize)
+      {memcpy(wBuff+wLen, buff, blen);
+       wLen += blen;
+       sCond.UnLock();
+       return blen;
+      }
+
+// Write out what we have and start a new buffer if the data is small enough
+// and we have the memory for it.
+//
+   if (wLen) WriteOut();
+   if (blen < (size_t)wrSize && (wBuff || (wBuff = GetBuff(wrSize))))
+      {memcpy(wBuff, buff, blen);
+       wOffset = offset; wLen = blen;
+       sCond.UnLock();
+       return blen;
+      }
+
+// Write the data directly once all previous writes are done. The write counts
+// as pending so that Drain() and WriteOut() order themselves against it.
+//
+   Drain();
+   if (wErr) {retval = wErr; wErr = 0; sCond.UnLock(); return retval;}
+   wNext = offset + blen;
+   wPend++;
+   sCond.UnLock();
+   retval = XrdPosixXrootd::Pwrite(fileFD, buff, blen, offset);
+   if (retval < 0) retval = -errno;
+   sCond.Lock();
+   wPend--;
+   sCond.Broadcast();
+   sCond.UnLock();
+   return retval;
+}
+
+/******************************************************************************/
+/*                       P r i v a t e   M e t h o d s                        */
+/******************************************************************************/
+/******************************************************************************/
+/*                                 A h e a d                                  */
+/******************************************************************************/
+
+// Start reading the windows following the data we have. Called with the
+// sCond lock held which is released while the reads are issued.
+
+void XrdPssStream::Ahead()
+{
+   off_t nextOff = rNext, maxOff = rNext + (off_t)rdNum*rdSize;
+   int i;
+
+// Find the end of the windows we have, stopping if we already hit the end
+//
+   for (i = 0; i < rdNum; i++)
+       if (rBlock[i].state != isIdle)
+          {if (rBlock[i].state == isReady && rBlock[i].dlen < rdSize) return;
+           if (rBlock[i].offset + rdSize > nextOff)
+              nextOff = rBlock[i].offset + rdSize;
+          }
+
+// Read the following windows into any free blocks
+//
+   for (i = 0; i < rdNum && nextOff < maxOff; i++)
+       {Block &blk = rBlock[i];
+        if (blk.state != isIdle) continue;
+        if (!(blk.buff = GetBuff(rdSize))) return;
+        blk.offset = nextOff; blk.dlen = 0; blk.state = isPending;
+        nextOff += rdSize;
+        rPend++;
+        sCond.UnLock();
+        XrdPosixXrootd::Pread(fileFD, blk.buff, rdSize, blk.offset,
+                              new IOCB(this, &blk));
+        sCond.Lock();
+       }
+}
+
+/******************************************************************************/
+/*                                  D o n e                                   */
+/******************************************************************************/
+
+void XrdPssStream::Done(Block *bP, char *wbP, ssize_t result, int eNum)
+{
+   sCond.Lock();
+   if (bP)
+      {if (result < 0) bP->state = isFailed;
+          else {bP->dlen = result; bP->state = isReady;}
+       rPend--;
+      } else {
+       RetBuff(wbP, wrSize);
+       if (result < 0 && !wErr) wErr = -eNum;
+       wPend--;
+      }
+   sCond.Broadcast();
+   sCond.UnLock();
+}
+
+/******************************************************************************/
+/*                                 D r a i n                                  */
+/******************************************************************************/
+
+// Wait for all outstanding writes. Called with the sCond lock held.
+
+void XrdPssStream::Drain()
+{
+   while(wPend) sCond.Wait();
+}
+
+/******************************************************************************/
+/*                               G e t B u f f                                */
+/******************************************************************************/
+
+char *XrdPssStream::GetBuff(int bsz)
+{
+   char *bp = 0;
+
+   memMutex.Lock();
+   if (memUsed + bsz <= memMax && (bp = (char *)malloc(bsz))) memUsed += bsz;
+   memMutex.UnLock();
+   return bp;
+}
+
+/******************************************************************************/
+/*                               R e l e a s e                                */
+/******************************************************************************/
+
+// Free the windows that are behind the offset or too far ahead of it to be of
+// use; a negative offset frees all of them. Called with the sCond lock held.
+
+void XrdPssStream::Release(off_t offset)
+{
+   for (int i = 0; i < rdNum; i++)
+       {Block &blk = rBlock[i];
+        if (blk.state == isIdle || blk.state == isPending) continue;
+        if (offset < 0 || blk.state == isFailed
+        ||  blk.offset + rdSize <= offset
+        ||  blk.offset >= offset + (off_t)rdNum*rdSize)
+           {RetBuff(blk.buff, rdSize);
+            blk.buff = 0; blk.state = isIdle;
+           }
+       }
+}
+
+/******************************************************************************/
+/*                               R e t B u f f                                */
+/******************************************************************************/
+
+void XrdPssStream::RetBuff(char *bp, int bsz)
+{
+   free(bp);
+   memMutex.Lock();
+   memUsed -= bsz;
+   memMutex.UnLock();
+}
+
+/******************************************************************************/
+/*                              W r i t e O u t                               */
+/******************************************************************************/
+
+// Asynchronously write the buffer. Writes that do not follow the previous one
+// are only issued after the previous writes are done so that overlapping data
+// is written in order. Called with the sCond lock held which is released
+// while the write is issued.
+
+void XrdPssStream::WriteOut()
+{
+   char *bp;
+   off_t offset;
+   int blen;
+
+// Wait for a free slot
+//
+   while(wPend >= wrMax || (wPend && wOffset != wNext)) sCond.Wait();
+
+// Issue the write
+//
+   bp = wBuff; offset = wOffset; blen = wLen;
+   wBuff = 0; wLen = 0;
+   wNext = offset + blen;
+   wPend++;
+   sCond.UnLock();
+   XrdPosixXrootd::Pwrite(fileFD, bp, blen, offset, new IOCB(this,0,bp,blen));
+   sCond.Lock();
+}
@@ -0,0 +1,119 @@
+#ifndef _XRDPSS_STREAM_H
+#define _XRDPSS_STREAM_H
+/******************************************************************************/
+/*                                                                            */
+/*                       X r d P s s S t r e a m . h h                        */
+/*                                                                            */
+/* This file is part of the XRootD software suite.                            */
+/*                                                                            */
+/* XRootD is free software: you can redistribute it and/or modify it under    */
+/* the terms of the GNU Lesser General Public License as published by the     */
+/* Free Software Foundation, either version 3 of the License, or (at your     */
+/* option) any later version.                                                 */
+/*                                                                            */
+/* XRootD is distributed in the hope that it will be useful, but WITHOUT      */
+/* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or      */
+/* FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public       */
+/* License for more details.                                                  */
+/*                                                                            */
+/* You should have received a copy of the GNU Lesser General Public License   */
+/* along with XRootD in a file called COPYING.LESSER (LGPL license) and file  */
+/* COPYING (GPL license).  If not, see <http://www.gnu.org/licenses/>.        */
+/*                                                                            */
+/* The copyright holder's institutional names and contributor's names may not */
+/* be used to endorse or promote products derived from this software without  */
+/* specific prior written permission of the institution or contributor.       */
+/******************************************************************************/
+
+#include <sys/types.h>
+
+#include "XrdSys/XrdSysPthread.hh"
+
+// The XrdPssStream object speeds up sequential access to a proxied file when
+// no cache is in use. For files opened for reading, once a few sequential reads
+// are seen the next windows of the file are read asynchronously so that they
+// are at hand when the client asks for them. For files opened for writing,
+// small sequential writes are gathered into large buffers that are written
+// asynchronously; they are all written out before a read, sync or close. As
+// writes complete after the client was told they succeeded, a failed write is
+// reported by the next write, sync or close. All buffers come from a pool of
+// memory shared by all files; when it is exhausted we fall back to plain I/O.
+//
+class XrdPssStream
+{
+public:
+
+// Alloc() returns a stream object for the file or nil if streaming is off.
+//
+static XrdPssStream *Alloc(int fd, bool isRW);
+
+// Close() writes out any buffered data and waits for all outstanding I/O to
+//         complete. It returns 0 or the -errno of a failed write.
+//
+int                  Close();
+
+// Flush() writes out any buffered data and waits for it to be written. It
+//         returns 0 or the -errno of a failed write.
+//
+int                  Flush();
+
+ssize_t              Read(void *buff, off_t offset, size_t blen);
+
+ssize_t              Write(const void *buff, off_t offset, size_t blen);
+
+static bool          Enabled() {return rdSize > 0 || wrSize > 0;}
+
+static void          setParms(int rdsz, int wrsz, long long maxmem)
+                             {rdSize = rdsz; wrSize = wrsz; memMax = maxmem;}
+
+                     XrdPssStream(int fd, bool isRW);
+                    ~XrdPssStream();
+
+private:
+
+class IOCB;
+friend class IOCB;
+
+static const int     rdNum = 2;   // Number of readahead windows
+static const int     wrMax = 4;   // Maximum number of outstanding writes
+static const int     seqMin = 2;  // Sequential reads before reading ahead
+
+enum BlkState {isIdle = 0, isPending, isReady, isFailed};
+
+struct Block
+      {char     *buff;
+       off_t     offset;
+       ssize_t   dlen;
+       BlkState  state;
+      };
+
+static char         *GetBuff(int bsz);
+static void          RetBuff(char *bp, int bsz);
+
+void                 Ahead();
+void                 Done(Block *bP, char *wbP, ssize_t result, int eNum);
+void                 Drain();
+void                 Release(off_t offset);
+void                 WriteOut();
+
+XrdSysCondVar        sCond;
+Block                rBlock[rdNum];
+off_t                rNext;     // End offset of the previous read
+int                  rSeq;      // Number of consecutive sequential reads
+int                  rPend;     // Outstanding readaheads
+char                *wBuff;     // Buffer gathering writes
+off_t                wOffset;   // File offset of wBuff
+int                  wLen;      // Bytes in wBuff
+off_t                wNext;     // End offset of the previous write issued
+int                  wPend;     // Outstanding writes
+int                  wErr;      // -errno of the first failed write, if any
+int                  fileFD;
+bool                 isWrite;
+
+static XrdSysMutex   memMutex;
+static long long     memUsed;
+static long long     memMax;
+static int           rdSize;
+static int           wrSize;
+};
+#endif
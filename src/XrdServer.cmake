@@ -28,9 +28,11 @@ add_library(
   XrdXrootd/XrdXrootdFileLock1.cc       XrdXrootd/XrdXrootdFileLock1.hh
                                         XrdXrootd/XrdXrootdFileStats.hh
   XrdXrootd/XrdXrootdJob.cc             XrdXrootd/XrdXrootdJob.hh
+  XrdXrootd/XrdXrootdLatency.cc         XrdXrootd/XrdXrootdLatency.hh
   XrdXrootd/XrdXrootdLoadLib.cc
                                         XrdXrootd/XrdXrootdMonData.hh
   XrdXrootd/XrdXrootdMonFile.cc         XrdXrootd/XrdXrootdMonFile.hh
+  XrdXrootd/XrdXrootdMonFSink.cc        XrdXrootd/XrdXrootdMonFSink.hh
   XrdXrootd/XrdXrootdMonFMap.cc         XrdXrootd/XrdXrootdMonFMap.hh
   XrdXrootd/XrdXrootdMonitor.cc         XrdXrootd/XrdXrootdMonitor.hh
 
@@ -43,6 +45,7 @@ add_library(
   XrdXrootd/XrdXrootdTransit.cc         XrdXrootd/XrdXrootdTransit.hh
   XrdXrootd/XrdXrootdTransPend.cc       XrdXrootd/XrdXrootdTransPend.hh
   XrdXrootd/XrdXrootdTransSend.cc       XrdXrootd/XrdXrootdTransSend.hh
+  XrdXrootd/XrdXrootdWPipe.cc           XrdXrootd/XrdXrootdWPipe.hh
   XrdXrootd/XrdXrootdXeq.cc
   XrdXrootd/XrdXrootdXeqAio.cc
                                         XrdXrootd/XrdXrootdTrace.hh
@@ -165,6 +168,7 @@ target_link_libraries(
   ${CMAKE_DL_LIBS}
   pthread
   ${EXTRA_LIBS}
+  ${ZLIB_LIBRARY}
   ${SOCKET_LIBRARY} )
 
 set_target_properties(
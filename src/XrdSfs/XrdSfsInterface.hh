@@ -48,6 +48,7 @@
 #define SFS_O_CREAT        0x100         // used for file creation
 #define SFS_O_TRUNC        0x200         // used for file truncation
 #define SFS_O_MULTIW       0x400         // used for multi-write locations
+#define SFS_O_SEQIO   0x00010000         // file will be read sequentially
 #define SFS_O_POSC     0x0100000         // persist on successful close
 #define SFS_O_FORCE    0x0200000         // used for locate only
 #define SFS_O_HNAME    0x0400000         // used for locate only
@@ -673,6 +674,7 @@ public:
 //!                  SFS_O_RDWR    open read/write
 //!                  SFS_O_REPLICA Open for replication
 //!                  SFS_O_RESET   Reset any cached information
+//!                  SFS_O_SEQIO   file will be read sequentially
 //!                  SFS_O_TRUNC   truncate existing file to zero length
 //!                  SFS_O_WRONLY  open write/only
 //! @param  cMode  - The file's mode if it will be created.
@@ -45,6 +45,7 @@ XrdSsi/XrdSsiService.cc                XrdSsi/XrdSsiService.hh
 XrdSsi/XrdSsiSessReal.cc               XrdSsi/XrdSsiSessReal.hh
 XrdSsi/XrdSsiStats.cc                  XrdSsi/XrdSsiStats.hh
                                        XrdSsi/XrdSsiStream.hh
+XrdSsi/XrdSsiStreamQ.cc                XrdSsi/XrdSsiStreamQ.hh
 XrdSsi/XrdSsiTaskReal.cc               XrdSsi/XrdSsiTaskReal.hh
                                        XrdSsi/XrdSsiTrace.hh
 XrdSsi/XrdSsiUtils.cc                  XrdSsi/XrdSsiUtils.hh)
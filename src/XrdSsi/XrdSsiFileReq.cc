@@ -45,6 +45,7 @@
 #include "XrdSsi/XrdSsiService.hh"
 #include "XrdSsi/XrdSsiSfs.hh"
 #include "XrdSsi/XrdSsiStream.hh"
+#include "XrdSsi/XrdSsiStreamQ.hh"
 #include "XrdSsi/XrdSsiStats.hh"
 #include "XrdSsi/XrdSsiTrace.hh"
 #include "XrdSsi/XrdSsiUtils.hh"
@@ -555,6 +556,7 @@ void XrdSsiFileReq::Init(const char *cID)
    oucBuff    = 0;
    sfsBref    = 0;
    strBuff    = 0;
+   strmQ      = 0;
    reqSize    = 0;
    respBuf    = 0;
    respOff    = 0;
@@ -614,6 +616,7 @@ bool XrdSsiFileReq::ProcessResponse(const XrdSsiErrInfo  &eInfo,
           case XrdSsiRespInfo::isStream:
                DEBUGXQ("Resp strm");
                respLen = 0;
+               strmQ   = dynamic_cast<XrdSsiStreamQ *>(Resp.strmP);
                Stats.Bump(Stats.RspStrm);
                break;
           default:
@@ -735,7 +738,10 @@ do{if (strBuff)
 
    if (!strmEOF && blen)
       {respLen = blen; respOff = 0;
-       strBuff = strmP->GetBuff(eObj, respLen, strmEOF);
+       if (strmQ && xlen)
+          {if (!(strBuff = strmQ->TryBuff(respLen, strmEOF)) && !strmEOF)
+              return xlen;
+          } else strBuff = strmP->GetBuff(eObj, respLen, strmEOF);
       }
   } while(strBuff);
 
@@ -906,8 +912,9 @@ int XrdSsiFileReq::sendStrmA(XrdSsiStream *strmP,
 {
    static const char *epname = "sendStrmA";
    XrdSsiErrInfo  eObj;
-   XrdOucSFVec    sfVec[2];
-   int rc;
+   XrdOucSFVec    sfVec[XrdOucSFVec::sfMax];
+   XrdSsiStream::Buffer *sentBuff[XrdOucSFVec::sfMax];
+   int rc, sfNum = 1, sentNum = 0;
 
 // Check if we need a buffer
 //
@@ -921,25 +928,31 @@ int XrdSsiFileReq::sendStrmA(XrdSsiStream *strmP,
        respOff = 0;
       }
 
-// Complete the sendfile vector
+// Complete the sendfile vector. For a queued stream we add whatever buffers
+// are at hand so that many small fragments go out in a single send.
 //
-   sfVec[1].buffer = strBuff->data+respOff;
-   sfVec[1].fdnum  = -1;
+do{sfVec[sfNum].buffer = strBuff->data+respOff;
+   sfVec[sfNum].fdnum  = -1;
    if (respLen > blen)
-      {sfVec[1].sendsz = blen;
-       respLen -= blen; respOff += blen;
+      {sfVec[sfNum].sendsz = blen;
+       respLen -= blen; respOff += blen; blen = 0;
       } else {
-       sfVec[1].sendsz = respLen;
-       respLen = 0;
+       sfVec[sfNum].sendsz = respLen;
+       blen -= respLen; respLen = 0;
+       sentBuff[sentNum++] = strBuff; strBuff = 0;
       }
+   sfNum++;
+   if (!strmQ || !blen || sfNum >= XrdOucSFVec::sfMax || strmEOF) break;
+   respOff = 0;
+  } while((strBuff = strmQ->TryBuff(respLen, strmEOF)));
 
 // Send off the data
 //
-   rc = sfDio->SendFile(sfVec, 2);
+   rc = sfDio->SendFile(sfVec, sfNum);
 
-// Release any completed buffer
+// Release any completed buffers
 //
-   if (strBuff && !respLen) {strBuff->Recycle(); strBuff = 0;}
+   for (int i = 0; i < sentNum; i++) sentBuff[i]->Recycle();
 
 // If send succeeded, indicate the action to be taken
 //
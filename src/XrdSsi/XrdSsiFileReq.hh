@@ -49,6 +49,7 @@ class  XrdSsiRespInfoMsg;
 class  XrdSsiRRInfo;
 class  XrdSsiService;
 class  XrdSsiStream;
+class  XrdSsiStreamQ;
 
 class XrdSsiFileReq : public XrdSsiRequest, public XrdOucEICB, public XrdJob
 {
@@ -157,6 +158,7 @@ union {long long       fileSz;
 XrdSfsXioHandle       *sfsBref;
 XrdOucBuffer          *oucBuff;
 XrdSsiStream::Buffer  *strBuff;
+XrdSsiStreamQ         *strmQ;
 reqState               myState;
 rspState               urState;
 int                    reqSize;
@@ -0,0 +1,194 @@
+/******************************************************************************/
+/*                                                                            */
+/*                      X r d S s i S t r e a m Q . c c                       */
+/*                                                                            */
+/* This file is part of the XRootD software suite.                            */
+/*                                                                            */
+/* XRootD is free software: you can redistribute it and/or modify it under    */
+/* the terms of the GNU Lesser General Public License as published by the     */
+/* Free Software Foundation, either version 3 of the License, or (at your     */
+/* option) any later version.                                                 */
+/*                                                                            */
+/* XRootD is distributed in the hope that it will be useful, but WITHOUT      */
+/* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or      */
+/* FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public       */
+/* License for more details.                                                  */
+/*                                                                            */
+/* You should have received a copy of the GNU Lesser General Public License   */
+/* along with XRootD in a file called COPYING.LESSER (LGPL license) and file  */
+/* COPYING (GPL license).  If not, see <http://www.gnu.org/licenses/>.        */
+/*                                                                            */
+/* The copyright holder's institutional names and contributor's names may not */
+/* be used to endorse or promote products derived from this software without  */
+/* specific prior written permission of the institution or contributor.       */
+/******************************************************************************/
+
+#include "XrdSsi/XrdSsiStreamQ.hh"
+#include "XrdSys/XrdSysPthread.hh"
+
+// The ring is used by exactly one producer and one consumer. Each side only
+// advances its own index so that the fast path needs no locks. A side finding
+// the ring empty (consumer) or full (producer) announces that it is waiting
+// and checks the ring again before it sleeps; the other side checks for such
+// an announcement after it moves its index. As both use sequentially
+// consistent operations for this, at least one of them sees the other.
+
+/******************************************************************************/
+/*                           C o n s t r u c t o r                            */
+/******************************************************************************/
+
+XrdSsiStreamQ::XrdSsiStreamQ(int qSize)
+             : XrdSsiStream(XrdSsiStream::isActive),
+               qHead(0), qTail(0), qEnd(notEnded), cWait(0), pWait(0)
+{
+   unsigned int n = 2;
+
+// The ring size must be a power of two
+//
+   while(n < (unsigned int)qSize && n < 65536) n <<= 1;
+   ring  = new Slot[n];
+   qMask = n - 1;
+   cSem  = new XrdSysSemaphore(0);
+   pSem  = new XrdSysSemaphore(0);
+}
+
+/******************************************************************************/
+/*                            D e s t r u c t o r                             */
+/******************************************************************************/
+
+XrdSsiStreamQ::~XrdSsiStreamQ()
+{
+   unsigned int head = qHead.load(), tail = qTail.load();
+
+// Recycle whatever was never sent
+//
+   while(head != tail) ring[head++ & qMask].bP->Recycle();
+   delete [] ring;
+   delete cSem;
+   delete pSem;
+}
+
+/******************************************************************************/
+/*                                   E n d                                    */
+/******************************************************************************/
+
+void XrdSsiStreamQ::End()
+{
+   qEnd.store(wasEnded);
+   if (cWait.load() && cWait.exchange(0)) cSem->Post();
+}
+
+/******************************************************************************/
+/*                                  F a i l                                   */
+/******************************************************************************/
+
+void XrdSsiStreamQ::Fail(const char *eMsg, int eNum)
+{
+   if (qEnd.load(std::memory_order_relaxed)) return;
+   eInfo.Set(eMsg, eNum);
+   qEnd.store(wasFailed);
+   if (cWait.load() && cWait.exchange(0)) cSem->Post();
+}
+
+/******************************************************************************/
+/*                               G e t B u f f                                */
+/******************************************************************************/
+
+XrdSsiStream::Buffer *XrdSsiStreamQ::GetBuff(XrdSsiErrInfo &eRef,
+                                             int &dlen, bool &last)
+{
+   Buffer *bP;
+
+// Wait until a buffer is added or the stream ends
+//
+   while(!(bP = TryBuff(dlen, last)))
+        {if (last) return 0;
+         if (qEnd.load() == wasFailed) {eRef = eInfo; return 0;}
+         cWait.store(1);
+         if (qHead.load(std::memory_order_relaxed) != qTail.load()
+         ||  qEnd.load())
+            {cWait.store(0); continue;}
+         cSem->Wait();
+        }
+   return bP;
+}
+
+/******************************************************************************/
+/*                                   P u t                                    */
+/******************************************************************************/
+
+bool XrdSsiStreamQ::Put(XrdSsiStream::Buffer *bP, int dlen, bool wait)
+{
+   unsigned int tail = qTail.load(std::memory_order_relaxed);
+
+// Nothing may be added once the stream has ended
+//
+   if (qEnd.load(std::memory_order_relaxed)) return false;
+
+// Wait for space or ask to be told when there is space
+//
+   while(tail - qHead.load(std::memory_order_acquire) > qMask)
+        {pWait.store(wait ? 1 : 2);
+         if (tail - qHead.load() <= qMask) {pWait.store(0); break;}
+         if (!wait) return false;
+         pSem->Wait();
+        }
+
+// Add the buffer and wake up the consumer if it is waiting for one
+//
+   ring[tail & qMask].bP   = bP;
+   ring[tail & qMask].dlen = dlen;
+   qTail.store(tail+1);
+   if (cWait.load() && cWait.exchange(0)) cSem->Post();
+   return true;
+}
+
+/******************************************************************************/
+/*                               T r y B u f f                                */
+/******************************************************************************/
+
+XrdSsiStream::Buffer *XrdSsiStreamQ::TryBuff(int &dlen, bool &last)
+{
+   unsigned int head = qHead.load(std::memory_order_relaxed);
+   int          eVal = qEnd.load(std::memory_order_acquire);
+   Buffer      *bP;
+
+// Check if there is anything in the ring. As the end is set after the last
+// buffer was added, an empty ring after the end was seen stays empty.
+//
+   if (head == qTail.load(std::memory_order_acquire))
+      {last = (eVal == wasEnded);
+       return 0;
+      }
+
+// Take the buffer and tell the producer if it is waiting for space
+//
+   bP   = ring[head & qMask].bP;
+   dlen = ring[head & qMask].dlen;
+   qHead.store(head+1);
+   if (pWait.load()) Wake(head+1);
+   last = false;
+   return bP;
+}
+
+/******************************************************************************/
+/*                       P r i v a t e   M e t h o d s                        */
+/******************************************************************************/
+/******************************************************************************/
+/*                                  W a k e                                   */
+/******************************************************************************/
+
+void XrdSsiStreamQ::Wake(unsigned int head)
+{
+   int pVal = pWait.load();
+
+// The producer is only told once the ring is half empty so that it can add a
+// batch of buffers rather than waking up for each free slot.
+//
+   if (!pVal || qTail.load() - head > (qMask+1)/2) return;
+   switch(pWait.exchange(0))
+         {case 1:  pSem->Post(); break;
+          case 2:  Resume();     break;
+          default: break;
+         }
+}
@@ -0,0 +1,140 @@
+#ifndef __XRDSSISTREAMQ_HH__
+#define __XRDSSISTREAMQ_HH__
+/******************************************************************************/
+/*                                                                            */
+/*                      X r d S s i S t r e a m Q . h h                       */
+/*                                                                            */
+/* This file is part of the XRootD software suite.                            */
+/*                                                                            */
+/* XRootD is free software: you can redistribute it and/or modify it under    */
+/* the terms of the GNU Lesser General Public License as published by the     */
+/* Free Software Foundation, either version 3 of the License, or (at your     */
+/* option) any later version.                                                 */
+/*                                                                            */
+/* XRootD is distributed in the hope that it will be useful, but WITHOUT      */
+/* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or      */
+/* FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public       */
+/* License for more details.                                                  */
+/*                                                                            */
+/* You should have received a copy of the GNU Lesser General Public License   */
+/* along with XRootD in a file called COPYING.LESSER (LGPL license) and file  */
+/* COPYING (GPL license).  If not, see <http://www.gnu.org/licenses/>.        */
+/*                                                                            */
+/* The copyright holder's institutional names and contributor's names may not */
+/* be used to endorse or promote products derived from this software without  */
+/* specific prior written permission of the institution or contributor.       */
+/******************************************************************************/
+
+#include <atomic>
+
+#include "XrdSsi/XrdSsiErrInfo.hh"
+#include "XrdSsi/XrdSsiStream.hh"
+
+class XrdSysSemaphore;
+
+//-----------------------------------------------------------------------------
+//! The XrdSsiStreamQ class is an active stream meant for responses made up of
+//! many fragments. Buffers are handed from the thread producing the response
+//! to the thread sending it through a lock-free ring so that neither side
+//! takes a lock unless the ring is empty or full. Only one thread at a time
+//! may add buffers. When the ring is full, Put() either waits for space or
+//! fails; in the latter case Resume() is called once the ring has drained to
+//! half its size. Since all of the queued buffers are at hand, several of them
+//! are sent to the client at once. Buffers that were never sent are recycled
+//! when the stream is deleted.
+//-----------------------------------------------------------------------------
+
+class XrdSsiStreamQ : public XrdSsiStream
+{
+public:
+
+//-----------------------------------------------------------------------------
+//! Indicate that no more buffers will be added to the stream.
+//-----------------------------------------------------------------------------
+
+void            End();
+
+//-----------------------------------------------------------------------------
+//! Indicate that the response failed. Buffers already added are still sent
+//! after which the client receives the error.
+//!
+//! @param  eMsg  the error message.
+//! @param  eNum  the error number.
+//-----------------------------------------------------------------------------
+
+void            Fail(const char *eMsg, int eNum);
+
+//-----------------------------------------------------------------------------
+//! Add a buffer to the stream.
+//!
+//! @param  bP    pointer to the buffer holding the data.
+//! @param  dlen  the number of bytes of data in the buffer.
+//! @param  wait  when true and the ring is full, wait for space. Otherwise,
+//!               return false and have Resume() called when there is space.
+//!
+//! @return true  The buffer was added; it is recycled once it has been sent.
+//! @return false The ring is full or the stream has ended. The buffer still
+//!               belongs to the caller.
+//-----------------------------------------------------------------------------
+
+bool            Put(Buffer *bP, int dlen, bool wait=true);
+
+//-----------------------------------------------------------------------------
+//! Called when the ring has drained to half its size after Put() failed
+//! because it was full. It is called by the thread sending the response and
+//! must not block; typically, it reschedules the producer of the response.
+//! It may occasionally be called even though Put() did not fail.
+//-----------------------------------------------------------------------------
+
+virtual void    Resume() {}
+
+//-----------------------------------------------------------------------------
+//! Obtain the next buffer, waiting for one to be added (server-side only).
+//! See XrdSsiStream::GetBuff() for the arguments.
+//-----------------------------------------------------------------------------
+
+Buffer         *GetBuff(XrdSsiErrInfo &eRef, int &dlen, bool &last);
+
+//-----------------------------------------------------------------------------
+//! Obtain the next buffer without waiting (server-side only).
+//!
+//! @param  dlen  output: the amount of data in the buffer.
+//! @param  last  output: true if End() was called and no buffers remain.
+//!
+//! @return !0    Pointer to the Buffer object to be recycled once sent.
+//! @return =0    No buffer is queued at the moment or no more data remains.
+//-----------------------------------------------------------------------------
+
+Buffer         *TryBuff(int &dlen, bool &last);
+
+//-----------------------------------------------------------------------------
+//! Constructor
+//!
+//! @param  qSize the number of buffers the ring can hold. It is rounded up
+//!               to a power of two.
+//-----------------------------------------------------------------------------
+
+                XrdSsiStreamQ(int qSize=64);
+
+virtual        ~XrdSsiStreamQ();
+
+private:
+
+void            Wake(unsigned int head);
+
+struct Slot {Buffer *bP; int dlen;};
+
+enum EndType {notEnded = 0, wasEnded, wasFailed};
+
+Slot                     *ring;
+unsigned int              qMask;
+std::atomic<unsigned int> qHead;    // Next slot to take, set by the consumer
+std::atomic<unsigned int> qTail;    // Next slot to fill, set by the producer
+std::atomic<int>          qEnd;     // One of EndType
+std::atomic<int>          cWait;    // Consumer waits for a buffer
+std::atomic<int>          pWait;    // Producer waits (1) or wants Resume (2)
+XrdSysSemaphore          *cSem;
+XrdSysSemaphore          *pSem;
+XrdSsiErrInfo             eInfo;
+};
+#endif
@@ -101,6 +101,7 @@ private:
 
    unique_sfs_ptr m_sfs;
    int m_uid; // A unique identifier for this user; has no meaning except for the fairshare.
+   int m_devslot; // Load monitor slot of the device holding the file, or -1.
    std::string m_loadshed;
    std::string m_user;
    XrdThrottleManager &m_throttle;
@@ -234,6 +235,15 @@ private:
    int
    xloadshed(XrdOucStream &Config);
 
+   int
+   xadaptive(XrdOucStream &Config);
+
+   int
+   xfairshare(XrdOucStream &Config);
+
+   int
+   xbucket(XrdOucStream &Config);
+
    int
    xtrace(XrdOucStream &Config);
 
@@ -0,0 +1,497 @@
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "XrdThrottleBuckets.hh"
+
+#include "XrdSys/XrdSysError.hh"
+
+#define XRD_TRACE m_trace->
+#include "XrdThrottle/XrdThrottleTrace.hh"
+
+const char *
+XrdThrottleBuckets::TraceID = "ThrottleBuckets";
+
+// Users beyond this number share the overflow bucket of their VO.
+const
+int XrdThrottleBuckets::m_max_users = 4096;
+
+static const char *default_vo = "*";
+
+/*
+ * Token bucket primitives.  A negative rate means the dimension is not
+ * limited.  A request larger than the bucket capacity is allowed once the
+ * bucket is full, driving the bucket into debt.
+ */
+void
+XrdThrottleBuckets::TokenBucket::Configure(float bytes_rate, float ops_rate, float burst_seconds)
+{
+   rate[Bytes] = bytes_rate;
+   rate[Ops]   = ops_rate;
+   for (int i=0; i<Dims; i++)
+   {
+      capacity[i] = (rate[i] > 0) ? rate[i] * burst_seconds : 0;
+      if (rate[i] > 0 && capacity[i] < 1) capacity[i] = 1;
+      tokens[i] = capacity[i];
+   }
+   last = Now();
+}
+
+/*
+ * Seconds until the bucket will have refilled enough for the request.
+ */
+double
+XrdThrottleBuckets::TokenBucket::Delay(const double need[Dims]) const
+{
+   double delay = 0;
+   for (int i=0; i<Dims; i++)
+   {
+      if (rate[i] <= 0 || !need[i]) continue;
+      double short_by = (need[i] < capacity[i] ? need[i] : capacity[i]) - tokens[i];
+      if (short_by > 0 && short_by / rate[i] > delay) delay = short_by / rate[i];
+   }
+   return delay;
+}
+
+bool
+XrdThrottleBuckets::TokenBucket::Fits(const double need[Dims]) const
+{
+   for (int i=0; i<Dims; i++)
+   {
+      if (rate[i] < 0 || !need[i]) continue;
+      if (tokens[i] < (need[i] < capacity[i] ? need[i] : capacity[i])) return false;
+   }
+   return true;
+}
+
+void
+XrdThrottleBuckets::TokenBucket::Refill(double now)
+{
+   double elapsed = now - last;
+   if (elapsed <= 0) return;
+   last = now;
+   for (int i=0; i<Dims; i++)
+   {
+      if (rate[i] < 0) continue;
+      tokens[i] += rate[i] * elapsed;
+      if (tokens[i] > capacity[i]) tokens[i] = capacity[i];
+   }
+}
+
+void
+XrdThrottleBuckets::TokenBucket::Take(const double need[Dims])
+{
+   for (int i=0; i<Dims; i++)
+   {
+      if (rate[i] >= 0) tokens[i] -= need[i];
+   }
+}
+
+XrdThrottleBuckets::Node::Node(const std::string &nm, const Limits &lim, float burst, Node *up) :
+   name(nm),
+   weight(lim.weight > 0 ? lim.weight : 1.0),
+   parent(up),
+   deficit(0),
+   active(false),
+   blocked(0),
+   bytes(0),
+   ops(0),
+   waits(0),
+   wait_seconds(0)
+{
+   bucket.Configure(lim.bytes_per_second, lim.ops_per_second, burst);
+}
+
+XrdThrottleBuckets::XrdThrottleBuckets(XrdSysError *lP, XrdOucTrace *tP) :
+   m_trace(tP),
+   m_log(lP),
+   m_cond(0),
+   m_burst_seconds(1.0),
+   m_quantum(0),
+   m_pass(0)
+{
+   m_global.Configure(-1, -1, 1.0);
+}
+
+void
+XrdThrottleBuckets::SetGlobal(float bytes_per_second, float ops_per_second, float burst_seconds)
+{
+   m_burst_seconds = burst_seconds > 0 ? burst_seconds : 1.0;
+   m_global.Configure(bytes_per_second, ops_per_second, m_burst_seconds);
+}
+
+void
+XrdThrottleBuckets::SetVO(const std::string &name, const Limits &limits)
+{
+   if (name == default_vo) m_default_vo = limits;
+   else m_vo_limits[name] = limits;
+}
+
+void
+XrdThrottleBuckets::SetUser(const std::string &name, const Limits &limits)
+{
+   if (name == "*") m_default_user = limits;
+   else m_user_limits[name] = limits;
+}
+
+/*
+ * Requests are charged in seconds of global capacity so that bytes and
+ * operations can be compared.  Without global limits we fall back to
+ * charging megabytes plus operations.
+ */
+double
+XrdThrottleBuckets::Cost(const double need[Dims]) const
+{
+   double cost = 0;
+   bool limited = false;
+   for (int i=0; i<Dims; i++)
+   {
+      if (m_global.rate[i] > 0) {cost += need[i] / m_global.rate[i]; limited = true;}
+   }
+   if (!limited) cost = need[Bytes] / (1024*1024) + need[Ops];
+   return cost;
+}
+
+void
+XrdThrottleBuckets::Init()
+{
+   bool limited = (m_global.rate[Bytes] > 0) || (m_global.rate[Ops] > 0);
+   // Each round a node of weight 1 may use 10ms worth of server capacity.
+   m_quantum = limited ? 0.01 : 1.0;
+
+   int rc;
+   pthread_t tid;
+   if ((rc = XrdSysThread::Run(&tid, XrdThrottleBuckets::DispatcherBootstrap, static_cast<void *>(this), 0, "Throttle bucket dispatcher")))
+      m_log->Emsg("ThrottleBuckets", rc, "create throttle dispatcher thread");
+}
+
+double
+XrdThrottleBuckets::Now()
+{
+   struct timespec now = {0, 0};
+   clock_gettime(CLOCK_MONOTONIC, &now);
+   return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+/*
+ * Find or create the VO node; must be called with m_cond locked.
+ */
+XrdThrottleBuckets::Node *
+XrdThrottleBuckets::GetVO(const char *vo)
+{
+   std::string name = (vo && *vo) ? vo : default_vo;
+   std::map<std::string, Node*>::iterator it = m_vos.find(name);
+   if (it != m_vos.end()) return it->second;
+
+   std::map<std::string, Limits>::const_iterator lit = m_vo_limits.find(name);
+   Node *node = new Node(name, lit == m_vo_limits.end() ? m_default_vo : lit->second, m_burst_seconds, 0);
+   m_vos[name] = node;
+   return node;
+}
+
+/*
+ * Map a user onto its bucket.  Users are keyed by name and VO; the ids
+ * are stable for the lifetime of the server.
+ */
+int
+XrdThrottleBuckets::GetUid(const char *user, const char *vo)
+{
+   std::string uname = user ? user : "";
+   std::string key = uname;
+   key += "@";
+   if (vo) key += vo;
+
+   XrdSysCondVarHelper lock(m_cond);
+   std::map<std::string, int>::iterator it = m_uids.find(key);
+   if (it != m_uids.end()) return it->second;
+
+   Node *vonode = GetVO(vo);
+   if (static_cast<int>(m_users.size()) >= m_max_users)
+   {
+      // Out of buckets; share the VO's overflow bucket.
+      key = "*@"; key += vonode->name;
+      if ((it = m_uids.find(key)) != m_uids.end()) return it->second;
+      uname = "*";
+   }
+
+   std::map<std::string, Limits>::const_iterator lit = m_user_limits.find(uname);
+   Node *node = new Node(uname, lit == m_user_limits.end() ? m_default_user : lit->second, m_burst_seconds, vonode);
+   int uid = m_users.size();
+   m_users.push_back(node);
+   m_uids[key] = uid;
+   TRACE(DEBUG, "Assigned bucket " << uid << " to user " << uname << " of VO " << vonode->name);
+   return uid;
+}
+
+/*
+ * Buckets are refilled lazily, only along the path of the request being
+ * considered.  Must be called with m_cond locked.
+ */
+bool
+XrdThrottleBuckets::Fits(const double need[Dims], Node *user, double now)
+{
+   m_global.Refill(now);
+   user->parent->bucket.Refill(now);
+   user->bucket.Refill(now);
+   return m_global.Fits(need) && user->parent->bucket.Fits(need) && user->bucket.Fits(need);
+}
+
+void
+XrdThrottleBuckets::Take(const double need[Dims], Node *user)
+{
+   m_global.Take(need);
+   user->parent->bucket.Take(need);
+   user->bucket.Take(need);
+   for (Node *node = user; node; node = node->parent)
+   {
+      node->bytes += static_cast<long long>(need[Bytes]);
+      node->ops   += static_cast<long long>(need[Ops]);
+   }
+}
+
+/*
+ * Apply the throttle for a user.  The fast path is taken when nobody is
+ * queued and every bucket on the path has enough tokens; otherwise the
+ * request is queued and we sleep until the dispatcher grants it.
+ */
+bool
+XrdThrottleBuckets::Apply(int reqsize, int reqops, int uid)
+{
+   double need[Dims] = {static_cast<double>(reqsize), static_cast<double>(reqops)};
+   if (uid < 0) return false;
+
+   m_cond.Lock();
+   if (uid >= static_cast<int>(m_users.size())) {m_cond.UnLock(); return false;}
+   Node *user = m_users[uid];
+   if (m_active.empty() && Fits(need, user, Now()))
+   {
+      Take(need, user);
+      m_cond.UnLock();
+      return false;
+   }
+
+   Waiter waiter;
+   waiter.need[Bytes] = need[Bytes];
+   waiter.need[Ops]   = need[Ops];
+   waiter.cost        = Cost(need);
+   clock_gettime(CLOCK_MONOTONIC, &waiter.start);
+   Activate(&waiter, user);
+   m_cond.Signal();
+   m_cond.UnLock();
+
+   TRACE(BANDWIDTH, "Queued request of " << reqsize << " bytes for user " << user->name);
+   waiter.granted.Wait();
+   return true;
+}
+
+/*
+ * Queue the waiter and link its user (and the user's VO) into the active
+ * lists.  Must be called with m_cond locked.
+ */
+void
+XrdThrottleBuckets::Activate(Waiter *waiter, Node *user)
+{
+   Node *vo = user->parent;
+   user->queue.push_back(waiter);
+   for (Node *node = user; node; node = node->parent) node->waits++;
+   if (!user->active)
+   {
+      user->active = true;
+      vo->children.push_back(user);
+   }
+   if (!vo->active)
+   {
+      vo->active = true;
+      m_active.push_back(vo);
+   }
+}
+
+/*
+ * Dequeue and release the waiter at the head of the user's queue.
+ * Must be called with m_cond locked.
+ */
+void
+XrdThrottleBuckets::Grant(Waiter *waiter, Node *user)
+{
+   Node *vo = user->parent;
+   Take(waiter->need, user);
+   user->deficit -= waiter->cost;
+   vo->deficit   -= waiter->cost;
+   user->queue.pop_front();
+
+   struct timespec now = {0, 0};
+   clock_gettime(CLOCK_MONOTONIC, &now);
+   double waited = (now.tv_sec - waiter->start.tv_sec) + (now.tv_nsec - waiter->start.tv_nsec) * 1e-9;
+   user->wait_seconds += waited;
+   vo->wait_seconds   += waited;
+
+   if (user->queue.empty())
+   {
+      user->active  = false;
+      user->deficit = 0;
+      vo->children.remove(user);
+   }
+   if (vo->children.empty())
+   {
+      vo->active  = false;
+      vo->deficit = 0;
+      m_active.remove(vo);
+   }
+   waiter->granted.Post();
+}
+
+/*
+ * One pass of the weighted deficit round robin.  Returns true if at least
+ * one request was granted.  A node that cannot proceed because of its own
+ * bucket is marked as blocked for this pass; the pass ends when the global
+ * bucket is exhausted or every active VO is blocked.  The delay is set to
+ * the seconds until the first of the blocking buckets has refilled enough.
+ * Must be called with m_cond locked.
+ */
+bool
+XrdThrottleBuckets::Dispatch(double &delay)
+{
+   bool granted = false;
+   delay = -1;
+   double now = Now();
+   unsigned pass = ++m_pass;
+   if (!pass) pass = ++m_pass;
+
+   while (!m_active.empty())
+   {
+      // Select the VO: the first one that is not blocked and has credit.
+      Node *vo = 0;
+      size_t scanned = 0, nvos = m_active.size();
+      while (scanned < nvos)
+      {
+         Node *cand = m_active.front();
+         if (cand->blocked == pass) {m_active.splice(m_active.end(), m_active, m_active.begin()); scanned++; continue;}
+         if (cand->deficit <= 0)
+         {
+            cand->deficit += m_quantum * cand->weight;
+            m_active.splice(m_active.end(), m_active, m_active.begin());
+            continue;
+         }
+         vo = cand;
+         break;
+      }
+      if (!vo) break;
+
+      // Within the VO, select the user in the same way.
+      Node *user = 0;
+      scanned = 0;
+      size_t nusers = vo->children.size();
+      while (scanned < nusers)
+      {
+         Node *cand = vo->children.front();
+         if (cand->blocked == pass) {vo->children.splice(vo->children.end(), vo->children, vo->children.begin()); scanned++; continue;}
+         if (cand->deficit <= 0)
+         {
+            cand->deficit += m_quantum * cand->weight;
+            vo->children.splice(vo->children.end(), vo->children, vo->children.begin());
+            continue;
+         }
+         user = cand;
+         break;
+      }
+      if (!user) {vo->blocked = pass; continue;}
+
+      Waiter *waiter = user->queue.front();
+      if (Fits(waiter->need, user, now)) {Grant(waiter, user); granted = true; continue;}
+      TokenBucket *bucket = &user->bucket;
+      if (!m_global.Fits(waiter->need)) bucket = &m_global;
+      else if (!vo->bucket.Fits(waiter->need)) {bucket = &vo->bucket; vo->blocked = pass;}
+      else user->blocked = pass;
+      double wait = bucket->Delay(waiter->need);
+      if (delay < 0 || wait < delay) delay = wait;
+      if (bucket == &m_global) break;
+   }
+   return granted;
+}
+
+void *
+XrdThrottleBuckets::DispatcherBootstrap(void *instance)
+{
+   XrdThrottleBuckets * buckets = static_cast<XrdThrottleBuckets*>(instance);
+   buckets->Dispatcher();
+   return NULL;
+}
+
+/*
+ * Serve the queues as tokens are refilled.  We sleep until a request is
+ * queued; while requests are pending and none can be granted we sleep
+ * until the blocking bucket has refilled enough (a new request wakes us
+ * up early as it may be able to use another path).
+ */
+void
+XrdThrottleBuckets::Dispatcher()
+{
+   double delay;
+   m_cond.Lock();
+   while (1)
+   {
+      if (m_active.empty())
+      {
+         m_cond.Wait();
+         continue;
+      }
+      if (Dispatch(delay) || m_active.empty()) continue;
+      // Every blocked request reports a delay; recheck in a second otherwise.
+      int ms = (delay < 0 ? 1000 : static_cast<int>(delay * 1000) + 1);
+      m_cond.WaitMS(ms);
+   }
+}
+
+int
+XrdThrottleBuckets::StatsNode(char *buff, int blen, const char *type, Node *node)
+{
+   static const char statfmt[] = "<%s><name>%s</name><wgt>%.2f</wgt><bytes>%lld</bytes>"
+                                 "<ops>%lld</ops><waits>%lld</waits><wait_ms>%lld</wait_ms></%s>";
+   int n = snprintf(buff, blen, statfmt, type, node->name.c_str(), node->weight,
+                    node->bytes, node->ops, node->waits,
+                    static_cast<long long>(node->wait_seconds * 1000), type);
+   return (n < blen) ? n : 0;
+}
+
+/*
+ * Report the per-bucket statistics.  The VOs are always reported; users
+ * are reported as long as there is room in the buffer.
+ */
+int
+XrdThrottleBuckets::Stats(char *buff, int blen)
+{
+   static const int nodesz = 160 + 256;
+   static const int maxusers = 64;
+   char *bp = buff;
+   int n;
+
+   if (!buff)
+   {
+      XrdSysCondVarHelper lock(m_cond);
+      int nusers = static_cast<int>(m_users.size()) < maxusers ? static_cast<int>(m_users.size()) : maxusers;
+      return 32 + nodesz * (m_vos.size() + nusers);
+   }
+
+   static const char trailer[] = "</buckets>";
+   if (blen < nodesz) return 0;
+   blen -= sizeof(trailer);
+
+   XrdSysCondVarHelper lock(m_cond);
+   n = sprintf(bp, "<buckets>");
+   bp += n; blen -= n;
+   for (std::map<std::string, Node*>::iterator it = m_vos.begin(); it != m_vos.end(); ++it)
+   {
+      if (blen < nodesz || !(n = StatsNode(bp, blen, "vo", it->second))) break;
+      bp += n; blen -= n;
+   }
+   int users = 0;
+   for (std::vector<Node*>::iterator it = m_users.begin(); it != m_users.end() && users < maxusers; ++it, ++users)
+   {
+      if (blen < nodesz || !(n = StatsNode(bp, blen, "user", *it))) break;
+      bp += n; blen -= n;
+   }
+   strcpy(bp, trailer);
+   bp += sizeof(trailer)-1;
+   return bp - buff;
+}
@@ -0,0 +1,167 @@
+
+/*
+ * XrdThrottleBuckets
+ *
+ * Hierarchical token buckets used by the throttle manager when the
+ * "buckets" fairshare mode is configured.
+ *
+ * There are three levels of buckets: the global one (the server-wide
+ * data and IOPS limits), one per VO (or group) and one per user.  Any
+ * bucket may carry its own rate limit; a request may only proceed when
+ * every bucket on its path has enough tokens.
+ *
+ * When the request cannot be satisfied immediately (or somebody else is
+ * already waiting) it is queued on its user.  A dispatcher thread serves
+ * the queues with a weighted deficit round robin, first across the VOs
+ * and then across the users of the selected VO, as soon as tokens become
+ * available.  This way a user issuing many requests only gets its weighted
+ * share of the server and cannot starve the others.  While nothing fits the
+ * dispatcher sleeps until the earliest time the buckets in the way will
+ * have refilled enough, or until a new request is queued.
+ */
+
+#ifndef __XrdThrottleBuckets_hh_
+#define __XrdThrottleBuckets_hh_
+
+#include <deque>
+#include <list>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "XrdSys/XrdSysPthread.hh"
+
+class XrdSysError;
+class XrdOucTrace;
+
+class XrdThrottleBuckets
+{
+public:
+
+struct Limits
+{
+   float weight;
+   float bytes_per_second;
+   float ops_per_second;
+
+   Limits() : weight(1.0), bytes_per_second(-1), ops_per_second(-1) {}
+};
+
+void        SetGlobal(float bytes_per_second, float ops_per_second, float burst_seconds);
+
+void        SetVO(const std::string &name, const Limits &limits);
+
+void        SetUser(const std::string &name, const Limits &limits);
+
+void        Init();
+
+// Returns the identifier to be passed to Apply() for the given user.
+int         GetUid(const char *user, const char *vo);
+
+// Returns true if the request had to wait for tokens.
+bool        Apply(int reqsize, int reqops, int uid);
+
+int         Stats(char *buff, int blen);
+
+            XrdThrottleBuckets(XrdSysError *lP, XrdOucTrace *tP);
+
+           ~XrdThrottleBuckets() {} // Never deleted, like the manager
+
+private:
+
+enum {Bytes = 0, Ops = 1, Dims = 2};
+
+struct TokenBucket
+{
+   double rate[Dims];
+   double capacity[Dims];
+   double tokens[Dims];
+   double last;
+
+   void   Configure(float bytes_rate, float ops_rate, float burst_seconds);
+   double Delay(const double need[Dims]) const;
+   bool   Fits(const double need[Dims]) const;
+   void   Refill(double now);
+   void   Take(const double need[Dims]);
+};
+
+struct Waiter
+{
+   double          need[Dims];
+   double          cost;
+   struct timespec start;
+   XrdSysSemaphore granted;
+
+   Waiter() : granted(0) {}
+};
+
+struct Node
+{
+   std::string         name;
+   float               weight;
+   TokenBucket         bucket;
+   Node               *parent;
+   double              deficit;
+   bool                active;
+   unsigned            blocked;  // Dispatch pass in which the node was blocked
+   std::deque<Waiter*> queue;    // Users only
+   std::list<Node*>    children; // VOs only; the users with queued requests
+
+   // Statistics
+   long long           bytes;
+   long long           ops;
+   long long           waits;
+   double              wait_seconds;
+
+   Node(const std::string &nm, const Limits &lim, float burst, Node *up);
+};
+
+void        Activate(Waiter *waiter, Node *user);
+
+double      Cost(const double need[Dims]) const;
+
+bool        Dispatch(double &delay);
+
+void        Dispatcher();
+
+static
+void *      DispatcherBootstrap(void *pp);
+
+bool        Fits(const double need[Dims], Node *user, double now);
+
+Node       *GetVO(const char *vo);
+
+void        Grant(Waiter *waiter, Node *user);
+
+int         StatsNode(char *buff, int blen, const char *type, Node *node);
+
+void        Take(const double need[Dims], Node *user);
+
+static double Now();
+
+XrdOucTrace * m_trace;
+XrdSysError * m_log;
+
+XrdSysCondVar m_cond;
+
+TokenBucket   m_global;
+float         m_burst_seconds;
+double        m_quantum;
+unsigned      m_pass;
+
+Limits        m_default_vo;
+Limits        m_default_user;
+
+std::map<std::string, Limits> m_vo_limits;
+std::map<std::string, Limits> m_user_limits;
+
+std::map<std::string, Node*> m_vos;
+std::map<std::string, int>   m_uids;
+std::vector<Node*>           m_users;
+std::list<Node*>             m_active; // The VOs with queued requests
+
+static const int    m_max_users;
+static const char  *TraceID;
+};
+
+#endif
@@ -6,7 +6,7 @@
 
 using namespace XrdThrottle;
 
-#define DO_LOADSHED if (m_throttle.CheckLoadShed(m_loadshed)) \
+#define DO_LOADSHED if (m_throttle.CheckLoadShed(m_loadshed, m_devslot)) \
 { \
    unsigned port; \
    std::string host; \
@@ -66,6 +66,7 @@ File::File(const char                     *user,
      m_sfs(sfs),
 #endif
      m_uid(0),
+     m_devslot(-1),
      m_user(user),
      m_throttle(throttle),
      m_eroute(eroute)
@@ -81,10 +82,19 @@ File::open(const char                *fileName,
            const XrdSecEntity        *client,
            const char                *opaque)
 {
-   m_uid = XrdThrottleManager::GetUid(client->name);
+   m_uid = m_throttle.GetUid(client);
    m_throttle.PrepLoadShed(opaque, m_loadshed);
    ErrorSentry sentry(error, m_sfs->error, true);
-   return m_sfs->open(fileName, openMode, createMode, client, opaque);
+   int rc = m_sfs->open(fileName, openMode, createMode, client, opaque);
+   // Remember the device holding the file so load shedding can favour
+   // redirecting the clients of the busiest one.
+   if (rc == SFS_OK && m_throttle.UseDeviceLoad())
+   {
+      struct stat buf;
+      if (m_sfs->stat(&buf) == SFS_OK)
+         m_devslot = m_throttle.TrackDevice(buf.st_dev);
+   }
+   return rc;
 }
 
 int
@@ -90,7 +90,12 @@ int
 FileSystem::getStats(char *buff,
                      int   blen)
 {
-   return m_sfs_ptr->getStats(buff, blen);
+   int n;
+
+   if (!buff) return m_sfs_ptr->getStats(0, 0) + m_throttle.Stats(0, 0);
+
+   n = m_sfs_ptr->getStats(buff, blen);
+   return n + m_throttle.Stats(buff+n, blen-n);
 }
 
 const char *
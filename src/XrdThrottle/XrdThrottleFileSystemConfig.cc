@@ -147,6 +147,9 @@ FileSystem::Configure(XrdSysError & log, XrdSfsFileSystem *native_fs)
       }
       TS_Xeq("throttle.throttle", xthrottle);
       TS_Xeq("throttle.loadshed", xloadshed);
+      TS_Xeq("throttle.adaptive", xadaptive);
+      TS_Xeq("throttle.fairshare", xfairshare);
+      TS_Xeq("throttle.bucket", xbucket);
       TS_Xeq("throttle.trace", xtrace);
       if (NoGo)
       {
@@ -228,19 +231,25 @@ FileSystem::xthrottle(XrdOucStream &Config)
 /* Function: xloadshed
 
    Purpose:  To parse the directive: loadshed host <hostname> [port <port>] [frequency <freq>]
+                                              [diskutil <dpct>] [netutil <npct> nic <ifname>]
 
              <hostname> hostname of server to shed load to.  Required
              <port>     port of server to shed load to.  Defaults to 1094
              <freq>     A value from 1 to 100 specifying how often to shed load
                         (1 = 1% chance; 100 = 100% chance; defaults to 10).
+             <dpct>     also shed when the device holding the file is busier
+                        than this percentage (from /proc/diskstats).  Files
+                        on the busiest devices are then shed preferentially.
+             <npct>     also shed when the network interface <ifname> is
+                        busier than this percentage of its link speed.
 
    Output: 0 upon success or !0 upon failure.
 */
 int FileSystem::xloadshed(XrdOucStream &Config)
 {
-    long long port = 0, freq = 0;
+    long long port = 0, freq = 0, diskutil = -1, netutil = -1;
     char *val;
-    std::string hostname;
+    std::string hostname, nic;
 
     while ((val = Config.GetWord()))
     {
@@ -262,6 +271,24 @@ int FileSystem::xloadshed(XrdOucStream &Config)
               {m_eroute.Emsg("Config", "Loadshed frequency not specified."); return 1;}
            if (XrdOuca2x::a2sz(m_eroute,"Loadshed frequency",val,&freq,1,100)) return 1;
        }
+       else if (strcmp("diskutil", val) == 0)
+       {
+           if (!(val = Config.GetWord()))
+              {m_eroute.Emsg("Config", "Loadshed disk utilisation not specified."); return 1;}
+           if (XrdOuca2x::a2sz(m_eroute,"Loadshed disk utilisation",val,&diskutil,0,100)) return 1;
+       }
+       else if (strcmp("netutil", val) == 0)
+       {
+           if (!(val = Config.GetWord()))
+              {m_eroute.Emsg("Config", "Loadshed network utilisation not specified."); return 1;}
+           if (XrdOuca2x::a2sz(m_eroute,"Loadshed network utilisation",val,&netutil,0,100)) return 1;
+       }
+       else if (strcmp("nic", val) == 0)
+       {
+           if (!(val = Config.GetWord()))
+              {m_eroute.Emsg("Config", "Loadshed network interface not specified."); return 1;}
+           nic = val;
+       }
        else
        {
            m_eroute.Emsg("Config", "Warning - unknown loadshed option specified", val, ".");
@@ -274,7 +301,178 @@ int FileSystem::xloadshed(XrdOucStream &Config)
         return 1;
     }
 
+    if (netutil >= 0 && nic.empty())
+    {
+        m_eroute.Emsg("Config", "must specify the nic for loadshed netutil.");
+        return 1;
+    }
+
     m_throttle.SetLoadShed(hostname, port, freq);
+    m_throttle.SetLoadMetrics(diskutil, netutil, nic);
+    return 0;
+}
+
+/******************************************************************************/
+/*                             x a d a p t i v e                              */
+/******************************************************************************/
+
+/* Function: xadaptive
+
+   Purpose:  To parse the directive: adaptive [target <ms>] [percentile <pct>]
+                                              [min <lower>] [max <upper>]
+
+             <ms>       IO latency, in milliseconds, above which the disks are
+                        considered saturated (default 100).
+             <pct>      the latency percentile compared to the target
+                        (default 95).
+             <lower>    the concurrency limit is never lowered below this
+                        number of IOs (default 4).
+             <upper>    the concurrency limit is never raised above this
+                        number of IOs (default the throttle concurrency or,
+                        if not set, 1024).
+
+             The concurrency limit is adjusted at every recompute interval.
+
+   Output: 0 upon success or !0 upon failure.
+*/
+int FileSystem::xadaptive(XrdOucStream &Config)
+{
+    long long target = 100, pct = 95, lower = 4, upper = -1;
+    char *val;
+
+    while ((val = Config.GetWord()))
+    {
+       if (strcmp("target", val) == 0)
+       {
+          if (!(val = Config.GetWord()))
+             {m_eroute.Emsg("Config", "adaptive latency target not specified."); return 1;}
+          if (XrdOuca2x::a2ll(m_eroute,"adaptive latency target",val,&target,1)) return 1;
+       }
+       else if (strcmp("percentile", val) == 0)
+       {
+          if (!(val = Config.GetWord()))
+             {m_eroute.Emsg("Config", "adaptive percentile not specified."); return 1;}
+          if (XrdOuca2x::a2ll(m_eroute,"adaptive percentile",val,&pct,1,100)) return 1;
+       }
+       else if (strcmp("min", val) == 0)
+       {
+          if (!(val = Config.GetWord()))
+             {m_eroute.Emsg("Config", "adaptive minimum not specified."); return 1;}
+          if (XrdOuca2x::a2sz(m_eroute,"adaptive minimum",val,&lower,1)) return 1;
+       }
+       else if (strcmp("max", val) == 0)
+       {
+          if (!(val = Config.GetWord()))
+             {m_eroute.Emsg("Config", "adaptive maximum not specified."); return 1;}
+          if (XrdOuca2x::a2sz(m_eroute,"adaptive maximum",val,&upper,1)) return 1;
+       }
+       else
+       {
+          m_eroute.Emsg("Config", "Warning - unknown adaptive option specified", val, ".");
+       }
+    }
+
+    m_throttle.SetAdaptive(static_cast<float>(target), pct, lower, upper);
+    return 0;
+}
+
+/******************************************************************************/
+/*                            x f a i r s h a r e                             */
+/******************************************************************************/
+
+/* Function: xfairshare
+
+   Purpose:  To parse the directive: fairshare {shares | buckets}
+
+             shares     per-user shares recomputed every interval (default).
+             buckets    hierarchical token buckets (global, VO, user) with
+                        weighted fair queuing of the waiting requests.
+
+   Output: 0 upon success or !0 upon failure.
+*/
+int FileSystem::xfairshare(XrdOucStream &Config)
+{
+    char *val;
+
+    if (!(val = Config.GetWord()))
+       {m_eroute.Emsg("Config", "fairshare mode not specified."); return 1;}
+
+    if (strcmp("shares", val) == 0) m_throttle.SetFairshare(false);
+    else if (strcmp("buckets", val) == 0) m_throttle.SetFairshare(true);
+    else
+       {m_eroute.Emsg("Config", "invalid fairshare mode", val, "."); return 1;}
+    return 0;
+}
+
+/******************************************************************************/
+/*                               x b u c k e t                                */
+/******************************************************************************/
+
+/* Function: xbucket
+
+   Purpose:  To parse the directive: bucket {vo | user} <name> [weight <wgt>]
+                                            [data <drate>] [iops <irate>]
+
+             <name>     the name of the VO (or group) or of the user. The
+                        name '*' sets the defaults for unlisted ones.
+             <wgt>      relative share of the parent bucket (default 1).
+             <drate>    maximum bytes per second for this bucket.
+             <irate>    maximum IOPS per second for this bucket.
+
+             Buckets are only used when 'fairshare buckets' is specified.
+
+   Output: 0 upon success or !0 upon failure.
+*/
+int FileSystem::xbucket(XrdOucStream &Config)
+{
+    XrdThrottleBuckets::Limits limits;
+    long long drate = -1, irate = -1, weight = 1;
+    bool isvo;
+    std::string name;
+    char *val;
+
+    if (!(val = Config.GetWord()))
+       {m_eroute.Emsg("Config", "bucket type not specified."); return 1;}
+    if (strcmp("vo", val) == 0) isvo = true;
+    else if (strcmp("user", val) == 0) isvo = false;
+    else
+       {m_eroute.Emsg("Config", "invalid bucket type", val, "."); return 1;}
+
+    if (!(val = Config.GetWord()))
+       {m_eroute.Emsg("Config", "bucket name not specified."); return 1;}
+    name = val;
+
+    while ((val = Config.GetWord()))
+    {
+       if (strcmp("weight", val) == 0)
+       {
+          if (!(val = Config.GetWord()))
+             {m_eroute.Emsg("Config", "bucket weight not specified."); return 1;}
+          if (XrdOuca2x::a2ll(m_eroute,"bucket weight value",val,&weight,1,1000)) return 1;
+       }
+       else if (strcmp("data", val) == 0)
+       {
+          if (!(val = Config.GetWord()))
+             {m_eroute.Emsg("Config", "bucket data limit not specified."); return 1;}
+          if (XrdOuca2x::a2sz(m_eroute,"bucket data value",val,&drate,1)) return 1;
+       }
+       else if (strcmp("iops", val) == 0)
+       {
+          if (!(val = Config.GetWord()))
+             {m_eroute.Emsg("Config", "bucket IOPS limit not specified."); return 1;}
+          if (XrdOuca2x::a2sz(m_eroute,"bucket IOPS value",val,&irate,1)) return 1;
+       }
+       else
+       {
+          m_eroute.Emsg("Config", "Warning - unknown bucket option specified", val, ".");
+       }
+    }
+
+    limits.weight = weight;
+    limits.bytes_per_second = drate;
+    limits.ops_per_second = irate;
+    if (isvo) m_throttle.Buckets().SetVO(name, limits);
+    else m_throttle.Buckets().SetUser(name, limits);
     return 0;
 }
 
@@ -0,0 +1,230 @@
+
+#include <stdio.h>
+#include <string.h>
+#include <sys/types.h>
+#if defined(__linux__)
+#include <sys/sysmacros.h>
+#endif
+
+#include "XrdThrottleLoadMonitor.hh"
+
+#include "XrdSys/XrdSysAtomics.hh"
+#include "XrdSys/XrdSysError.hh"
+
+#define XRD_TRACE m_trace->
+#include "XrdThrottle/XrdThrottleTrace.hh"
+
+const char *
+XrdThrottleLoadMonitor::TraceID = "ThrottleLoad";
+
+XrdThrottleLoadMonitor::XrdThrottleLoadMonitor(XrdSysError *lP, XrdOucTrace *tP) :
+   m_trace(tP),
+   m_log(lP),
+   m_ndevs(0),
+   m_busiest_util(0),
+   m_nic_speed(0),
+   m_nic_rx(0),
+   m_nic_tx(0),
+   m_net_util(-1),
+   m_net_rate(0)
+{
+   memset(m_devs, 0, sizeof(m_devs));
+}
+
+/*
+ * Find out the link speed of the interface, if one was configured.
+ */
+bool
+XrdThrottleLoadMonitor::Init()
+{
+#if defined(__linux__)
+   if (m_nic.empty()) return true;
+
+   std::string path = "/sys/class/net/" + m_nic + "/speed";
+   FILE *fp = fopen(path.c_str(), "r");
+   long long mbps = -1;
+   if (fp)
+   {
+      if (fscanf(fp, "%lld", &mbps) != 1) mbps = -1;
+      fclose(fp);
+   }
+   if (mbps <= 0)
+   {
+      m_log->Emsg("LoadMonitor", "Unable to determine link speed of", m_nic.c_str(),
+                  "; network utilisation will not be used.");
+      return false;
+   }
+   m_nic_speed = mbps * 1000 * 1000 / 8;
+   SampleNet(0);
+   return true;
+#else
+   if (!m_nic.empty())
+      m_log->Emsg("LoadMonitor", "Network utilisation is not supported on this platform.");
+   return m_nic.empty();
+#endif
+}
+
+int
+XrdThrottleLoadMonitor::TrackDevice(dev_t dev)
+{
+#if defined(__linux__)
+   unsigned maj = major(dev), min = minor(dev);
+   int ndevs = AtomicGet(m_ndevs);
+
+   // Fast path: most opens are on a device we already know.
+   for (int i=0; i<ndevs; i++)
+   {
+      if (m_devs[i].major == maj && m_devs[i].minor == min) return i;
+   }
+
+   XrdSysMutexHelper lock(m_dev_mutex);
+   for (int i=0; i<m_ndevs; i++)
+   {
+      if (m_devs[i].major == maj && m_devs[i].minor == min) return i;
+   }
+   if (m_ndevs >= m_max_devs) return -1;
+
+   DevInfo &info = m_devs[m_ndevs];
+   info.major = maj;
+   info.minor = min;
+   info.valid = false;
+   snprintf(info.name, sizeof(info.name), "%u:%u", maj, min);
+   TRACE(DEBUG, "Monitoring device " << info.name);
+   AtomicInc(m_ndevs);
+   return m_ndevs-1;
+#else
+   return -1;
+#endif
+}
+
+void
+XrdThrottleLoadMonitor::Sample(float interval_seconds)
+{
+   SampleDisks(interval_seconds);
+   if (m_nic_speed) SampleNet(interval_seconds);
+}
+
+/*
+ * Parse /proc/diskstats.  The fields we use are the device numbers and
+ * name, the number of IOs in progress and the milliseconds spent doing IO;
+ * the increase of the latter over the interval is the utilisation.
+ */
+bool
+XrdThrottleLoadMonitor::SampleDisks(float interval_seconds)
+{
+#if defined(__linux__)
+   if (!AtomicGet(m_ndevs)) return true;
+
+   FILE *fp = fopen("/proc/diskstats", "r");
+   if (!fp) return false;
+
+   XrdSysMutexHelper lock(m_dev_mutex);
+   char line[512], name[32];
+   unsigned maj, min;
+   unsigned long long f[11];
+   int busiest = 0;
+   while (fgets(line, sizeof(line), fp))
+   {
+      if (sscanf(line, "%u %u %31s %llu %llu %llu %llu %llu %llu %llu %llu %llu %llu %llu",
+                 &maj, &min, name, &f[0], &f[1], &f[2], &f[3], &f[4], &f[5], &f[6],
+                 &f[7], &f[8], &f[9], &f[10]) != 14) continue;
+      for (int i=0; i<m_ndevs; i++)
+      {
+         DevInfo &info = m_devs[i];
+         if (info.major != maj || info.minor != min) continue;
+         if (info.valid && interval_seconds > 0)
+         {
+            long long util = static_cast<long long>((f[9] - info.io_ticks) / (interval_seconds * 10));
+            info.util = (util > 100) ? 100 : (util < 0 ? 0 : static_cast<int>(util));
+         }
+         snprintf(info.name, sizeof(info.name), "%s", name);
+         info.inflight = static_cast<int>(f[8]);
+         info.io_ticks = f[9];
+         info.valid = true;
+         if (info.util > busiest) busiest = info.util;
+         TRACE(IOLOAD, "Device " << name << " utilisation " << info.util << "%; " << info.inflight << " IOs in flight.");
+         break;
+      }
+   }
+   fclose(fp);
+   m_busiest_util = busiest;
+   return true;
+#else
+   return false;
+#endif
+}
+
+/*
+ * Parse /proc/net/dev for the configured interface.  The link speed is per
+ * direction, so the utilisation is that of the busier of rx and tx.
+ */
+bool
+XrdThrottleLoadMonitor::SampleNet(float interval_seconds)
+{
+#if defined(__linux__)
+   FILE *fp = fopen("/proc/net/dev", "r");
+   if (!fp) return false;
+
+   char line[512];
+   unsigned long long f[16];
+   bool found = false;
+   while (fgets(line, sizeof(line), fp))
+   {
+      char *colon = strchr(line, ':');
+      if (!colon) continue;
+      *colon = '\0';
+      char *ifname = line;
+      while (*ifname == ' ') ifname++;
+      if (m_nic != ifname) continue;
+      if (sscanf(colon+1, "%llu %llu %llu %llu %llu %llu %llu %llu %llu",
+                 &f[0], &f[1], &f[2], &f[3], &f[4], &f[5], &f[6], &f[7], &f[8]) != 9) break;
+
+      unsigned long long rx = f[0], tx = f[8];
+      if (interval_seconds > 0 && m_nic_speed)
+      {
+         long long rate_rx = static_cast<long long>((rx - m_nic_rx) / interval_seconds);
+         long long rate_tx = static_cast<long long>((tx - m_nic_tx) / interval_seconds);
+         m_net_rate = rate_rx > rate_tx ? rate_rx : rate_tx;
+         long long util = m_net_rate * 100 / m_nic_speed;
+         m_net_util = (util > 100) ? 100 : static_cast<int>(util);
+         TRACE(IOLOAD, "Interface " << m_nic << " at " << m_net_rate << " bytes/s; utilisation " << m_net_util << "%.");
+      }
+      m_nic_rx = rx;
+      m_nic_tx = tx;
+      found = true;
+      break;
+   }
+   fclose(fp);
+   return found;
+#else
+   return false;
+#endif
+}
+
+int
+XrdThrottleLoadMonitor::Stats(char *buff, int blen)
+{
+   static const char statfmt1[] = "<load><net><name>%s</name><util>%d</util><rate>%lld</rate></net>";
+   static const char statfmt2[] = "<dev><name>%s</name><util>%d</util><queue>%d</queue></dev>";
+   static const char statfmt3[] = "</load>";
+   static const int  statflen = sizeof(statfmt1) + 64 + 16*2 + sizeof(statfmt3)
+                              + (sizeof(statfmt2) + 32 + 16*2) * m_max_devs;
+   char *bp = buff;
+   int n;
+
+   if (!buff) return statflen;
+   if (blen < statflen) return 0;
+
+   n = sprintf(bp, statfmt1, m_nic.empty() ? "" : m_nic.c_str(), m_net_util, m_net_rate);
+   bp += n;
+
+   XrdSysMutexHelper lock(m_dev_mutex);
+   for (int i=0; i<m_ndevs; i++)
+   {
+      n = sprintf(bp, statfmt2, m_devs[i].name, m_devs[i].util, m_devs[i].inflight);
+      bp += n;
+   }
+   strcpy(bp, statfmt3);
+   bp += sizeof(statfmt3)-1;
+   return bp - buff;
+}
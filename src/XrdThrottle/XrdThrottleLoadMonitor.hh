@@ -0,0 +1,96 @@
+
+/*
+ * XrdThrottleLoadMonitor
+ *
+ * Samples the utilisation of the block devices backing the files served
+ * and of the network interface, so that the load shedding decision can be
+ * based on the real state of the server rather than only on the throttle
+ * limits being hit.
+ *
+ * Devices are registered as files get opened (using the device of the
+ * file) and sampled from /proc/diskstats every recompute interval; the
+ * interface throughput is taken from /proc/net/dev and compared with the
+ * link speed.  Readers never take a lock: the per-device figures are plain
+ * ints updated by the sampling thread.
+ */
+
+#ifndef __XrdThrottleLoadMonitor_hh_
+#define __XrdThrottleLoadMonitor_hh_
+
+#include <string>
+#include <sys/types.h>
+
+#include "XrdSys/XrdSysPthread.hh"
+
+class XrdSysError;
+class XrdOucTrace;
+
+class XrdThrottleLoadMonitor
+{
+public:
+
+void        SetNic(const std::string &nic) {m_nic = nic;}
+
+bool        Init();
+
+// Start monitoring the device; returns the device slot or -1.
+int         TrackDevice(dev_t dev);
+
+// Sample all the metrics; interval is the time since the previous sample.
+void        Sample(float interval_seconds);
+
+// The last utilisation (0-100) of the device in the given slot.
+int         DeviceUtil(int slot) const {return (slot >= 0 && slot < m_ndevs) ? m_devs[slot].util : 0;}
+
+// The number of IOs in flight on the device in the given slot.
+int         DeviceQueue(int slot) const {return (slot >= 0 && slot < m_ndevs) ? m_devs[slot].inflight : 0;}
+
+int         BusiestUtil() const {return m_busiest_util;}
+
+// The last utilisation (0-100) of the network interface, -1 if unknown.
+int         NetUtil() const {return m_net_util;}
+
+int         Stats(char *buff, int blen);
+
+            XrdThrottleLoadMonitor(XrdSysError *lP, XrdOucTrace *tP);
+
+           ~XrdThrottleLoadMonitor() {}
+
+private:
+
+bool        SampleDisks(float interval_seconds);
+
+bool        SampleNet(float interval_seconds);
+
+struct DevInfo
+{
+   unsigned           major;
+   unsigned           minor;
+   unsigned long long io_ticks;  // Milliseconds spent doing IO
+   int                util;
+   int                inflight;
+   bool               valid;     // io_ticks holds a previous sample
+   char               name[32];
+};
+
+static const int m_max_devs = 64;
+
+XrdOucTrace * m_trace;
+XrdSysError * m_log;
+
+XrdSysMutex   m_dev_mutex;   // Serializes TrackDevice() and Sample()
+DevInfo       m_devs[m_max_devs];
+int           m_ndevs;
+int           m_busiest_util;
+
+std::string   m_nic;
+long long     m_nic_speed;   // Bytes per second, 0 if unknown
+unsigned long long m_nic_rx;
+unsigned long long m_nic_tx;
+int           m_net_util;
+long long     m_net_rate;    // Bytes per second in the last interval
+
+static const char *TraceID;
+};
+
+#endif
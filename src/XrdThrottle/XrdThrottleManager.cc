@@ -1,10 +1,13 @@
 
 #include "XrdThrottleManager.hh"
 
+#include "Xrd/XrdStatsShm.hh"
+
 #include "XrdSys/XrdSysAtomics.hh"
 #include "XrdSys/XrdSysTimer.hh"
 
 #include "XrdOuc/XrdOucEnv.hh"
+#include "XrdSec/XrdSecEntity.hh"
 
 #define XRD_TRACE m_trace->
 #include "XrdThrottle/XrdThrottleTrace.hh"
@@ -31,19 +34,44 @@ XrdThrottleManager::XrdThrottleManager(XrdSysError *lP, XrdOucTrace *tP) :
    m_concurrency_limit(-1),
    m_last_round_allocation(100*1024),
    m_io_counter(0),
+   m_adaptive(false),
+   m_adapt_target_us(100000),
+   m_adapt_percentile(95),
+   m_adapt_min(4),
+   m_adapt_max(-1),
+   m_adapt_last_us(0),
+   m_concurrency_hit(0),
+   m_io_waiters(0),
+   m_use_buckets(false),
+   m_buckets(lP, tP),
    m_loadshed_host(""),
    m_loadshed_port(0),
    m_loadshed_frequency(0),
-   m_loadshed_limit_hit(0)
+   m_loadshed_limit_hit(0),
+   m_loadshed_disk_util(-1),
+   m_loadshed_net_util(-1),
+   m_load(lP, tP),
+   m_shm_ctr(XrdStatsShm::noCtr),
+   m_shm_ios(-1)
 {
+   m_stable_io_counter = 0;
    m_stable_io_wait.tv_sec = 0;
    m_stable_io_wait.tv_nsec = 0;
+   for (int i=0; i<m_lat_buckets; i++)
+   {
+      m_lat_interval[i] = 0;
+      m_lat_total[i] = 0;
+   }
 }
 
 void
 XrdThrottleManager::Init()
 {
+   static const char *ctr_names[] = {"bytes", "limit", "waitus"};
+
    TRACE(DEBUG, "Initializing the throttle manager.");
+   m_shm_ctr = XrdStatsShm::Define("throttle", ctr_names, 3);
+   m_shm_ios = XrdStatsShm::Define("throttle.ios", XrdStatsShm::isGauge);
    // Initialize all our shares to zero.
    m_primary_bytes_shares.reserve(m_max_users);
    m_secondary_bytes_shares.reserve(m_max_users);
@@ -61,6 +89,28 @@ XrdThrottleManager::Init()
    m_io_wait.tv_sec = 0;
    m_io_wait.tv_nsec = 0;
 
+   if (m_adaptive)
+   {
+      // The configured concurrency, if any, is the ceiling of the adaptive one.
+      if (m_adapt_max <= 0) m_adapt_max = (m_concurrency_limit > 0) ? m_concurrency_limit : 1024;
+      if (m_adapt_min > m_adapt_max) m_adapt_min = m_adapt_max;
+      m_concurrency_limit = m_adapt_max;
+      TRACE(IOLOAD, "Adaptive concurrency between " << m_adapt_min << " and " << m_adapt_max
+                    << "; target p" << m_adapt_percentile << " latency " << m_adapt_target_us << "us.");
+   }
+
+   if (m_loadshed_net_util >= 0 && !m_load.Init())
+   {
+      m_loadshed_net_util = -1;
+   }
+
+   if (m_use_buckets)
+   {
+      TRACE(DEBUG, "Using hierarchical token buckets for fairshare.");
+      m_buckets.SetGlobal(m_bytes_per_second, m_ops_per_second, m_interval_length_seconds);
+      m_buckets.Init();
+   }
+
    int rc;
    pthread_t tid;
    if ((rc = XrdSysThread::Run(&tid, XrdThrottleManager::RecomputeBootstrap, static_cast<void *>(this), 0, "Buffer Manager throttle")))
@@ -111,6 +161,18 @@ XrdThrottleManager::StealShares(int uid, int &reqsize, int &reqops)
 void
 XrdThrottleManager::Apply(int reqsize, int reqops, int uid)
 {
+   XrdStatsShm::Add(m_shm_ctr, reqsize);
+   if (m_use_buckets)
+   {
+      if (m_buckets.Apply(reqsize, reqops, uid))
+      {
+         AtomicBeg(m_compute_var);
+         AtomicInc(m_loadshed_limit_hit);
+         AtomicEnd(m_compute_var);
+         XrdStatsShm::Add(m_shm_ctr+1);
+      }
+      return;
+   }
    if (m_bytes_per_second < 0)
       reqsize = 0;
    if (m_ops_per_second < 0)
@@ -146,6 +208,7 @@ XrdThrottleManager::Apply(int reqsize, int reqops, int uid)
          AtomicBeg(m_compute_var);
          AtomicInc(m_loadshed_limit_hit);
          AtomicEnd(m_compute_var);
+         XrdStatsShm::Add(m_shm_ctr+1);
       }
    }
 
@@ -254,9 +317,105 @@ XrdThrottleManager::RecomputeInternal()
    }
    m_compute_var.UnLock();
    TRACE(IOLOAD, "Current IO counter is " << m_stable_io_counter << "; total IO wait time is " << (m_stable_io_wait.tv_sec*1000+m_stable_io_wait.tv_nsec/1000000) << "ms.");
+
+   RecomputeConcurrency();
+
+   if (m_loadshed_port && (m_loadshed_disk_util >= 0 || m_loadshed_net_util >= 0))
+   {
+      m_load.Sample(m_interval_length_seconds);
+   }
+
    m_compute_var.Broadcast();
 }
 
+/*
+ * Adjust the concurrency limit from the IO latencies seen during the last
+ * interval (additive increase, multiplicative decrease).  When the chosen
+ * latency percentile is above the target, the disks are saturated and the
+ * limit is cut by 10%.  When it is below the target and IOs had to wait
+ * for a slot, the limit is raised by 1/16th (at least one slot).  With
+ * too few samples the limit is left alone.
+ */
+void
+XrdThrottleManager::RecomputeConcurrency()
+{
+   unsigned long long hist[m_lat_buckets];
+   unsigned long long samples = 0;
+
+   AtomicBeg(m_compute_var);
+   for (int i=0; i<m_lat_buckets; i++)
+   {
+      hist[i] = AtomicFAZ(m_lat_interval[i]);
+      samples += hist[i];
+   }
+   int hits = AtomicFAZ(m_concurrency_hit);
+   AtomicEnd(m_compute_var);
+
+   if (!m_adaptive) return;
+
+   if (samples < 16)
+   {
+      TRACE(IOLOAD, "Too few IO samples (" << samples << ") to adjust concurrency limit " << m_concurrency_limit);
+      return;
+   }
+
+   long latency = LatencyPercentile(hist, m_adapt_percentile);
+   int limit = m_concurrency_limit, new_limit = limit;
+   if (latency > m_adapt_target_us)
+   {
+      new_limit = static_cast<int>(limit * 0.9);
+      if (new_limit == limit) new_limit--;
+      if (new_limit < m_adapt_min) new_limit = m_adapt_min;
+   }
+   else if (hits)
+   {
+      new_limit = limit + ((limit/16) ? limit/16 : 1);
+      if (new_limit > m_adapt_max) new_limit = m_adapt_max;
+   }
+
+   m_adapt_last_us = latency;
+   if (new_limit != limit)
+   {
+      TRACE(IOLOAD, "IO p" << m_adapt_percentile << " latency " << latency << "us; concurrency limit " << limit << " -> " << new_limit);
+      m_concurrency_limit = new_limit;
+   }
+}
+
+/*
+ * Latencies are kept in log2 buckets of microseconds.
+ */
+int
+XrdThrottleManager::LatencyBucket(long latency_us)
+{
+   int bucket = 0;
+   while (latency_us > 0 && bucket < m_lat_buckets-1)
+   {
+      latency_us >>= 1;
+      bucket++;
+   }
+   return bucket;
+}
+
+/*
+ * Return the upper bound, in microseconds, of the bucket holding the
+ * requested percentile.
+ */
+long
+XrdThrottleManager::LatencyPercentile(const unsigned long long *hist, int percentile)
+{
+   unsigned long long samples = 0, seen = 0;
+   for (int i=0; i<m_lat_buckets; i++) samples += hist[i];
+   if (!samples) return 0;
+
+   unsigned long long wanted = (samples * percentile + 99) / 100;
+   for (int i=0; i<m_lat_buckets; i++)
+   {
+      seen += hist[i];
+      if (seen >= wanted) return 1L << i;
+   }
+   return 1L << (m_lat_buckets-1);
+}
+
 /*
  * Do a simple hash across the username.
  */
@@ -275,6 +434,92 @@ XrdThrottleManager::GetUid(const char *username)
    return hval;
 }
 
+/*
+ * With token buckets each user gets its own bucket below the one of its
+ * VO; the first VO (or, lacking one, the first group) is used.
+ */
+int
+XrdThrottleManager::GetUid(const XrdSecEntity *client)
+{
+   const char *name = client ? client->name : 0;
+   if (!m_use_buckets) return GetUid(name);
+
+   const char *group = client ? (client->vorg && *client->vorg ? client->vorg : client->grps) : 0;
+   std::string vo;
+   if (group)
+   {
+      vo = group;
+      std::string::size_type pos = vo.find_first_of(" ,");
+      if (pos != std::string::npos) vo.erase(pos);
+   }
+   return m_buckets.GetUid(name ? name : "", vo.c_str());
+}
+
+/*
+ * Report the throttle statistics for the summary monitoring stream.
+ */
+int
+XrdThrottleManager::Stats(char *buff, int blen)
+{
+   static const char statfmt1[] = "<stats id=\"throttle\"><lhit>%d</lhit><io><active>%d</active>"
+                                  "<wait_ms>%lld</wait_ms></io>";
+   static const char statfmt3[] = "<conc><limit>%d</limit><adaptive>%d</adaptive>"
+                                  "<lat_us>%ld</lat_us></conc>";
+   static const char statfmt4[] = "<lat><p50>%ld</p50><p95>%ld</p95><p99>%ld</p99><hist>";
+   static const char statfmt5[] = "</hist></lat>";
+   static const char statfmt2[] = "</stats>";
+   static const int  statflen = sizeof(statfmt1) + 16*3 + sizeof(statfmt3) + 16*3
+                              + sizeof(statfmt4) + 16*3 + 21*m_lat_buckets
+                              + sizeof(statfmt5) + sizeof(statfmt2);
+   unsigned long long hist[m_lat_buckets];
+   char *bp = buff;
+   int n;
+
+   bool use_load = m_loadshed_port && (m_loadshed_disk_util >= 0 || m_loadshed_net_util >= 0);
+   if (!buff) return statflen + (m_use_buckets ? m_buckets.Stats(0, 0) : 0)
+                              + (use_load ? m_load.Stats(0, 0) : 0);
+   if (blen < statflen) return 0;
+
+   m_compute_var.Lock();
+   long long wait_ms = m_stable_io_wait.tv_sec*1000 + m_stable_io_wait.tv_nsec/1000000;
+   n = sprintf(bp, statfmt1, AtomicGet(m_loadshed_limit_hit), m_stable_io_counter, wait_ms);
+   m_compute_var.UnLock();
+   bp += n; blen -= n;
+
+   n = sprintf(bp, statfmt3, m_concurrency_limit, m_adaptive ? 1 : 0, m_adapt_last_us);
+   bp += n; blen -= n;
+
+   AtomicBeg(m_compute_var);
+   for (int i=0; i<m_lat_buckets; i++) hist[i] = AtomicGet(m_lat_total[i]);
+   AtomicEnd(m_compute_var);
+   n = sprintf(bp, statfmt4, LatencyPercentile(hist, 50), LatencyPercentile(hist, 95),
+                             LatencyPercentile(hist, 99));
+   bp += n; blen -= n;
+   for (int i=0; i<m_lat_buckets; i++)
+   {
+      n = sprintf(bp, i ? " %llu" : "%llu", hist[i]);
+      bp += n; blen -= n;
+   }
+   strcpy(bp, statfmt5);
+   bp += sizeof(statfmt5)-1; blen -= sizeof(statfmt5)-1;
+
+   if (m_use_buckets)
+   {
+      n = m_buckets.Stats(bp, blen - static_cast<int>(sizeof(statfmt2)));
+      bp += n; blen -= n;
+   }
+
+   if (use_load)
+   {
+      n = m_load.Stats(bp, blen - static_cast<int>(sizeof(statfmt2)));
+      bp += n; blen -= n;
+   }
+
+   strcpy(bp, statfmt2);
+   bp += sizeof(statfmt2)-1;
+   return bp - buff;
+}
+
 /*
  * Create an IO timer object; increment the number of outstanding IOs.
  */
@@ -288,13 +533,18 @@ XrdThrottleManager::StartIOTimer()
    {
       AtomicBeg(m_compute_var);
       AtomicInc(m_loadshed_limit_hit);
+      AtomicInc(m_concurrency_hit);
+      AtomicInc(m_io_waiters);
       AtomicDec(m_io_counter);
       AtomicEnd(m_compute_var);
+      XrdStatsShm::Add(m_shm_ctr+1);
       m_compute_var.Wait();
       AtomicBeg(m_compute_var);
+      AtomicDec(m_io_waiters);
       cur_counter = AtomicInc(m_io_counter);
       AtomicEnd(m_compute_var);
    }
+   XrdStatsShm::Add(m_shm_ios);
    return XrdThrottleTimer(*this);
 }
 
@@ -302,39 +552,80 @@ XrdThrottleManager::StartIOTimer()
  * Finish recording an IO timer.
  */
 void
-XrdThrottleManager::StopIOTimer(struct timespec timer)
+XrdThrottleManager::StopIOTimer(struct timespec timer, long latency_us)
 {
    AtomicBeg(m_compute_var);
    AtomicDec(m_io_counter);
    AtomicAdd(m_io_wait.tv_sec, timer.tv_sec);
    // Note this may result in tv_nsec > 1e9
    AtomicAdd(m_io_wait.tv_nsec, timer.tv_nsec);
+   if (latency_us >= 0)
+   {
+      int bucket = LatencyBucket(latency_us);
+      AtomicInc(m_lat_interval[bucket]);
+      AtomicInc(m_lat_total[bucket]);
+   }
+   int waiters = AtomicGet(m_io_waiters);
    AtomicEnd(m_compute_var);
+   XrdStatsShm::Add(m_shm_ios, -1);
+   XrdStatsShm::Add(m_shm_ctr+2, timer.tv_sec*1000000LL + timer.tv_nsec/1000);
+
+   // Hand the slot over right away rather than at the next recompute.
+   if (waiters) m_compute_var.Signal();
 }
 
 /*
  * Check the counters to see if we have hit any throttle limits in the
- * current time period.  If so, shed the client randomly.
+ * current time period, or if the network interface or the device holding
+ * the file (given by its monitor slot) is over the configured utilisation.
+ * If so, shed the client randomly.
+ *
+ * When device utilisation is monitored, files are shed in proportion to
+ * the utilisation of their device relative to the busiest one, so that
+ * clients reading from the busiest device are redirected first.  When a
+ * throttle limit is hit, clients of idle devices are still shed at a
+ * quarter of the frequency as the server as a whole is over its limit.
  *
  * If the client has already been load-shedded once and reconnected to this
  * server, then do not load-shed it again.
  */
 bool
-XrdThrottleManager::CheckLoadShed(const std::string &opaque)
+XrdThrottleManager::CheckLoadShed(const std::string &opaque, int devslot)
 {
    if (m_loadshed_port == 0)
    {
       return false;
    }
-   if (AtomicGet(m_loadshed_limit_hit) == 0)
+   if (opaque.empty())
    {
       return false;
    }
-   if (static_cast<unsigned>(rand()) % 100 > m_loadshed_frequency)
+
+   unsigned frequency = 0;
+   bool overloaded = AtomicGet(m_loadshed_limit_hit) != 0;
+   if (m_loadshed_disk_util >= 0 && devslot >= 0)
    {
-      return false;
+      int util = m_load.DeviceUtil(devslot);
+      int busiest = m_load.BusiestUtil();
+      if (overloaded || util >= m_loadshed_disk_util)
+      {
+         frequency = (busiest > 0) ? m_loadshed_frequency * util / busiest : m_loadshed_frequency;
+         if (overloaded && frequency < m_loadshed_frequency / 4)
+         {
+            frequency = m_loadshed_frequency / 4;
+         }
+      }
    }
-   if (opaque.empty())
+   else if (overloaded)
+   {
+      frequency = m_loadshed_frequency;
+   }
+   if (m_loadshed_net_util >= 0 && m_load.NetUtil() >= m_loadshed_net_util)
+   {
+      frequency = m_loadshed_frequency;
+   }
+
+   if (static_cast<unsigned>(rand()) % 100 >= frequency)
    {
       return false;
    }
@@ -33,7 +33,10 @@
 #include <time.h>
 
 #include "XrdSys/XrdSysPthread.hh"
+#include "XrdThrottle/XrdThrottleBuckets.hh"
+#include "XrdThrottle/XrdThrottleLoadMonitor.hh"
 
+class XrdSecEntity;
 class XrdSysError;
 class XrdOucTrace;
 class XrdThrottleTimer;
@@ -58,16 +61,35 @@ void        SetThrottles(float reqbyterate, float reqoprate, int concurrency, fl
 void        SetLoadShed(std::string &hostname, unsigned port, unsigned frequency)
             {m_loadshed_host = hostname; m_loadshed_port = port; m_loadshed_frequency = frequency;}
 
-//int         Stats(char *buff, int blen, int do_sync=0) {return m_pool.Stats(buff, blen, do_sync);}
+// Also shed when a device or the network interface is busier than the
+// given utilisation percentage (-1 to disable).
+void        SetLoadMetrics(int disk_util, int net_util, const std::string &nic)
+            {m_loadshed_disk_util = disk_util; m_loadshed_net_util = net_util; m_load.SetNic(nic);}
+
+void        SetFairshare(bool use_buckets) {m_use_buckets = use_buckets;}
+
+void        SetAdaptive(float target_ms, int percentile, int min_limit, int max_limit)
+            {m_adaptive = true; m_adapt_target_us = static_cast<long>(target_ms*1000);
+             m_adapt_percentile = percentile; m_adapt_min = min_limit; m_adapt_max = max_limit;}
+
+XrdThrottleBuckets &Buckets() {return m_buckets;}
+
+int         Stats(char *buff, int blen);
 
 static
 int         GetUid(const char *username);
 
+int         GetUid(const XrdSecEntity *client);
+
 XrdThrottleTimer StartIOTimer();
 
 void        PrepLoadShed(const char *opaque, std::string &lsOpaque);
 
-bool        CheckLoadShed(const std::string &opaque);
+bool        CheckLoadShed(const std::string &opaque, int devslot=-1);
+
+bool        UseDeviceLoad() const {return m_loadshed_port && m_loadshed_disk_util >= 0;}
+
+int         TrackDevice(dev_t dev) {return m_load.TrackDevice(dev);}
 
 void        PerformLoadShed(const std::string &opaque, std::string &host, unsigned &port);
 
@@ -77,7 +99,7 @@ void        PerformLoadShed(const std::string &opaque, std::string &host, unsign
 
 protected:
 
-void        StopIOTimer(struct timespec);
+void        StopIOTimer(struct timespec, long latency_us);
 
 private:
 
@@ -90,6 +112,14 @@ void *      RecomputeBootstrap(void *pp);
 
 int         WaitForShares();
 
+void        RecomputeConcurrency();
+
+static
+int         LatencyBucket(long latency_us);
+
+static
+long        LatencyPercentile(const unsigned long long *hist, int percentile);
+
 void        GetShares(int &shares, int &request);
 
 void        StealShares(int uid, int &reqsize, int &reqops);
@@ -121,11 +151,38 @@ struct timespec m_io_wait;
 int         m_stable_io_counter;
 struct timespec m_stable_io_wait;
 
+// IO latency histograms; bucket i counts latencies below 2^i microseconds.
+static const
+int         m_lat_buckets = 32;
+unsigned    m_lat_interval[m_lat_buckets];          // Current interval
+unsigned long long m_lat_total[m_lat_buckets];      // Since startup
+
+// Adaptive concurrency limit (AIMD on an IO latency percentile)
+bool        m_adaptive;
+long        m_adapt_target_us;
+int         m_adapt_percentile;
+int         m_adapt_min;
+int         m_adapt_max;
+long        m_adapt_last_us;      // Percentile seen in the last interval
+int         m_concurrency_hit;    // Times the limit was hit in the interval
+int         m_io_waiters;         // Threads waiting for an IO slot
+
+// Hierarchical token buckets, used instead of the shares when configured
+bool        m_use_buckets;
+XrdThrottleBuckets m_buckets;
+
 // Load shed details
 std::string m_loadshed_host;
 unsigned m_loadshed_port;
 unsigned m_loadshed_frequency;
 int m_loadshed_limit_hit;
+int m_loadshed_disk_util;
+int m_loadshed_net_util;
+XrdThrottleLoadMonitor m_load;
+
+// Shared statistics (see XrdStatsShm); bytes, limit and waitus are consecutive
+int m_shm_ctr;
+int m_shm_ios;
 
 static const char *TraceID;
 
@@ -146,6 +203,13 @@ void StopTimer()
 #else
    int retval = -1;
 #endif
+   struct timespec end_wall = {0, 0};
+   long latency_us = -1;
+   if (likely(clock_gettime(CLOCK_MONOTONIC, &end_wall) == 0) && m_wall.tv_nsec != -1)
+   {
+      latency_us = (end_wall.tv_sec - m_wall.tv_sec) * 1000000 +
+                   (end_wall.tv_nsec - m_wall.tv_nsec) / 1000;
+   }
    if (likely(retval == 0))
    {
       end_timer.tv_sec -= m_timer.tv_sec;
@@ -158,7 +222,7 @@ void StopTimer()
    }
    if (m_timer.tv_nsec != -1)
    {
-      m_manager.StopIOTimer(end_timer);
+      m_manager.StopIOTimer(end_timer, latency_us);
    }
    m_timer.tv_sec = 0;
    m_timer.tv_nsec = -1;
@@ -187,11 +251,18 @@ XrdThrottleTimer(XrdThrottleManager & manager) :
       m_timer.tv_sec = 0;
       m_timer.tv_nsec = 0;
    }
+   // The IO timer may measure thread CPU time; latency needs the wall clock.
+   if (unlikely(clock_gettime(CLOCK_MONOTONIC, &m_wall) == -1))
+   {
+      m_wall.tv_sec = 0;
+      m_wall.tv_nsec = -1;
+   }
 }
 
 private:
 XrdThrottleManager &m_manager;
 struct timespec m_timer;
+struct timespec m_wall;
 
 static int clock_id;
 };
@@ -171,6 +171,7 @@ add_library(
   Xrd/XrdProtocol.cc            Xrd/XrdProtocol.hh
   Xrd/XrdScheduler.cc           Xrd/XrdScheduler.hh
   Xrd/XrdSendQ.cc               Xrd/XrdSendQ.hh
+  Xrd/XrdStatsShm.cc            Xrd/XrdStatsShm.hh
                                 Xrd/XrdTrace.hh
 
   #-----------------------------------------------------------------------------
@@ -28,10 +28,14 @@
 /* specific prior written permission of the institution or contributor.       */
 /******************************************************************************/
   
+#include <errno.h>
+#include <stdio.h>
 #include <unistd.h>
+#include <sys/mman.h>
 
 #include "Xrd/XrdBuffer.hh"
 #include "Xrd/XrdLink.hh"
+#include "Xrd/XrdStatsShm.hh"
 #include "XProtocol/XProtocol.hh"
 #include "XrdSys/XrdSysError.hh"
 #include "XrdSys/XrdSysPthread.hh"
@@ -56,6 +60,13 @@ const char               *XrdXrootdAio::TraceID = "Aio";
 
 int                       XrdXrootdAio::maxAio;
 
+char                     *XrdXrootdAio::poolMem = 0;
+size_t                    XrdXrootdAio::poolLen = 0;
+XrdBuffer               **XrdXrootdAio::poolStk = 0;
+int                       XrdXrootdAio::poolTop = 0;
+int                       XrdXrootdAio::poolSeg = 0;
+int                       XrdXrootdAio::poolShm = XrdStatsShm::noCtr;
+
 XrdSysError              *XrdXrootdAioReq::eDest;
 XrdSysMutex               XrdXrootdAioReq::rqMutex;
 XrdXrootdAioReq          *XrdXrootdAioReq::rqFirst = 0;
@@ -77,18 +88,24 @@ XrdXrootdAio *XrdXrootdAio::Alloc(XrdXrootdAioReq *arp, int bsize)
 {
    XrdXrootdAio *aiop;
 
-// Obtain an aio object
+// Obtain an aio object and, if we have a segment pool, a segment from it
 //
    fqMutex.Lock();
    if ((aiop = fqFirst)) fqFirst = aiop->Next;
       else if (maxAio) aiop = addBlock();
    if (aiop && (++(SI->AsyncNow) > SI->AsyncMax)) SI->AsyncMax = SI->AsyncNow;
+   if (aiop && bsize && bsize <= poolSeg && poolTop)
+      {aiop->buffp = poolStk[--poolTop];
+       aiop->buffp->bsize = bsize;
+      }
    fqMutex.UnLock();
 
-// Allocate a buffer for this object
+// Allocate a buffer for this object if the pool did not supply one
 //
    if (aiop)
-      {if (bsize && (aiop->buffp = BPool->Obtain(bsize)))
+      {if (poolShm >= 0) XrdStatsShm::Add(poolShm + (aiop->buffp ? 0 : 1));
+       if (bsize && !aiop->buffp) aiop->buffp = BPool->Obtain(bsize);
+       if (aiop->buffp)
           {aiop->sfsAio.aio_buf = (void *)(aiop->buffp->buff);
            aiop->aioReq = arp;
            aiop->TIdent = arp->Link->ID;
@@ -183,13 +200,15 @@ void XrdXrootdAio::doneWrite()
 void XrdXrootdAio::Recycle()
 {
 
-// Recycle the buffer
+// Recycle the buffer unless it is a pool segment which is returned below
 //
-   if (buffp) {BPool->Release(buffp); buffp = 0;}
+   if (buffp && (buffp->buff < poolMem || buffp->buff >= poolMem+poolLen))
+      {BPool->Release(buffp); buffp = 0;}
 
 // Add this object to the free queue
 //
    fqMutex.Lock();
+   if (buffp) {poolStk[poolTop++] = buffp; buffp = 0;}
    Next = fqFirst;
    fqFirst = this;
    if (--(SI->AsyncNow) < 0) SI->AsyncNow=0;
@@ -218,6 +237,65 @@ XrdXrootdAio *XrdXrootdAio::addBlock()
 
    return aiop;
 }
+
+/******************************************************************************/
+/*                    X r d X r o o t d A i o : : P o o l                     */
+/******************************************************************************/
+
+// Pool() preallocates num segments of segsz bytes in a single region backed,
+// if at all possible, by 2MB huge pages. This avoids allocator traffic and
+// TLB misses when async I/O is heavy and, being one contiguous region, allows
+// it to be registered with the kernel as a fixed buffer. Segments are handed
+// out by Alloc() and the general buffer pool is used only when none are left.
+
+bool XrdXrootdAio::Pool(XrdSysError *eDest, int num, int segsz)
+{
+   static const char *shmNames[] = {"hit", "miss"};
+   const size_t hugeSZ = 2*1024*1024;
+   const char *how = "huge pages";
+   char buff[128];
+   void *memP;
+   size_t mLen = (((size_t)num * segsz) + hugeSZ - 1) & ~(hugeSZ - 1);
+
+// Try for explicit huge pages and fallback to transparent ones if the system
+// has not reserved any for us.
+//
+#ifdef MAP_HUGETLB
+   memP = mmap(0, mLen, PROT_READ|PROT_WRITE,
+               MAP_PRIVATE|MAP_ANONYMOUS|MAP_HUGETLB, -1, 0);
+   if (memP == MAP_FAILED)
+#endif
+      {memP = mmap(0, mLen, PROT_READ|PROT_WRITE,
+                   MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+       if (memP == MAP_FAILED)
+          {eDest->Emsg("Config", errno, "allocate aio segment pool");
+           return false;
+          }
+#ifdef MADV_HUGEPAGE
+       if (madvise(memP, mLen, MADV_HUGEPAGE)) how = "regular pages";
+          else how = "transparent huge pages";
+#else
+       how = "regular pages";
+#endif
+      }
+
+// Carve up the region into segments, lowest addresses being used first
+//
+   poolMem = (char *)memP;
+   poolLen = mLen;
+   poolSeg = segsz;
+   poolStk = new XrdBuffer*[num];
+   for (int i = 0; i < num; i++)
+       poolStk[num-i-1] = new XrdBuffer(poolMem + (size_t)i*segsz, segsz, 0);
+   poolTop = num;
+   poolShm = XrdStatsShm::Define("aio.pool", shmNames, 2);
+
+// Tell everyone what we did
+//
+   snprintf(buff, sizeof(buff), "%d %dK segments using ", num, segsz/1024);
+   eDest->Say("Config aio pool: ", buff, how, ".");
+   return true;
+}
   
 /******************************************************************************/
 /*                       X r d X r o o t d A i o R e q                        */
@@ -320,10 +398,11 @@ XrdXrootdAio *XrdXrootdAioReq::getAio()
 /*                 X r d X r o o t d A i o R e q : : I n i t                  */
 /******************************************************************************/
   
-void XrdXrootdAioReq::Init(int iosize, int maxaiopr, int maxaio)
+void XrdXrootdAioReq::Init(int iosize, int maxaiopr, int maxaio, int aiopool)
 {
    XrdXrootdAio    *aiop;
    XrdXrootdAioReq *arp;
+   int              aioMax;
 
 // Set the pointer to the buffer pool, scheduler and statistical area, these are
 // only used by the Aio object
@@ -348,6 +427,7 @@ void XrdXrootdAioReq::Init(int iosize, int maxaiopr, int maxaio)
    maxAioPR  = (maxaiopr < 1 ? 8 : maxaiopr);
    maxAioPR2 = maxAioPR * 2;
    XrdXrootdAio::maxAio = (maxaio < maxAioPR ? maxAioPR : maxaio);
+   aioMax = XrdXrootdAio::maxAio;
 
 // Do some debuging
 //
@@ -359,6 +439,17 @@ void XrdXrootdAioReq::Init(int iosize, int maxaiopr, int maxaio)
 //
    if ((arp  =               addBlock())) {arp->Clear(0); arp->Recycle(0);}
    if ((aiop = XrdXrootdAio::addBlock())) aiop->Recycle();
+
+// If a segment pool is wanted (a negative size means one segment for each aio
+// object we may have) create it and preallocate the aio objects to go with it.
+// We never pool more segments than aio objects as the excess could not be used.
+//
+   if (aiopool)
+      {if (aiopool < 0 || aiopool > aioMax) aiopool = aioMax;
+       if (XrdXrootdAio::Pool(eDest, aiopool, QuantumMax))
+          while(aioMax - XrdXrootdAio::maxAio < aiopool && XrdXrootdAio::maxAio
+            && (aiop = XrdXrootdAio::addBlock())) aiop->Recycle();
+      }
 }
 
 /******************************************************************************/
@@ -70,6 +70,7 @@ private:
 
 static  XrdXrootdAio    *Alloc(XrdXrootdAioReq *arp, int bsize=0);
 static  XrdXrootdAio    *addBlock();
+static  bool             Pool(XrdSysError *eDest, int num, int segsz);
 
 static  const char      *TraceID;
 static  XrdBuffManager  *BPool;   // -> Buffer Manager
@@ -78,6 +79,12 @@ static  XrdXrootdStats  *SI;      // -> System Statistics
 static  XrdSysMutex      fqMutex; // Locks static data
 static  XrdXrootdAio    *fqFirst; // -> Object in free queue
 static  int              maxAio;  // Maximum Aio objects we can yet have
+static  char            *poolMem; // -> Preallocated segment region
+static  size_t           poolLen; //    Length of the region
+static  XrdBuffer      **poolStk; // -> Free segments in the region
+static  int              poolTop; //    Number of free segments
+static  int              poolSeg; //    Size of each segment
+static  int              poolShm; //    Shared statistics counter ids
 
         XrdXrootdAio    *Next;    // Chain pointer
         XrdXrootdAioReq *aioReq;  // -> Associated request object
@@ -115,7 +122,8 @@ inline XrdXrootdAio      *Pop() {XrdXrootdAio *aiop = aioDone;
 inline void               Push(XrdXrootdAio *newp)
                               {newp->Next = aioDone; aioDone = newp;}
 
-static void               Init(int iosize, int maxaiopr, int maxaio=-80);
+static void               Init(int iosize, int maxaiopr, int maxaio=-80,
+                               int aiopool=0);
 
        int                Read();
 
@@ -68,12 +68,14 @@
 #include "XrdXrootd/XrdXrootdFileLock.hh"
 #include "XrdXrootd/XrdXrootdFileLock1.hh"
 #include "XrdXrootd/XrdXrootdJob.hh"
+#include "XrdXrootd/XrdXrootdMonFSink.hh"
 #include "XrdXrootd/XrdXrootdMonitor.hh"
 #include "XrdXrootd/XrdXrootdPrepare.hh"
 #include "XrdXrootd/XrdXrootdProtocol.hh"
 #include "XrdXrootd/XrdXrootdStats.hh"
 #include "XrdXrootd/XrdXrootdTrace.hh"
 #include "XrdXrootd/XrdXrootdTransit.hh"
+#include "XrdXrootd/XrdXrootdWPipe.hh"
 #include "XrdXrootd/XrdXrootdXPath.hh"
 
 #include "Xrd/XrdBuffer.hh"
@@ -333,9 +335,14 @@ int XrdXrootdProtocol::Configure(char *parms, XrdProtocol_Config *pi)
 // Initialiaze for AIO
 //
         if (getenv("XRDXROOTD_NOAIO")) as_noaio = 1;
-   else if (!as_noaio) XrdXrootdAioReq::Init(as_segsize, as_maxperreq, as_maxpersrv);
+   else if (!as_noaio) XrdXrootdAioReq::Init(as_segsize, as_maxperreq,
+                                             as_maxpersrv, as_aiopool);
    else eDest.Say("Config warning: asynchronous I/O has been disabled!");
 
+// Initialize the write pipeline
+//
+   XrdXrootdWPipe::Init(BPool, Sched, SI);
+
 // Create the file lock manager
 //
    Locker = (XrdXrootdFileLock *)new XrdXrootdFileLock1();
@@ -488,12 +495,14 @@ int XrdXrootdProtocol::Config(const char *ConfigFN)
             {     if TS_Xeq("async",         xasync);
              else if TS_Xeq("chksum",        xcksum);
              else if TS_Xeq("diglib",        xdig);
+             else if TS_Xeq("dirlist",       xdirl);
              else if TS_Xeq("export",        xexp);
              else if TS_Xeq("fslib",         xfsl);
              else if TS_Xeq("fsoverload",    xfso);
              else if TS_Xeq("log",           xlog);
              else if TS_Xeq("monitor",       xmon);
              else if TS_Xeq("pidpath",       xpidf);
+             else if TS_Xeq("pipewrite",     xpipew);
              else if TS_Xeq("prep",          xprep);
              else if TS_Xeq("redirect",      xred);
              else if TS_Xeq("seclib",        xsecl);
@@ -586,6 +595,7 @@ int XrdXrootdProtocol::ConfigSecurity(XrdOucEnv &xEnv, const char *cfn)
    Purpose:  To parse directive: async [limit <aiopl>] [maxsegs <msegs>]
                                        [maxtot <mtot>] [segsize <segsz>]
                                        [minsize <iosz>] [maxstalls <cnt>]
+                                       [pool {auto | off | <segs>}]
                                        [force] [syncw] [off] [nosf]
 
              <aiopl>  maximum number of async ops per link. Default 8.
@@ -600,6 +610,9 @@ int XrdXrootdProtocol::ConfigSecurity(XrdOucEnv &xEnv, const char *cfn)
                       typically 1M).
              <cnt>    Maximum number of client stalls before synchronous i/o is
                       used. Async mode is tried after <cnt> requests.
+             <segs>   the number of twice <segsz> segments to preallocate using
+                      huge pages for async i/o; auto uses <mtot>. The default
+                      is off (i.e. the general buffer pool is used).
              force    Uses async i/o for all requests, even when not explicitly
                       requested (this is compatible with synchronous clients).
              syncw    Use synchronous i/o for write requests.
@@ -615,7 +628,7 @@ int XrdXrootdProtocol::xasync(XrdOucStream &Config)
     int  i, ppp;
     int  V_force=-1, V_syncw = -1, V_off = -1, V_mstall = -1, V_nosf = -1;
     int  V_limit=-1, V_msegs=-1, V_mtot=-1, V_minsz=-1, V_segsz=-1;
-    int  V_minsf=-1;
+    int  V_minsf=-1, V_pool=-2;
     long long llp;
     struct asyncopts {const char *opname; int minv; int *oploc;
                       const char *opmsg;} asopts[] =
@@ -637,7 +650,19 @@ int XrdXrootdProtocol::xasync(XrdOucStream &Config)
        {eDest.Emsg("Config", "async option not specified"); return 1;}
 
     while (val)
-         {for (i = 0; i < numopts; i++)
+         {if (!strcmp(val, "pool"))
+             {if (!(val = Config.GetWord()))
+                 {eDest.Emsg("Config","async pool value not specified");
+                  return 1;
+                 }
+                   if (!strcmp(val, "auto")) V_pool = -1;
+              else if (!strcmp(val, "off"))  V_pool =  0;
+              else if (XrdOuca2x::a2i(eDest,"async pool",val,&ppp,1)) return 1;
+              else V_pool = ppp;
+              val = Config.GetWord();
+              continue;
+             }
+          for (i = 0; i < numopts; i++)
               if (!strcmp(val, asopts[i].opname))
                  {if (asopts[i].minv >=  0 && !(val = Config.GetWord()))
                      {eDest.Emsg("Config","async",(char *)asopts[i].opname,
@@ -693,6 +718,7 @@ int XrdXrootdProtocol::xasync(XrdOucStream &Config)
    if (V_syncw > 0) as_syncw     = 1;
    if (V_nosf  > 0) as_nosf      = 1;
    if (V_minsf > 0) as_minsfsz   = V_minsf;
+   if (V_pool > -2) as_aiopool   = V_pool;
 
    return 0;
 }
@@ -822,6 +848,61 @@ int XrdXrootdProtocol::xdig(XrdOucStream &Config)
    return 0;
 }
   
+/******************************************************************************/
+/*                                 x d i r l                                  */
+/******************************************************************************/
+
+/* Function: xdirl
+
+   Purpose:  To parse the directive: dirlist [pagesize <num>] [statpar <num>]
+
+             pagesize  the maximum number of entries returned in each page
+                       of a paged directory listing (default 1000).
+             statpar   the number of stat calls that may run in parallel to
+                       fill out a page with stat information when the file
+                       system does not provide it with each entry (default 4).
+
+  Output: 0 upon success or !0 upon failure.
+*/
+
+int XrdXrootdProtocol::xdirl(XrdOucStream &Config)
+{
+   int psz = -1, spar = -1;
+   char *val;
+
+// Process the options
+//
+   if (!(val = Config.GetWord()))
+      {eDest.Emsg("Config", "dirlist parameters not specified"); return 1;}
+
+   while(val)
+        {     if (!strcmp(val, "pagesize"))
+                 {if (!(val = Config.GetWord()))
+                     {eDest.Emsg("Config", "dirlist pagesize not specified");
+                      return 1;
+                     }
+                  if (XrdOuca2x::a2i(eDest, "dirlist pagesize", val, &psz,
+                                     1, 1000000)) return 1;
+                 }
+         else if (!strcmp(val, "statpar"))
+                 {if (!(val = Config.GetWord()))
+                     {eDest.Emsg("Config", "dirlist statpar not specified");
+                      return 1;
+                     }
+                  if (XrdOuca2x::a2i(eDest, "dirlist statpar", val, &spar,
+                                     1, 64)) return 1;
+                 }
+         else {eDest.Emsg("Config", "invalid dirlist option", val); return 1;}
+         val = Config.GetWord();
+        }
+
+// Set the values
+//
+   if (psz  > 0) dirPageSz  = psz;
+   if (spar > 0) dirStatPar = spar;
+   return 0;
+}
+  
 /******************************************************************************/
 /*                                  x e x p                                   */
 /******************************************************************************/
@@ -1112,6 +1193,7 @@ int XrdXrootdProtocol::xlog(XrdOucStream &Config)
 
    Purpose:  Parse directive: monitor [all] [auth]  [flush [io] <sec>]
                                       [fstat <sec> [lfn] [ops] [ssq] [xfr <n>]
+                                                   [batch <sz>] [zip <lvl>]]
                                       [ident <sec>] [mbuff <sz>] [rbuff <sz>]
                                       [rnums <cnt>] [window <sec>]
                                       dest [Events] <host:port>
@@ -1129,6 +1211,11 @@ int XrdXrootdProtocol::xlog(XrdOucStream &Config)
                             ssq    - computes the sum of squares for the ops rec
                             xfr <n>- inserts i/o stats for open files every
                                      <sec>*<n>. Minimum is 1.
+                            batch <sz> - records are batched per thread in
+                                     <sz> byte batches and sent by a
+                                     separate thread.
+                            zip <lvl>- compresses each packet using zlib
+                                     level <lvl> (1 to 9); implies batch.
          ident  <sec>       time (seconds, M, H) between identification records.
          mbuff  <sz>        size of message buffer for event trace monitoring.
          rbuff  <sz>        size of message buffer for redirection monitoring.
@@ -1144,6 +1231,8 @@ int XrdXrootdProtocol::xlog(XrdOucStream &Config)
          redir              monitors request redirections
          user               monitors user login and disconnect events.
          <host:port>        where monitor records are to be sentvia UDP.
+                            An absolute path names a local UNIX datagram
+                            socket instead.
 
    Output: 0 upon success or !0 upon failure. Ignored by master.
 */
@@ -1157,6 +1246,7 @@ int XrdXrootdProtocol::xmon(XrdOucStream &Config)
     int i, monFlash = 0, monFlush=0, monMBval=0, monRBval=0, monWWval=0;
     int    monIdent = 3600, xmode=0, monMode[2] = {0, 0}, mrType, *flushDest;
     int    monRnums = 0, monFSint = 0, monFSopt = 0, monFSion = 0;
+    int    monFSbsz = 0, monFSzip = 0;
     int    haveWord = 0;
 
     while(haveWord || (val = Config.GetWord()))
@@ -1195,6 +1285,23 @@ int XrdXrootdProtocol::xmon(XrdOucStream &Config)
                                                val, &monFSion,1)) return 1;
                             monFSopt |=  XROOTD_MON_FSXFR;
                            }
+                   else if (!strcmp("batch", val))
+                           {if (!(val = Config.GetWord()))
+                               {eDest.Emsg("Config", "monitor fstat batch size not specified");
+                                return 1;
+                               }
+                            if (XrdOuca2x::a2sz(eDest,"monitor fstat batch",
+                                           val, &tempval, 8192, 65536)) return 1;
+                            monFSbsz = static_cast<int>(tempval);
+                           }
+                   else if (!strcmp("zip", val))
+                           {if (!(val = Config.GetWord()))
+                               {eDest.Emsg("Config", "monitor fstat zip level not specified");
+                                return 1;
+                               }
+                            if (XrdOuca2x::a2i(eDest,"monitor fstat zip level",
+                                               val, &monFSzip,1,9)) return 1;
+                           }
                    else {haveWord = 1; break;}
                   }
           else if (!strcmp("mbuff",val) || !strcmp("rbuff",val))
@@ -1250,7 +1357,7 @@ int XrdXrootdProtocol::xmon(XrdOucStream &Config)
           if (!val) {eDest.Emsg("Config","monitor dest value not specified");
                      return 1;
                     }
-          if (!(cp = index(val, (int)':')) || !atoi(cp+1))
+          if (*val != '/' && (!(cp = index(val, (int)':')) || !atoi(cp+1)))
              {eDest.Emsg("Config","monitor dest port missing or invalid in",val);
               return 1;
              }
@@ -1292,6 +1399,8 @@ int XrdXrootdProtocol::xmon(XrdOucStream &Config)
    XrdXrootdMonitor::Defaults(monMBval, monRBval, monWWval,
                               monFlush, monFlash, monIdent, monRnums,
                               monFSint, monFSopt, monFSion);
+   if (monFSbsz || monFSzip)
+      XrdXrootdMonFSink::setParms((monFSbsz ? monFSbsz : 16384), monFSzip);
 
    if (monDest[0]) monMode[0] |= (monMode[0] ? xmode : XROOTD_MON_FILE|xmode);
    if (monDest[1]) monMode[1] |= (monMode[1] ? xmode : XROOTD_MON_FILE|xmode);
@@ -1330,6 +1439,65 @@ int XrdXrootdProtocol::xpidf(XrdOucStream &Config)
    return 0;
 }
 
+/******************************************************************************/
+/*                                x p i p e w                                 */
+/******************************************************************************/
+
+/* Function: xpipew
+
+   Purpose:  To parse the directive: pipewrite {off | [depth <n>]
+                                                        [minsize <sz>]}
+
+             off       writes are not pipelined.
+             depth     the number of buffers used to receive a write request
+                       while the previously received data is written (default
+                       3, maximum 8). A depth of 1 also disables pipelining.
+             minsize   the minimum write request size to pipeline (default 1m).
+
+  Output: 0 upon success or !0 upon failure.
+*/
+
+int XrdXrootdProtocol::xpipew(XrdOucStream &Config)
+{
+   int depth = -1;
+   long long minsz = -1;
+   char *val;
+
+// Process the options
+//
+   if (!(val = Config.GetWord()))
+      {eDest.Emsg("Config", "pipewrite parameters not specified"); return 1;}
+
+   if (!strcmp(val, "off")) {wp_depth = 0; return 0;}
+
+   while(val)
+        {     if (!strcmp(val, "depth"))
+                 {if (!(val = Config.GetWord()))
+                     {eDest.Emsg("Config", "pipewrite depth not specified");
+                      return 1;
+                     }
+                  if (XrdOuca2x::a2i(eDest, "pipewrite depth", val, &depth,
+                                     1, XrdXrootdWPipe::maxDepth)) return 1;
+                 }
+         else if (!strcmp(val, "minsize"))
+                 {if (!(val = Config.GetWord()))
+                     {eDest.Emsg("Config", "pipewrite minsize not specified");
+                      return 1;
+                     }
+                  if (XrdOuca2x::a2sz(eDest, "pipewrite minsize", val, &minsz,
+                                      65536, 0x7fffffff)) return 1;
+                 }
+         else {eDest.Emsg("Config", "invalid pipewrite option", val); return 1;}
+         val = Config.GetWord();
+        }
+
+// Set the values
+//
+   if (depth > 0) wp_depth = depth;
+   if (minsz > 0) wp_minsz = static_cast<int>(minsz);
+   return 0;
+}
+
 /******************************************************************************/
 /*                                 x p r e p                                  */
 /******************************************************************************/
@@ -48,6 +48,10 @@ struct {double      read;     // sum(read_size[i] **2) i = 1 to Ops.read
         double      rsegs;    // sum(readv_segs[i]**2) i = 1 to Ops.readv
         double      write;    // sum(write_size[i]**2) i = 1 to Ops.write
        }            ssq;
+struct {long long   bytes;    // Bytes written through the write pipeline
+        long long   wTime;    // Microseconds the file system took for them
+        int         waits;    // Times receiving waited for a write to end
+       }            wpipe;
 
 enum monLevel {monOff = 0, monOn = 1, monOps = 2, monSsq = 3};
 
@@ -58,6 +62,7 @@ enum monLevel {monOff = 0, monOn = 1, monOps = 2, monSsq = 3};
                  ops.rsMin = 0x7fff;
                  ops.rdMin = ops.rvMin = ops.wrMin = 0x7fffffff;
                  ssq.read  = ssq.readv = ssq.write = ssq.rsegs = 0.0;
+                 memset(&wpipe, 0, sizeof(wpipe));
                 };
 
 inline void rdOps(int rsz)
@@ -0,0 +1,284 @@
+/******************************************************************************/
+/*                                                                            */
+/*                   X r d X r o o t d L a t e n c y . c c                    */
+/*                                                                            */
+/* This file is part of the XRootD software suite.                            */
+/*                                                                            */
+/* XRootD is free software: you can redistribute it and/or modify it under    */
+/* the terms of the GNU Lesser General Public License as published by the     */
+/* Free Software Foundation, either version 3 of the License, or (at your     */
+/* option) any later version.                                                 */
+/*                                                                            */
+/* XRootD is distributed in the hope that it will be useful, but WITHOUT      */
+/* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or      */
+/* FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public       */
+/* License for more details.                                                  */
+/*                                                                            */
+/* You should have received a copy of the GNU Lesser General Public License   */
+/* along with XRootD in a file called COPYING.LESSER (LGPL license) and file  */
+/* COPYING (GPL license).  If not, see <http://www.gnu.org/licenses/>.        */
+/*                                                                            */
+/* The copyright holder's institutional names and contributor's names may not */
+/* be used to endorse or promote products derived from this software without  */
+/* specific prior written permission of the institution or contributor.       */
+/******************************************************************************/
+
+#include <netinet/in.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "XrdSys/XrdSysPlatform.hh"
+#include "XrdXrootd/XrdXrootdLatency.hh"
+
+/******************************************************************************/
+/*                               G l o b a l s                                */
+/******************************************************************************/
+
+thread_local XrdXrootdLatency::SetRef XrdXrootdLatency::mySet = {0};
+XrdSysMutex                           XrdXrootdLatency::setMutex;
+XrdXrootdLatency::Set                *XrdXrootdLatency::setAll  = 0;
+XrdXrootdLatency::Set                *XrdXrootdLatency::setFree = 0;
+
+/******************************************************************************/
+/*                                F o r m a t                                 */
+/******************************************************************************/
+
+int XrdXrootdLatency::Format(char *buff, int blen)
+{
+   static const char reqfmt[] = "<req id=\"%s\"><n>%llu</n><avg>%llu</avg>"
+          "<p50>%lld</p50><p90>%lld</p90><p99>%lld</p99><p999>%lld</p999>"
+          "<max>%llu</max></req>";
+   static const int  reqflen = sizeof(reqfmt) + 16 + 7*20;
+   Sum  *sums;
+   char *bp = buff;
+   int  n;
+
+// If no buffer, caller wants the maximum size we will generate
+//
+   if (!buff) return sizeof("<lat></lat>") + nReq*reqflen;
+   if (blen < (int)sizeof("<lat></lat>")) return 0;
+
+// Add up the histograms and format whatever requests we have seen
+//
+   sums = new Sum[nReq];
+   Merge(sums);
+   strcpy(bp, "<lat>"); bp += 5; blen -= 5;
+   for (int i = 0; i < nReq; i++)
+       {Sum &sum = sums[i];
+        if (!sum.Count) continue;
+        n = snprintf(bp, blen, reqfmt, XProtocol::reqName(kXR_auth+i),
+                     (unsigned long long)sum.Count,
+                     (unsigned long long)(sum.Total/sum.Count),
+                     Percentile(sum, 0.50), Percentile(sum, 0.90),
+                     Percentile(sum, 0.99), Percentile(sum, 0.999),
+                     (unsigned long long)sum.Max);
+        if (n >= blen - 6) break;
+        bp += n; blen -= n;
+       }
+   strcpy(bp, "</lat>"); bp += 6;
+   delete [] sums;
+   return bp - buff;
+}
+
+/******************************************************************************/
+/*                                  P a c k                                   */
+/******************************************************************************/
+
+int XrdXrootdLatency::Pack(char *buff, int blen)
+{
+   Sum  *sums = new Sum[nReq];
+   char *bp = buff;
+   kXR_unt16 *sP;
+   kXR_unt32  iVal;
+   kXR_unt64  lVal;
+   int  i, n, nEnt = 0, need = 4;
+
+// Add up the histograms and compute the length we need. As the counters are
+// updated without ordering, a count may be seen before its bucket; such an
+// entry is skipped until its buckets show up.
+//
+   Merge(sums);
+   for (i = 0; i < nReq; i++)
+       {if (!sums[i].Count) continue;
+        for (n = nBkt; n > 0 && !sums[i].Bkt[n-1]; n--) {}
+        if (!n) continue;
+        need += 4 + 3*8 + n*4;
+        nEnt++;
+       }
+   if (need > blen) {delete [] sums; return -need;}
+
+// Pack the header
+//
+   sP = (kXR_unt16 *)bp;
+   sP[0] = htons(1); sP[1] = htons(nEnt); bp += 4;
+
+// Pack each request
+//
+   for (i = 0; i < nReq; i++)
+       {Sum &sum = sums[i];
+        if (!sum.Count) continue;
+        for (n = nBkt; n > 0 && !sum.Bkt[n-1]; n--) {}
+        if (!n) continue;
+        sP = (kXR_unt16 *)bp;
+        sP[0] = htons(kXR_auth+i); sP[1] = htons(n); bp += 4;
+        lVal = htonll(sum.Count); memcpy(bp, &lVal, 8); bp += 8;
+        lVal = htonll(sum.Total); memcpy(bp, &lVal, 8); bp += 8;
+        lVal = htonll(sum.Max);   memcpy(bp, &lVal, 8); bp += 8;
+        for (int b = 0; b < n; b++)
+            {iVal = (sum.Bkt[b] > 0xffffffffULL ? 0xffffffff : sum.Bkt[b]);
+             iVal = htonl(iVal); memcpy(bp, &iVal, 4); bp += 4;
+            }
+       }
+   delete [] sums;
+   return bp - buff;
+}
+
+/******************************************************************************/
+/*                       P r i v a t e   M e t h o d s                        */
+/******************************************************************************/
+/******************************************************************************/
+/*                                B u c k e t                                 */
+/******************************************************************************/
+
+int XrdXrootdLatency::Bucket(long long usec)
+{
+   int e, b;
+
+// Small values have a bucket of their own, others are split into four buckets
+// per power of two.
+//
+   if (usec < 4) return (usec < 0 ? 0 : usec);
+   e = 63 - __builtin_clzll(usec);
+   b = 4*(e-1) + ((usec >> (e-2)) & 3);
+   return (b < nBkt ? b : nBkt-1);
+}
+
+/******************************************************************************/
+/*                                G e t S e t                                 */
+/******************************************************************************/
+
+XrdXrootdLatency::Set *XrdXrootdLatency::GetSet()
+{
+   XrdSysMutexHelper mHelp(setMutex);
+   Set *sP;
+
+// Reuse the set of a thread that has exited or create a new one
+//
+   if ((sP = setFree)) setFree = sP->nextFree;
+      else {sP = new Set;
+            for (int i = 0; i < nReq; i++) sP->Req[i].store(0);
+            sP->next = setAll;
+            setAll = sP;
+           }
+   sP->nextFree = 0;
+   mySet.sP = sP;
+   return sP;
+}
+
+/******************************************************************************/
+/*                                   L o w                                    */
+/******************************************************************************/
+
+// Return the smallest latency that falls into bucket b
+
+long long XrdXrootdLatency::Low(int b)
+{
+   return (b < 4 ? b : (long long)(4 + b%4) << (b/4 - 1));
+}
+
+/******************************************************************************/
+/*                                 M e r g e                                  */
+/******************************************************************************/
+
+void XrdXrootdLatency::Merge(Sum *sums)
+{
+   Hist *hP;
+
+   memset(sums, 0, sizeof(Sum)*nReq);
+
+// Add up the histograms of all of the threads. Each histogram only has a
+// single writer so we may see a slightly stale but never a broken count.
+//
+   setMutex.Lock();
+   for (Set *sP = setAll; sP; sP = sP->next)
+       for (int i = 0; i < nReq; i++)
+           {if (!(hP = sP->Req[i].load(std::memory_order_acquire))) continue;
+            Sum &sum = sums[i];
+            sum.Count += hP->Count.load(std::memory_order_relaxed);
+            sum.Total += hP->Total.load(std::memory_order_relaxed);
+            uint64_t mx = hP->Max.load(std::memory_order_relaxed);
+            if (mx > sum.Max) sum.Max = mx;
+            for (int b = 0; b < nBkt; b++)
+                sum.Bkt[b] += hP->Bkt[b].load(std::memory_order_relaxed);
+           }
+   setMutex.UnLock();
+}
+
+/******************************************************************************/
+/*                            P e r c e n t i l e                             */
+/******************************************************************************/
+
+long long XrdXrootdLatency::Percentile(const Sum &sum, double pct)
+{
+   uint64_t want = (uint64_t)(sum.Count * pct), have = 0;
+   long long lo, hi;
+   int b;
+
+// Find the bucket holding the wanted value
+//
+   for (b = 0; b < nBkt-1; b++)
+       if ((have += sum.Bkt[b]) > want) break;
+
+// Return the middle of the bucket but never more than the maximum seen
+//
+   if (b < 4) return b;
+   lo = Low(b); hi = Low(b+1) - 1;
+   hi = (lo + hi) / 2;
+   return (hi > (long long)sum.Max ? (long long)sum.Max : hi);
+}
+
+/******************************************************************************/
+/*                                R e c o r d                                 */
+/******************************************************************************/
+
+void XrdXrootdLatency::Record(int rIdx, long long usec)
+{
+   Set  *sP = (mySet.sP ? mySet.sP : GetSet());
+   Hist *hP = sP->Req[rIdx].load(std::memory_order_relaxed);
+   uint64_t val = (usec < 0 ? 0 : usec);
+   int b;
+
+// Allocate the histogram the first time this thread sees the request
+//
+   if (!hP)
+      {hP = new Hist;
+       hP->Count.store(0); hP->Total.store(0); hP->Max.store(0);
+       for (b = 0; b < nBkt; b++) hP->Bkt[b].store(0);
+       sP->Req[rIdx].store(hP, std::memory_order_release);
+      }
+
+// We are the only writer, so plain loads and stores are enough
+//
+   b = Bucket(val);
+   hP->Bkt[b].store(hP->Bkt[b].load(std::memory_order_relaxed)+1,
+                    std::memory_order_relaxed);
+   hP->Count.store(hP->Count.load(std::memory_order_relaxed)+1,
+                   std::memory_order_relaxed);
+   hP->Total.store(hP->Total.load(std::memory_order_relaxed)+val,
+                   std::memory_order_relaxed);
+   if (val > hP->Max.load(std::memory_order_relaxed))
+      hP->Max.store(val, std::memory_order_relaxed);
+}
+
+/******************************************************************************/
+/*                       S e t R e f   D e s t r u c t o r                    */
+/******************************************************************************/
+
+XrdXrootdLatency::SetRef::~SetRef()
+{
+   if (sP)
+      {XrdSysMutexHelper mHelp(setMutex);
+       sP->nextFree = setFree;
+       setFree = sP;
+      }
+}
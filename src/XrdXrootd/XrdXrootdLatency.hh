@@ -0,0 +1,122 @@
+#ifndef __XROOTD_LATENCY_H__
+#define __XROOTD_LATENCY_H__
+/******************************************************************************/
+/*                                                                            */
+/*                   X r d X r o o t d L a t e n c y . h h                    */
+/*                                                                            */
+/* This file is part of the XRootD software suite.                            */
+/*                                                                            */
+/* XRootD is free software: you can redistribute it and/or modify it under    */
+/* the terms of the GNU Lesser General Public License as published by the     */
+/* Free Software Foundation, either version 3 of the License, or (at your     */
+/* option) any later version.                                                 */
+/*                                                                            */
+/* XRootD is distributed in the hope that it will be useful, but WITHOUT      */
+/* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or      */
+/* FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public       */
+/* License for more details.                                                  */
+/*                                                                            */
+/* You should have received a copy of the GNU Lesser General Public License   */
+/* along with XRootD in a file called COPYING.LESSER (LGPL license) and file  */
+/* COPYING (GPL license).  If not, see <http://www.gnu.org/licenses/>.        */
+/*                                                                            */
+/* The copyright holder's institutional names and contributor's names may not */
+/* be used to endorse or promote products derived from this software without  */
+/* specific prior written permission of the institution or contributor.       */
+/******************************************************************************/
+
+#include <atomic>
+#include <stdint.h>
+#include <time.h>
+
+#include "XProtocol/XProtocol.hh"
+#include "XrdSys/XrdSysPthread.hh"
+
+// The XrdXrootdLatency class keeps a latency histogram for each kind of
+// request. Each thread records into its own set of histograms so recording
+// takes no locks; the sets are only added up when the statistics are wanted.
+// Histograms are log-linear with four buckets per power of two microseconds so
+// any latency is known to within 25%. A thread's set is handed on to the next
+// new thread when it exits so that counts are never lost.
+//
+// The binary form of the histograms (see Pack()) is, in network byte order:
+//
+// kXR_unt16 version (1), kXR_unt16 number of request entries, followed by one
+// entry for each kind of request that was seen:
+// kXR_unt16 request code, kXR_unt16 number of bucket counts that follow,
+// kXR_unt64 number of requests, kXR_unt64 total usec, kXR_unt64 max usec,
+// kXR_unt32 count[n] where bucket b < 4 holds latencies of b usec and any
+// other holds those from (4 + b%4) << (b/4 - 1) up to the next bucket.
+//
+class XrdXrootdLatency
+{
+public:
+
+static const int nBkt = 128;                    // Buckets per histogram
+static const int nReq = kXR_REQFENCE - kXR_auth; // Kinds of requests
+
+// Add() records that request reqID took usec microseconds.
+//
+static void      Add(int reqID, long long usec)
+                    {unsigned int rIdx = reqID - kXR_auth;
+                     if (rIdx < (unsigned int)nReq) Record(rIdx, usec);
+                    }
+
+// Format() places the XML form of the statistics in buff. When buff is nil,
+//          it returns the maximum length it may need.
+//
+static int       Format(char *buff, int blen);
+
+// Now() returns a monotonic time in microseconds used to time requests.
+//
+static long long Now()
+                    {struct timespec ts;
+                     clock_gettime(CLOCK_MONOTONIC, &ts);
+                     return ts.tv_sec*1000000LL + ts.tv_nsec/1000;
+                    }
+
+// Pack() places the binary form of the statistics in buff and returns its
+//        length or, if blen is too small, the negative of the length needed.
+//
+static int       Pack(char *buff, int blen);
+
+private:
+
+struct Hist
+      {std::atomic<uint64_t> Count;
+       std::atomic<uint64_t> Total;
+       std::atomic<uint64_t> Max;
+       std::atomic<uint32_t> Bkt[nBkt];
+      };
+
+struct Sum
+      {uint64_t Count;
+       uint64_t Total;
+       uint64_t Max;
+       uint64_t Bkt[nBkt];
+      };
+
+struct Set
+      {Set                *next;      // All sets
+       Set                *nextFree;  // Sets of threads that have exited
+       std::atomic<Hist *> Req[nReq];
+      };
+
+struct SetRef
+      {Set *sP;
+          ~SetRef();
+      };
+
+static int       Bucket(long long usec);
+static long long Percentile(const Sum &sum, double pct);
+static void      Record(int rIdx, long long usec);
+static Set      *GetSet();
+static long long Low(int b);
+static void      Merge(Sum *sums);
+
+static thread_local SetRef mySet;
+static XrdSysMutex         setMutex;
+static Set                *setAll;
+static Set                *setFree;
+};
+#endif
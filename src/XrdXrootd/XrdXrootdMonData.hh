@@ -104,6 +104,7 @@ const kXR_char XROOTD_MON_MAPSTAG       = 's'; // Internal use only!
 const kXR_char XROOTD_MON_MAPTRCE       = 't';
 const kXR_char XROOTD_MON_MAPUSER       = 'u';
 const kXR_char XROOTD_MON_MAPXFER       = 'x';
+const kXR_char XROOTD_MON_MAPZFST       = 'z'; // Compressed "f" stream
 
 // The following bits are insert in the low order 4 bits of the MON_REDIRECT
 // entry code to indicate the actual operation that was requestded.
@@ -148,6 +149,12 @@ const int      XROOTD_MON_NEWSTID       = 0x8000000;
 // XrdXrootdMonFileHdr   with recType == one of recTval   (variable length)
 // ...                   additional XrdXrootdMonFileHdr's (variable length)
 // XrdXrootdMonFileTOD   with recType == isTime
+//
+// When compression is enabled, a packet may instead consist of
+//
+// XrdXrootdMonHeader    with Code    ==  XROOTD_MON_MAPZFST
+// kXR_unt32             length of the uncompressed packet
+// ...                   the above layout compressed in zlib format
   
 struct XrdXrootdMonFileHdr    // 8
 {
@@ -0,0 +1,417 @@
+/******************************************************************************/
+/*                                                                            */
+/*                  X r d X r o o t d M o n F S i n k . c c                   */
+/*                                                                            */
+/* This file is part of the XRootD software suite.                            */
+/*                                                                            */
+/* XRootD is free software: you can redistribute it and/or modify it under    */
+/* the terms of the GNU Lesser General Public License as published by the     */
+/* Free Software Foundation, either version 3 of the License, or (at your     */
+/* option) any later version.                                                 */
+/*                                                                            */
+/* XRootD is distributed in the hope that it will be useful, but WITHOUT      */
+/* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or      */
+/* FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public       */
+/* License for more details.                                                  */
+/*                                                                            */
+/* You should have received a copy of the GNU Lesser General Public License   */
+/* along with XRootD in a file called COPYING.LESSER (LGPL license) and file  */
+/* COPYING (GPL license).  If not, see <http://www.gnu.org/licenses/>.        */
+/*                                                                            */
+/* The copyright holder's institutional names and contributor's names may not */
+/* be used to endorse or promote products derived from this software without  */
+/* specific prior written permission of the institution or contributor.       */
+/******************************************************************************/
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <zlib.h>
+
+#include "XrdSys/XrdSysError.hh"
+#include "XrdSys/XrdSysPlatform.hh"
+#include "XrdXrootd/XrdXrootdMonData.hh"
+#include "XrdXrootd/XrdXrootdMonFSink.hh"
+#include "XrdXrootd/XrdXrootdMonitor.hh"
+
+/******************************************************************************/
+/*                               G l o b a l s                                */
+/******************************************************************************/
+
+namespace XrdXrootdMonInfo
+{
+extern long long mySID;
+}
+
+/******************************************************************************/
+/*                        S t a t i c   M e m b e r s                         */
+/******************************************************************************/
+
+thread_local XrdXrootdMonFSink::TBuffRef XrdXrootdMonFSink::myTB = {0};
+XrdSysMutex                     XrdXrootdMonFSink::tbMutex;
+XrdXrootdMonFSink::TBuff       *XrdXrootdMonFSink::tbAll    = 0;
+XrdXrootdMonFSink::TBuff       *XrdXrootdMonFSink::tbFree   = 0;
+std::atomic<XrdXrootdMonFSink::Batch *> XrdXrootdMonFSink::readyQ(0);
+XrdSysMutex                     XrdXrootdMonFSink::fbMutex;
+XrdXrootdMonFSink::Batch       *XrdXrootdMonFSink::fbFree   = 0;
+std::atomic<int>                XrdXrootdMonFSink::qNum(0);
+XrdSysCondVar                   XrdXrootdMonFSink::sndCV(0);
+XrdSysMutex                     XrdXrootdMonFSink::stMutex;
+XrdSysError                    *XrdXrootdMonFSink::eDest    = 0;
+char                           *XrdXrootdMonFSink::pBuff    = 0;
+char                           *XrdXrootdMonFSink::zBuff    = 0;
+int                             XrdXrootdMonFSink::zBsz     = 0;
+int                             XrdXrootdMonFSink::pSize    = 0;
+int                             XrdXrootdMonFSink::bSize    = 0;
+int                             XrdXrootdMonFSink::zLevel   = 0;
+bool                            XrdXrootdMonFSink::sndGo    = false;
+bool                            XrdXrootdMonFSink::isOn     = false;
+
+std::atomic<long long>          XrdXrootdMonFSink::recDrop(0);
+long long                       XrdXrootdMonFSink::recSent  = 0;
+long long                       XrdXrootdMonFSink::pktSent  = 0;
+long long                       XrdXrootdMonFSink::pktFail  = 0;
+long long                       XrdXrootdMonFSink::recFail  = 0;
+long long                       XrdXrootdMonFSink::bytesIn  = 0;
+long long                       XrdXrootdMonFSink::bytesOut = 0;
+
+namespace
+{
+const int hdrSize = sizeof(XrdXrootdMonHeader) + sizeof(XrdXrootdMonFileTOD);
+const int zhdSize = sizeof(XrdXrootdMonHeader) + sizeof(kXR_unt32);
+}
+
+/******************************************************************************/
+/*                                 F l u s h                                  */
+/******************************************************************************/
+
+void XrdXrootdMonFSink::Flush()
+{
+   TBuff *tP;
+   Batch *bP;
+
+// Queue every thread's partial batch
+//
+   tbMutex.Lock();
+   tP = tbAll;
+   tbMutex.UnLock();
+   while(tP)
+        {tP->tMutex.Lock();
+         bP = tP->curB; tP->curB = 0;
+         tP->tMutex.UnLock();
+         if (bP) Queue(bP);
+         tbMutex.Lock();
+         tP = tP->next;
+         tbMutex.UnLock();
+        }
+}
+
+/******************************************************************************/
+/*                                F o r m a t                                 */
+/******************************************************************************/
+
+int XrdXrootdMonFSink::Format(char *buff, int blen)
+{
+   static const char statfmt[] = "<fsink><rec>%lld</rec><pkt>%lld</pkt>"
+          "<in>%lld</in><out>%lld</out><drop>%lld</drop><fail>%lld</fail>"
+          "<lost>%lld</lost></fsink>";
+   static const int  statflen = sizeof(statfmt) + 7*20;
+   int n;
+
+// Say nothing unless we are in use
+//
+   if (!isOn) return 0;
+   if (!buff) return statflen;
+   if (blen < statflen) return 0;
+
+// Format the statistics
+//
+   stMutex.Lock();
+   n = snprintf(buff, blen, statfmt, recSent, pktSent, bytesIn, bytesOut,
+                recDrop.load(), pktFail, recFail);
+   stMutex.UnLock();
+   return n;
+}
+
+/******************************************************************************/
+/*                                  I n i t                                   */
+/******************************************************************************/
+
+bool XrdXrootdMonFSink::Init(XrdSysError *errp, int psz)
+{
+   XrdXrootdMonHeader  *hP;
+   XrdXrootdMonFileTOD *tP;
+   pthread_t tid;
+
+// Allocate the packet buffers, a batch must always fit in a packet
+//
+   eDest = errp;
+   pSize = psz;
+   if (bSize > pSize - hdrSize) bSize = pSize - hdrSize;
+   zBsz  = zhdSize + compressBound(pSize);
+   if (!(pBuff = (char *)malloc(pSize))
+   ||  (zLevel && !(zBuff = (char *)malloc(zBsz))))
+      {eDest->Emsg("MonFSink", "Unable to allocate monitor buffer.");
+       return false;
+      }
+
+// Set the header and the time record (always present)
+//
+   hP = (XrdXrootdMonHeader *)pBuff;
+   hP->code = XROOTD_MON_MAPFSTA;
+   hP->pseq = 0;
+   hP->stod = XrdXrootdMonitor::startTime;
+   tP = (XrdXrootdMonFileTOD *)(pBuff + sizeof(XrdXrootdMonHeader));
+   tP->Hdr.recType = XrdXrootdMonFileHdr::isTime;
+   tP->Hdr.recFlag = XrdXrootdMonFileHdr::hasSID;
+   tP->Hdr.recSize = htons(sizeof(XrdXrootdMonFileTOD));
+   tP->sID = static_cast<kXR_int64>(XrdXrootdMonInfo::mySID);
+
+// The compressed packet header is fixed except for the sequence and length
+//
+   if (zLevel)
+      {hP = (XrdXrootdMonHeader *)zBuff;
+       hP->code = XROOTD_MON_MAPZFST;
+       hP->stod = XrdXrootdMonitor::startTime;
+      }
+
+// Start the sender
+//
+   if (XrdSysThread::Run(&tid, Sender, 0, 0, "fstat sender"))
+      {eDest->Emsg("MonFSink", errno, "start fstat sender");
+       return false;
+      }
+   return true;
+}
+
+/******************************************************************************/
+/*                       P r i v a t e   M e t h o d s                        */
+/******************************************************************************/
+/******************************************************************************/
+/*                              G e t B a t c h                               */
+/******************************************************************************/
+
+XrdXrootdMonFSink::Batch *XrdXrootdMonFSink::GetBatch()
+{
+   Batch *bP;
+
+   fbMutex.Lock();
+   if ((bP = fbFree)) fbFree = bP->next;
+   fbMutex.UnLock();
+
+   if (!bP && !(bP = (Batch *)malloc(offsetof(Batch, data) + bSize)))
+      return 0;
+   bP->dlen  = 0;
+   bP->nRecs = bP->nXfr = 0;
+   bP->tBeg  = static_cast<int>(time(0));
+   return bP;
+}
+
+/******************************************************************************/
+/*                              G e t T B u f f                               */
+/******************************************************************************/
+
+XrdXrootdMonFSink::TBuff *XrdXrootdMonFSink::GetTBuff()
+{
+   XrdSysMutexHelper mHelp(tbMutex);
+   TBuff *tP;
+
+// Reuse the buffer of a thread that has exited, otherwise make a new one.
+// Buffers are never freed as the flusher may be looking at them.
+//
+   if ((tP = tbFree)) tbFree = tP->nextFree;
+      else {tP = new TBuff;
+            tP->curB = 0;
+            tP->next = tbAll;
+            tbAll = tP;
+           }
+   tP->nextFree = 0;
+   myTB.tP = tP;
+   return tP;
+}
+
+/******************************************************************************/
+/*                                 Q u e u e                                  */
+/******************************************************************************/
+
+void XrdXrootdMonFSink::Queue(Batch *bP)
+{
+   Batch *oldQ;
+
+// Drop the batch if too many are waiting to be sent
+//
+   if (qNum++ >= qMax)
+      {qNum--;
+       recDrop += bP->nRecs;
+       fbMutex.Lock();
+       bP->next = fbFree; fbFree = bP;
+       fbMutex.UnLock();
+       return;
+      }
+
+// Push it on the ready queue and wake up the sender if it was empty
+//
+   oldQ = readyQ.load(std::memory_order_relaxed);
+   do {bP->next = oldQ;}
+      while(!readyQ.compare_exchange_weak(oldQ, bP,
+                                          std::memory_order_release,
+                                          std::memory_order_relaxed));
+   if (!oldQ)
+      {sndCV.Lock();
+       sndGo = true;
+       sndCV.Signal();
+       sndCV.UnLock();
+      }
+}
+
+/******************************************************************************/
+/*                                R e c o r d                                 */
+/******************************************************************************/
+
+bool XrdXrootdMonFSink::Record(const void *rec, int rlen, bool isXfr)
+{
+   TBuff *tP = (myTB.tP ? myTB.tP : GetTBuff());
+   Batch *bP;
+
+// Records that can never fit are simply dropped
+//
+   if (rlen > bSize) return false;
+
+// Queue our batch if the record does not fit and start a new one
+//
+   tP->tMutex.Lock();
+   if ((bP = tP->curB) && bP->dlen + rlen > bSize)
+      {Queue(bP); bP = tP->curB = 0;}
+   if (!bP && !(bP = tP->curB = GetBatch()))
+      {tP->tMutex.UnLock(); return false;}
+
+// Add the record
+//
+   memcpy(bP->data + bP->dlen, rec, rlen);
+   bP->dlen += rlen;
+   bP->nRecs++;
+   if (isXfr) bP->nXfr++;
+   tP->tMutex.UnLock();
+   return true;
+}
+
+/******************************************************************************/
+/*                                  S e n d                                   */
+/******************************************************************************/
+
+// Send the packet in pBuff holding plen bytes, compressing it if so wanted.
+
+void XrdXrootdMonFSink::Send(int plen, int nRecs, int nXfr, int tBeg)
+{
+   static int seq = 0;
+   XrdXrootdMonHeader  *hP = (XrdXrootdMonHeader  *)pBuff;
+   XrdXrootdMonFileTOD *tP = (XrdXrootdMonFileTOD *)(pBuff
+                                                  + sizeof(XrdXrootdMonHeader));
+   char  *oBuff = pBuff;
+   int    oLen  = plen;
+   uLongf zlen;
+   bool   aOK;
+
+// Complete the header and the time record
+//
+   hP->pseq = static_cast<char>(0x00ff & seq++);
+   hP->plen = htons(static_cast<short>(plen));
+   tP->Hdr.nRecs[0] = htons(static_cast<short>(nXfr));
+   tP->Hdr.nRecs[1] = htons(static_cast<short>(nRecs));
+   tP->tBeg = htonl(tBeg);
+   tP->tEnd = htonl(static_cast<int>(time(0)));
+
+// Compress the packet if that makes it smaller
+//
+   if (zLevel)
+      {zlen = zBsz - zhdSize;
+       if (compress2((Bytef *)zBuff+zhdSize, &zlen, (const Bytef *)pBuff,
+                     plen, zLevel) == Z_OK && (int)zlen + zhdSize < plen)
+          {hP = (XrdXrootdMonHeader *)zBuff;
+           oLen = zlen + zhdSize;
+           hP->pseq = ((XrdXrootdMonHeader *)pBuff)->pseq;
+           hP->plen = htons(static_cast<short>(oLen));
+           *(kXR_unt32 *)(zBuff+sizeof(XrdXrootdMonHeader)) = htonl(plen);
+           oBuff = zBuff;
+          }
+      }
+
+// Send it off and account for it
+//
+   aOK = !XrdXrootdMonitor::Send(XROOTD_MON_FSTA, oBuff, oLen);
+   stMutex.Lock();
+   if (aOK) {pktSent++; recSent += nRecs; bytesIn += plen; bytesOut += oLen;}
+      else  {pktFail++; recFail += nRecs;}
+   stMutex.UnLock();
+}
+
+/******************************************************************************/
+/*                                S e n d e r                                 */
+/******************************************************************************/
+
+void *XrdXrootdMonFSink::Sender(void *)
+{
+   while(1)
+        {sndCV.Lock();
+         while(!sndGo) sndCV.Wait();
+         sndGo = false;
+         sndCV.UnLock();
+         SendAll();
+        }
+   return 0;
+}
+
+/******************************************************************************/
+/*                               S e n d A l l                                */
+/******************************************************************************/
+
+void XrdXrootdMonFSink::SendAll()
+{
+   Batch *bP, *nP, *fP = 0, *fLast = 0;
+   int plen = hdrSize, nRecs = 0, nXfr = 0, tBeg = 0;
+
+// Grab everything that is ready and put it back in the order it was queued
+//
+   bP = readyQ.exchange(0, std::memory_order_acquire);
+   for (nP = 0; bP; bP = fP) {fP = bP->next; bP->next = nP; nP = bP;}
+
+// Pack the batches into as few packets as possible
+//
+   for (bP = nP; bP; bP = bP->next)
+       {if (plen + bP->dlen > pSize)
+           {Send(plen, nRecs, nXfr, tBeg);
+            plen = hdrSize; nRecs = nXfr = 0;
+           }
+        if (!nRecs || bP->tBeg < tBeg) tBeg = bP->tBeg;
+        memcpy(pBuff + plen, bP->data, bP->dlen);
+        plen  += bP->dlen;
+        nRecs += bP->nRecs;
+        nXfr  += bP->nXfr;
+        qNum--;
+        fLast = bP;
+       }
+   if (nRecs) Send(plen, nRecs, nXfr, tBeg);
+
+// Return the batches for reuse
+//
+   if (fLast)
+      {fbMutex.Lock();
+       fLast->next = fbFree; fbFree = nP;
+       fbMutex.UnLock();
+      }
+}
+
+/******************************************************************************/
+/*                   T B u f f R e f   D e s t r u c t o r                    */
+/******************************************************************************/
+
+XrdXrootdMonFSink::TBuffRef::~TBuffRef()
+{
+   if (tP)
+      {XrdSysMutexHelper mHelp(tbMutex);
+       tP->nextFree = tbFree;
+       tbFree = tP;
+      }
+}
@@ -0,0 +1,141 @@
+#ifndef __XROOTD_MONFSINK_H__
+#define __XROOTD_MONFSINK_H__
+/******************************************************************************/
+/*                                                                            */
+/*                  X r d X r o o t d M o n F S i n k . h h                   */
+/*                                                                            */
+/* This file is part of the XRootD software suite.                            */
+/*                                                                            */
+/* XRootD is free software: you can redistribute it and/or modify it under    */
+/* the terms of the GNU Lesser General Public License as published by the     */
+/* Free Software Foundation, either version 3 of the License, or (at your     */
+/* option) any later version.                                                 */
+/*                                                                            */
+/* XRootD is distributed in the hope that it will be useful, but WITHOUT      */
+/* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or      */
+/* FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public       */
+/* License for more details.                                                  */
+/*                                                                            */
+/* You should have received a copy of the GNU Lesser General Public License   */
+/* along with XRootD in a file called COPYING.LESSER (LGPL license) and file  */
+/* COPYING (GPL license).  If not, see <http://www.gnu.org/licenses/>.        */
+/*                                                                            */
+/* The copyright holder's institutional names and contributor's names may not */
+/* be used to endorse or promote products derived from this software without  */
+/* specific prior written permission of the institution or contributor.       */
+/******************************************************************************/
+
+#include <atomic>
+#include <stdint.h>
+
+#include "XrdSys/XrdSysPthread.hh"
+
+class XrdSysError;
+
+// The XrdXrootdMonFSink class is an alternate way of shipping the "f" stream.
+// Each thread appends its records to a batch of its own so that recording
+// takes no global lock. Full batches are queued without locks to a sender
+// thread that packs them into "f" stream packets, optionally compresses each
+// packet, and sends it to the monitor destinations (which may be local UNIX
+// datagram sockets). Partial batches are picked up at each fstat interval.
+// Should the sender fall behind, records are dropped rather than making the
+// clients wait; dropped records and packets that could not be sent are counted.
+//
+// A compressed packet consists of an XrdXrootdMonHeader with a code of
+// XROOTD_MON_MAPZFST followed by the kXR_unt32 length of the original packet
+// and the original "f" stream packet compressed in zlib format.
+//
+class XrdXrootdMonFSink
+{
+public:
+
+// Add() records an "f" stream record of rlen bytes.
+//
+static void Add(const void *rec, int rlen, bool isXfr=false)
+               {if (!Record(rec, rlen, isXfr)) recDrop++;}
+
+// Enabled() returns true if the "f" stream goes through us.
+//
+static bool Enabled() {return isOn;}
+
+// Flush() sends whatever records have been added so far.
+//
+static void Flush();
+
+// Format() places the XML form of the sink statistics in buff. When buff is
+//          nil, it returns the maximum length it may need.
+//
+static int  Format(char *buff, int blen);
+
+// Init() starts the sink using packets of psz bytes.
+//
+static bool Init(XrdSysError *errp, int psz);
+
+// setParms() records the per-thread batch size and the zlib compression level
+//            (0 for none). This enables the sink.
+//
+static void setParms(int bsz, int zlvl)
+                    {bSize = bsz; zLevel = zlvl; isOn = true;}
+
+private:
+
+struct Batch
+      {Batch       *next;
+       int          dlen;      // Bytes of records in data
+       short        nRecs;     // Number of records
+       short        nXfr;      // Number of isXfr records
+       int          tBeg;      // Time the first record was added
+       char         data[8];   // Really bSize bytes
+      };
+
+struct TBuff
+      {TBuff       *next;      // All thread buffers
+       TBuff       *nextFree;  // Buffers of threads that have exited
+       Batch       *curB;      // Batch being filled
+       XrdSysMutex  tMutex;    // Only contended when flushing
+      };
+
+struct TBuffRef
+      {TBuff *tP;
+            ~TBuffRef();
+      };
+
+static Batch   *GetBatch();
+static TBuff   *GetTBuff();
+static void     Queue(Batch *bP);
+static bool     Record(const void *rec, int rlen, bool isXfr);
+static void     Send(int plen, int nRecs, int nXfr, int tBeg);
+static void    *Sender(void *);
+static void     SendAll();
+
+static const int qMax = 1024;        // Maximum batches waiting to be sent
+
+static thread_local TBuffRef myTB;
+static XrdSysMutex           tbMutex;
+static TBuff                *tbAll;
+static TBuff                *tbFree;
+static std::atomic<Batch *>  readyQ;
+static XrdSysMutex           fbMutex;
+static Batch                *fbFree;
+static std::atomic<int>      qNum;
+static XrdSysCondVar         sndCV;
+static XrdSysMutex           stMutex;
+static XrdSysError          *eDest;
+static char                 *pBuff;
+static char                 *zBuff;
+static int                   zBsz;
+static int                   pSize;
+static int                   bSize;
+static int                   zLevel;
+static bool                  sndGo;
+static bool                  isOn;
+
+static std::atomic<long long> recDrop;
+static long long             recSent;
+static long long             pktSent;
+static long long             pktFail;
+static long long             recFail;
+static long long             bytesIn;
+static long long             bytesOut;
+};
+#endif
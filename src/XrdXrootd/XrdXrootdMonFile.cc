@@ -36,6 +36,7 @@
 #include "XrdSys/XrdSysPlatform.hh"
 
 #include "XrdXrootd/XrdXrootdMonFile.hh"
+#include "XrdXrootd/XrdXrootdMonFSink.hh"
 #include "XrdXrootd/XrdXrootdFileStats.hh"
 
 /******************************************************************************/
@@ -162,8 +163,11 @@ void XrdXrootdMonFile::Close(XrdXrootdFileStats *fsP, bool isDisc)
        cRec.Ssq.write.dlong = htonll(xval.dlong);
       }
 
-// Get a pointer to the next slot (the buffer gets locked)
+// Hand the record to the sink or get a pointer to the next slot (the buffer
+// gets locked).
 //
+   if (XrdXrootdMonFSink::Enabled())
+      {XrdXrootdMonFSink::Add(&cRec, crecSize); return;}
    cP = GetSlot(crecSize);
    memcpy(cP, &cRec, crecSize);
    bfMutex.UnLock();
@@ -204,11 +208,14 @@ void XrdXrootdMonFile::Defaults(int intv, int opts, int xfrcnt)
 void XrdXrootdMonFile::Disc(unsigned int usrID)
 {
    static short drecSize = htons(sizeof(XrdXrootdMonFileDSC));
-   XrdXrootdMonFileDSC *dP;
+   XrdXrootdMonFileDSC *dP, dRec;
+   bool toSink = XrdXrootdMonFSink::Enabled();
 
-// Get a pointer to the next slot (the buffer gets locked)
+// Get a pointer to the next slot (the buffer gets locked) unless the record
+// goes to the sink.
 //
-   dP = (XrdXrootdMonFileDSC *)GetSlot(sizeof(XrdXrootdMonFileDSC));
+   if (toSink) dP = &dRec;
+      else dP = (XrdXrootdMonFileDSC *)GetSlot(sizeof(XrdXrootdMonFileDSC));
 
 // Fill out the record. It's pretty simple
 //
@@ -216,7 +223,8 @@ void XrdXrootdMonFile::Disc(unsigned int usrID)
    dP->Hdr.recFlag = 0;
    dP->Hdr.recSize = drecSize;
    dP->Hdr.userID  = usrID;
-   bfMutex.UnLock();
+   if (toSink) XrdXrootdMonFSink::Add(&dRec, sizeof(dRec));
+      else bfMutex.UnLock();
 }
   
 /******************************************************************************/
@@ -233,9 +241,11 @@ void XrdXrootdMonFile::DoIt()
 
 // Check if we should flush the buffer
 //
-   bfMutex.Lock();
-   if (repNext) Flush();
-   bfMutex.UnLock();
+   if (XrdXrootdMonFSink::Enabled()) XrdXrootdMonFSink::Flush();
+      else {bfMutex.Lock();
+            if (repNext) Flush();
+            bfMutex.UnLock();
+           }
 
 // Reschedule ourselves
 //
@@ -306,8 +316,11 @@ void XrdXrootdMonFile::DoXFR(XrdXrootdFileStats *fsP)
    xfrRec.Xfr.readv  = htonll(xfrReadv);
    xfrRec.Xfr.write  = htonll(xfrWrite);
 
-// Get a pointer to the next slot (the buffer gets locked)
+// Hand the record to the sink or get a pointer to the next slot (the buffer
+// gets locked).
 //
+   if (XrdXrootdMonFSink::Enabled())
+      {XrdXrootdMonFSink::Add(&xfrRec, sizeof(xfrRec), true); return;}
    cP = GetSlot(sizeof(xfrRec));
    memcpy(cP, &xfrRec, sizeof(xfrRec));
    xfrRecs++;
@@ -328,6 +341,11 @@ bool XrdXrootdMonFile::Init(XrdScheduler *sp, XrdSysError  *errp, int bfsz)
    Sched = sp;
    eDest = errp;
 
+// Start the sink if the records go there
+//
+   if (XrdXrootdMonFSink::Enabled() && !XrdXrootdMonFSink::Init(eDest, bfsz))
+      return false;
+
 // Allocate a socket buffer
 //
    alignment = (bfsz < pagsz ? 1024 : pagsz);
@@ -468,7 +486,11 @@ void XrdXrootdMonFile::Open(XrdXrootdFileStats *fsP, const char *Path,
 {
    static const int minRecSz = sizeof(XrdXrootdMonFileOPN)
                              - sizeof(XrdXrootdMonFileLFN);
+   union {XrdXrootdMonFileOPN oRec;
+          char                oBuff[minRecSz + sizeof(kXR_unt32) + 4096];
+         } oArea;
    XrdXrootdMonFileOPN *oP;
+   bool toSink = XrdXrootdMonFSink::Enabled();
    int i = 0, sNum = -1, rLen, pLen = 0;
 
 // Assign the path a dictionary id if not assigned via file monitoring
@@ -497,20 +519,25 @@ void XrdXrootdMonFile::Open(XrdXrootdFileStats *fsP, const char *Path,
    fsP->monLvl = fsLVL;
    fsP->xfrXeq = 0;
 
-// Compute the size of this record
+// Compute the size of this record. Records going to the sink are built here
+// and a path too long for our area is truncated.
 //
    rLen = minRecSz;
    if (fsLFN)
       {pLen  = strlen(Path);
+       if (toSink && pLen >= (int)sizeof(oArea) - rLen - 12)
+          pLen = sizeof(oArea) - rLen - 12;
        rLen += sizeof(kXR_unt32) + pLen;
        i     = (rLen + 8) & ~0x00000003;
        pLen  = pLen + (i - rLen);
        rLen  = i;
       }
 
-// Get a pointer to the next slot (the buffer gets locked)
+// Get a pointer to the next slot (the buffer gets locked) unless the record
+// goes to the sink.
 //
-   oP = (XrdXrootdMonFileOPN *)GetSlot(rLen);
+   if (toSink) oP = &oArea.oRec;
+      else oP = (XrdXrootdMonFileOPN *)GetSlot(rLen);
 
 // Fill out the record
 //
@@ -526,6 +553,8 @@ void XrdXrootdMonFile::Open(XrdXrootdFileStats *fsP, const char *Path,
       {oP->Hdr.recFlag |= XrdXrootdMonFileHdr::hasLFN;
        oP->ufn.user = uDID;
        strncpy(oP->ufn.lfn, Path, pLen);
+       if (toSink) oP->ufn.lfn[pLen-1] = 0;
       }
-   bfMutex.UnLock();
+   if (toSink) XrdXrootdMonFSink::Add(oP, rLen);
+      else bfMutex.UnLock();
 }
@@ -74,6 +74,7 @@ public:
        class User;
 friend class User;
 friend class XrdXrootdMonFile;
+friend class XrdXrootdMonFSink;
 
 // All values for Add_xx() must be passed in network byte order
 //
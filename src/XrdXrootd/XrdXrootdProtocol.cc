@@ -40,12 +40,14 @@
 #include "XrdXrootd/XrdXrootdFile.hh"
 #include "XrdXrootd/XrdXrootdFileLock.hh"
 #include "XrdXrootd/XrdXrootdFileLock1.hh"
+#include "XrdXrootd/XrdXrootdLatency.hh"
 #include "XrdXrootd/XrdXrootdMonFile.hh"
 #include "XrdXrootd/XrdXrootdMonitor.hh"
 #include "XrdXrootd/XrdXrootdPio.hh"
 #include "XrdXrootd/XrdXrootdProtocol.hh"
 #include "XrdXrootd/XrdXrootdStats.hh"
 #include "XrdXrootd/XrdXrootdTrace.hh"
+#include "XrdXrootd/XrdXrootdWPipe.hh"
 #include "XrdXrootd/XrdXrootdXPath.hh"
 
 /******************************************************************************/
@@ -97,6 +99,7 @@ int                   XrdXrootdProtocol::maxTransz    = 262144; // 256KB
 int                   XrdXrootdProtocol::as_maxperlnk = 8;   // Max ops per link
 int                   XrdXrootdProtocol::as_maxperreq = 8;   // Max ops per request
 int                   XrdXrootdProtocol::as_maxpersrv = 4096;// Max ops per server
+int                   XrdXrootdProtocol::as_aiopool   = 0;   // Segments in pool
 int                   XrdXrootdProtocol::as_segsize   = 131072;
 int                   XrdXrootdProtocol::as_miniosz   = 32768;
 #ifdef __solaris__
@@ -109,6 +112,8 @@ int                   XrdXrootdProtocol::as_force     = 0;
 int                   XrdXrootdProtocol::as_noaio     = 0;
 int                   XrdXrootdProtocol::as_nosf      = 0;
 int                   XrdXrootdProtocol::as_syncw     = 0;
+int                   XrdXrootdProtocol::wp_depth     = 3;
+int                   XrdXrootdProtocol::wp_minsz     = 1048576;
 
 const char           *XrdXrootdProtocol::myInst  = 0;
 const char           *XrdXrootdProtocol::TraceID = "Protocol";
@@ -122,6 +127,9 @@ int                   XrdXrootdProtocol::PrepareLimit = -1;
 bool                  XrdXrootdProtocol::PrepareAlt = false;
 bool                  XrdXrootdProtocol::LimitError = true;
 
+int                   XrdXrootdProtocol::dirPageSz  = 1000;
+int                   XrdXrootdProtocol::dirStatPar = 4;
+
 struct XrdXrootdProtocol::RD_Table XrdXrootdProtocol::Route[RD_Num];
 int                   XrdXrootdProtocol::OD_Stall = 33;
 bool                  XrdXrootdProtocol::OD_Bypass= false;
@@ -354,12 +362,17 @@ int XrdXrootdProtocol::Process(XrdLink *lp) // We ignore the argument here
            return rc;
           }
           else if ((rc = (*this.*Resume)()) != 0) return rc;
-                  else {Resume = 0; return 0;}
+                  else {Resume = 0;
+                        XrdXrootdLatency::Add(Request.header.requestid,
+                                          XrdXrootdLatency::Now() - reqStart);
+                        return 0;
+                       }
       }
 
 // Read the next request header
 //
    if ((rc=getData("request",(char *)&Request,sizeof(Request))) != 0) return rc;
+   reqStart = XrdXrootdLatency::Now();
 
 // Check if we need to copy the request prior to unmarshalling it
 //
@@ -406,9 +419,12 @@ int XrdXrootdProtocol::Process(XrdLink *lp) // We ignore the argument here
           {Resume = &XrdXrootdProtocol::Process2; return rc;}
       }
 
-// Continue with request processing at the resume point
+// Continue with request processing at the resume point. Requests that were
+// answered or handed off are timed.
 //
-   return Process2();
+   if (!(rc = Process2()) && !Resume)
+      XrdXrootdLatency::Add(reqID, XrdXrootdLatency::Now() - reqStart);
+   return rc;
 }
 
 /******************************************************************************/
@@ -745,6 +761,10 @@ void XrdXrootdProtocol::Cleanup()
 //
    if (argp) {BPool->Release(argp); argp = 0;}
 
+// Wait for any pipelined writes to complete before the files go away
+//
+   if (wPipe) {wPipe->Recycle(); wPipe = 0;}
+
 // Notify the filesystem of a disconnect prior to deleting file tables
 //
    if (Status != XRD_BOUNDPATH) osFS->Disc(Client);
@@ -792,6 +812,16 @@ void XrdXrootdProtocol::Cleanup()
 // Handle writev appendage
 //
    if (wvInfo) {free(wvInfo); wvInfo = 0;}
+
+// Close any directories held open for paged listings
+//
+   for (i = 0; i < maxDirCursors; i++)
+       if (dirCursor[i].dp)
+          {dirCursor[i].dp->close();
+           delete dirCursor[i].dp;
+           free(dirCursor[i].path);
+           dirCursor[i].dp = 0;
+          }
 }
   
 /******************************************************************************/
@@ -835,9 +865,11 @@ void XrdXrootdProtocol::Reset()
    myOffset           = 0;
    myIOLen            = 0;
    myStalls           = 0;
+   reqStart           = 0;
    myAioReq           = 0;
    myFile             = 0;
    wvInfo             = 0;
+   wPipe              = 0;
    numReads           = 0;
    numReadP           = 0;
    numReadV           = 0;
@@ -875,4 +907,7 @@ void XrdXrootdProtocol::Reset()
    Entity.Reset();
    memset(Stream,  0, sizeof(Stream));
    PrepareCount       = 0;
+   memset(dirCursor, 0, sizeof(dirCursor));
+   dirCursorID        = 0;
+   dirCursorUse       = 0;
 }
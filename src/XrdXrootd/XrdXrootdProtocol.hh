@@ -32,6 +32,7 @@
 #include <stdlib.h>
 #include <unistd.h>
 #include <sys/types.h>
+#include <sys/stat.h>
 
 #include "XrdSys/XrdSysError.hh"
 #include "XrdSys/XrdSysPthread.hh"
@@ -87,6 +88,7 @@ class XrdXrootdJob;
 class XrdXrootdMonitor;
 class XrdXrootdPio;
 class XrdXrootdStats;
+class XrdXrootdWPipe;
 class XrdXrootdWVInfo;
 class XrdXrootdXPath;
 
@@ -145,6 +147,9 @@ enum RD_func {RD_chmod = 0, RD_chksum,  RD_dirlist, RD_locate, RD_mkdir,
        int   do_Close();
        int   do_Dirlist();
        int   do_DirStat(XrdSfsDirectory *dp, char *pbuff, char *opaque);
+       int   do_DirPage(char *cursor, char *opaque, bool doDig);
+       bool  DirPageStat(char **names, struct stat *sbuf, int *rcv, int num,
+                         char *opaque, bool doDig, int &rc);
        int   do_Endsess();
        int   do_Getfile();
        int   do_Login();
@@ -174,12 +179,15 @@ enum RD_func {RD_chmod = 0, RD_chksum,  RD_dirlist, RD_locate, RD_mkdir,
        int   do_Set_Mon(XrdOucTokenizer &setargs);
        int   do_Stat();
        int   do_Statx();
+       int   do_StatxInfo();
        int   do_Sync();
        int   do_Truncate();
        int   do_Write();
        int   do_WriteAll();
        int   do_WriteCont();
        int   do_WriteNone();
+       int   do_WritePipe();
+       int   do_WritePCont();
        int   do_WriteV();
        int   do_WriteVec();
 
@@ -227,7 +235,9 @@ static void  xred_set(RD_func func, char *rHost[2], int rPort[2]);
 static bool  xred_xok(int     func, char *rHost[2], int rPort[2]);
 static int   xsecl(XrdOucStream &Config);
 static int   xtrace(XrdOucStream &Config);
+static int   xpipew(XrdOucStream &Config);
 static int   xlimit(XrdOucStream &Config);
+static int   xdirl(XrdOucStream &Config);
 
 static XrdObjectQ<XrdXrootdProtocol> ProtStack;
 XrdObject<XrdXrootdProtocol>         ProtLink;
@@ -298,6 +308,7 @@ static bool   OD_Redir;
 static int                 as_maxperlnk; // Max async requests per link
 static int                 as_maxperreq; // Max async ops per request
 static int                 as_maxpersrv; // Max async ops per server
+static int                 as_aiopool;   // Aio segments to preallocate
 static int                 as_miniosz;   // Min async request size
 static int                 as_minsfsz;   // Min sendf request size
 static int                 as_segsize;   // Aio quantum (optimal)
@@ -306,6 +317,8 @@ static int                 as_force;     // aio to be forced
 static int                 as_noaio;     // aio is disabled
 static int                 as_nosf;      // sendfile is disabled
 static int                 as_syncw;     // writes to be synchronous
+static int                 wp_depth;     // Write pipeline depth (0 -> off)
+static int                 wp_minsz;     // Min write size for the pipeline
 static int                 maxBuffsz;    // Maximum buffer size we can have
 static int                 maxTransz;    // Maximum transfer size we can have
 static const int           maxRvecsz = 1024;   // Maximum read vector size
@@ -369,6 +382,7 @@ int                        myBlast;
 int                       (XrdXrootdProtocol::*Resume)();
 XrdXrootdFile             *myFile;
 XrdXrootdWVInfo           *wvInfo;
+XrdXrootdWPipe            *wPipe;
 union {
 long long                  myOffset;
 long long                  myWVBytes;
@@ -376,6 +390,7 @@ int                        myEInfo[2];
       };
 int                        myIOLen;
 int                        myStalls;
+long long                  reqStart;     // When the current request arrived
 
 // Buffer resize control area
 //
@@ -416,6 +431,27 @@ static bool                LimitError;  // Indicates that hitting a limit should
 int                        PrepareCount;
 static int                 PrepareLimit;
 
+// This area is used for paged directory listings. Each cursor holds an open
+// directory positioned at the next entry to be returned.
+//
+struct DirCursor
+      {XrdSfsDirectory    *dp;
+       char               *path;
+       long long           pos;     // Entries returned so far
+       unsigned int        id;
+       unsigned int        lastUse;
+       bool                doStat;
+       bool                autoStat;
+       struct stat         Stat;    // Filled in by autostat directories
+      };
+
+static const int           maxDirCursors = 8;
+DirCursor                  dirCursor[maxDirCursors];
+unsigned int               dirCursorID;
+unsigned int               dirCursorUse;
+static int                 dirPageSz;   // Entries per page
+static int                 dirStatPar;  // Parallel stats per page
+
 // Buffers to handle client requests
 //
 XrdXrootdReqID             ReqID;
@@ -28,9 +28,13 @@
 /******************************************************************************/
  
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
   
 #include "Xrd/XrdStats.hh"
 #include "XrdSfs/XrdSfsInterface.hh"
+#include "XrdXrootd/XrdXrootdLatency.hh"
+#include "XrdXrootd/XrdXrootdMonFSink.hh"
 #include "XrdXrootd/XrdXrootdResponse.hh"
 #include "XrdXrootd/XrdXrootdStats.hh"
  
@@ -40,6 +44,9 @@
   
 XrdXrootdStats::XrdXrootdStats(XrdStats *sp)
 {
+static const char *shmName[] = {"rd", "rv", "rs", "wv", "ws", "wr",
+                                "open", "sync", "login", "wp.bytes",
+                                "wp.wait"};
 
 xstats   = sp;
 fsP      = 0;
@@ -72,6 +79,8 @@ AuthBad  = 0;     // Stats: Number of authentication failures
 aokSCnt  = 0;     // Stats: Number of signature successes
 badSCnt  = 0;     // Stats: Number of signature failures
 ignSCnt  = 0;     // Stats: Number of signature ignored
+
+shmBase  = XrdStatsShm::Define("xrootd", shmName, shmWpW+1);
 }
 
 /******************************************************************************/
@@ -88,7 +97,7 @@ int XrdXrootdStats::Stats(char *buff, int blen, int do_sync)
    "<sig><ok>%d</ok><bad>%d</bad><ign>%d</ign></sig>"
    "<aio><num>%lld</num><max>%d</max><rej>%lld</rej></aio>"
    "<err>%d</err><rdr>%lld</rdr><dly>%d</dly>"
-   "<lgn><num>%d</num><af>%d</af><au>%d</au><ua>%d</ua></lgn></stats>";
+   "<lgn><num>%d</num><af>%d</af><au>%d</au><ua>%d</ua></lgn>";
 //                                   1 2 3 4 5 6 7 8
    static const long long LLMax = 0x7fffffffffffffffLL;
    static const int       INMax = 0x7fffffff;
@@ -105,6 +114,8 @@ int XrdXrootdStats::Stats(char *buff, int blen, int do_sync)
                       INMax, INMax, INMax,
                       LLMax, INMax, LLMax, INMax, LLMax, INMax,
                       INMax, INMax, INMax, INMax);
+       len += XrdXrootdLatency::Format(0, 0) + XrdXrootdMonFSink::Format(0, 0)
+            + sizeof("</stats>");
        return len + (fsP ? fsP->getStats(0,0) : 0);
       }
 
@@ -121,6 +132,15 @@ int XrdXrootdStats::Stats(char *buff, int blen, int do_sync)
                   LoginAT, AuthBad, LoginAU, LoginUA);
    statsMutex.UnLock();
 
+// Add the request latencies and the fstat sink counters
+//
+   if (len < blen)
+      {len += XrdXrootdLatency::Format(buff+len, blen-len-sizeof("</stats>"));
+       len += XrdXrootdMonFSink::Format(buff+len, blen-len-sizeof("</stats>"));
+       if (len + (int)sizeof("</stats>") <= blen)
+          {strcpy(buff+len, "</stats>"); len += sizeof("</stats>")-1;}
+      }
+
 // Now include filesystem statistics and return
 //
    if (fsP) len += fsP->getStats(buff+len, blen-len);
@@ -144,6 +164,20 @@ int XrdXrootdStats::Stats(XrdXrootdResponse &resp, const char *opts)
     statsInfo statsResp(&resp);
     int xopts = 0;
 
+// Latency histograms are returned by themselves in binary form
+//
+    if (strchr(opts, 'h'))
+       {char *lbuff;
+        int   llen = XrdXrootdLatency::Pack(0, 0), rc;
+        do {if (!(lbuff = (char *)malloc(-llen)))
+               return resp.Send(kXR_NoMemory, "insufficient memory for stats");
+            if ((llen = XrdXrootdLatency::Pack(lbuff, -llen)) < 0) free(lbuff);
+           } while(llen < 0);
+        rc = resp.Send(lbuff, llen);
+        free(lbuff);
+        return rc;
+       }
+
     while(*opts)
          {switch(*opts)
                 {case 'a': xopts |= XRD_STATS_ALL;  break;
@@ -29,6 +29,7 @@
 /* specific prior written permission of the institution or contributor.       */
 /******************************************************************************/
 
+#include "Xrd/XrdStatsShm.hh"
 #include "XrdSys/XrdSysPthread.hh"
 #include "XrdOuc/XrdOucStats.hh"
 
@@ -68,6 +69,14 @@ int              aokSCnt;      // Stats: Number of signature successes
 int              badSCnt;      // Stats: Number of signature failures
 int              ignSCnt;      // Stats: Number of signature ignored
 
+// Counters also published in shared memory (see XrdStatsShm)
+//
+enum shmCtr {shmRd = 0, shmRv, shmRs, shmWv, shmWs, shmWr,
+             shmOpen, shmSync, shmLogin, shmWpB, shmWpW};
+
+void             Publish(shmCtr ctr, long long n=1)
+                        {XrdStatsShm::Add(shmBase+ctr, n);}
+
 void             setFS(XrdSfsFileSystem *fsp) {fsP = fsp;}
 
 int              Stats(char *buff, int blen, int do_sync=0);
@@ -80,5 +89,6 @@ private:
 
 XrdSfsFileSystem *fsP;
 XrdStats *xstats;
+int       shmBase;
 };
 #endif
@@ -0,0 +1,261 @@
+/******************************************************************************/
+/*                                                                            */
+/*                     X r d X r o o t d W P i p e . c c                      */
+/*                                                                            */
+/* This file is part of the XRootD software suite.                            */
+/*                                                                            */
+/* XRootD is free software: you can redistribute it and/or modify it under    */
+/* the terms of the GNU Lesser General Public License as published by the     */
+/* Free Software Foundation, either version 3 of the License, or (at your     */
+/* option) any later version.                                                 */
+/*                                                                            */
+/* XRootD is distributed in the hope that it will be useful, but WITHOUT      */
+/* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or      */
+/* FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public       */
+/* License for more details.                                                  */
+/*                                                                            */
+/* You should have received a copy of the GNU Lesser General Public License   */
+/* along with XRootD in a file called COPYING.LESSER (LGPL license) and file  */
+/* COPYING (GPL license).  If not, see <http://www.gnu.org/licenses/>.        */
+/*                                                                            */
+/* The copyright holder's institutional names and contributor's names may not */
+/* be used to endorse or promote products derived from this software without  */
+/* specific prior written permission of the institution or contributor.       */
+/******************************************************************************/
+
+#include <time.h>
+
+#include "Xrd/XrdBuffer.hh"
+#include "Xrd/XrdScheduler.hh"
+#include "XrdSfs/XrdSfsInterface.hh"
+#include "XrdXrootd/XrdXrootdFile.hh"
+#include "XrdXrootd/XrdXrootdStats.hh"
+#include "XrdXrootd/XrdXrootdWPipe.hh"
+
+/******************************************************************************/
+/*                        S t a t i c   O b j e c t s                         */
+/******************************************************************************/
+
+XrdBuffManager *XrdXrootdWPipe::BPool = 0;
+XrdScheduler   *XrdXrootdWPipe::Sched = 0;
+XrdXrootdStats *XrdXrootdWPipe::SI    = 0;
+
+namespace
+{
+long long usNow()
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (long long)ts.tv_sec*1000000LL + ts.tv_nsec/1000;
+}
+}
+
+/******************************************************************************/
+/*                                B u f f e r                                 */
+/******************************************************************************/
+
+char *XrdXrootdWPipe::Buffer()
+{
+   char *bP;
+
+// Wait for the next buffer to have been written. This is where the network
+// gets throttled to the speed of the file system. We write the oldest chunk
+// ourselves unless the writer job is busy with it as the job may be queued
+// behind requests that are waiting for a worker, possibly this one.
+//
+   wpCond.Lock();
+   if (numFull >= wpDepth)
+      {wpFile->Stats.wpipe.waits++;
+       SI->Publish(XrdXrootdStats::shmWpW);
+       do {if (wrBusy) wpCond.Wait();
+              else WriteOne();
+          } while(numFull >= wpDepth);
+      }
+   bP = wpBuff[rdSlot]->buff;
+   wpCond.UnLock();
+   return bP;
+}
+
+/******************************************************************************/
+/*                                  D o I t                                   */
+/******************************************************************************/
+
+void XrdXrootdWPipe::DoIt()
+{
+
+// Write each received chunk in the order received. Should the receiving
+// thread be writing one itself, wait for it so that the order is kept.
+//
+   wpCond.Lock();
+   while(numFull)
+        {if (wrBusy) wpCond.Wait();
+            else WriteOne();
+        }
+
+// Indicate that we are no longer running. We must not touch this object
+// after unlocking as the pipe may be finished and reused at that point. If
+// the pipe was recycled while we were queued, it's up to us to delete it.
+//
+   wrActive = false;
+   if (wpZombie) {wpCond.UnLock(); delete this; return;}
+   wpCond.Broadcast();
+   wpCond.UnLock();
+}
+
+/******************************************************************************/
+/*                                 E r r o r                                  */
+/******************************************************************************/
+
+int XrdXrootdWPipe::Error()
+{
+   int rc;
+
+   wpCond.Lock(); rc = wpRC; wpCond.UnLock();
+   return rc;
+}
+
+/******************************************************************************/
+/*                                F i n i s h                                 */
+/******************************************************************************/
+
+int XrdXrootdWPipe::Finish()
+{
+   XrdBuffer *bP[maxDepth];
+   int rc, num;
+
+// Drain the pipe writing whatever the writer job has not gotten to. We don't
+// wait for a job that has not started as it may never get a worker; should it
+// run later it will find nothing to do.
+//
+   wpCond.Lock();
+   while(numFull)
+        {if (wrBusy) wpCond.Wait();
+            else WriteOne();
+        }
+   rc = wpRC; wpRC = 0;
+   num = wpDepth; wpDepth = 0; wpFile = 0;
+   for (int i = 0; i < num; i++) bP[i] = wpBuff[i];
+   wpCond.UnLock();
+
+// Release the buffers
+//
+   for (int i = 0; i < num; i++) BPool->Release(bP[i]);
+   return rc;
+}
+
+/******************************************************************************/
+/*                                  I n i t                                   */
+/******************************************************************************/
+
+void XrdXrootdWPipe::Init(XrdBuffManager *bP, XrdScheduler *sP,
+                          XrdXrootdStats *siP)
+{
+   BPool = bP;
+   Sched = sP;
+   SI    = siP;
+}
+
+/******************************************************************************/
+/*                                 Q u e u e                                  */
+/******************************************************************************/
+
+void XrdXrootdWPipe::Queue(long long offset, int dlen)
+{
+   bool doSched;
+
+// Add the chunk to the pipe and start the writer if it is not running
+//
+   wpCond.Lock();
+   wpOffs[rdSlot] = offset;
+   wpDlen[rdSlot] = dlen;
+   rdSlot = (rdSlot+1) % wpDepth; numFull++;
+   if ((doSched = !wrActive)) wrActive = true;
+   wpCond.UnLock();
+
+   if (doSched) Sched->Schedule((XrdJob *)this);
+}
+
+/******************************************************************************/
+/*                               R e c y c l e                                */
+/******************************************************************************/
+
+void XrdXrootdWPipe::Recycle()
+{
+
+// Write out anything pending and release the buffers
+//
+   Finish();
+
+// If the writer job is still queued it references this object, so let it
+// delete the pipe when it finally runs.
+//
+   wpCond.Lock();
+   if (wrActive) {wpZombie = true; wpCond.UnLock(); return;}
+   wpCond.UnLock();
+   delete this;
+}
+
+/******************************************************************************/
+/*                                 S t a r t                                  */
+/******************************************************************************/
+
+bool XrdXrootdWPipe::Start(XrdXrootdFile *fP, int depth, int bsz)
+{
+   XrdBuffer *bP[maxDepth];
+   int num;
+
+// Obtain the buffers; any previous request must have been finished
+//
+   if (depth > maxDepth) depth = maxDepth;
+   for (num = 0; num < depth; num++)
+       if (!(bP[num] = BPool->Obtain(bsz)))
+          {while(num--) BPool->Release(bP[num]);
+           return false;
+          }
+
+// Set up for the request. A writer job left over from a previous request may
+// still run, hence the lock.
+//
+   wpCond.Lock();
+   for (int i = 0; i < num; i++) wpBuff[i] = bP[i];
+   wpDepth = num;
+   wpFile  = fP;
+   wpChunk = bsz;
+   rdSlot  = wrSlot = numFull = 0;
+   wpCond.UnLock();
+   return true;
+}
+
+/******************************************************************************/
+/*                       P r i v a t e   M e t h o d s                        */
+/******************************************************************************/
+/******************************************************************************/
+/*                              W r i t e O n e                               */
+/******************************************************************************/
+
+void XrdXrootdWPipe::WriteOne() // wpCond must be locked
+{
+   XrdBuffer *bP = wpBuff[wrSlot];
+   long long  offs = wpOffs[wrSlot], tBeg;
+   int        dlen = wpDlen[wrSlot], rc;
+
+// Write the oldest chunk. Once an error occurs the remaining chunks are simply
+// discarded as the request will fail anyway.
+//
+   if (!wpRC)
+      {wrBusy = true;
+       wpCond.UnLock();
+       tBeg = usNow();
+       rc = wpFile->XrdSfsp->write(offs, bP->buff, dlen);
+       tBeg = usNow() - tBeg;
+       wpCond.Lock();
+       wrBusy = false;
+       if (rc < 0) wpRC = rc;
+          else {wpFile->Stats.wpipe.bytes += dlen;
+                wpFile->Stats.wpipe.wTime += tBeg;
+                SI->Publish(XrdXrootdStats::shmWpB, dlen);
+               }
+      }
+   wrSlot = (wrSlot+1) % wpDepth; numFull--;
+   wpCond.Broadcast();
+}
@@ -0,0 +1,123 @@
+#ifndef __XRDXROOTDWPIPE_HH__
+#define __XRDXROOTDWPIPE_HH__
+/******************************************************************************/
+/*                                                                            */
+/*                     X r d X r o o t d W P i p e . h h                      */
+/*                                                                            */
+/* This file is part of the XRootD software suite.                            */
+/*                                                                            */
+/* XRootD is free software: you can redistribute it and/or modify it under    */
+/* the terms of the GNU Lesser General Public License as published by the     */
+/* Free Software Foundation, either version 3 of the License, or (at your     */
+/* option) any later version.                                                 */
+/*                                                                            */
+/* XRootD is distributed in the hope that it will be useful, but WITHOUT      */
+/* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or      */
+/* FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public       */
+/* License for more details.                                                  */
+/*                                                                            */
+/* You should have received a copy of the GNU Lesser General Public License   */
+/* along with XRootD in a file called COPYING.LESSER (LGPL license) and file  */
+/* COPYING (GPL license).  If not, see <http://www.gnu.org/licenses/>.        */
+/*                                                                            */
+/* The copyright holder's institutional names and contributor's names may not */
+/* be used to endorse or promote products derived from this software without  */
+/* specific prior written permission of the institution or contributor.       */
+/******************************************************************************/
+
+#include "Xrd/XrdJob.hh"
+#include "XrdSys/XrdSysPthread.hh"
+
+/******************************************************************************/
+/*                        X r d X r o o t d W P i p e                         */
+/******************************************************************************/
+
+// The XrdXrootdWPipe object overlaps receiving the data of a large write
+// request with writing it to the file. The data is received into one of up
+// to maxDepth buffers while the previously received ones are written, in
+// order, by a scheduler job. The job may not get to run when all workers are
+// busy, so the receiving thread never waits for it: when it runs out of
+// buffers or finishes the request it writes pending chunks itself unless the
+// job is in the middle of writing one. There is at most one pipe per link and
+// it is only used by the thread handling the link's current request.
+
+class XrdBuffer;
+class XrdBuffManager;
+class XrdScheduler;
+class XrdXrootdFile;
+class XrdXrootdStats;
+
+class XrdXrootdWPipe : public XrdJob
+{
+public:
+
+// Buffer() returns the buffer to receive the next chunk, writing the oldest
+//          chunk (or waiting for it to be written) if they are all in use.
+//
+       char         *Buffer();
+
+// Chunk() returns the size of each chunk for the current request.
+//
+inline int           Chunk() {return wpChunk;}
+
+       void          DoIt();
+
+// Error() returns the first write error encountered, if any.
+//
+       int           Error();
+
+// Finish() writes all queued chunks, releases the buffers, and returns the
+//          first write error encountered (0 if none).
+//
+       int           Finish();
+
+static void          Init(XrdBuffManager *bP, XrdScheduler *sP,
+                          XrdXrootdStats *siP);
+
+// Queue() queues the chunk in the current buffer to be written at offset.
+//
+       void          Queue(long long offset, int dlen);
+
+// Recycle() finishes the pipe and deletes it once the writer job, which may
+//           still be queued, is done with it.
+//
+       void          Recycle();
+
+// Start() sets up the pipe to write fP using depth buffers of bsz bytes. It
+//         returns false if the buffers could not be obtained.
+//
+       bool          Start(XrdXrootdFile *fP, int depth, int bsz);
+
+static const int     maxDepth = 8;
+
+                     XrdXrootdWPipe() : XrdJob("write pipe"), wpCond(0),
+                                        wpFile(0), wpDepth(0), wpChunk(0),
+                                        rdSlot(0), wrSlot(0), numFull(0),
+                                        wpRC(0), wrActive(false),
+                                        wrBusy(false), wpZombie(false) {}
+
+private:
+                    ~XrdXrootdWPipe() {}
+
+void                 WriteOne();
+
+static XrdBuffManager *BPool;
+static XrdScheduler   *Sched;
+static XrdXrootdStats *SI;
+
+XrdSysCondVar          wpCond;    // Caller handles the lock
+XrdXrootdFile         *wpFile;
+XrdBuffer             *wpBuff[maxDepth];
+long long              wpOffs[maxDepth];
+int                    wpDlen[maxDepth];
+int                    wpDepth;   // Number of buffers
+int                    wpChunk;   // Size of each chunk
+int                    rdSlot;    // Buffer being received into
+int                    wrSlot;    // Buffer being written from
+int                    numFull;   // Buffers received but not yet written
+int                    wpRC;      // First write error
+bool                   wrActive;  // Writer job has been scheduled
+bool                   wrBusy;    // A chunk is being written
+bool                   wpZombie;  // Pipe is to be deleted by the writer job
+};
+#endif
@@ -59,6 +59,7 @@
 #include "XrdXrootd/XrdXrootdProtocol.hh"
 #include "XrdXrootd/XrdXrootdStats.hh"
 #include "XrdXrootd/XrdXrootdTrace.hh"
+#include "XrdXrootd/XrdXrootdWPipe.hh"
 #include "XrdXrootd/XrdXrootdXPath.hh"
 
 #include "XrdVersion.hh"
@@ -107,6 +108,102 @@ struct XrdXrootdWVInfo
         XrdOucIOVec  ioVec[1]; // Dynamically sized
        };
 
+// The XrdXrootdDirStat object stats the entries in a page of a paged directory
+// listing. The worker filling out the page stats entries itself while the
+// jobs it schedules help out by claiming entries one at a time. As the jobs
+// may not get a worker for a while, the page only waits for entries that have
+// been claimed; jobs that run later find nothing left to do. The object is
+// deleted by whoever releases the last reference to it.
+//
+class XrdXrootdDirStat
+{
+public:
+
+class Helper : public XrdJob
+     {public:
+      void DoIt() {dsP->Run(); dsP->Unref();}
+      XrdXrootdDirStat *dsP;
+           Helper() : XrdJob("dirlist stat"), dsP(0) {}
+          ~Helper() {}
+     };
+
+static const int maxHelp = 64;
+
+void Run()
+    {XrdOucErrInfo eInfo(tident, monID, ucap);
+     const char *eTxt;
+     char pbuff[2048];
+     int i, rc, eCode, plen = strlen(dPath);
+
+     dsCond.Lock();
+     while(next < num && !errRC)
+          {i = next++; busy++;
+           dsCond.UnLock();
+           if (plen + strlen(names[i]) >= sizeof(pbuff))
+              {rc = SFS_ERROR; eInfo.setErrInfo(ENAMETOOLONG, "path too long");}
+              else {strcpy(pbuff, dPath); strcpy(pbuff+plen, names[i]);
+                    rc = fsP->stat(pbuff, &sbuf[i], eInfo, client, opaque);
+                   }
+           eTxt = eInfo.getErrText(eCode);
+           dsCond.Lock();
+           busy--;
+           if (rc == SFS_OK) rcv[i] = SFS_OK;
+              else if (rc == SFS_ERROR && eCode == ENOENT) rcv[i] = SFS_ERROR;
+              else {rcv[i] = rc;
+                    if (!errRC)
+                       {errRC = rc; errCode = eCode;
+                        strlcpy(errText, eTxt, sizeof(errText));
+                       }
+                   }
+           if (eInfo.extData()) eInfo.Reset();
+           if (!busy && (next >= num || errRC)) dsCond.Broadcast();
+          }
+     dsCond.UnLock();
+    }
+
+// Wait() waits for all claimed entries to have been stated.
+//
+void Wait()
+    {dsCond.Lock();
+     while(busy || (next < num && !errRC)) dsCond.Wait();
+     dsCond.UnLock();
+    }
+
+void Unref()
+    {dsCond.Lock();
+     if (--refs) {dsCond.UnLock(); return;}
+     dsCond.UnLock();
+     delete this;
+    }
+
+Helper              helper[maxHelp];
+XrdSysCondVar       dsCond;   // Caller handles the lock
+XrdSfsFileSystem   *fsP;
+const XrdSecEntity *client;
+const char         *tident;
+char               *dPath;    // Directory path with a trailing slash
+const char         *opaque;
+char              **names;
+struct stat        *sbuf;
+int                *rcv;
+int                 monID;
+int                 ucap;
+int                 num;      // Number of entries
+int                 next;     // Next entry to be claimed
+int                 busy;     // Entries being stated right now
+int                 refs;
+int                 errRC;    // First failure other than a vanished entry
+int                 errCode;
+char                errText[2048];
+
+     XrdXrootdDirStat() : dsCond(0), dPath(0), next(0), busy(0), refs(1),
+                          errRC(0), errCode(0)
+                        {for (int i = 0; i < maxHelp; i++) helper[i].dsP = this;
+                         *errText = 0;
+                        }
+    ~XrdXrootdDirStat() {if (dPath) free(dPath);}
+};
+
 /******************************************************************************/
 /*                         L o c a l   D e f i n e s                          */
 /******************************************************************************/
@@ -545,6 +642,12 @@ int XrdXrootdProtocol::do_Close()
 //
    rc = fp->XrdSfsp->close();
    TRACEP(FS, "close rc=" <<rc <<" fh=" <<fh.handle);
+   if (fp->Stats.wpipe.bytes)
+      {long long wpT = fp->Stats.wpipe.wTime;
+       TRACEP(FS, "fh=" <<fh.handle <<" pipelined " <<fp->Stats.wpipe.bytes
+                  <<" bytes at " <<fp->Stats.wpipe.bytes/(wpT ? wpT : 1)
+                  <<" MB/s; " <<fp->Stats.wpipe.waits <<" waits");
+      }
    if (rc >= SFS_STALL) return fsError(rc, 0, fp->XrdSfsp->error, 0, 0);
    if (rc == SFS_STARTED) doDel = false;
 
@@ -574,11 +677,17 @@ int XrdXrootdProtocol::do_Close()
 int XrdXrootdProtocol::do_Dirlist()
 {
    int bleft, rc = 0, dlen, cnt = 0;
-   char *opaque, *buff, ebuff[4096];
+   char *opaque, *buff, *cursor = 0, ebuff[4096];
    const char *dname;
    XrdSfsDirectory *dp;
    bool doDig;
 
+// A paged listing may carry the cursor returned with the previous page on a
+// line following the path.
+//
+   if (Request.dirlist.options[0] & kXR_dcursor
+   &&  (cursor = index(argp->buff, '\n'))) *cursor++ = '\0';
+
 // Check if we are digging for data
 //
    doDig = (digFS && SFS_LCLROOT(argp->buff));
@@ -592,6 +701,11 @@ int XrdXrootdProtocol::do_Dirlist()
    if (rpCheck(argp->buff, &opaque)) return rpEmsg("Listing", argp->buff);
    if (!doDig && !Squash(argp->buff))return vpEmsg("Listing", argp->buff);
 
+// Check if the caller wants the listing a page at a time
+//
+   if (Request.dirlist.options[0] & kXR_dcursor)
+      return do_DirPage(cursor, opaque, doDig);
+
 // Get a directory object
 //
    if (doDig) dp = digFS->newDir(Link->ID, Monitor.Did);
@@ -656,6 +770,161 @@ int XrdXrootdProtocol::do_Dirlist()
    return rc;
 }
 
+/******************************************************************************/
+/*                            d o _ D i r P a g e                             */
+/******************************************************************************/
+
+int XrdXrootdProtocol::do_DirPage(char *cursor, char *opaque, bool doDig)
+{
+   static const int statSz = 80;
+   DirCursor *cP = 0;
+   XrdSfsDirectory *dp;
+   struct stat *sbuf = 0;
+   long long pos = 0, skip;
+   unsigned int cid = 0;
+   int i, bleft, dlen, num = 0, rc = 0, *rcv;
+   char *cp, *buff, **names, ebuff[8192];
+   const char *dname;
+   bool doStat = (Request.dirlist.options[0] & kXR_dstat) != 0, more;
+
+// Decode the cursor, if any, and find the directory it refers to. A cursor
+// is of the form <id>.<pos> where pos is the number of entries returned so far.
+//
+   if (cursor && *cursor)
+      {cid = strtoul(cursor, &cp, 10);
+       if (*cp != '.' || (pos = strtoll(cp+1, &cp, 10)) < 0 || *cp)
+          return Response.Send(kXR_ArgInvalid, "invalid dirlist cursor");
+       for (i = 0; i < maxDirCursors; i++)
+           if (dirCursor[i].dp && dirCursor[i].id == cid
+           &&  dirCursor[i].pos == pos && dirCursor[i].doStat == doStat
+           &&  !strcmp(dirCursor[i].path, argp->buff))
+              {cP = &dirCursor[i]; break;}
+      }
+
+// If we do not have the directory open, open it in a free slot (reclaiming
+// the least recently used one if need be) and skip over the entries that were
+// already returned. This allows a listing to be resumed on a new connection.
+//
+   if (!cP)
+      {cP = &dirCursor[0];
+       for (i = 0; i < maxDirCursors; i++)
+           {if (!dirCursor[i].dp) {cP = &dirCursor[i]; break;}
+            if (dirCursor[i].lastUse < cP->lastUse) cP = &dirCursor[i];
+           }
+       if (cP->dp)
+          {cP->dp->close(); delete cP->dp; free(cP->path); cP->dp = 0;}
+
+       if (doDig) dp = digFS->newDir(Link->ID, Monitor.Did);
+          else    dp =  osFS->newDir(Link->ID, Monitor.Did);
+       if (!dp)
+          {snprintf(ebuff,sizeof(ebuff)-1,"Insufficient memory to open %s",
+                    argp->buff);
+           eDest.Emsg("Xeq", ebuff);
+           return Response.Send(kXR_NoMemory, ebuff);
+          }
+
+       dp->error.setUCap(clientPV);
+       if ((rc = dp->open(argp->buff, CRED, opaque)))
+          {rc = fsError(rc, XROOTD_MON_OPENDIR, dp->error, argp->buff, opaque);
+           delete dp;
+           return rc;
+          }
+
+       cP->autoStat = doStat && dp->autoStat(&cP->Stat) == SFS_OK;
+       for (skip = pos; skip > 0 && (dname = dp->nextEntry());)
+           {dlen = strlen(dname);
+            if (dlen > 2 || dname[0] != '.' || (dlen == 2 && dname[1] != '.'))
+               skip--;
+           }
+       cP->dp     = dp;
+       cP->path   = strdup(argp->buff);
+       cP->pos    = pos;
+       cP->id     = ++dirCursorID;
+       cP->doStat = doStat;
+      }
+   cP->lastUse = ++dirCursorUse;
+   dp = cP->dp;
+
+// Read the entries for this page. Stat information either comes along with
+// each entry or is obtained afterwards by a set of parallel stat calls.
+//
+   names = new char *[dirPageSz];
+   rcv   = new int[dirPageSz];
+   if (doStat) sbuf = new struct stat[dirPageSz];
+   while(num < dirPageSz && (dname = dp->nextEntry()))
+        {dlen = strlen(dname);
+         if (dlen > 2 || dname[0] != '.' || (dlen == 2 && dname[1] != '.'))
+            {names[num] = strdup(dname);
+             if (cP->autoStat) sbuf[num] = cP->Stat;
+             rcv[num++] = SFS_OK;
+            }
+        }
+   more = (num >= dirPageSz);
+   if (doStat && !cP->autoStat && num
+   &&  !DirPageStat(names, sbuf, rcv, num, opaque, doDig, rc))
+      {dp->close(); delete dp; free(cP->path); cP->dp = 0;
+       for (i = 0; i < num; i++) free(names[i]);
+       delete [] names;
+       delete [] rcv;
+       delete [] sbuf;
+       return rc;
+      }
+
+// Place each entry in the buffer as do_Dirlist() and do_DirStat() do, sending
+// the buffer with an OKSOFAR whenever it fills up. Entries that have gone away
+// since we read the directory are skipped. If there are more entries, the last
+// line holds the cursor to get them; as it starts with a slash it can never be
+// mistaken for an entry.
+//
+   if (doStat) {strcpy(ebuff, ".\n0 0 0 0\n"); buff = ebuff+10;}
+      else buff = ebuff;
+   bleft = sizeof(ebuff) - (buff - ebuff);
+   for (i = 0; i < num && !rc; i++)
+       {if (rcv[i] != SFS_OK) continue;
+        dlen = strlen(names[i]);
+        if (bleft < dlen + 1 + statSz)
+           {if ((rc = Response.Send(kXR_oksofar, ebuff, buff-ebuff))) break;
+            buff = ebuff; bleft = sizeof(ebuff);
+           }
+        strcpy(buff, names[i]); buff += dlen; *buff++ = '\n'; bleft -= dlen+1;
+        if (doStat)
+           {dlen = StatGen(sbuf[i], buff);
+            bleft -= dlen; buff += (dlen-1); *buff++ = '\n';
+           }
+       }
+   if (!rc && more)
+      {if (bleft < 48)
+          {rc = Response.Send(kXR_oksofar, ebuff, buff-ebuff);
+           buff = ebuff; bleft = sizeof(ebuff);
+          }
+       buff += sprintf(buff, "/%u.%lld\n", cP->id, pos+num);
+      }
+
+// Send the ending packet if we actually have one to send
+//
+   if (!rc)
+      {if (ebuff == buff) rc = Response.Send();
+          else {*(buff-1) = '\0';
+                rc = Response.Send((void *)ebuff, buff-ebuff);
+               }
+      }
+
+// Advance the cursor or, if the listing is complete, close the directory
+//
+   if (more) cP->pos = pos + num;
+      else {dp->close(); delete dp; free(cP->path); cP->dp = 0;}
+
+// Clean up and return
+//
+   for (i = 0; i < num; i++) free(names[i]);
+   delete [] names;
+   delete [] rcv;
+   if (sbuf) delete [] sbuf;
+   if (!rc) {TRACEP(FS, "dirlist page entries=" <<num <<" pos=" <<pos
+                        <<" path=" <<argp->buff);}
+   return rc;
+}
+
 /******************************************************************************/
 /*                            d o _ D i r S t a t                             */
 /******************************************************************************/
@@ -879,6 +1148,7 @@ int XrdXrootdProtocol::do_Login()
 // Keep Statistics
 //
    SI->Bump(SI->LoginAT);
+   SI->Publish(XrdXrootdStats::shmLogin);
 
 // Unmarshall the data
 //
@@ -1307,6 +1577,7 @@ int XrdXrootdProtocol::do_Open()
 // Keep Statistics
 //
    SI->Bump(SI->openCnt);
+   SI->Publish(XrdXrootdStats::shmOpen);
 
 // Unmarshall the data
 //
@@ -1359,6 +1630,7 @@ int XrdXrootdProtocol::do_Open()
                                       }
    if (opts & kXR_retstat)            {*op++ = 't'; retStat = 1;}
    if (opts & kXR_posc)               {*op++ = 'p'; openopts |= SFS_O_POSC;}
+   if (opts & kXR_seqio)              {*op++ = 'q'; openopts |= SFS_O_SEQIO;}
    *op = '\0';
    TRACEP(FS, "open " <<opt <<' ' <<fn);
 
@@ -2150,7 +2422,7 @@ int XrdXrootdProtocol::do_Read()
 {
    int pathID, retc;
    XrdXrootdFHandle fh(Request.read.fhandle);
-   numReads++;
+   numReads++; SI->Publish(XrdXrootdStats::shmRd);
 
 // We first handle the pre-read list, if any. We do it this way because of
 // a historical glitch in the protocol. One should really not piggy back a
@@ -2307,7 +2579,7 @@ int XrdXrootdProtocol::do_ReadNone(int &retc, int &pathID)
          myFile->XrdSfsp->read(myOffset, myIOLen);
          ralsz -= sizeof(struct readahead_list);
          ralsp++;
-         numReads++;
+         numReads++; SI->Publish(XrdXrootdStats::shmRd);
         };
 
 // All done
@@ -2356,6 +2628,8 @@ int XrdXrootdProtocol::do_ReadV()
 // So, now we account for the number of readv requests and total segments
 //
    numReadV++; numSegsV += rdVecNum;
+   SI->Publish(XrdXrootdStats::shmRv);
+   SI->Publish(XrdXrootdStats::shmRs, rdVecNum);
 
 // Run down the list and compute the total size of the read. No individual
 // read may be greater than the maximum transfer size. We also use this loop
@@ -2706,6 +2980,10 @@ int XrdXrootdProtocol::do_Statx()
 //
    STATIC_REDIRECT(RD_stat);
 
+// Check if the caller wants full stat information for each path
+//
+   if (Request.stat.options & kXR_sxinfo) return do_StatxInfo();
+
 // Cycle through all of the paths in the list
 //
    while((path = pathlist.GetLine()))
@@ -2727,6 +3005,78 @@ int XrdXrootdProtocol::do_Statx()
    return Response.Send(argp->buff, respinfo-argp->buff);
 }
 
+/******************************************************************************/
+/*                           d o _ S t a t x I n f o                          */
+/******************************************************************************/
+
+int XrdXrootdProtocol::do_StatxInfo()
+{
+   XrdOucErrInfo myError(Link->ID, Monitor.Did, clientPV);
+   XrdOucTokenizer pathlist(argp->buff);
+   struct stat Stat;
+   static const int itemSz = 320;
+   int bleft, ecode, dlen, rc = 0, cnt = 0;
+   char *path, *opaque, *buff, *bp, ebuff[8192];
+   const char *eMsg;
+
+// The initial leadin is a "dot" line to indicate to the client that we
+// support the sxinfo option (older servers return a flag byte per path). It's
+// up to the client to issue individual stat requests in that case.
+//
+   strcpy(ebuff, ".\n");
+   buff = ebuff+2; bleft = sizeof(ebuff)-2;
+
+// Stat each path placing the result on a line of its own in the order the
+// paths were given: "0 <statinfo>" upon success, "<errcode> <errmsg>" upon
+// failure, and "-1" if the path must be stated on its own because it cannot
+// be handled here (e.g. it is redirected or needs to wait). Failures apply to
+// the path alone. Whenever the buffer fills up, send what we have with an
+// OKSOFAR and continue. No callbacks are allowed as we must reply in order.
+//
+   while((path = pathlist.GetLine()))
+        {if (bleft < itemSz)
+            {if ((rc = Response.Send(kXR_oksofar, ebuff, buff-ebuff)))
+                return rc;
+             buff = ebuff; bleft = sizeof(ebuff);
+            }
+         cnt++;
+         if (rpCheck(path, &opaque))
+            dlen = sprintf(buff, "%d relative path not allowed\n",
+                                 kXR_ArgInvalid);
+            else if (!Squash(path))
+            dlen = sprintf(buff, "%d path not allowed\n", kXR_NotAuthorized);
+            else {rc = osFS->stat(path, &Stat, myError, CRED, opaque);
+                  TRACEP(FS, "rc=" <<rc <<" statx " <<path);
+                  if (rc == SFS_OK)
+                     {buff[0] = '0'; buff[1] = ' ';
+                      dlen = StatGen(Stat, buff+2) + 2;
+                      buff[dlen-1] = '\n';
+                     }
+                     else if (rc == SFS_ERROR)
+                             {SI->errorCnt++;
+                              eMsg = myError.getErrText(ecode);
+                              dlen = snprintf(buff, itemSz-1, "%d %s",
+                                              XProtocol::mapError(ecode), eMsg);
+                              if (dlen > itemSz-2) dlen = itemSz-2;
+                              for (bp = buff; bp < buff+dlen; bp++)
+                                  if (*bp == '\n') *bp = ' ';
+                              buff[dlen++] = '\n';
+                             }
+                             else dlen = sprintf(buff, "-1\n");
+                  if (myError.extData()) myError.Reset();
+                  rc = 0;
+                 }
+         buff += dlen; bleft -= dlen;
+        }
+
+// Send the ending packet (we always have at least the leadin line)
+//
+   *(buff-1) = '\0';
+   rc = Response.Send((void *)ebuff, buff-ebuff);
+   if (!rc) {TRACEP(FS, "statx entries=" <<cnt);}
+   return rc;
+}
+
 /******************************************************************************/
 /*                               d o _ S y n c                                */
 /******************************************************************************/
@@ -2741,6 +3091,7 @@ int XrdXrootdProtocol::do_Sync()
 // Keep Statistics
 //
    SI->Bump(SI->syncCnt);
+   SI->Publish(XrdXrootdStats::shmSync);
 
 // Find the file object
 //
@@ -2835,7 +3186,7 @@ int XrdXrootdProtocol::do_Write()
 {
    int retc, pathID;
    XrdXrootdFHandle fh(Request.write.fhandle);
-   numWrites++;
+   numWrites++; SI->Publish(XrdXrootdStats::shmWr);
 
 // Unmarshall the data
 //
@@ -2904,6 +3255,17 @@ int XrdXrootdProtocol::do_WriteAll()
 {
    int rc, Quantum = (myIOLen > maxBuffsz ? maxBuffsz : myIOLen);
 
+// Large writes are pipelined so that receiving the data overlaps writing it.
+// The data is split into at least wp_depth chunks rounded up to 64K.
+//
+   if (wp_depth > 1 && myIOLen >= wp_minsz)
+      {int chunk = (myIOLen + wp_depth - 1) / wp_depth;
+       chunk = (chunk + 65535) & ~65535;
+       if (chunk > maxBuffsz) chunk = maxBuffsz;
+       if (!wPipe) wPipe = new XrdXrootdWPipe;
+       if (wPipe->Start(myFile, wp_depth, chunk)) return do_WritePipe();
+      }
+
 // Make sure we have a large enough buffer
 //
    if (!argp || Quantum < halfBSize || Quantum > argp->bsize)
@@ -2961,6 +3323,64 @@ int XrdXrootdProtocol::do_WriteCont()
    return Response.Send();
 }
   
+/******************************************************************************/
+/*                          d o _ W r i t e P i p e                           */
+/******************************************************************************/
+
+// myFile   = file to be written
+// myOffset = Offset at which to write
+// myIOLen  = Number of bytes to read from socket and write to file
+// wPipe    = Write pipeline that has been started for myFile
+
+int XrdXrootdProtocol::do_WritePipe()
+{
+   char *buff;
+   int rc, Quantum;
+
+// Receive each chunk and hand it off to be written while we receive the next
+//
+   while(myIOLen > 0 && !wPipe->Error())
+        {Quantum = (myIOLen > wPipe->Chunk() ? wPipe->Chunk() : myIOLen);
+         buff = wPipe->Buffer();
+         if ((rc = getData("data", buff, Quantum)))
+            {if (rc > 0)
+                {Resume = &XrdXrootdProtocol::do_WritePCont;
+                 myBlast = Quantum;
+                 myStalls++;
+                }
+             return rc;
+            }
+         wPipe->Queue(myOffset, Quantum);
+         myOffset += Quantum; myIOLen -= Quantum;
+        }
+
+// Wait for the writes to complete. Any data not yet received is discarded
+// should one of them have failed (this needs the normal buffer).
+//
+   if ((rc = wPipe->Finish()) < 0)
+      {myEInfo[0] = rc;
+       if (!argp && (rc = getBuff(0, wPipe->Chunk())) <= 0) return rc;
+       return do_WriteNone();
+      }
+   return Response.Send();
+}
+
+/******************************************************************************/
+/*                         d o _ W r i t e P C o n t                          */
+/******************************************************************************/
+
+// myBlast  = Number of bytes received into the pipeline's current buffer
+
+int XrdXrootdProtocol::do_WritePCont()
+{
+
+// Queue the chunk that finally came in and continue with the pipeline
+//
+   wPipe->Queue(myOffset, myBlast);
+   myOffset += myBlast; myIOLen -= myBlast;
+   return do_WritePipe();
+}
+
 /******************************************************************************/
 /*                          d o _ W r i t e N o n e                           */
 /******************************************************************************/
@@ -3000,7 +3420,7 @@ int XrdXrootdProtocol::do_WriteSpan()
 {
    int rc;
    XrdXrootdFHandle fh(Request.write.fhandle);
-   numWrites++;
+   numWrites++; SI->Publish(XrdXrootdStats::shmWr);
 
 // Unmarshall the data
 //
@@ -3124,6 +3544,8 @@ int XrdXrootdProtocol::do_WriteV()
 // So, now we account for the number of writev requests and total segments
 //
    numWritV++; numSegsW += k; wrVecNum = k;
+   SI->Publish(XrdXrootdStats::shmWv);
+   SI->Publish(XrdXrootdStats::shmWs, k);
 
 // Calculate the transfer unit which will be the smaller of the maximum
 // transfer unit and the actual amount we need to transfer.
@@ -3320,6 +3742,73 @@ void XrdXrootdProtocol::SetFD(int fildes)
 /******************************************************************************/
 /*                       U t i l i t y   M e t h o d s                        */
 /******************************************************************************/
+/******************************************************************************/
+/*                           D i r P a g e S t a t                            */
+/******************************************************************************/
+
+// Stat each of the num entries of a directory page, placing the stat
+// information in sbuf and the result in rcv. Entries that have gone away are
+// marked with SFS_ERROR. Large pages are stated in parallel with the help of
+// up to dirStatPar-1 scheduler jobs. Any other failure is sent to the client
+// as do_Stat() would send it, in which case false is returned with rc holding
+// the result of sending the response.
+
+bool XrdXrootdProtocol::DirPageStat(char **names, struct stat *sbuf, int *rcv,
+                                    int num, char *opaque, bool doDig, int &rc)
+{
+   static const int minSlice = 32;
+   XrdXrootdDirStat *dsP = new XrdXrootdDirStat;
+   bool isOK = true;
+   int i, nHelp = dirStatPar - 1, plen = strlen(argp->buff);
+
+// Construct the path to the directory
+//
+   dsP->dPath = (char *)malloc(plen+2);
+   strcpy(dsP->dPath, argp->buff);
+   if (!plen || dsP->dPath[plen-1] != '/') strcpy(dsP->dPath+plen, "/");
+
+// Fill out what the stat calls need
+//
+   dsP->fsP     = (doDig ? digFS : osFS);
+   dsP->client  = CRED;
+   dsP->tident  = Link->ID;
+   dsP->opaque  = opaque;
+   dsP->names   = names;
+   dsP->sbuf    = sbuf;
+   dsP->rcv     = rcv;
+   dsP->monID   = Monitor.Did;
+   dsP->ucap    = clientPV;
+   dsP->num     = num;
+
+// Get some help for large pages, small pages are done inline
+//
+   if (nHelp > num/minSlice - 1) nHelp = num/minSlice - 1;
+   if (nHelp > XrdXrootdDirStat::maxHelp) nHelp = XrdXrootdDirStat::maxHelp;
+   if (nHelp > 0)
+      {dsP->refs += nHelp;
+       for (i = 0; i < nHelp; i++) Sched->Schedule(&(dsP->helper[i]));
+      }
+
+// Stat entries ourselves and then wait for the ones our helpers are doing
+//
+   dsP->Run();
+   dsP->Wait();
+
+// Report the first failure, if any
+//
+   if (dsP->errRC)
+      {XrdOucErrInfo myError(Link->ID, Monitor.Did, clientPV);
+       myError.setErrInfo(dsP->errCode, dsP->errText);
+       rc = fsError(dsP->errRC, XROOTD_MON_STAT, myError, argp->buff, opaque);
+       isOK = false;
+      }
+
+// All done
+//
+   dsP->Unref();
+   return isOK;
+}
+
 /******************************************************************************/
 /*                               f s E r r o r                                */
 /******************************************************************************/
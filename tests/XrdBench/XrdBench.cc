@@ -0,0 +1,601 @@
+/******************************************************************************/
+/*                                                                            */
+/*                           X r d B e n c h . c c                            */
+/*                                                                            */
+/* This file is part of the XRootD software suite.                            */
+/*                                                                            */
+/* XRootD is free software: you can redistribute it and/or modify it under    */
+/* the terms of the GNU Lesser General Public License as published by the     */
+/* Free Software Foundation, either version 3 of the License, or (at your     */
+/* option) any later version.                                                 */
+/*                                                                            */
+/* XRootD is distributed in the hope that it will be useful, but WITHOUT      */
+/* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or      */
+/* FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public       */
+/* License for more details.                                                  */
+/*                                                                            */
+/* You should have received a copy of the GNU Lesser General Public License   */
+/* along with XRootD in a file called COPYING.LESSER (LGPL license) and file  */
+/* COPYING (GPL license).  If not, see <http://www.gnu.org/licenses/>.        */
+/*                                                                            */
+/* The copyright holder's institutional names and contributor's names may not */
+/* be used to endorse or promote products derived from this software without  */
+/* specific prior written permission of the institution or contributor.       */
+/******************************************************************************/
+
+#include <algorithm>
+#include <atomic>
+#include <errno.h>
+#include <fcntl.h>
+#include <ftw.h>
+#include <iostream>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <string.h>
+#include <thread>
+#include <time.h>
+#include <unistd.h>
+#include <vector>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include "XrdCl/XrdClFile.hh"
+#include "XrdCl/XrdClFileSystem.hh"
+#include "XrdCl/XrdClURL.hh"
+
+using namespace std;
+
+// xrdbench measures the throughput and latency of a server's hot paths on a
+// single machine. Unless pointed at a running server, it starts an xrootd
+// whose storage is a directory in a tmpfs (so that the disk does not matter),
+// creates a data set through the server and then drives it over loopback
+// with one or more synthetic workloads, each run by a number of clients that
+// have their own connection:
+//
+// stat  - stat of the data set files
+// open  - open and close of the data set files
+// read  - sequential reads of the data set files
+// readv - ROOT-like vector reads of small chunks scattered over a window
+// write - small sequential writes to a file per client
+//
+// For each workload the requests per second, bytes per second and request
+// latency percentiles are reported.
+
+/******************************************************************************/
+/*                          U n i t   G l o b a l s                           */
+/******************************************************************************/
+
+namespace
+{
+   const char          *MeMe     = "xrdbench: ";
+   const char          *srvURL   = 0;      // -u: use this server
+   const char          *srvPgm   = XRDBENCH_XROOTD;
+   const char          *tmpBase  = "/dev/shm";
+   const char          *xtraCfg  = 0;      // -o: extra config directives
+   std::string          workDir;           // Server's root & config
+   std::string          baseURL;
+   pid_t                srvPID   = 0;
+   int                  numCln   = 16;     // -c
+   int                  numSec   = 10;     // -d
+   int                  numFiles = 16;     // -f
+   long long            fileSize = 8*1024*1024LL; // -s
+   int                  rdBsz    = 1024*1024;     // -b (read)
+   int                  wrBsz    = 4096;          // -B (write)
+   int                  rvChunks = 64;     // -v: chunks per readv
+   bool                 keepDir  = false;  // -k
+
+   std::atomic<bool>    endRun(false);
+}
+
+/******************************************************************************/
+/*                               D e f i n e s                                */
+/******************************************************************************/
+
+#define FMSG(x) {cerr <<MeMe <<x <<endl; Cleanup(); exit(2);}
+#define SAY(x)  cerr <<MeMe <<x <<endl
+
+/******************************************************************************/
+/*                         L o c a l   C l a s s e s                          */
+/******************************************************************************/
+
+// What a client accumulated while running a workload
+//
+struct ClnStats
+      {std::vector<unsigned int> lat;   // Microseconds, one per request
+       long long                 bytes;
+       long long                 errors;
+       ClnStats() : bytes(0), errors(0) {lat.reserve(65536);}
+      };
+
+// The wall clock in microseconds
+//
+inline long long Now()
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec*1000000LL + ts.tv_nsec/1000;
+}
+
+/******************************************************************************/
+/*                               C l e a n u p                                */
+/******************************************************************************/
+
+int RmOne(const char *path, const struct stat *sb, int flag, struct FTW *fb)
+{
+   remove(path);
+   return 0;
+}
+
+void Cleanup()
+{
+   int status;
+
+// Stop the server, if we started it
+//
+   if (srvPID > 0)
+      {kill(srvPID, SIGTERM);
+       waitpid(srvPID, &status, 0);
+       srvPID = 0;
+      }
+
+// Remove what we created unless asked to keep it
+//
+   if (!workDir.empty())
+      {if (keepDir) SAY("Server files kept in " <<workDir);
+          else nftw(workDir.c_str(), RmOne, 16, FTW_DEPTH | FTW_PHYS);
+       workDir.clear();
+      }
+}
+
+/******************************************************************************/
+/*                                 U s a g e                                  */
+/******************************************************************************/
+
+void Usage(int rc)
+{
+   cerr <<"\nUsage: xrdbench [opts] [<workload>[,<workload>[...]]]\n"
+          "\nopts: -b <bsz> -B <bsz> -c <clients> -d <sec> -f <files> -h -k"
+          "\n      -o <cfg> -s <fsz> -t <dir> -u <url> -v <chunks> -x <xrootd>\n"
+          "\n-b read  block size (default 1m)."
+          "\n-B write block size (default 4k)."
+          "\n-c number of clients, each with its own connection (default 16)."
+          "\n-d seconds each workload runs (default 10)."
+          "\n-f number of files in the data set (default 16)."
+          "\n-k keep the server's directory when done."
+          "\n-o file of extra directives for the server's configuration."
+          "\n-s size of each data set file (default 8m)."
+          "\n-t directory in which to place the server's files (default "
+          "/dev/shm)."
+          "\n-u url of a running server to use instead of starting one, e.g."
+          "\n   root://host:port//tmp/bench; the path must be writable."
+          "\n-v number of chunks in each readv (default 64)."
+          "\n-x the xrootd executable to start.\n"
+          "\nworkload: stat, open, read, readv, or write (default all of them)."
+          <<endl;
+   exit(rc);
+}
+
+/******************************************************************************/
+/*                                 G e t S z                                  */
+/******************************************************************************/
+
+long long GetSz(const char *item, const char *val)
+{
+   char *eP;
+   long long n = strtoll(val, &eP, 10);
+
+   switch(*eP)
+         {case 'k': case 'K': n <<= 10; eP++; break;
+          case 'm': case 'M': n <<= 20; eP++; break;
+          case 'g': case 'G': n <<= 30; eP++; break;
+          default: break;
+         }
+   if (*eP || n <= 0) {SAY("Invalid " <<item <<" - " <<val); Usage(1);}
+   return n;
+}
+
+/******************************************************************************/
+/*                               F i l e U R L                                */
+/******************************************************************************/
+
+std::string FileURL(const char *pfx, int cln, int num)
+{
+   char buff[64];
+
+// Each client uses a different user name so that it gets its own connection
+//
+   std::string url(baseURL);
+   snprintf(buff, sizeof(buff), "bench%d@", cln);
+   url.insert(url.find("://")+3, buff);
+   snprintf(buff, sizeof(buff), "/%s%d", pfx, num);
+   return url + buff;
+}
+
+/******************************************************************************/
+/*                              S t a r t S r v                               */
+/******************************************************************************/
+
+void StartSrv()
+{
+   struct sockaddr_in sa;
+   socklen_t slen = sizeof(sa);
+   char dirTmp[1024], buff[1024];
+   int sFD, port, status;
+   FILE *cfP;
+
+// Create the directory to hold the server's files
+//
+   snprintf(dirTmp, sizeof(dirTmp), "%s/xrdbench.XXXXXX", tmpBase);
+   if (!mkdtemp(dirTmp)) FMSG("Unable to create " <<dirTmp <<"; "
+                              <<strerror(errno));
+   workDir = dirTmp;
+   chmod(dirTmp, 0777);
+   mkdir((workDir + "/data").c_str(),  0777);
+   mkdir((workDir + "/data/bench").c_str(),  0777);
+   mkdir((workDir + "/admin").c_str(), 0777);
+   chmod((workDir + "/data").c_str(),  0777);
+   chmod((workDir + "/data/bench").c_str(),  0777);
+   chmod((workDir + "/admin").c_str(), 0777);
+
+// Find a free port on the loopback interface
+//
+   memset(&sa, 0, sizeof(sa));
+   sa.sin_family = AF_INET;
+   sa.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+   if ((sFD = socket(AF_INET, SOCK_STREAM, 0)) < 0
+   ||  bind(sFD, (struct sockaddr *)&sa, sizeof(sa))
+   ||  getsockname(sFD, (struct sockaddr *)&sa, &slen))
+      FMSG("Unable to find a free port; " <<strerror(errno));
+   port = ntohs(sa.sin_port);
+   close(sFD);
+
+// Write the configuration file
+//
+   std::string cfn = workDir + "/xrootd.cf";
+   if (!(cfP = fopen(cfn.c_str(), "w")))
+      FMSG("Unable to create " <<cfn <<"; " <<strerror(errno));
+   fprintf(cfP, "all.export /bench\nall.adminpath %s/admin\n"
+                "oss.localroot %s/data\nxrd.port %d\n",
+                workDir.c_str(), workDir.c_str(), port);
+   if (xtraCfg)
+      {FILE *xP = fopen(xtraCfg, "r");
+       if (!xP) {fclose(cfP);
+                 FMSG("Unable to open " <<xtraCfg <<"; " <<strerror(errno));
+                }
+       while(fgets(buff, sizeof(buff), xP)) fputs(buff, cfP);
+       fclose(xP);
+      }
+   fclose(cfP);
+
+// Start the server
+//
+   std::string lfn = workDir + "/xrootd.log";
+   if (!(srvPID = fork()))
+      {int fd = open("/dev/null", O_RDWR);
+       if (fd >= 0) {dup2(fd, STDIN_FILENO); dup2(fd, STDOUT_FILENO);
+                     dup2(fd, STDERR_FILENO);
+                    }
+       if (geteuid())
+          execl(srvPgm, "xrootd", "-c", cfn.c_str(), "-l", lfn.c_str(),
+                "-n", "xrdbench", (char *)0);
+          else
+          execl(srvPgm, "xrootd", "-c", cfn.c_str(), "-l", lfn.c_str(),
+                "-n", "xrdbench", "-R", "nobody", (char *)0);
+       _exit(127);
+      }
+   if (srvPID < 0) FMSG("Unable to start " <<srvPgm <<"; " <<strerror(errno));
+
+// Wait for the server to accept connections
+//
+   for (int i = 0; i < 150; i++)
+       {if (waitpid(srvPID, &status, WNOHANG) == srvPID)
+           {srvPID = 0;
+            FMSG("Server failed to start; see " <<lfn <<" (use -k to keep it)");
+           }
+        if ((sFD = socket(AF_INET, SOCK_STREAM, 0)) >= 0)
+           {int rc = connect(sFD, (struct sockaddr *)&sa, sizeof(sa));
+            close(sFD);
+            if (!rc)
+               {snprintf(buff, sizeof(buff), "root://localhost:%d//bench", port);
+                baseURL = buff;
+                return;
+               }
+           }
+        usleep(100000);
+       }
+   FMSG("Server did not start listening on port " <<port);
+}
+
+/******************************************************************************/
+/*                                 S e t u p                                  */
+/******************************************************************************/
+
+// Create the data set through the server. This is not timed.
+
+void Setup()
+{
+   std::vector<char> buff(rdBsz);
+   XrdCl::XRootDStatus st;
+
+   for (size_t i = 0; i < buff.size(); i++) buff[i] = char(i*131);
+
+   for (int i = 0; i < numFiles; i++)
+       {XrdCl::File file;
+        std::string url = FileURL("f", 0, i);
+        st = file.Open(url, XrdCl::OpenFlags::Delete
+                          | XrdCl::OpenFlags::MakePath,
+                            XrdCl::Access::UR | XrdCl::Access::UW);
+        if (!st.IsOK()) FMSG("Unable to create " <<url <<"; " <<st.ToStr());
+        for (long long off = 0; off < fileSize; off += rdBsz)
+            {uint32_t n = (fileSize - off < rdBsz ? fileSize - off : rdBsz);
+             st = file.Write(off, n, &buff[0]);
+             if (!st.IsOK()) FMSG("Unable to write " <<url <<"; "
+                                  <<st.ToStr());
+            }
+        st = file.Close();
+        if (!st.IsOK()) FMSG("Unable to close " <<url <<"; " <<st.ToStr());
+       }
+}
+
+/******************************************************************************/
+/*                             W o r k l o a d s                              */
+/******************************************************************************/
+
+// Each workload runs until endRun is set, recording every request.
+
+void DoStat(int cln, ClnStats &cs)
+{
+   XrdCl::FileSystem fs(XrdCl::URL(FileURL("f", cln, 0)));
+   std::vector<std::string> path;
+   long long tBeg;
+
+   for (int i = 0; i < numFiles; i++)
+       path.push_back(XrdCl::URL(FileURL("f", cln, i)).GetPath());
+
+   for (int i = cln; !endRun; i++)
+       {XrdCl::StatInfo *sP = 0;
+        tBeg = Now();
+        if (!fs.Stat(path[i % numFiles], sP).IsOK()) cs.errors++;
+        cs.lat.push_back(Now() - tBeg);
+        delete sP;
+       }
+}
+
+void DoOpen(int cln, ClnStats &cs)
+{
+   long long tBeg;
+
+   for (int i = cln; !endRun; i++)
+       {XrdCl::File file;
+        std::string url = FileURL("f", cln, i % numFiles);
+        tBeg = Now();
+        if (!file.Open(url, XrdCl::OpenFlags::Read).IsOK()) cs.errors++;
+           else if (!file.Close().IsOK()) cs.errors++;
+        cs.lat.push_back(Now() - tBeg);
+       }
+}
+
+void DoRead(int cln, ClnStats &cs)
+{
+   std::vector<char> buff(rdBsz);
+   long long tBeg;
+   uint32_t bRead;
+
+   for (int i = cln; !endRun; i++)
+       {XrdCl::File file;
+        if (!file.Open(FileURL("f", cln, i % numFiles),
+                       XrdCl::OpenFlags::Read).IsOK())
+           {cs.errors++; continue;}
+        for (long long off = 0; off < fileSize && !endRun; off += bRead)
+            {tBeg = Now();
+             if (!file.Read(off, rdBsz, &buff[0], bRead).IsOK() || !bRead)
+                {cs.errors++; break;}
+             cs.lat.push_back(Now() - tBeg);
+             cs.bytes += bRead;
+            }
+        if (!file.Close().IsOK()) cs.errors++;
+       }
+}
+
+void DoReadV(int cln, ClnStats &cs)
+{
+   const long long window = 4*1024*1024LL;
+   std::vector<char> buff(rvChunks * 32768);
+   unsigned int seed = cln;
+   long long tBeg, base;
+
+// ROOT reads the baskets of the branches in use, which are small and spread
+// over a cluster of entries. Emulate that by reading chunks of 1 to 32K
+// scattered over a window that moves through the file.
+//
+   for (int i = cln; !endRun; i++)
+       {XrdCl::File file;
+        if (!file.Open(FileURL("f", cln, i % numFiles),
+                       XrdCl::OpenFlags::Read).IsOK())
+           {cs.errors++; continue;}
+        for (base = 0; base < fileSize && !endRun; base += window)
+            {XrdCl::ChunkList chunks;
+             XrdCl::VectorReadInfo *vrP = 0;
+             long long wlen = std::min(window, fileSize - base);
+             char *bP = &buff[0];
+             for (int j = 0; j < rvChunks; j++)
+                 {uint32_t len = 1024 + rand_r(&seed) % 31744;
+                  if (len > wlen) len = wlen;
+                  uint64_t off = base + rand_r(&seed) % (wlen - len + 1);
+                  chunks.push_back(XrdCl::ChunkInfo(off, len, bP));
+                  bP += len;
+                 }
+             std::sort(chunks.begin(), chunks.end(),
+                       [](const XrdCl::ChunkInfo &a, const XrdCl::ChunkInfo &b)
+                         {return a.offset < b.offset;});
+             tBeg = Now();
+             if (!file.VectorRead(chunks, 0, vrP).IsOK()) cs.errors++;
+                else {cs.lat.push_back(Now() - tBeg);
+                      cs.bytes += vrP->GetSize();
+                     }
+             delete vrP;
+            }
+        if (!file.Close().IsOK()) cs.errors++;
+       }
+}
+
+void DoWrite(int cln, ClnStats &cs)
+{
+   std::vector<char> buff(wrBsz, 'w');
+   long long tBeg;
+
+   for (int i = 0; !endRun; i++)
+       {XrdCl::File file;
+        if (!file.Open(FileURL("w", cln, cln), XrdCl::OpenFlags::Delete,
+                       XrdCl::Access::UR | XrdCl::Access::UW).IsOK())
+           {cs.errors++; continue;}
+        for (long long off = 0; off < fileSize && !endRun; off += wrBsz)
+            {tBeg = Now();
+             if (!file.Write(off, wrBsz, &buff[0]).IsOK())
+                {cs.errors++; break;}
+             cs.lat.push_back(Now() - tBeg);
+             cs.bytes += wrBsz;
+            }
+        if (!file.Close().IsOK()) cs.errors++;
+       }
+}
+
+/******************************************************************************/
+/*                                   R u n                                    */
+/******************************************************************************/
+
+void Run(const char *wName, void (*wFunc)(int, ClnStats &))
+{
+   std::vector<ClnStats>    cs(numCln);
+   std::vector<std::thread> tv;
+   std::vector<unsigned int> lat;
+   long long tBeg, tEnd, bytes = 0, errors = 0;
+   double secs;
+
+// Run the workload for the requested time
+//
+   endRun = false;
+   tBeg = Now();
+   for (int i = 0; i < numCln; i++) tv.push_back(std::thread(wFunc, i,
+                                                 std::ref(cs[i])));
+   sleep(numSec);
+   endRun = true;
+   for (int i = 0; i < numCln; i++) tv[i].join();
+   tEnd = Now();
+
+// Merge what the clients saw
+//
+   for (int i = 0; i < numCln; i++)
+       {lat.insert(lat.end(), cs[i].lat.begin(), cs[i].lat.end());
+        bytes  += cs[i].bytes;
+        errors += cs[i].errors;
+       }
+   std::sort(lat.begin(), lat.end());
+   secs = (tEnd - tBeg) / 1000000.0;
+
+// Report
+//
+   printf("%-6s %10zu req %10.0f req/s %9.2f MB/s", wName, lat.size(),
+          lat.size()/secs, bytes/secs/(1024*1024));
+   if (!lat.empty())
+      {static const double pct[] = {50.0, 90.0, 99.0, 99.9};
+       printf("  lat us");
+       for (int i = 0; i < 4; i++)
+           printf(" p%g=%u", pct[i],
+                  lat[std::min(lat.size()-1, size_t(lat.size()*pct[i]/100))]);
+       printf(" max=%u", lat.back());
+      }
+   if (errors) printf("  errors=%lld", errors);
+   printf("\n");
+   fflush(stdout);
+}
+
+/******************************************************************************/
+/*                                  m a i n                                   */
+/******************************************************************************/
+
+int main(int argc, char *argv[])
+{
+   static const struct {const char *name; void (*func)(int, ClnStats &);}
+          wlTab[] = {{"stat", DoStat}, {"open", DoOpen}, {"read", DoRead},
+                     {"readv", DoReadV}, {"write", DoWrite}};
+   static const int wlNum = sizeof(wlTab)/sizeof(wlTab[0]);
+   extern char *optarg;
+   extern int optind, opterr, optopt;
+   std::vector<int> wlRun;
+   char c;
+
+// Process the options
+//
+   opterr = 0;
+   while ((c = getopt(argc,argv,":b:B:c:d:f:hko:s:t:u:v:x:"))
+      && ((unsigned char)c != 0xff))
+     { switch(c)
+       {
+       case 'b': rdBsz    = GetSz("read block size",  optarg); break;
+       case 'B': wrBsz    = GetSz("write block size", optarg); break;
+       case 'c': numCln   = GetSz("client count",     optarg); break;
+       case 'd': numSec   = GetSz("duration",         optarg); break;
+       case 'f': numFiles = GetSz("file count",       optarg); break;
+       case 'h': Usage(0);
+                 break;
+       case 'k': keepDir  = true;   break;
+       case 'o': xtraCfg  = optarg; break;
+       case 's': fileSize = GetSz("file size",        optarg); break;
+       case 't': tmpBase  = optarg; break;
+       case 'u': srvURL   = optarg; break;
+       case 'v': rvChunks = GetSz("readv chunk count", optarg); break;
+       case 'x': srvPgm   = optarg; break;
+       default:  cerr <<MeMe <<'-' <<char(optopt);
+                 if (c == ':') cerr <<" value not specified." <<endl;
+                    else cerr <<" option is invalid" <<endl;
+                 Usage(1);
+                 break;
+       }
+     }
+
+// Establish the workloads to run
+//
+   if (optind >= argc) for (int i = 0; i < wlNum; i++) wlRun.push_back(i);
+      else {char *wP = strtok(argv[optind], ",");
+            while(wP)
+                 {int i;
+                  for (i = 0; i < wlNum; i++)
+                      if (!strcmp(wP, wlTab[i].name)) break;
+                  if (i >= wlNum) {SAY("Invalid workload - " <<wP); Usage(1);}
+                  wlRun.push_back(i);
+                  wP = strtok(0, ",");
+                 }
+           }
+
+// Get a server to talk to
+//
+   signal(SIGPIPE, SIG_IGN);
+   if (srvURL)
+      {XrdCl::URL url(srvURL);
+       if (!url.IsValid()) {SAY("Invalid url - " <<srvURL); Usage(1);}
+       baseURL = srvURL;
+       while(baseURL.size() && baseURL[baseURL.size()-1] == '/')
+            baseURL.erase(baseURL.size()-1);
+      } else StartSrv();
+
+// Create the data set and run each workload
+//
+   printf("xrdbench: %d clients, %d files of %lld bytes, %d seconds each\n",
+          numCln, numFiles, fileSize, numSec);
+   fflush(stdout);
+   Setup();
+   for (size_t i = 0; i < wlRun.size(); i++)
+       Run(wlTab[wlRun[i]].name, wlTab[wlRun[i]].func);
+
+// All done
+//
+   Cleanup();
+   return 0;
+}